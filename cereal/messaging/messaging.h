@@ -43,6 +43,9 @@ private:
 class MessageBuilder : public capnp::MallocMessageBuilder {
 public:
   MessageBuilder() = default;
+  // builds into firstSegment until it is full. It is zeroed again on destruction, so a
+  // zero-initialized buffer can be reused for every message
+  explicit MessageBuilder(kj::ArrayPtr<capnp::word> firstSegment) : capnp::MallocMessageBuilder(firstSegment) {}
 
   cereal::Event::Builder initEvent(bool valid = true) {
     cereal::Event::Builder event = initRoot<cereal::Event>();
@@ -94,6 +94,8 @@ _services: dict[str, tuple] = {
   "lateralPlan": (False, 20.),
   "liveENaviData": (False, 0.),
   "liveMapData": (False, 0.),
+  "encoderStats": (True, 1., 10),
+  "processTimings": (True, 0.5, 15),
 }
 SERVICE_LIST = {name: Service(*vals) for
                 idx, (name, vals) in enumerate(_services.items())}
@@ -11,7 +11,7 @@ int gpio_set(int pin_nr, bool high) {
   return 0;
 }
 
-int gpiochip_get_ro_value_fd(const char* consumer_label, int gpiochiop_id, int pin_nr) {
+int gpiochip_get_ro_value_fd(const char* consumer_label, int gpiochiop_id, int pin_nr, bool rising_edge_only) {
   return 0;
 }
 
@@ -48,7 +48,7 @@ int gpio_set(int pin_nr, bool high) {
   return util::write_file(pin_val_path, (void*)(high ? "1" : "0"), 1);
 }
 
-int gpiochip_get_ro_value_fd(const char* consumer_label, int gpiochiop_id, int pin_nr) {
+int gpiochip_get_ro_value_fd(const char* consumer_label, int gpiochiop_id, int pin_nr, bool rising_edge_only) {
 
   // Assumed that all interrupt pins are unexported and rights are given to
   // read from gpiochip0.
@@ -66,8 +66,10 @@ int gpiochip_get_ro_value_fd(const char* consumer_label, int gpiochiop_id, int p
 
   /* Requesting both edges as the data ready pulse from the lsm6ds sensor is
      very short(75us) and is mostly detected as falling edge instead of rising.
-     So if it is detected as rising the following falling edge is skipped. */
-  rq.eventflags = GPIOEVENT_REQUEST_BOTH_EDGES;
+     So if it is detected as rising the following falling edge is skipped.
+     Level interrupts like a FIFO threshold only need the rising edge, their
+     falling edge is just the FIFO being read. */
+  rq.eventflags = rising_edge_only ? GPIOEVENT_REQUEST_RISING_EDGE : GPIOEVENT_REQUEST_BOTH_EDGES;
 
   strncpy(rq.consumer_label, consumer_label, std::size(rq.consumer_label) - 1);
   int ret = util::safe_ioctl(fd, GPIO_GET_LINEEVENT_IOCTL, &rq);
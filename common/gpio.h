@@ -30,4 +30,5 @@
 int gpio_init(int pin_nr, bool output);
 int gpio_set(int pin_nr, bool high);
 
-int gpiochip_get_ro_value_fd(const char* consumer_label, int gpiochiop_id, int pin_nr);
+// event fd of an input line, reporting both edges unless rising_edge_only
+int gpiochip_get_ro_value_fd(const char* consumer_label, int gpiochiop_id, int pin_nr, bool rising_edge_only = false);
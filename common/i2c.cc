@@ -8,6 +8,7 @@
 #include <cstdio>
 #include <stdexcept>
 
+#include "common/gpio.h"
 #include "common/swaglog.h"
 #include "common/util.h"
 
@@ -16,6 +17,7 @@
 #ifdef QCOM2
 // TODO: decide if we want to install libi2c-dev everywhere
 extern "C" {
+  #include <linux/i2c.h>
   #include <linux/i2c-dev.h>
   #include <i2c/smbus.h>
 }
@@ -44,8 +46,27 @@ int I2CBus::read_register(uint8_t device_address, uint register_address, uint8_t
   ret = HANDLE_EINTR(ioctl(i2c_fd, I2C_SLAVE, device_address));
   if (ret < 0) { goto fail; }
 
-  ret = i2c_smbus_read_i2c_block_data(i2c_fd, register_address, len, buffer);
-  if ((ret < 0) || (ret != len)) { goto fail; }
+  if (len <= I2C_SMBUS_BLOCK_MAX) {
+    ret = i2c_smbus_read_i2c_block_data(i2c_fd, register_address, len, buffer);
+    if ((ret < 0) || (ret != len)) { goto fail; }
+  } else {
+    // longer bursts, like sensor FIFOs, as one combined write/read transfer
+    uint8_t reg = register_address;
+    struct i2c_msg msgs[2];
+    msgs[0].addr = device_address;
+    msgs[0].flags = 0;
+    msgs[0].len = 1;
+    msgs[0].buf = &reg;
+    msgs[1].addr = device_address;
+    msgs[1].flags = I2C_M_RD;
+    msgs[1].len = len;
+    msgs[1].buf = buffer;
+    struct i2c_rdwr_ioctl_data rdwr = {msgs, 2};
+
+    ret = HANDLE_EINTR(ioctl(i2c_fd, I2C_RDWR, &rdwr));
+    if (ret < 0) { goto fail; }
+    ret = len;
+  }
 
 fail:
   return ret;
@@ -90,3 +111,7 @@ int I2CBus::set_register(uint8_t device_address, uint register_address, uint8_t
   return -1;
 }
 #endif
+
+int I2CBus::gpio_event_fd(const char *consumer_label, int gpiochip_id, int pin_nr, bool rising_edge_only) {
+  return gpiochip_get_ro_value_fd(consumer_label, gpiochip_id, pin_nr, rising_edge_only);
+}
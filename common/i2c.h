@@ -10,10 +10,16 @@ class I2CBus {
     int i2c_fd;
     std::mutex m;
 
+  protected:
+    // for fakes in tests, which don't open a bus
+    I2CBus() : i2c_fd(-1) {}
+
   public:
     I2CBus(uint8_t bus_id);
-    ~I2CBus();
+    virtual ~I2CBus();
 
-    int read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len);
-    int set_register(uint8_t device_address, uint register_address, uint8_t data);
+    virtual int read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len);
+    virtual int set_register(uint8_t device_address, uint register_address, uint8_t data);
+    // event fd of an interrupt line of a device on this bus, see gpiochip_get_ro_value_fd
+    virtual int gpio_event_fd(const char *consumer_label, int gpiochip_id, int pin_nr, bool rising_edge_only = false);
 };
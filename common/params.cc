@@ -1,14 +1,22 @@
 #include "common/params.h"
 
 #include <dirent.h>
+#include <pthread.h>
 #include <sys/file.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
 
 #include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <csignal>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <unordered_map>
 
-#include "common/queue.h"
 #include "common/swaglog.h"
 #include "common/util.h"
 #include "system/hardware/hw.h"
@@ -87,6 +95,219 @@ private:
   int fd_ = -1;
 };
 
+// Process-wide cache of param values, invalidated by one inotify watch per params directory.
+// Writes from this process invalidate synchronously; writes from other processes are seen once
+// the watcher thread has handled the inotify event.
+class ParamsCache {
+public:
+  static ParamsCache &instance() {
+    // never destroyed, the watcher thread may still be blocked in read() at exit
+    static ParamsCache *cache = new ParamsCache();
+    return *cache;
+  }
+
+  std::string get(const std::string &dir, const std::string &key) {
+    const std::string path = dir + "/" + key;
+    uint64_t seq_before;
+    {
+      std::unique_lock lk(lock);
+      if (!watch(dir)) {
+        lk.unlock();
+        return util::read_file(path);
+      }
+      if (auto it = values.find(path); it != values.end()) {
+        return it->second;
+      }
+      seq_before = seq;
+    }
+
+    std::string value = util::read_file(path);
+
+    std::unique_lock lk(lock);
+    // only cache the value if nothing changed in the meantime, it may already be stale
+    if (seq == seq_before) {
+      values[path] = value;
+    }
+    return value;
+  }
+
+  void invalidate(const std::string &dir, const std::string &key) {
+    {
+      std::unique_lock lk(lock);
+      values.erase(dir + "/" + key);
+      ++seq;
+    }
+    cv.notify_all();
+  }
+
+  void invalidateAll() {
+    {
+      std::unique_lock lk(lock);
+      values.clear();
+      ++seq;
+    }
+    cv.notify_all();
+  }
+
+  uint64_t sequence() {
+    std::unique_lock lk(lock);
+    return seq;
+  }
+
+  // wait until anything in a watched directory changes, or the timeout expires
+  void waitForChange(uint64_t last_seq, int timeout_ms) {
+    std::unique_lock lk(lock);
+    cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), [&] { return seq != last_seq; });
+  }
+
+  int addListener(const std::string &dir, std::function<void(const std::string &)> f) {
+    std::unique_lock listeners_lk(listeners_lock);
+    std::unique_lock lk(lock);
+    if (!watch(dir)) return 0;
+    listeners[++last_listener_id] = {dir, f};
+    return last_listener_id;
+  }
+
+  void removeListener(int id) {
+    // waits for a call to the listener that is in progress
+    std::unique_lock listeners_lk(listeners_lock);
+    listeners.erase(id);
+  }
+
+  // handles an inotify queue overflow like one reported by the kernel, on the calling thread
+  void injectOverflow() {
+#ifdef __linux__
+    alignas(struct inotify_event) char buf[sizeof(struct inotify_event)] = {};
+    auto event = (struct inotify_event *)buf;
+    event->wd = -1;
+    event->mask = IN_Q_OVERFLOW;
+    int fd;
+    {
+      std::unique_lock lk(lock);
+      fd = inotify_fd;
+    }
+    handleEvents(fd, buf, sizeof(buf));
+#endif
+  }
+
+private:
+  ParamsCache() {
+    // listeners_lock is taken before lock everywhere, listeners may read params
+    pthread_atfork([]() { instance().listeners_lock.lock(); instance().lock.lock(); },
+                   []() { instance().lock.unlock(); instance().listeners_lock.unlock(); },
+                   []() { instance().resetAfterFork(); });
+  }
+
+  // the watcher thread doesn't survive fork, start over in the child
+  void resetAfterFork() {
+    if (inotify_fd >= 0) close(inotify_fd);
+    inotify_fd = -1;
+    watches.clear();
+    values.clear();
+    ++seq;
+    // listeners belong to the parent's threads
+    listeners.clear();
+    lock.unlock();
+    listeners_lock.unlock();
+  }
+
+  // caller must hold lock
+  bool watch(const std::string &dir) {
+#ifdef __linux__
+    if (inotify_fd < 0) {
+      inotify_fd = inotify_init1(IN_CLOEXEC);
+      if (inotify_fd < 0) return false;
+      std::thread(&ParamsCache::watcherThread, this, inotify_fd).detach();
+    }
+    for (auto &[wd, d] : watches) {
+      if (d == dir) return true;
+    }
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_ATTRIB;
+    int wd = inotify_add_watch(inotify_fd, dir.c_str(), mask);
+    if (wd < 0) return false;
+    watches[wd] = dir;
+    return true;
+#else
+    return false;
+#endif
+  }
+
+#ifdef __linux__
+  void watcherThread(int fd) {
+    util::set_thread_name("params_cache");
+    alignas(struct inotify_event) char buf[4096];
+    while (true) {
+      ssize_t len = HANDLE_EINTR(read(fd, buf, sizeof(buf)));
+      if (len <= 0 || !handleEvents(fd, buf, len)) break;
+    }
+  }
+
+  // returns false if fd was closed after a fork
+  bool handleEvents(int fd, char *buf, ssize_t len) {
+    // (directory, key) of each change, an empty key if anything may have changed
+    std::set<std::pair<std::string, std::string>> changed;
+    bool lost = false;
+    {
+      std::unique_lock lk(lock);
+      if (fd != inotify_fd) return false;
+
+      for (char *ptr = buf; ptr < buf + len;) {
+        auto event = (const struct inotify_event *)ptr;
+        ptr += sizeof(struct inotify_event) + event->len;
+
+        // events were lost, an overflow isn't tied to a watch (wd is -1)
+        if (event->mask & IN_Q_OVERFLOW) {
+          values.clear();
+          lost = true;
+          continue;
+        }
+
+        auto it = watches.find(event->wd);
+        if (it == watches.end()) continue;
+        if (event->mask & (IN_DELETE_SELF | IN_IGNORED)) {
+          // directory is gone, drop everything
+          values.clear();
+          changed.insert({it->second, ""});
+          watches.erase(it);
+        } else if (event->len > 0) {
+          values.erase(it->second + "/" + event->name);
+          changed.insert({it->second, event->name});
+        }
+      }
+      ++seq;
+    }
+    cv.notify_all();
+    notifyListeners(changed, lost);
+    return true;
+  }
+
+  void notifyListeners(const std::set<std::pair<std::string, std::string>> &changed, bool lost) {
+    std::unique_lock listeners_lk(listeners_lock);
+    for (auto &[id, listener] : listeners) {
+      auto &[dir, f] = listener;
+      if (lost || changed.count({dir, ""})) {
+        f("");
+        continue;
+      }
+      for (auto it = changed.lower_bound({dir, ""}); it != changed.end() && it->first == dir; ++it) {
+        f(it->second);
+      }
+    }
+  }
+#endif
+
+  std::mutex lock;
+  std::condition_variable cv;
+  int inotify_fd = -1;
+  std::unordered_map<int, std::string> watches;  // watch descriptor -> directory
+  std::unordered_map<std::string, std::string> values;  // path -> value, empty if not set
+  uint64_t seq = 0;
+
+  std::mutex listeners_lock;
+  std::map<int, std::pair<std::string, std::function<void(const std::string &)>>> listeners;  // id -> (directory, f)
+  int last_listener_id = 0;
+};
+
 std::unordered_map<std::string, uint32_t> keys = {
     {"AccessToken", CLEAR_ON_MANAGER_START | DONT_LOG},
     {"AlwaysOnDM", PERSISTENT},
@@ -415,7 +636,7 @@ Params::~Params() {
   if (future.valid()) {
     future.wait();
   }
-  assert(queue.empty());
+  assert(pending.empty());
 }
 
 std::vector<std::string> Params::allKeys() const {
@@ -435,39 +656,55 @@ ParamKeyType Params::getKeyType(const std::string &key) {
 }
 
 int Params::put(const char* key, const char* value, size_t value_size) {
+  return putBatch({{key, std::string(value, value_size)}});
+}
+
+int Params::putBatch(const std::map<std::string, std::string> &values) {
   // Information about safely and atomically writing a file: https://lwn.net/Articles/457667/
   // 1) Create temp file
   // 2) Write data to temp file
   // 3) fsync() the temp file
   // 4) rename the temp file to the real name
   // 5) fsync() the containing directory
-  std::string tmp_path = params_path + "/.tmp_value_XXXXXX";
-  int tmp_fd = mkstemp((char*)tmp_path.c_str());
-  if (tmp_fd < 0) return -1;
+  // Each key is still replaced atomically, but the lock and the directory fsync are shared by the batch.
+  std::vector<std::pair<std::string, std::string>> tmp_files;  // (key, temp path)
+  int result = 0;
+  for (auto &[key, value] : values) {
+    std::string tmp_path = params_path + "/.tmp_value_XXXXXX";
+    int tmp_fd = mkstemp((char*)tmp_path.c_str());
+    if (tmp_fd < 0) {
+      result = -1;
+      break;
+    }
+    tmp_files.emplace_back(key, tmp_path);
 
-  int result = -1;
-  do {
     // Write value to temp.
-    ssize_t bytes_written = HANDLE_EINTR(write(tmp_fd, value, value_size));
-    if (bytes_written < 0 || (size_t)bytes_written != value_size) {
+    ssize_t bytes_written = HANDLE_EINTR(write(tmp_fd, value.data(), value.size()));
+    if (bytes_written < 0 || (size_t)bytes_written != value.size()) {
       result = -20;
-      break;
+    } else {
+      // fsync to force persist the changes.
+      result = fsync(tmp_fd);
     }
+    close(tmp_fd);
+    if (result != 0) break;
+  }
 
-    // fsync to force persist the changes.
-    if ((result = fsync(tmp_fd)) < 0) break;
-
+  if (result == 0) {
     FileLock file_lock(params_path + "/.lock");
 
-    // Move temp into place.
-    if ((result = rename(tmp_path.c_str(), getParamPath(key).c_str())) < 0) break;
+    // Move temps into place.
+    for (auto it = tmp_files.begin(); it != tmp_files.end(); it = tmp_files.erase(it)) {
+      if ((result = rename(it->second.c_str(), getParamPath(it->first).c_str())) < 0) break;
+      ParamsCache::instance().invalidate(getParamPath(), it->first);
+    }
 
     // fsync parent directory
-    result = fsync_dir(getParamPath());
-  } while (false);
+    int fsync_result = fsync_dir(getParamPath());
+    if (result == 0) result = fsync_result;
+  }
 
-  close(tmp_fd);
-  if (result != 0) {
+  for (auto &[key, tmp_path] : tmp_files) {
     ::unlink(tmp_path.c_str());
   }
   return result;
@@ -479,12 +716,14 @@ int Params::remove(const std::string &key) {
   if (result != 0) {
     return result;
   }
+  ParamsCache::instance().invalidate(getParamPath(), key);
   return fsync_dir(getParamPath());
 }
 
 std::string Params::get(const std::string &key, bool block) {
+  ParamsCache &cache = ParamsCache::instance();
   if (!block) {
-    return util::read_file(getParamPath(key));
+    return cache.get(getParamPath(), key);
   } else {
     // blocking read until successful
     params_do_exit = 0;
@@ -493,10 +732,12 @@ std::string Params::get(const std::string &key, bool block) {
 
     std::string value;
     while (!params_do_exit) {
-      if (value = util::read_file(getParamPath(key)); !value.empty()) {
+      uint64_t seq = cache.sequence();
+      if (value = cache.get(getParamPath(), key); !value.empty()) {
         break;
       }
-      util::sleep_for(100);  // 0.1 s
+      // woken up by the inotify watch, the timeout only bounds how long a signal goes unnoticed
+      cache.waitForChange(seq, 100);
     }
 
     std::signal(SIGINT, prev_handler_sigint);
@@ -528,22 +769,65 @@ void Params::clearAll(ParamKeyType key_type) {
     closedir(d);
   }
 
+  ParamsCache::instance().invalidateAll();
   fsync_dir(getParamPath());
 }
 
 void Params::putNonBlocking(const std::string &key, const std::string &val) {
-   queue.push(std::make_pair(key, val));
+  queueWrite(key, val);
+}
+
+void Params::removeNonBlocking(const std::string &key) {
+  queueWrite(key, std::nullopt);
+}
+
+int Params::watchChanges(std::function<void(const std::string &key)> f) {
+  return ParamsCache::instance().addListener(getParamPath(), f);
+}
+
+void Params::unwatchChanges(int id) {
+  ParamsCache::instance().removeListener(id);
+}
+
+void params_cache_inject_overflow() {
+  ParamsCache::instance().injectOverflow();
+}
+
+void Params::queueWrite(const std::string &key, const std::optional<std::string> &val) {
+  std::lock_guard lk(pending_lock);
+  // only the latest value of a key is written
+  pending[key] = val;
   // start thread on demand
-  if (!future.valid() || future.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready) {
+  if (!writer_running) {
+    writer_running = true;
     future = std::async(std::launch::async, &Params::asyncWriteThread, this);
   }
 }
 
 void Params::asyncWriteThread() {
-  // TODO: write the latest one if a key has multiple values in the queue.
-  std::pair<std::string, std::string> p;
-  while (queue.try_pop(p, 0)) {
-    // Params::put is Thread-Safe
-    put(p.first, p.second);
+  std::map<std::string, std::optional<std::string>> batch;
+  while (true) {
+    {
+      std::lock_guard lk(pending_lock);
+      if (pending.empty()) {
+        writer_running = false;
+        return;
+      }
+      batch.swap(pending);
+    }
+    // everything queued while the previous batch was written goes out together,
+    // a key is either written or removed, whichever was queued last
+    std::map<std::string, std::string> values;
+    for (const auto &[key, val] : batch) {
+      if (val) {
+        values[key] = *val;
+      } else {
+        remove(key);
+      }
+    }
+    if (!values.empty()) {
+      putBatch(values);
+    }
+    batch.clear();
   }
 }
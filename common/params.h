@@ -1,14 +1,15 @@
 #pragma once
 
+#include <functional>
 #include <future>
 #include <map>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <tuple>
 #include <utility>
 #include <vector>
 
-#include "common/queue.h"
-
 enum ParamKeyType {
   PERSISTENT = 0x02,
   CLEAR_ON_MANAGER_START = 0x04,
@@ -36,6 +37,8 @@ public:
 
   // Delete a value
   int remove(const std::string &key);
+  // queued behind the nonblocking writes, so an earlier putNonBlocking of key can't bring it back
+  void removeNonBlocking(const std::string &key);
   void clearAll(ParamKeyType type);
 
   // helpers for reading values
@@ -53,18 +56,31 @@ public:
   inline int putBool(const std::string &key, bool val) {
     return put(key.c_str(), val ? "1" : "0", 1);
   }
+  // write several keys under one lock and one directory fsync, each key is still replaced atomically
+  int putBatch(const std::map<std::string, std::string> &values);
   void putNonBlocking(const std::string &key, const std::string &val);
   inline void putBoolNonBlocking(const std::string &key, bool val) {
     putNonBlocking(key, val ? "1" : "0");
   }
 
+  // calls f on the params watcher thread with the key of each param changed by any process, or an
+  // empty key when changes were missed. f must not (un)watch. Returns 0 if changes can't be watched.
+  int watchChanges(std::function<void(const std::string &key)> f);
+  void unwatchChanges(int id);
+
 private:
+  void queueWrite(const std::string &key, const std::optional<std::string> &val);
   void asyncWriteThread();
 
   std::string params_path;
   std::string params_prefix;
 
-  // for nonblocking write
+  // for nonblocking write, coalesced to the latest value per key, nullopt to remove it
   std::future<void> future;
-  SafeQueue<std::pair<std::string, std::string>> queue;
+  std::mutex pending_lock;
+  std::map<std::string, std::optional<std::string>> pending;
+  bool writer_running = false;
 };
+
+// test hook: the params cache handles an inotify queue overflow, as if changes were missed
+void params_cache_inject_overflow();
@@ -1,23 +1,103 @@
 #include "common/ratekeeper.h"
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
 
 #include "common/swaglog.h"
 #include "common/timing.h"
 #include "common/util.h"
 
-RateKeeper::RateKeeper(const std::string &name, float rate, float print_delay_threshold)
+const std::string stats_dir = "/dev/shm";
+const std::string stats_fn_prefix = "rk_";  // + <pid>_<n>_<name>
+
+static std::atomic<int> stats_count = 0;
+
+static int bucket(uint64_t us) {
+  int b = us == 0 ? 0 : 64 - __builtin_clzll(us);
+  return std::min(b, RateKeeperStats::BUCKETS - 1);
+}
+
+// only the loop writes, a plain store is enough
+static inline void add(std::atomic<uint64_t> &counter, uint64_t n = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+static inline void update_max(std::atomic<uint64_t> &counter, uint64_t v) {
+  if (v > counter.load(std::memory_order_relaxed)) {
+    counter.store(v, std::memory_order_relaxed);
+  }
+}
+
+static RateKeeperStats *map_stats(const std::string &path) {
+  int fd = HANDLE_EINTR(open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+  if (fd < 0) return nullptr;
+
+  void *p = MAP_FAILED;
+  if (ftruncate(fd, sizeof(RateKeeperStats)) == 0) {
+    p = mmap(nullptr, sizeof(RateKeeperStats), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (p == MAP_FAILED) {
+    unlink(path.c_str());
+    return nullptr;
+  }
+  return static_cast<RateKeeperStats *>(p);
+}
+
+RateKeeper::RateKeeper(const std::string &name, float rate, float print_delay_threshold, bool absolute_sleep)
     : name(name),
-      print_delay_threshold(std::max(0.f, print_delay_threshold)) {
+      print_delay_threshold(std::max(0.f, print_delay_threshold)),
+      absolute_sleep(absolute_sleep) {
   interval = 1 / rate;
-  last_monitor_time = seconds_since_boot();
+  last_monitor_time = wake_time = seconds_since_boot();
   next_frame_time = last_monitor_time + interval;
+
+  std::string fn_name = name;
+  std::replace(fn_name.begin(), fn_name.end(), '/', '_');
+  stats_path = stats_dir + "/" + stats_fn_prefix + std::to_string(getpid()) + "_" + std::to_string(stats_count++) + "_" + fn_name;
+  stats_ = map_stats(stats_path);
+  if (!stats_) {
+    LOGW("%s: no stats page at %s", name.c_str(), stats_path.c_str());
+    local_stats = std::make_unique<RateKeeperStats>();
+    stats_ = local_stats.get();
+  }
+  stats_->pid = getpid();
+  strncpy(stats_->name, name.c_str(), sizeof(stats_->name) - 1);
+  stats_->rate = rate;
+  std::atomic_thread_fence(std::memory_order_release);
+  stats_->version = RateKeeperStats::VERSION;
+}
+
+RateKeeper::~RateKeeper() {
+  if (!local_stats) {
+    munmap(stats_, sizeof(RateKeeperStats));
+    unlink(stats_path.c_str());
+  }
 }
 
 bool RateKeeper::keepTime() {
   bool lagged = monitorTime();
   if (remaining_ > 0) {
-    util::sleep_for(remaining_ * 1000);
+#ifndef __APPLE__
+    if (absolute_sleep) {
+      struct timespec ts;
+      ts.tv_sec = (time_t)deadline;
+      ts.tv_nsec = (long)((deadline - ts.tv_sec) * 1e9);
+      // like sleep_for, a signal ends the sleep early
+      clock_nanosleep(CLOCK_BOOTTIME, TIMER_ABSTIME, &ts, nullptr);
+    } else
+#endif
+    {
+      util::sleep_for(remaining_ * 1000);
+    }
+    wake_time = seconds_since_boot();
   }
   return lagged;
 }
@@ -25,7 +105,10 @@ bool RateKeeper::keepTime() {
 bool RateKeeper::monitorTime() {
   ++frame_;
   last_monitor_time = seconds_since_boot();
-  remaining_ = next_frame_time - last_monitor_time;
+  deadline = next_frame_time;
+  remaining_ = deadline - last_monitor_time;
+  record(last_monitor_time - wake_time, -remaining_);
+  wake_time = last_monitor_time;
 
   bool lagged = remaining_ < 0;
   if (lagged) {
@@ -38,3 +121,68 @@ bool RateKeeper::monitorTime() {
   }
   return lagged;
 }
+
+void RateKeeper::record(double duration, double lateness) {
+  const uint64_t duration_us = std::max(0.0, duration * 1e6);
+  const uint64_t lateness_us = std::max(0.0, lateness * 1e6);
+  add(stats_->frames);
+  add(stats_->lagged, lateness > 0);
+  add(stats_->duration_us[bucket(duration_us)]);
+  add(stats_->lateness_us[bucket(lateness_us)]);
+  update_max(stats_->max_duration_us, duration_us);
+  update_max(stats_->max_lateness_us, lateness_us);
+}
+
+static bool read_stats(const std::string &path, RateKeeperTimings &t) {
+  int fd = HANDLE_EINTR(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd < 0) return false;
+  void *p = mmap(nullptr, sizeof(RateKeeperStats), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return false;
+
+  // a page of another version, or one still being set up
+  const RateKeeperStats *s = static_cast<const RateKeeperStats *>(p);
+  const bool ok = s->version == RateKeeperStats::VERSION;
+  if (ok) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    t.name = std::string(s->name, strnlen(s->name, sizeof(s->name)));
+    t.pid = s->pid;
+    t.rate = s->rate;
+    t.frames = s->frames.load(std::memory_order_relaxed);
+    t.lagged = s->lagged.load(std::memory_order_relaxed);
+    t.max_duration_us = s->max_duration_us.load(std::memory_order_relaxed);
+    t.max_lateness_us = s->max_lateness_us.load(std::memory_order_relaxed);
+    for (int i = 0; i < RateKeeperStats::BUCKETS; i++) {
+      t.duration_us[i] = s->duration_us[i].load(std::memory_order_relaxed);
+      t.lateness_us[i] = s->lateness_us[i].load(std::memory_order_relaxed);
+    }
+  }
+  munmap(p, sizeof(RateKeeperStats));
+  return ok;
+}
+
+std::vector<RateKeeperTimings> ratekeeper_timings() {
+  std::vector<RateKeeperTimings> timings;
+  DIR *d = opendir(stats_dir.c_str());
+  if (!d) return timings;
+
+  struct dirent *de = NULL;
+  while ((de = readdir(d))) {
+    if (strncmp(de->d_name, stats_fn_prefix.c_str(), stats_fn_prefix.size()) != 0) continue;
+
+    const std::string path = stats_dir + "/" + de->d_name;
+    const int pid = atoi(de->d_name + stats_fn_prefix.size());
+    if (pid <= 0) continue;
+    if (kill(pid, 0) != 0 && errno == ESRCH) {
+      unlink(path.c_str());
+      continue;
+    }
+
+    RateKeeperTimings t = {};
+    if (read_stats(path, t)) {
+      timings.push_back(std::move(t));
+    }
+  }
+  closedir(d);
+  return timings;
+}
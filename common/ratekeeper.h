@@ -1,23 +1,76 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
+
+// Timing histograms of a RateKeeper loop, shared with other processes through
+// /dev/shm/rk_<pid>_<n>_<name>, n counts the RateKeepers of the process so loops with the
+// same name don't share a page. Only the loop writes, so readers see each counter whole without locks.
+struct RateKeeperStats {
+  static constexpr uint32_t VERSION = 1;
+  // log2 buckets in us, bucket i counts [2^(i-1), 2^i) and the last one everything above
+  static constexpr int BUCKETS = 24;
+
+  uint32_t version;
+  int32_t pid;
+  char name[64];
+  float rate;
+
+  std::atomic<uint64_t> frames;
+  std::atomic<uint64_t> lagged;
+  std::atomic<uint64_t> max_duration_us;
+  std::atomic<uint64_t> max_lateness_us;
+  // time from waking up to the next keepTime/monitorTime
+  std::atomic<uint64_t> duration_us[BUCKETS];
+  // how far past its deadline that was, 0 if on time
+  std::atomic<uint64_t> lateness_us[BUCKETS];
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+struct RateKeeperTimings {
+  std::string name;
+  int pid;
+  float rate;
+  uint64_t frames, lagged;
+  uint64_t max_duration_us, max_lateness_us;
+  std::array<uint64_t, RateKeeperStats::BUCKETS> duration_us, lateness_us;
+};
+
+// the stats of all RateKeepers running, pages left by processes that exited are removed
+std::vector<RateKeeperTimings> ratekeeper_timings();
 
 class RateKeeper {
 public:
-  RateKeeper(const std::string &name, float rate, float print_delay_threshold = 0);
-  ~RateKeeper() {}
+  // absolute_sleep sleeps with clock_nanosleep until the frame deadline, instead of for the
+  // remaining time rounded down to a millisecond
+  RateKeeper(const std::string &name, float rate, float print_delay_threshold = 0, bool absolute_sleep = false);
+  RateKeeper(const RateKeeper &) = delete;
+  ~RateKeeper();
   bool keepTime();
   bool monitorTime();
   inline uint64_t frame() const { return frame_; }
   inline double remaining() const { return remaining_; }
+  inline const RateKeeperStats &stats() const { return *stats_; }
 
 private:
+  void record(double duration, double lateness);
+
   double interval;
   double next_frame_time;
   double last_monitor_time;
+  double deadline = 0;
+  double wake_time = 0;
   double remaining_ = 0;
   float print_delay_threshold = 0;
+  bool absolute_sleep = false;
   uint64_t frame_ = 0;
   std::string name;
+
+  std::string stats_path;
+  RateKeeperStats *stats_ = nullptr;
+  std::unique_ptr<RateKeeperStats> local_stats;
 };
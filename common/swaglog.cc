@@ -4,27 +4,60 @@
 
 #include "common/swaglog.h"
 
+#include <pthread.h>
+
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstring>
 #include <limits>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <zmq.h>
 #include <stdarg.h>
 #include "third_party/json11/json11.hpp"
+#include "common/util.h"
 #include "common/version.h"
 #include "system/hardware/hw.h"
 
+bool LOG_TIMESTAMPS = getenv("LOG_TIMESTAMPS");
+uint32_t NO_FRAME_ID = std::numeric_limits<uint32_t>::max();
+
+// One log call, captured on the caller's thread. filename and func are string literals from the
+// LOG macros, so only the formatted message needs to be copied.
+struct LogRecord {
+  int levelnum;
+  const char *filename;
+  int lineno;
+  const char *func;
+  double created;
+  bool timestamp;       // LOGT event
+  uint64_t time_nanos;  // LOGT only
+  uint32_t frame_id;    // LOGT only
+  char *long_msg;       // heap copy for messages that don't fit in msg
+  char msg[256];
+
+  const char *text() const { return long_msg ? long_msg : msg; }
+};
+
+// Single-producer single-consumer ring owned by one logging thread
+struct LogRing {
+  static constexpr uint64_t SIZE = 128;
+  LogRecord records[SIZE];
+  std::atomic<uint64_t> head = 0;  // next slot written by the owner thread
+  std::atomic<uint64_t> tail = 0;  // next slot read by the swaglog thread
+};
+
 class SwaglogState {
 public:
   SwaglogState() {
-    zctx = zmq_ctx_new();
-    sock = zmq_socket(zctx, ZMQ_PUSH);
-
-    // Timeout on shutdown for messages to be received by the logging process
-    int timeout = 100;
-    zmq_setsockopt(sock, ZMQ_LINGER, &timeout, sizeof(timeout));
-    zmq_connect(sock, Path::swaglog_ipc().c_str());
+    connect();
 
     print_level = CLOUDLOG_WARNING;
     if (const char* print_lvl = getenv("LOGPRINT")) {
@@ -56,97 +89,279 @@ public:
     ctx_j["version"] = COMMA_VERSION;
     ctx_j["dirty"] = !getenv("CLEAN");
     ctx_j["device"] = Hardware::get_name();
+
+    sender = new std::thread(&SwaglogState::senderThread, this);
+
+    // the sender thread doesn't survive fork, start a new one in the child
+    pthread_atfork([]() { instance().send_lock.lock(); instance().rings_lock.lock(); instance().wake_lock.lock(); },
+                   []() { instance().wake_lock.unlock(); instance().rings_lock.unlock(); instance().send_lock.unlock(); },
+                   []() {
+                     SwaglogState &s = instance();
+                     s.wake_lock.unlock();
+                     s.rings_lock.unlock();
+                     s.send_lock.unlock();
+                     // what is left in the rings is the parent's to send, threads start new ones
+                     s.rings.clear();
+                     s.generation++;
+                     s.dropped = 0;
+                     // a zmq context can't be used across fork, the parent's is left alone
+                     s.connect();
+                     s.sleeping = false;
+                     s.sender = new std::thread(&SwaglogState::senderThread, &s);  // the old handle is leaked on purpose
+                   });
   }
 
   ~SwaglogState() {
+    do_exit = true;
+    wake();
+    if (sender && sender->joinable()) sender->join();
+    delete sender;
     zmq_close(sock);
     zmq_ctx_destroy(zctx);
   }
 
-  void log(int levelnum, const char* filename, int lineno, const char* func, const char* msg, const std::string& log_s) {
-    std::lock_guard lk(lock);
-    if (levelnum >= print_level) {
-      printf("%s: %s\n", filename, msg);
+  static SwaglogState &instance() {
+    static SwaglogState s;
+    return s;
+  }
+
+  // Called on the logging thread. Never blocks: if the ring is full the record is counted and dropped.
+  // The sender thread isn't woken for records the caller flushes itself.
+  template <typename Fill>
+  bool push(Fill fill, bool wake_sender = true) {
+    LogRing *ring = threadRing();
+    const uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= LogRing::SIZE) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    fill(ring->records[head % LogRing::SIZE]);
+    ring->head.store(head + 1, std::memory_order_release);
+
+    // pairs with the fence in senderThread: either we see it sleeping or it sees the new record
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (wake_sender && sleeping.load(std::memory_order_relaxed) && sleeping.exchange(false)) {
+      wake();
+    }
+    return true;
+  }
+
+  // sends everything logged so far, on the calling thread
+  void flush() {
+    std::vector<std::shared_ptr<LogRing>> local_rings;
+    {
+      std::lock_guard lk(rings_lock);
+      local_rings = rings;
+    }
+    std::string log_s;
+    drain(local_rings, log_s);
+  }
+
+  int print_level;
+
+private:
+  void connect() {
+    zctx = zmq_ctx_new();
+    sock = zmq_socket(zctx, ZMQ_PUSH);
+
+    // Timeout on shutdown for messages to be received by the logging process
+    int timeout = 100;
+    zmq_setsockopt(sock, ZMQ_LINGER, &timeout, sizeof(timeout));
+    zmq_connect(sock, Path::swaglog_ipc().c_str());
+  }
+
+  LogRing *threadRing() {
+    // the registry keeps the ring alive until it is drained after the thread exits
+    thread_local std::shared_ptr<LogRing> ring;
+    thread_local uint64_t ring_generation = 0;
+    if (!ring || ring_generation != generation) {
+      ring_generation = generation;
+      ring = std::make_shared<LogRing>();
+      std::lock_guard lk(rings_lock);
+      rings.push_back(ring);
+    }
+    return ring.get();
+  }
+
+  void wake() {
+    std::lock_guard lk(wake_lock);
+    wake_cv.notify_one();
+  }
+
+  void senderThread() {
+    util::set_thread_name("swaglog");
+    std::vector<std::shared_ptr<LogRing>> local_rings;
+    std::string log_s;
+    uint64_t reported_dropped = 0;
+
+    while (true) {
+      {
+        std::lock_guard lk(rings_lock);
+        // drop rings of exited threads once they are drained
+        rings.erase(std::remove_if(rings.begin(), rings.end(), [](auto &r) {
+          return r.use_count() == 1 && r->head == r->tail;
+        }), rings.end());
+        local_rings = rings;
+      }
+
+      bool sent = drain(local_rings, log_s);
+
+      // counted for the whole process, rings of exited threads come and go
+      const uint64_t dropped = this->dropped.load(std::memory_order_relaxed);
+      if (dropped != reported_dropped) {
+        LogRecord r = {.levelnum = CLOUDLOG_WARNING, .filename = __FILE__, .lineno = __LINE__, .func = __func__,
+                       .created = seconds_since_epoch()};
+        snprintf(r.msg, sizeof(r.msg), "swaglog: %" PRIu64 " messages dropped", dropped - reported_dropped);
+        std::lock_guard lk(send_lock);
+        send(r, log_s);
+        reported_dropped = dropped;
+      }
+
+      if (sent) continue;
+      if (do_exit) break;
+
+      // nothing to send, sleep until a logging thread wakes us up
+      std::unique_lock lk(wake_lock);
+      sleeping = true;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      bool pending = std::any_of(local_rings.begin(), local_rings.end(), [](auto &r) { return r->head != r->tail; });
+      if (!pending) {
+        wake_cv.wait_for(lk, std::chrono::milliseconds(100));
+      }
+      sleeping = false;
     }
+  }
+
+  // Sends the pending records of the rings, returns false if there were none. send_lock makes
+  // whoever holds it the only reader of the rings and the only user of the socket.
+  bool drain(const std::vector<std::shared_ptr<LogRing>> &local_rings, std::string &log_s) {
+    std::lock_guard lk(send_lock);
+    bool sent = false;
+    for (auto &ring : local_rings) {
+      uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+      const uint64_t head = ring->head.load(std::memory_order_acquire);
+      for (; tail != head; ++tail) {
+        LogRecord &r = ring->records[tail % LogRing::SIZE];
+        send(r, log_s);
+        free(r.long_msg);
+        r.long_msg = nullptr;
+        ring->tail.store(tail + 1, std::memory_order_release);
+        sent = true;
+      }
+    }
+    return sent;
+  }
+
+  void send(const LogRecord &r, std::string &log_s) {
+    json11::Json::object log_j = json11::Json::object {
+      {"ctx", ctx_j},
+      {"levelnum", r.levelnum},
+      {"filename", r.filename},
+      {"lineno", r.lineno},
+      {"funcname", r.func},
+      {"created", r.created}
+    };
+    if (!r.timestamp) {
+      log_j["msg"] = r.text();
+    } else {
+      json11::Json::object tspt_j = json11::Json::object{
+        {"event", r.text()},
+        {"time", std::to_string(r.time_nanos)}
+      };
+      if (r.frame_id < NO_FRAME_ID) {
+        tspt_j["frame_id"] = std::to_string(r.frame_id);
+      }
+      log_j["msg"] = json11::Json::object{{"timestamp", tspt_j}};
+    }
+
+    log_s.clear();
+    log_s += (char)r.levelnum;
+    ((json11::Json)log_j).dump(log_s);
     zmq_send(sock, log_s.data(), log_s.length(), ZMQ_NOBLOCK);
   }
 
-  std::mutex lock;
   void* zctx = nullptr;
   void* sock = nullptr;
-  int print_level;
   json11::Json::object ctx_j;
-};
 
-bool LOG_TIMESTAMPS = getenv("LOG_TIMESTAMPS");
-uint32_t NO_FRAME_ID = std::numeric_limits<uint32_t>::max();
+  std::mutex send_lock;  // taken before rings_lock and wake_lock
+  std::thread *sender = nullptr;
+  std::atomic<bool> do_exit = false;
+  std::atomic<bool> sleeping = false;
+  std::mutex wake_lock;
+  std::condition_variable wake_cv;
+
+  std::mutex rings_lock;
+  std::vector<std::shared_ptr<LogRing>> rings;
+  std::atomic<uint64_t> generation = 0;  // bumped in a forked child, threads then start new rings
+  std::atomic<uint64_t> dropped = 0;
+};
 
 static void cloudlog_common(int levelnum, const char* filename, int lineno, const char* func,
-                            char* msg_buf, const json11::Json::object &msg_j={}) {
-  static SwaglogState s;
-
-  json11::Json::object log_j = json11::Json::object {
-    {"ctx", s.ctx_j},
-    {"levelnum", levelnum},
-    {"filename", filename},
-    {"lineno", lineno},
-    {"funcname", func},
-    {"created", seconds_since_epoch()}
+                            bool timestamp, uint32_t frame_id, const char* fmt, va_list args) {
+  SwaglogState &s = SwaglogState::instance();
+  const uint64_t time_nanos = timestamp ? nanos_since_boot() : 0;
+  const double created = seconds_since_epoch();
+
+  auto fill = [&](LogRecord &r) {
+    r.levelnum = levelnum;
+    r.filename = filename;
+    r.lineno = lineno;
+    r.func = func;
+    r.created = created;
+    r.timestamp = timestamp;
+    r.time_nanos = time_nanos;
+    r.frame_id = frame_id;
+    r.long_msg = nullptr;
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+    int len = vsnprintf(r.msg, sizeof(r.msg), fmt, args_copy);
+    va_end(args_copy);
+    if (len >= (int)sizeof(r.msg) && vasprintf(&r.long_msg, fmt, args) < 0) {
+      r.long_msg = nullptr;
+    }
+
+    if (levelnum >= s.print_level) {
+      printf("%s: %s\n", filename, r.text());
+    }
   };
-  if (msg_j.empty()) {
-    log_j["msg"] = msg_buf;
-  } else {
-    log_j["msg"] = msg_j;
-  }
 
-  std::string log_s;
-  log_s += (char)levelnum;
-  ((json11::Json)log_j).dump(log_s);
-  s.log(levelnum, filename, lineno, func, msg_buf, log_s);
+  // Errors are sent before returning, the process may be about to abort and the sender thread
+  // wouldn't get to them. Flushing first also makes room for them in a full ring.
+  const bool sync = levelnum >= CLOUDLOG_ERROR;
+  if (sync) s.flush();
+  bool pushed = s.push(fill, !sync);
+  if (sync) s.flush();
 
-  free(msg_buf);
+  if (!pushed && levelnum >= s.print_level) {
+    char msg[256];
+    vsnprintf(msg, sizeof(msg), fmt, args);
+    printf("%s: %s\n", filename, msg);
+  }
 }
 
 void cloudlog_e(int levelnum, const char* filename, int lineno, const char* func,
                 const char* fmt, ...) {
   va_list args;
   va_start(args, fmt);
-  char* msg_buf = nullptr;
-  int ret = vasprintf(&msg_buf, fmt, args);
+  cloudlog_common(levelnum, filename, lineno, func, false, NO_FRAME_ID, fmt, args);
   va_end(args);
-  if (ret <= 0 || !msg_buf) return;
-  cloudlog_common(levelnum, filename, lineno, func, msg_buf);
-}
-
-void cloudlog_t_common(int levelnum, const char* filename, int lineno, const char* func,
-                       uint32_t frame_id, const char* fmt, va_list args) {
-  if (!LOG_TIMESTAMPS) return;
-  char* msg_buf = nullptr;
-  int ret = vasprintf(&msg_buf, fmt, args);
-  if (ret <= 0 || !msg_buf) return;
-  json11::Json::object tspt_j = json11::Json::object{
-    {"event", msg_buf},
-    {"time", std::to_string(nanos_since_boot())}
-  };
-  if (frame_id < NO_FRAME_ID) {
-    tspt_j["frame_id"] = std::to_string(frame_id);
-  }
-  tspt_j = json11::Json::object{{"timestamp", tspt_j}};
-  cloudlog_common(levelnum, filename, lineno, func, msg_buf, tspt_j);
 }
 
-
 void cloudlog_te(int levelnum, const char* filename, int lineno, const char* func,
                  const char* fmt, ...) {
+  if (!LOG_TIMESTAMPS) return;
   va_list args;
   va_start(args, fmt);
-  cloudlog_t_common(levelnum, filename, lineno, func, NO_FRAME_ID, fmt, args);
+  cloudlog_common(levelnum, filename, lineno, func, true, NO_FRAME_ID, fmt, args);
   va_end(args);
 }
 void cloudlog_te(int levelnum, const char* filename, int lineno, const char* func,
                  uint32_t frame_id, const char* fmt, ...) {
+  if (!LOG_TIMESTAMPS) return;
   va_list args;
   va_start(args, fmt);
-  cloudlog_t_common(levelnum, filename, lineno, func, frame_id, fmt, args);
+  cloudlog_common(levelnum, filename, lineno, func, true, frame_id, fmt, args);
   va_end(args);
 }
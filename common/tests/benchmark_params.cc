@@ -0,0 +1,83 @@
+// Measures Params::get throughput with the inotify-invalidated cache against
+// a plain file read per call (the uncached behaviour), and a burst of 100 puts
+// written one by one against the coalescing putNonBlocking path.
+//
+// usage: benchmark_params [iterations]
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "common/params.h"
+#include "common/timing.h"
+#include "common/util.h"
+
+int main(int argc, char *argv[]) {
+  const int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+  const std::string params_path = "/tmp/benchmark_params";
+  system(("rm -rf " + params_path).c_str());
+
+  Params params(params_path);
+  const std::vector<std::string> keys = {"DongleId", "IsMetric", "LanguageSetting", "RecordFront", "GitBranch"};
+  for (const auto &k : keys) {
+    params.put(k, "1");
+  }
+
+  size_t checksum = 0;
+  double t = millis_since_boot();
+  for (int i = 0; i < iterations; ++i) {
+    checksum += util::read_file(params.getParamPath(keys[i % keys.size()])).size();
+  }
+  const double uncached_ms = millis_since_boot() - t;
+
+  t = millis_since_boot();
+  for (int i = 0; i < iterations; ++i) {
+    checksum += params.get(keys[i % keys.size()]).size();
+  }
+  const double cached_ms = millis_since_boot() - t;
+
+  // a write from another Params instance must be visible right away
+  Params other(params_path);
+  other.put("IsMetric", "0");
+  if (params.get("IsMetric") != "0") {
+    printf("stale value after put\n");
+    return 1;
+  }
+
+  printf("uncached: %10.0f gets/s\n", iterations / (uncached_ms / 1000.0));
+  printf("cached:   %10.0f gets/s\n", iterations / (cached_ms / 1000.0));
+  printf("(checksum %zu)\n", checksum);
+
+  // a burst of toggles, like the UI produces, over a handful of keys
+  const int puts = 100;
+  t = millis_since_boot();
+  for (int i = 0; i < puts; ++i) {
+    params.put(keys[i % keys.size()], std::to_string(i));
+  }
+  const double put_ms = millis_since_boot() - t;
+
+  double put_nonblocking_ms;
+  {
+    Params async_params(params_path);
+    t = millis_since_boot();
+    for (int i = 0; i < puts; ++i) {
+      async_params.putNonBlocking(keys[i % keys.size()], std::to_string(i + puts));
+    }
+    // the destructor waits for the writer thread to finish
+  }
+  put_nonblocking_ms = millis_since_boot() - t;
+
+  for (int i = puts - keys.size(); i < puts; ++i) {
+    if (params.get(keys[i % keys.size()]) != std::to_string(i + puts)) {
+      printf("coalesced write lost the latest value of %s\n", keys[i % keys.size()].c_str());
+      return 1;
+    }
+  }
+
+  printf("%d puts:              %8.2f ms\n", puts, put_ms);
+  printf("%d putNonBlocking:    %8.2f ms (until persisted)\n", puts, put_nonblocking_ms);
+
+  system(("rm -rf " + params_path).c_str());
+  return 0;
+}
@@ -0,0 +1,50 @@
+// Measures the caller-side cost of a swaglog call. Records are formatted into
+// the calling thread's ring and shipped by the swaglog thread, so this is the
+// time a hot loop (e.g. LOGT in pandad's send loop) spends logging.
+//
+// usage: benchmark_swaglog [calls per thread] [threads]
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "common/swaglog.h"
+#include "common/timing.h"
+#include "common/util.h"
+
+int main(int argc, char *argv[]) {
+  const int calls = argc > 1 ? atoi(argv[1]) : 100;
+  const int threads = argc > 2 ? atoi(argv[2]) : 4;
+
+  // warm up: creates the swaglog state and this thread's ring
+  LOGD("swaglog benchmark start");
+  util::sleep_for(10);
+
+  auto run = [&](int id, double *ns_per_call) {
+    const uint64_t start = nanos_since_boot();
+    for (int i = 0; i < calls; ++i) {
+      LOGD("benchmark thread %d call %d value %f", id, i, i * 0.5);
+    }
+    *ns_per_call = double(nanos_since_boot() - start) / calls;
+  };
+
+  double single_ns;
+  run(0, &single_ns);
+  printf("1 thread:   %8.1f ns/call\n", single_ns);
+
+  // let the swaglog thread drain the ring before the contended run
+  util::sleep_for(100);
+
+  std::vector<double> results(threads);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back(run, i + 1, &results[i]);
+  }
+  for (auto &t : workers) t.join();
+
+  double total = 0;
+  for (double r : results) total += r;
+  printf("%d threads:  %8.1f ns/call\n", threads, total / threads);
+  return 0;
+}
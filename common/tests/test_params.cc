@@ -0,0 +1,90 @@
+#include "catch2/catch.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <mutex>
+#include <set>
+#include <string>
+
+#include "common/params.h"
+#include "common/util.h"
+
+static std::string tempParamsDir() {
+  char tmp_path[] = "/tmp/test_params_XXXXXX";
+  return mkdtemp(tmp_path);
+}
+
+TEST_CASE("ParamsCache rereads after an inotify overflow") {
+  Params params(tempParamsDir());
+  params.put("DongleId", "start");
+
+  // the watcher only hears about writes through the params directory, the link is outside of it
+  const std::string link_path = tempParamsDir() + "/DongleId";
+  REQUIRE(link(params.getParamPath("DongleId").c_str(), link_path.c_str()) == 0);
+
+  std::mutex lock;
+  std::set<std::string> changed;
+  int id = params.watchChanges([&](const std::string &key) {
+    std::lock_guard lk(lock);
+    changed.insert(key);
+  });
+  REQUIRE(id > 0);
+
+  // the watcher is done with the events of the put and the link before the value is cached
+  util::sleep_for(50);
+  REQUIRE(params.get("DongleId") == "start");
+  util::write_file(link_path.c_str(), "final", 5, O_WRONLY | O_TRUNC);
+  util::sleep_for(50);
+  REQUIRE(params.get("DongleId") == "start");
+
+  // the missed write shows up once the watcher learns that events were lost
+  params_cache_inject_overflow();
+  REQUIRE(params.get("DongleId") == "final");
+  params.unwatchChanges(id);
+  std::lock_guard lk(lock);
+  REQUIRE(changed.count("") == 1);
+}
+
+TEST_CASE("Params removeNonBlocking is ordered after queued writes") {
+  Params params(tempParamsDir());
+  params.put("DongleId", "old");
+  for (int i = 0; i < 100; ++i) {
+    params.putNonBlocking("DongleId", std::to_string(i));
+    params.removeNonBlocking("DongleId");
+  }
+  params.putNonBlocking("IsMetric", "1");
+  util::sleep_for(200);
+  REQUIRE(params.get("DongleId").empty());
+  REQUIRE(params.get("IsMetric") == "1");
+}
+
+TEST_CASE("Params watchChanges") {
+  const std::string dir = tempParamsDir();
+  Params params(dir);
+  std::mutex lock;
+  std::set<std::string> changed;
+  int id = params.watchChanges([&](const std::string &key) {
+    std::lock_guard lk(lock);
+    changed.insert(key);
+  });
+  REQUIRE(id != 0);
+
+  // changes by anyone are seen, written through another Params or around it
+  Params(dir).put("DongleId", "1");
+  util::write_file(params.getParamPath("IsMetric").c_str(), "1", 1, O_WRONLY | O_CREAT);
+  params.remove("DongleId");
+  util::sleep_for(100);
+  {
+    std::lock_guard lk(lock);
+    REQUIRE(changed.count("DongleId"));
+    REQUIRE(changed.count("IsMetric"));
+    changed.clear();
+  }
+
+  params.unwatchChanges(id);
+  params.put("DongleId", "2");
+  util::sleep_for(100);
+  std::lock_guard lk(lock);
+  REQUIRE(changed.empty());
+}
@@ -49,3 +49,10 @@ static inline uint64_t nanos_monotonic_raw() {
   clock_gettime(CLOCK_MONOTONIC_RAW, &t);
   return t.tv_sec * 1000000000ULL + t.tv_nsec;
 }
+
+// CPU time consumed by the calling thread
+static inline uint64_t nanos_thread_cpu() {
+  struct timespec t;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+  return t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
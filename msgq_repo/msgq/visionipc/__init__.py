@@ -1,5 +1,6 @@
-from msgq.visionipc.visionipc_pyx import VisionBuf, VisionIpcClient, VisionIpcServer, VisionStreamType, get_endpoint_name
+from msgq.visionipc.visionipc_pyx import VisionBuf, VisionBufBackend, VisionIpcClient, VisionIpcServer, VisionStreamType, get_endpoint_name
 assert VisionBuf
+assert VisionBufBackend
 assert VisionIpcClient
 assert VisionIpcServer
 assert VisionStreamType
@@ -2,7 +2,7 @@ import os
 import time
 import random
 import numpy as np
-from msgq.visionipc import VisionIpcServer, VisionIpcClient, VisionStreamType
+from msgq.visionipc import VisionBufBackend, VisionIpcServer, VisionIpcClient, VisionStreamType
 
 def zmq_sleep(t=1):
   if "ZMQ" in os.environ:
@@ -11,8 +11,8 @@ def zmq_sleep(t=1):
 
 class TestVisionIpc:
 
-  def setup_vipc(self, name, *stream_types, num_buffers=1, width=100, height=100, conflate=False):
-    self.server = VisionIpcServer(name)
+  def setup_vipc(self, name, *stream_types, num_buffers=1, width=100, height=100, conflate=False, backend=VisionBufBackend.VISIONBUF_BACKEND_DEVICE):
+    self.server = VisionIpcServer(name, backend)
     for stream_type in stream_types:
       self.server.create_buffers(stream_type, num_buffers, width, height)
     self.server.start_listener()
@@ -65,6 +65,21 @@ class TestVisionIpc:
     del self.client
     del self.server
 
+  def test_cpu_backend(self):
+    for backend in (VisionBufBackend.VISIONBUF_BACKEND_CPU, VisionBufBackend.VISIONBUF_BACKEND_CPU_HUGEPAGES):
+      self.setup_vipc("camerad", VisionStreamType.VISION_STREAM_ROAD, backend=backend)
+
+      buf = np.zeros(self.client.buffer_len, dtype=np.uint8)
+      buf.view('<i4')[0] = 1234
+      self.server.send(VisionStreamType.VISION_STREAM_ROAD, buf, frame_id=1337)
+
+      recv_buf = self.client.recv()
+      assert recv_buf is not None
+      assert recv_buf.data.view('<i4')[0] == 1234
+      assert self.client.frame_id == 1337
+      del self.client
+      del self.server
+
   def test_no_conflate(self):
     self.setup_vipc("camerad", VisionStreamType.VISION_STREAM_ROAD)
 
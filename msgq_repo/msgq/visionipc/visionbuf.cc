@@ -1,5 +1,21 @@
 #include "msgq/visionipc/visionbuf.h"
 
+#include <cassert>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/memfd.h>
+#include <sys/syscall.h>
+#endif
+
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
 void VisionBuf::init_yuv(size_t init_width, size_t init_height, size_t init_stride, size_t init_uv_offset){
   this->width = init_width;
   this->height = init_height;
@@ -11,10 +27,109 @@ void VisionBuf::init_yuv(size_t init_width, size_t init_height, size_t init_stri
 }
 
 
+static int memfd(size_t len, bool huge_pages) {
+#ifdef __linux__
+  int fd = syscall(SYS_memfd_create, "visionbuf", MFD_CLOEXEC | (huge_pages ? MFD_HUGETLB : 0));
+#else
+  assert(!huge_pages);
+  char path[] = "/tmp/visionbuf_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd >= 0) unlink(path);
+#endif
+  if (fd >= 0 && ftruncate(fd, len) != 0) {
+    close(fd);
+    fd = -1;
+  }
+  return fd;
+}
+
+void VisionBuf::allocate_cpu(size_t length) {
+  this->len = length;
+  this->mmap_len = this->len + VISIONBUF_META_SIZE;
+
+  if (backend == VISIONBUF_BACKEND_CPU_HUGEPAGES) {
+    this->mmap_len = (this->mmap_len + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    this->fd = memfd(this->mmap_len, true);
+    if (this->fd >= 0) {
+      this->addr = mmap(NULL, this->mmap_len, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+      if (this->addr != MAP_FAILED) {
+        init_meta((uint8_t*)this->addr + this->len);
+        return;
+      }
+      // no hugetlb pages reserved, use regular pages and ask for THP on mmap instead
+      close(this->fd);
+    }
+  }
+
+  this->fd = memfd(this->mmap_len, false);
+  assert(this->fd >= 0);
+  import_cpu();
+}
+
+void VisionBuf::import_cpu() {
+  assert(this->fd >= 0);
+  this->addr = mmap(NULL, this->mmap_len, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+  assert(this->addr != MAP_FAILED);
+#ifdef MADV_HUGEPAGE
+  if (backend == VISIONBUF_BACKEND_CPU_HUGEPAGES) {
+    madvise(this->addr, this->mmap_len, MADV_HUGEPAGE);
+  }
+#endif
+  init_meta((uint8_t*)this->addr + this->len);
+}
+
+int VisionBuf::free_cpu() {
+  int err = munmap(this->addr, this->mmap_len);
+  if (err != 0) return err;
+  return close(this->fd);
+}
+
+void VisionBuf::init_meta(uint8_t *meta) {
+  this->frame_id = (uint64_t *)meta;
+  this->leases = (std::atomic<int32_t> *)(meta + sizeof(uint64_t));
+}
+
 uint64_t VisionBuf::get_frame_id() {
-  return *frame_id;
+  return __atomic_load_n(frame_id, __ATOMIC_SEQ_CST);
 }
 
 void VisionBuf::set_frame_id(uint64_t id) {
-  *frame_id = id;
+  __atomic_store_n(frame_id, id, __ATOMIC_SEQ_CST);
+}
+
+int VisionBuf::acquire_lease() {
+  const int32_t pid = getpid();
+  for (int i = 0; i < VISIONBUF_LEASE_SLOTS; i++) {
+    int32_t free_slot = 0;
+    if (leases[i].compare_exchange_strong(free_slot, pid)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void VisionBuf::release_lease(int slot) {
+  assert(slot >= 0 && slot < VISIONBUF_LEASE_SLOTS);
+  leases[slot].store(0);
+}
+
+void VisionBuf::clear_leases() {
+  for (int i = 0; i < VISIONBUF_LEASE_SLOTS; i++) {
+    leases[i].store(0);
+  }
+}
+
+bool VisionBuf::leased() {
+  bool ret = false;
+  for (int i = 0; i < VISIONBUF_LEASE_SLOTS; i++) {
+    int32_t pid = leases[i].load();
+    if (pid == 0) continue;
+    if (kill(pid, 0) != 0 && errno == ESRCH) {
+      // the client crashed holding it
+      leases[i].compare_exchange_strong(pid, 0);
+      continue;
+    }
+    ret = true;
+  }
+  return ret;
 }
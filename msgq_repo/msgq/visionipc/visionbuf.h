@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+
 #include "msgq/visionipc/visionipc.h"
 
 #define CL_USE_DEPRECATED_OPENCL_1_2_APIS
@@ -12,12 +15,33 @@
 #define VISIONBUF_SYNC_FROM_DEVICE 0
 #define VISIONBUF_SYNC_TO_DEVICE 1
 
+// Shared metadata stored after the image data: frame id and the pids of the clients holding a lease
+#define VISIONBUF_LEASE_SLOTS 6
+#define VISIONBUF_META_SIZE (sizeof(uint64_t) + VISIONBUF_LEASE_SLOTS * sizeof(int32_t))
+// frame id of a buffer the server is writing to
+#define VISIONBUF_INVALID_FRAME_ID UINT64_MAX
+
+enum VisionBufBackend {
+  VISIONBUF_BACKEND_DEVICE,         // OpenCL-backed shm on PC, ion on device
+  VISIONBUF_BACKEND_CPU,            // plain memfd shared memory, no OpenCL/ion
+  VISIONBUF_BACKEND_CPU_HUGEPAGES,  // memfd on hugetlbfs, falls back to transparent huge pages
+};
+
 enum VisionStreamType {
   VISION_STREAM_ROAD,
   VISION_STREAM_DRIVER,
   VISION_STREAM_WIDE_ROAD,
 
   VISION_STREAM_MAP,
+
+  // downscaled companions of the camera streams, see VisionIpcServer::create_pyramid
+  VISION_STREAM_ROAD_HALF,
+  VISION_STREAM_DRIVER_HALF,
+  VISION_STREAM_WIDE_ROAD_HALF,
+  VISION_STREAM_ROAD_QUARTER,
+  VISION_STREAM_DRIVER_QUARTER,
+  VISION_STREAM_WIDE_ROAD_QUARTER,
+
   VISION_STREAM_MAX,
 };
 
@@ -27,6 +51,7 @@ class VisionBuf {
   size_t mmap_len = 0;
   void * addr = nullptr;
   uint64_t *frame_id;
+  std::atomic<int32_t> *leases;  // VISIONBUF_LEASE_SLOTS pids, 0 if free
   int fd = 0;
 
   size_t width = 0;
@@ -42,6 +67,7 @@ class VisionBuf {
   uint64_t server_id = 0;
   size_t idx = 0;
   VisionStreamType type;
+  VisionBufBackend backend = VISIONBUF_BACKEND_DEVICE;
 
   // OpenCL
   cl_mem buf_cl = nullptr;
@@ -59,4 +85,21 @@ class VisionBuf {
 
   void set_frame_id(uint64_t id);
   uint64_t get_frame_id();
+
+  // Leases are held by clients while they read a buffer, the server avoids handing out leased buffers.
+  // acquire_lease returns the slot to release, or -1 if all slots are taken.
+  int acquire_lease();
+  void release_lease(int slot);
+  void clear_leases();
+  // leases of clients that died without releasing them are dropped here
+  bool leased();
+
+ private:
+  void init_meta(uint8_t *meta);
+
+  // VISIONBUF_BACKEND_CPU*
+  bool is_cpu() const { return backend != VISIONBUF_BACKEND_DEVICE; }
+  void allocate_cpu(size_t len);
+  void import_cpu();
+  int free_cpu();
 };
@@ -33,13 +33,16 @@ static void *malloc_with_fd(size_t len, int *fd) {
 }
 
 void VisionBuf::allocate(size_t length) {
+  if (is_cpu()) return allocate_cpu(length);
+
   this->len = length;
-  this->mmap_len = this->len + sizeof(uint64_t);
+  this->mmap_len = this->len + VISIONBUF_META_SIZE;
   this->addr = malloc_with_fd(this->mmap_len, &this->fd);
-  this->frame_id = (uint64_t*)((uint8_t*)this->addr + this->len);
+  init_meta((uint8_t*)this->addr + this->len);
 }
 
 void VisionBuf::init_cl(cl_device_id device_id, cl_context ctx){
+  if (is_cpu()) return;
   int err;
 
   this->copy_q = clCreateCommandQueue(ctx, device_id, 0, &err);
@@ -51,11 +54,12 @@ void VisionBuf::init_cl(cl_device_id device_id, cl_context ctx){
 
 
 void VisionBuf::import(){
+  if (is_cpu()) return import_cpu();
   assert(this->fd >= 0);
   this->addr = mmap(NULL, this->mmap_len, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
   assert(this->addr != MAP_FAILED);
 
-  this->frame_id = (uint64_t*)((uint8_t*)this->addr + this->len);
+  init_meta((uint8_t*)this->addr + this->len);
 }
 
 
@@ -77,6 +81,7 @@ int VisionBuf::sync(int dir) {
 }
 
 int VisionBuf::free() {
+  if (is_cpu()) return free_cpu();
   int err = 0;
   if (this->buf_cl){
     err = clReleaseMemObject(this->buf_cl);
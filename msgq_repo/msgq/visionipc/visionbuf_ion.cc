@@ -57,8 +57,10 @@ int ion_fd() {
 }
 
 void VisionBuf::allocate(size_t length) {
+  if (is_cpu()) return allocate_cpu(length);
+
   struct ion_allocation_data ion_alloc = {0};
-  ion_alloc.len = length + PADDING_CL + sizeof(uint64_t);
+  ion_alloc.len = length + PADDING_CL + VISIONBUF_META_SIZE;
   ion_alloc.align = 4096;
   ion_alloc.heap_id_mask = 1 << ION_IOMMU_HEAP_ID;
   ion_alloc.flags = ION_FLAG_CACHED;
@@ -83,10 +85,11 @@ void VisionBuf::allocate(size_t length) {
   this->addr = mmap_addr;
   this->handle = ion_alloc.handle;
   this->fd = ion_fd_data.fd;
-  this->frame_id = (uint64_t*)((uint8_t*)this->addr + this->len + PADDING_CL);
+  init_meta((uint8_t*)this->addr + this->len + PADDING_CL);
 }
 
 void VisionBuf::import(){
+  if (is_cpu()) return import_cpu();
   int err;
   assert(this->fd >= 0);
 
@@ -100,10 +103,11 @@ void VisionBuf::import(){
   this->addr = mmap(NULL, this->mmap_len, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
   assert(this->addr != MAP_FAILED);
 
-  this->frame_id = (uint64_t*)((uint8_t*)this->addr + this->len + PADDING_CL);
+  init_meta((uint8_t*)this->addr + this->len + PADDING_CL);
 }
 
 void VisionBuf::init_cl(cl_device_id device_id, cl_context ctx) {
+  if (is_cpu()) return;
   int err;
 
   assert(((uintptr_t)this->addr % DEVICE_PAGE_SIZE_CL) == 0);
@@ -122,6 +126,7 @@ void VisionBuf::init_cl(cl_device_id device_id, cl_context ctx) {
 
 
 int VisionBuf::sync(int dir) {
+  if (is_cpu()) return 0;
   struct ion_flush_data flush_data = {0};
   flush_data.handle = this->handle;
   flush_data.vaddr = this->addr;
@@ -143,6 +148,7 @@ int VisionBuf::sync(int dir) {
 }
 
 int VisionBuf::free() {
+  if (is_cpu()) return free_cpu();
   int err = 0;
 
   if (this->buf_cl){
@@ -19,6 +19,9 @@ cdef extern from "msgq/visionipc/visionbuf.h":
   cdef enum VisionStreamType:
     pass
 
+  cdef enum VisionBufBackend:
+    pass
+
   cdef cppclass VisionBuf:
     void * addr
     size_t len
@@ -41,8 +44,10 @@ cdef extern from "msgq/visionipc/visionipc_server.h":
 
   cdef cppclass VisionIpcServer:
     VisionIpcServer(string, void*, void*)
+    VisionIpcServer(string, VisionBufBackend)
     void create_buffers(VisionStreamType, size_t, size_t, size_t)
     void create_buffers_with_sizes(VisionStreamType, size_t, size_t, size_t, size_t, size_t, size_t)
+    void create_pyramid(VisionStreamType, int, size_t)
     VisionBuf * get_buffer(VisionStreamType)
     void send(VisionBuf *, VisionIpcBufExtra *, bool)
     void start_listener()
@@ -55,5 +60,7 @@ cdef extern from "msgq/visionipc/visionipc_client.h":
     VisionBuf * recv(VisionIpcBufExtra *, int)
     bool connect(bool)
     bool is_connected()
+    void set_lease_mode(bool)
+    void release()
     @staticmethod
     set[VisionStreamType] getAvailableStreams(string, bool)
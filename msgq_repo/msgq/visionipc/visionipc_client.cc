@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <cassert>
 #include <iostream>
@@ -10,6 +11,10 @@
 #include "logger/logger.h"
 #include "logger/logger.h"
 
+static double millis_since_start() {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 static int connect_to_vipc_server(const std::string &name, bool blocking) {
   const std::string ipc_path = get_ipc_path(name);
   int socket_fd = ipc_connect(ipc_path.c_str());
@@ -27,11 +32,13 @@ VisionIpcClient::VisionIpcClient(std::string name, VisionStreamType type, bool c
 
   poller = Poller::create();
   poller->registerSocket(sock);
+  std::fill_n(lease_slot, VISIONIPC_MAX_FDS, -1);
 }
 
 // Connect is not thread safe. Do not use the buffers while calling connect
 bool VisionIpcClient::connect(bool blocking){
   connected = false;
+  release();
 
   // Cleanup old buffers on reconnect
   for (size_t i = 0; i < num_buffers; i++){
@@ -41,6 +48,10 @@ bool VisionIpcClient::connect(bool blocking){
   }
 
   num_buffers = 0;
+  if (server_fd >= 0) {
+    close(server_fd);
+    server_fd = -1;
+  }
 
   int socket_fd = connect_to_vipc_server(name, blocking);
   if (socket_fd < 0) {
@@ -68,7 +79,7 @@ bool VisionIpcClient::connect(bool blocking){
     if (device_id) buffers[i].init_cl(device_id, ctx);
   }
 
-  close(socket_fd);
+  server_fd = socket_fd;
   connected = true;
   return true;
 }
@@ -102,6 +113,24 @@ VisionBuf * VisionIpcClient::recv(VisionIpcBufExtra * extra, const int timeout_m
     *extra = packet->extra;
   }
 
+  if (lease_mode) {
+    // still leased from an earlier frame, the server overwrote it anyway because all buffers were leased
+    release(buf);
+    lease_slot[buf->idx] = buf->acquire_lease();
+    if (lease_slot[buf->idx] < 0) {
+      stats.unleased_frames++;
+    } else if (buf->get_frame_id() != packet->extra.frame_id) {
+      // the server already reused this buffer for a newer frame
+      release(buf);
+      stats.torn_frames++;
+      delete r;
+      return nullptr;
+    }
+    lease_start_ms[buf->idx] = millis_since_start();
+    lease_frame_id[buf->idx] = packet->extra.frame_id;
+  }
+  stats.frames++;
+
   if (buf->sync(VISIONBUF_SYNC_TO_DEVICE) != 0) {
     LOGE("Failed to sync buffer");
   }
@@ -110,6 +139,27 @@ VisionBuf * VisionIpcClient::recv(VisionIpcBufExtra * extra, const int timeout_m
   return buf;
 }
 
+void VisionIpcClient::release(VisionBuf *buf) {
+  int &slot = lease_slot[buf->idx];
+  if (slot >= 0) {
+    buf->release_lease(slot);
+    stats.lease_ms_max = std::max(stats.lease_ms_max, millis_since_start() - lease_start_ms[buf->idx]);
+    slot = -1;
+  }
+}
+
+void VisionIpcClient::release(VisionBuf *buf, uint32_t frame_id) {
+  if (lease_frame_id[buf->idx] == frame_id) {
+    release(buf);
+  }
+}
+
+void VisionIpcClient::release() {
+  for (size_t i = 0; i < num_buffers; i++) {
+    release(&buffers[i]);
+  }
+}
+
 std::set<VisionStreamType> VisionIpcClient::getAvailableStreams(const std::string &name, bool blocking) {
   int socket_fd = connect_to_vipc_server(name, blocking);
   if (socket_fd < 0) {
@@ -128,11 +178,15 @@ std::set<VisionStreamType> VisionIpcClient::getAvailableStreams(const std::strin
 }
 
 VisionIpcClient::~VisionIpcClient(){
+  release();
   for (size_t i = 0; i < num_buffers; i++){
     if (buffers[i].free() != 0) {
       LOGE("Failed to free buffer %zu", i);
     }
   }
+  if (server_fd >= 0) {
+    close(server_fd);
+  }
 
   delete sock;
   delete poller;
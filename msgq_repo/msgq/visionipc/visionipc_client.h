@@ -7,6 +7,13 @@
 #include "msgq/visionipc/visionbuf.h"
 
 
+struct VisionIpcClientStats {
+  uint64_t frames = 0;
+  uint64_t torn_frames = 0;      // buffer was already being overwritten when the lease was taken
+  uint64_t unleased_frames = 0;  // all lease slots of the buffer were taken by other clients
+  double lease_ms_max = 0;       // longest a buffer was held
+};
+
 class VisionIpcClient {
 private:
   std::string name;
@@ -17,6 +24,13 @@ private:
   cl_device_id device_id = nullptr;
   cl_context ctx = nullptr;
 
+  bool lease_mode = false;
+  int lease_slot[VISIONIPC_MAX_FDS];  // -1 if the buffer isn't leased
+  double lease_start_ms[VISIONIPC_MAX_FDS] = {};
+  uint32_t lease_frame_id[VISIONIPC_MAX_FDS] = {};  // frame the lease was taken for
+  // held open while connected, the server produces pyramid levels only while their clients hold one
+  int server_fd = -1;
+
 public:
   bool connected = false;
   VisionStreamType type;
@@ -27,5 +41,16 @@ public:
   VisionBuf * recv(VisionIpcBufExtra * extra=nullptr, const int timeout_ms=100);
   bool connect(bool blocking=true);
   bool is_connected() { return connected; }
+
+  // In lease mode a buffer returned by recv() is not reused by the server until it is released.
+  // Frames that were overwritten before they could be leased are dropped.
+  void set_lease_mode(bool enable) { lease_mode = enable; }
+  void release(VisionBuf *buf);
+  // releases the buffer only if its lease is still held for frame_id, a buffer that was overwritten
+  // and received again is leased for the newer frame
+  void release(VisionBuf *buf, uint32_t frame_id);
+  // releases all buffers
+  void release();
+  VisionIpcClientStats stats;
   static std::set<VisionStreamType> getAvailableStreams(const std::string &name, bool blocking = true);
 };
@@ -26,6 +26,18 @@ cpdef enum VisionStreamType:
   VISION_STREAM_DRIVER
   VISION_STREAM_WIDE_ROAD
   VISION_STREAM_MAP
+  VISION_STREAM_ROAD_HALF
+  VISION_STREAM_DRIVER_HALF
+  VISION_STREAM_WIDE_ROAD_HALF
+  VISION_STREAM_ROAD_QUARTER
+  VISION_STREAM_DRIVER_QUARTER
+  VISION_STREAM_WIDE_ROAD_QUARTER
+
+
+cpdef enum VisionBufBackend:
+  VISIONBUF_BACKEND_DEVICE
+  VISIONBUF_BACKEND_CPU
+  VISIONBUF_BACKEND_CPU_HUGEPAGES
 
 
 cdef class VisionBuf:
@@ -59,8 +71,9 @@ cdef class VisionBuf:
 cdef class VisionIpcServer:
   cdef cppVisionIpcServer * server
 
-  def __init__(self, string name):
-    self.server = new cppVisionIpcServer(name, NULL, NULL)
+  def __init__(self, string name, VisionBufBackend backend=VisionBufBackend.VISIONBUF_BACKEND_DEVICE):
+    # the CPU backends need no OpenCL, for pipelines on machines without a GPU
+    self.server = new cppVisionIpcServer(name, backend)
 
   def create_buffers(self, VisionStreamType tp, size_t num_buffers, size_t width, size_t height):
     self.server.create_buffers(tp, num_buffers, width, height)
@@ -68,6 +81,9 @@ cdef class VisionIpcServer:
   def create_buffers_with_sizes(self, VisionStreamType tp, size_t num_buffers, size_t width, size_t height, size_t size, size_t stride, size_t uv_offset):
     self.server.create_buffers_with_sizes(tp, num_buffers, width, height, size, stride, uv_offset)
 
+  def create_pyramid(self, VisionStreamType tp, int levels, size_t num_buffers):
+    self.server.create_pyramid(tp, levels, num_buffers)
+
   def send(self, VisionStreamType tp, const unsigned char[:] data, uint32_t frame_id=0, uint64_t timestamp_sof=0, uint64_t timestamp_eof=0):
     cdef cppVisionBuf * buf = self.server.get_buffer(tp)
 
@@ -152,6 +168,12 @@ cdef class VisionIpcClient:
   def connect(self, bool blocking):
     return self.client.connect(blocking)
 
+  def set_lease_mode(self, bool enable):
+    self.client.set_lease_mode(enable)
+
+  def release(self):
+    self.client.release()
+
   def is_connected(self):
     return self.client.is_connected()
 
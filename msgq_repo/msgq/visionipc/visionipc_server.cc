@@ -30,6 +30,41 @@ std::string get_ipc_path(const std::string& name) {
   return path + "visionipc_" + name;
 }
 
+VisionStreamType get_pyramid_stream(VisionStreamType type, int level) {
+  assert(level >= 1 && level <= VISIONIPC_MAX_PYRAMID_LEVELS);
+  switch (type) {
+    case VISION_STREAM_ROAD: return level == 1 ? VISION_STREAM_ROAD_HALF : VISION_STREAM_ROAD_QUARTER;
+    case VISION_STREAM_DRIVER: return level == 1 ? VISION_STREAM_DRIVER_HALF : VISION_STREAM_DRIVER_QUARTER;
+    case VISION_STREAM_WIDE_ROAD: return level == 1 ? VISION_STREAM_WIDE_ROAD_HALF : VISION_STREAM_WIDE_ROAD_QUARTER;
+    default: assert(false && "stream has no pyramid"); return VISION_STREAM_MAX;
+  }
+}
+
+// 2x2 box filter from src into dst, which is at most half the size of src.
+// The chroma plane is interleaved UV, so neighbouring samples of the same channel are two bytes apart.
+static void downscale_nv12(const VisionBuf *src, VisionBuf *dst) {
+  assert(dst->width * 2 <= src->width && dst->height * 2 <= src->height);
+
+  for (size_t y = 0; y < dst->height; y++) {
+    const uint8_t *s0 = src->y + (2 * y) * src->stride;
+    const uint8_t *s1 = s0 + src->stride;
+    uint8_t *d = dst->y + y * dst->stride;
+    for (size_t x = 0; x < dst->width; x++) {
+      d[x] = (s0[2*x] + s0[2*x + 1] + s1[2*x] + s1[2*x + 1] + 2) >> 2;
+    }
+  }
+
+  for (size_t y = 0; y < dst->height / 2; y++) {
+    const uint8_t *s0 = src->uv + (2 * y) * src->stride;
+    const uint8_t *s1 = s0 + src->stride;
+    uint8_t *d = dst->uv + y * dst->stride;
+    for (size_t x = 0; x < dst->width / 2; x++) {
+      d[2*x + 0] = (s0[4*x + 0] + s0[4*x + 2] + s1[4*x + 0] + s1[4*x + 2] + 2) >> 2;
+      d[2*x + 1] = (s0[4*x + 1] + s0[4*x + 3] + s1[4*x + 1] + s1[4*x + 3] + 2) >> 2;
+    }
+  }
+}
+
 VisionIpcServer::VisionIpcServer(std::string name, cl_device_id device_id, cl_context ctx) : name(name), device_id(device_id), ctx(ctx) {
   msg_ctx = Context::create();
 
@@ -38,6 +73,10 @@ VisionIpcServer::VisionIpcServer(std::string name, cl_device_id device_id, cl_co
   server_id = distribution(rd);
 }
 
+VisionIpcServer::VisionIpcServer(std::string name, VisionBufBackend backend) : VisionIpcServer(name) {
+  this->backend = backend;
+}
+
 void VisionIpcServer::create_buffers(VisionStreamType type, size_t num_buffers, size_t width, size_t height){
   // TODO: assert that this type is not created yet
   assert(num_buffers < VISIONIPC_MAX_FDS);
@@ -54,9 +93,22 @@ void VisionIpcServer::create_buffers(VisionStreamType type, size_t num_buffers,
 }
 
 void VisionIpcServer::create_buffers_with_sizes(VisionStreamType type, size_t num_buffers, size_t width, size_t height, size_t size, size_t stride, size_t uv_offset) {
+  allocate_buffers(type, num_buffers, width, height, size, stride, uv_offset);
+
+  cur_idx[type] = 0;
+  // only looked up from here on, the camera threads share the map
+  stats[type] = {};
+
+  // Create msgq publisher for each of the `name` + type combos
+  // TODO: compute port number directly if using zmq
+  sockets[type] = PubSocket::create(msg_ctx, get_endpoint_name(name, type), false);
+}
+
+void VisionIpcServer::allocate_buffers(VisionStreamType type, size_t num_buffers, size_t width, size_t height, size_t size, size_t stride, size_t uv_offset) {
   // Create map + alloc requested buffers
   for (size_t i = 0; i < num_buffers; i++){
     VisionBuf* buf = new VisionBuf();
+    buf->backend = backend;
     buf->allocate(size);
     buf->idx = i;
     buf->type = type;
@@ -64,15 +116,66 @@ void VisionIpcServer::create_buffers_with_sizes(VisionStreamType type, size_t nu
     if (device_id) buf->init_cl(device_id, ctx);
 
     buf->init_yuv(width, height, stride, uv_offset);
+    buf->clear_leases();
 
     buffers[type].push_back(buf);
   }
+}
 
-  cur_idx[type] = 0;
+void VisionIpcServer::create_pyramid(VisionStreamType type, int levels, size_t num_buffers) {
+  assert(buffers.count(type));
+  assert(levels >= 1 && levels <= VISIONIPC_MAX_PYRAMID_LEVELS);
 
-  // Create msgq publisher for each of the `name` + type combos
-  // TODO: compute port number directly if using zmq
-  sockets[type] = PubSocket::create(msg_ctx, get_endpoint_name(name, type), false);
+  assert(num_buffers < VISIONIPC_MAX_FDS);
+
+  // keep every level NV12 compatible: even width and height
+  size_t width = buffers[type][0]->width;
+  size_t height = buffers[type][0]->height;
+  for (int level = 1; level <= levels; level++) {
+    width = (width / 2) & ~1;
+    height = (height / 2) & ~1;
+
+    // everything but the buffers, so the maps don't change once the listener runs
+    VisionStreamType level_type = get_pyramid_stream(type, level);
+    pyramid_level_info[level_type] = {type, level, num_buffers, width, height};
+    buffers[level_type] = {};
+    cur_idx[level_type] = 0;
+    stats[level_type] = {};
+    sockets[level_type] = PubSocket::create(msg_ctx, get_endpoint_name(name, level_type), false);
+  }
+  pyramid_levels[type] = levels;
+
+  if (!pyramid_thread.joinable()) {
+    pyramid_thread = std::thread(&VisionIpcServer::pyramid_worker, this);
+  }
+}
+
+// Called by the listener when a client asks for a pyramid level. Levels are computed from the one
+// above, so those are allocated too. The worker only touches a level after it has been requested.
+void VisionIpcServer::request_pyramid_level(VisionStreamType type, int fd) {
+  const PyramidLevel &info = pyramid_level_info.at(type);
+  for (int level = 1; level <= info.level; level++) {
+    VisionStreamType level_type = get_pyramid_stream(info.base, level);
+    if (buffers[level_type].empty()) {
+      const PyramidLevel &l = pyramid_level_info.at(level_type);
+      allocate_buffers(level_type, l.num_buffers, l.width, l.height, l.width * l.height * 3 / 2, l.width, l.width * l.height);
+    }
+  }
+
+  pyramid_clients[fd] = type;
+  if (pyramid_client_count[type]++ == 0) {
+    pyramid_requested[type] = true;
+  }
+}
+
+void VisionIpcServer::drop_pyramid_client(int fd) {
+  VisionStreamType type = pyramid_clients.at(fd);
+  pyramid_clients.erase(fd);
+  close(fd);
+  // the buffers stay allocated, a client coming back gets the same ones
+  if (--pyramid_client_count[type] == 0) {
+    pyramid_requested[type] = false;
+  }
 }
 
 
@@ -89,12 +192,13 @@ void VisionIpcServer::listener(){
   assert(sock >= 0);
 
   while (!should_exit){
-    // Wait for incoming connection
-    struct pollfd polls[1] = {{0}};
-    polls[0].fd = sock;
-    polls[0].events = POLLIN;
+    // Wait for incoming connection, or for a client of a pyramid level to close its connection
+    std::vector<struct pollfd> polls = {{.fd = sock, .events = POLLIN}};
+    for (auto &[fd, _] : pyramid_clients) {
+      polls.push_back({.fd = fd, .events = POLLIN});
+    }
 
-    int ret = poll(polls, 1, 100);
+    int ret = poll(polls.data(), polls.size(), 100);
     if (ret < 0) {
       if (errno == EINTR || errno == EAGAIN) continue;
       std::cout << "poll failed, stopping listener" << std::endl;
@@ -102,6 +206,12 @@ void VisionIpcServer::listener(){
     }
 
     if (should_exit) break;
+    // clients don't send anything after the request, so anything but silence means they are gone
+    for (size_t i = 1; i < polls.size(); i++) {
+      if (polls[i].revents) {
+        drop_pyramid_client(polls[i].fd);
+      }
+    }
     if (!polls[0].revents) {
       continue;
     }
@@ -131,6 +241,10 @@ void VisionIpcServer::listener(){
       close(fd);
       continue;
     }
+    const bool pyramid_level = pyramid_level_info.count(type);
+    if (pyramid_level) {
+      request_pyramid_level(type, fd);
+    }
 
     int fds[VISIONIPC_MAX_FDS];
     int num_fds = buffers[type].size();
@@ -150,10 +264,16 @@ void VisionIpcServer::listener(){
 
     r = ipc_sendrecv_with_fds(true, fd, &bufs, sizeof(VisionBuf) * num_fds, fds, num_fds, nullptr);
 
-    close(fd);
+    if (!pyramid_level) {
+      close(fd);
+    }
   }
 
   std::cout << "Stopping listener for: " << name << std::endl;
+  for (auto &[fd, _] : pyramid_clients) {
+    close(fd);
+  }
+  pyramid_clients.clear();
   close(sock);
   unlink(ipc_path.c_str());
 }
@@ -161,16 +281,35 @@ void VisionIpcServer::listener(){
 
 
 VisionBuf * VisionIpcServer::get_buffer(VisionStreamType type, int idx){
-  // Do we want to keep track if the buffer has been sent out yet and warn user?
   assert(buffers.count(type));
-  auto b = buffers[type];
-  if (idx < 0) {
-    idx = cur_idx[type]++ % b.size();
-  } else {
+  auto &b = buffers[type];
+  if (idx >= 0) {
     assert(idx < b.size() && idx >= 0);
     cur_idx[type] = idx;
+    b[idx]->set_frame_id(VISIONBUF_INVALID_FRAME_ID);
+    return b[idx];
   }
-  return b[idx];
+
+  // Round robin, skipping buffers a client holds a lease on. The frame id is invalidated before the
+  // lease is checked, so a client leasing concurrently either sees the invalid id or gets skipped.
+  const size_t start = cur_idx[type]++;
+  for (size_t i = 0; i < b.size(); i++) {
+    VisionBuf *buf = b[(start + i) % b.size()];
+    const uint64_t prev_frame_id = buf->get_frame_id();
+    buf->set_frame_id(VISIONBUF_INVALID_FRAME_ID);
+    if (!buf->leased()) {
+      cur_idx[type] = start + i + 1;
+      return buf;
+    }
+    buf->set_frame_id(prev_frame_id);
+    stats.at(type).leased_skips++;
+  }
+
+  // every buffer is leased, a client is stuck. don't stall the camera for it
+  stats.at(type).forced_overwrites++;
+  VisionBuf *buf = b[start % b.size()];
+  buf->set_frame_id(VISIONBUF_INVALID_FRAME_ID);
+  return buf;
 }
 
 void VisionIpcServer::send(VisionBuf * buf, VisionIpcBufExtra * extra, bool sync){
@@ -189,10 +328,66 @@ void VisionIpcServer::send(VisionBuf * buf, VisionIpcBufExtra * extra, bool sync
   packet.extra = *extra;
 
   sockets[buf->type]->send((char*)&packet, sizeof(packet));
+
+  if (auto it = pyramid_levels.find(buf->type); it != pyramid_levels.end()) {
+    for (int level = 1; level <= it->second; level++) {
+      if (pyramid_requested[get_pyramid_stream(buf->type, level)]) {
+        std::lock_guard lk(pyramid_lock);
+        pyramid_pending[buf->type] = {buf, buf->get_frame_id(), *extra};
+        pyramid_cv.notify_one();
+        break;
+      }
+    }
+  }
+}
+
+void VisionIpcServer::pyramid_worker() {
+  std::unique_lock lk(pyramid_lock);
+  while (!should_exit) {
+    pyramid_cv.wait(lk, [&]() { return should_exit || !pyramid_pending.empty(); });
+    auto pending = std::move(pyramid_pending);
+    pyramid_pending.clear();
+
+    lk.unlock();
+    for (auto &[type, frame] : pending) {
+      send_pyramid(frame);
+    }
+    lk.lock();
+  }
+}
+
+void VisionIpcServer::send_pyramid(const PyramidFrame &frame) {
+  VisionBuf *buf = frame.buf;
+  VisionIpcBufExtra extra = frame.extra;
+  // levels are computed from the previous one, so build up to the deepest level anyone listens to
+  const int levels = pyramid_levels.at(buf->type);
+  int needed = 0;
+  for (int level = 1; level <= levels; level++) {
+    if (pyramid_requested[get_pyramid_stream(buf->type, level)]) needed = level;
+  }
+
+  VisionBuf *src = buf;
+  for (int level = 1; level <= needed; level++) {
+    VisionBuf *dst = get_buffer(get_pyramid_stream(buf->type, level));
+    downscale_nv12(src, dst);
+    // the sender reused the buffer while it was read, the level keeps the invalid frame id
+    if (buf->get_frame_id() != frame.buf_frame_id) return;
+    dst->set_frame_id(extra.frame_id);
+    if (dst->sync(VISIONBUF_SYNC_TO_DEVICE) != 0) {
+      LOGE("Failed to sync buffer");
+    }
+    send(dst, &extra, false);
+    src = dst;
+  }
 }
 
 VisionIpcServer::~VisionIpcServer(){
-  should_exit = true;
+  {
+    std::lock_guard lk(pyramid_lock);
+    should_exit = true;
+  }
+  pyramid_cv.notify_all();
+  if (pyramid_thread.joinable()) pyramid_thread.join();
   listener_thread.join();
 
   // VisionBuf cleanup
@@ -3,18 +3,30 @@
 #include <string>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
 #include <map>
+#include <mutex>
 
 #include "msgq/ipc.h"
 #include "msgq/visionipc/visionbuf.h"
 
 std::string get_endpoint_name(std::string name, VisionStreamType type);
 std::string get_ipc_path(const std::string &name);
+// downscaled companion of a camera stream, level 1 is half and level 2 quarter resolution
+VisionStreamType get_pyramid_stream(VisionStreamType type, int level);
+
+#define VISIONIPC_MAX_PYRAMID_LEVELS 2
+
+struct VisionIpcServerStats {
+  uint64_t leased_skips = 0;       // buffers skipped because a client still held them
+  uint64_t forced_overwrites = 0;  // every buffer was leased, one was overwritten anyway
+};
 
 class VisionIpcServer {
  private:
   cl_device_id device_id = nullptr;
   cl_context ctx = nullptr;
+  VisionBufBackend backend = VISIONBUF_BACKEND_DEVICE;
   uint64_t server_id;
 
   std::atomic<bool> should_exit = false;
@@ -23,20 +35,58 @@ class VisionIpcServer {
 
   std::map<VisionStreamType, std::atomic<size_t> > cur_idx;
   std::map<VisionStreamType, std::vector<VisionBuf*> > buffers;
+  std::map<VisionStreamType, VisionIpcServerStats> stats;
+
+  // Pyramid levels are advertised right away but their buffers are allocated by the listener when
+  // the first client asks for them. A level is computed while any client is connected to it.
+  struct PyramidLevel {
+    VisionStreamType base;
+    int level;
+    size_t num_buffers, width, height;
+  };
+  std::map<VisionStreamType, int> pyramid_levels;
+  std::map<VisionStreamType, PyramidLevel> pyramid_level_info;
+  std::atomic<bool> pyramid_requested[VISION_STREAM_MAX] = {};
+  // listener thread only: connections held open by clients of a level, and their count per level
+  std::map<int, VisionStreamType> pyramid_clients;
+  int pyramid_client_count[VISION_STREAM_MAX] = {};
+  void request_pyramid_level(VisionStreamType type, int fd);
+  void drop_pyramid_client(int fd);
+
+  // the downscale runs here, off the thread calling send(). Only the newest frame of each stream waits.
+  std::thread pyramid_thread;
+  std::mutex pyramid_lock;
+  std::condition_variable pyramid_cv;
+  struct PyramidFrame {
+    VisionBuf *buf;
+    uint64_t buf_frame_id;  // as sent, a different one means the buffer was reused meanwhile
+    VisionIpcBufExtra extra;
+  };
+  std::map<VisionStreamType, PyramidFrame> pyramid_pending;
+  void pyramid_worker();
+  void send_pyramid(const PyramidFrame &frame);
 
   Context * msg_ctx;
   std::map<VisionStreamType, PubSocket*> sockets;
 
   void listener(void);
+  void allocate_buffers(VisionStreamType type, size_t num_buffers, size_t width, size_t height, size_t size, size_t stride, size_t uv_offset);
 
  public:
   VisionIpcServer(std::string name, cl_device_id device_id=nullptr, cl_context ctx=nullptr);
+  // buffers without OpenCL or ion, for pipelines on machines without a GPU
+  VisionIpcServer(std::string name, VisionBufBackend backend);
   ~VisionIpcServer();
 
   VisionBuf * get_buffer(VisionStreamType type, int idx = -1);
 
   void create_buffers(VisionStreamType type, size_t num_buffers, size_t width, size_t height);
   void create_buffers_with_sizes(VisionStreamType type, size_t num_buffers, size_t width, size_t height, size_t size, size_t stride, size_t uv_offset);
+  // Publish half (and quarter) resolution copies of a stream, downscaled on a worker thread after
+  // send(). A level uses no memory until a client asks for it and no CPU while none is connected.
+  void create_pyramid(VisionStreamType type, int levels, size_t num_buffers);
   void send(VisionBuf * buf, VisionIpcBufExtra * extra, bool sync=true);
   void start_listener();
+  // counted in get_buffer, read them on the thread that calls it. Pyramid levels are counted on the worker.
+  VisionIpcServerStats get_stats(VisionStreamType type) { return stats.at(type); }
 };
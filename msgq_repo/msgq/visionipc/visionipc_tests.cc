@@ -1,5 +1,10 @@
 #include <thread>
 #include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "catch2/catch.hpp"
 
@@ -133,3 +138,266 @@ TEST_CASE("Test conflate"){
   recv_buf = client.recv(&extra_recv);
   REQUIRE(recv_buf == nullptr);
 }
+
+TEST_CASE("Lease skips held buffer"){
+  VisionIpcServer server("camerad");
+  server.create_buffers(VISION_STREAM_ROAD, 2, 100, 100);
+  server.start_listener();
+
+  VisionIpcClient client = VisionIpcClient("camerad", VISION_STREAM_ROAD, false);
+  client.set_lease_mode(true);
+  REQUIRE(client.connect());
+  zmq_sleep();
+
+  VisionBuf * buf = server.get_buffer(VISION_STREAM_ROAD);
+  VisionIpcBufExtra extra = {0};
+  extra.frame_id = 1;
+  buf->set_frame_id(extra.frame_id);
+  server.send(buf, &extra);
+
+  VisionBuf * recv_buf = client.recv();
+  REQUIRE(recv_buf != nullptr);
+  REQUIRE(recv_buf->idx == buf->idx);
+
+  // the leased buffer is never handed out while the client holds it
+  REQUIRE(server.get_buffer(VISION_STREAM_ROAD)->idx != buf->idx);
+  REQUIRE(server.get_buffer(VISION_STREAM_ROAD)->idx != buf->idx);
+  REQUIRE(server.get_stats(VISION_STREAM_ROAD).leased_skips == 1);
+  REQUIRE(recv_buf->get_frame_id() == 1);
+
+  client.release(recv_buf);
+  REQUIRE(server.get_buffer(VISION_STREAM_ROAD)->idx == buf->idx);
+}
+
+TEST_CASE("Lease drops overwritten frame"){
+  VisionIpcServer server("camerad");
+  server.create_buffers(VISION_STREAM_ROAD, 1, 100, 100);
+  server.start_listener();
+
+  VisionIpcClient client = VisionIpcClient("camerad", VISION_STREAM_ROAD, false);
+  client.set_lease_mode(true);
+  REQUIRE(client.connect());
+  zmq_sleep();
+
+  VisionBuf * buf = server.get_buffer(VISION_STREAM_ROAD);
+  VisionIpcBufExtra extra = {0};
+  extra.frame_id = 1;
+  buf->set_frame_id(extra.frame_id);
+  server.send(buf, &extra);
+
+  // server starts writing the next frame before the client got to this one
+  REQUIRE(server.get_buffer(VISION_STREAM_ROAD) == buf);
+
+  REQUIRE(client.recv() == nullptr);
+  REQUIRE(client.stats.torn_frames == 1);
+  REQUIRE(!buf->leased());
+}
+
+TEST_CASE("Stale release keeps lease of newer frame"){
+  VisionIpcServer server("camerad");
+  server.create_buffers(VISION_STREAM_ROAD, 1, 100, 100);
+  server.start_listener();
+
+  VisionIpcClient client = VisionIpcClient("camerad", VISION_STREAM_ROAD, false);
+  client.set_lease_mode(true);
+  REQUIRE(client.connect());
+  zmq_sleep();
+
+  VisionIpcBufExtra extra = {0};
+  for (uint32_t frame_id : {1, 2}) {
+    // the only buffer is leased for frame 1, it's overwritten anyway for frame 2
+    VisionBuf * buf = server.get_buffer(VISION_STREAM_ROAD);
+    extra.frame_id = frame_id;
+    buf->set_frame_id(extra.frame_id);
+    server.send(buf, &extra);
+    VisionBuf * recv_buf = client.recv();
+    REQUIRE(recv_buf != nullptr);
+    REQUIRE(recv_buf->get_frame_id() == frame_id);
+  }
+  VisionBuf * buf = &client.buffers[0];
+
+  client.release(buf, 1);
+  REQUIRE(buf->leased());
+  client.release(buf, 2);
+  REQUIRE(!buf->leased());
+}
+
+TEST_CASE("Lease of a crashed client is dropped"){
+  VisionIpcServer server("camerad");
+  server.create_buffers(VISION_STREAM_ROAD, 1, 100, 100);
+  server.start_listener();
+  VisionBuf * buf = server.get_buffer(VISION_STREAM_ROAD);
+
+  // a live client keeps its lease, all buffers leased means one is overwritten anyway
+  int slot = buf->acquire_lease();
+  REQUIRE(slot >= 0);
+  REQUIRE(server.get_buffer(VISION_STREAM_ROAD) == buf);
+  REQUIRE(server.get_stats(VISION_STREAM_ROAD).forced_overwrites == 1);
+  buf->release_lease(slot);
+
+  // the buffer is shared with the child, which exits without releasing it
+  pid_t pid = fork();
+  if (pid == 0) {
+    buf->acquire_lease();
+    _exit(0);
+  }
+  waitpid(pid, nullptr, 0);
+
+  REQUIRE(server.get_buffer(VISION_STREAM_ROAD) == buf);
+  REQUIRE(server.get_stats(VISION_STREAM_ROAD).forced_overwrites == 1);
+  REQUIRE(!buf->leased());
+}
+
+TEST_CASE("CPU backend"){
+  VisionIpcServer server("camerad", VISIONBUF_BACKEND_CPU);
+  server.create_buffers(VISION_STREAM_ROAD, 2, 100, 100);
+  server.start_listener();
+
+  VisionIpcClient client = VisionIpcClient("camerad", VISION_STREAM_ROAD, false);
+  REQUIRE(client.connect());
+  REQUIRE(client.buffers[0].backend == VISIONBUF_BACKEND_CPU);
+  REQUIRE(client.buffers[0].buf_cl == nullptr);
+  zmq_sleep();
+
+  VisionBuf * buf = server.get_buffer(VISION_STREAM_ROAD);
+  *((uint64_t*)buf->addr) = 1234;
+  VisionIpcBufExtra extra = {0};
+  extra.frame_id = 1;
+  buf->set_frame_id(extra.frame_id);
+  server.send(buf, &extra);
+
+  VisionBuf * recv_buf = client.recv();
+  REQUIRE(recv_buf != nullptr);
+  REQUIRE(*(uint64_t*)recv_buf->addr == 1234);
+  REQUIRE(recv_buf->get_frame_id() == 1);
+}
+
+TEST_CASE("Pyramid"){
+  const size_t width = 100, height = 60;
+  VisionIpcServer server("camerad");
+  server.create_buffers(VISION_STREAM_ROAD, 2, width, height);
+  server.create_pyramid(VISION_STREAM_ROAD, 2, 2);
+  server.start_listener();
+
+  auto available_streams = VisionIpcClient::getAvailableStreams("camerad");
+  REQUIRE(available_streams.count(VISION_STREAM_ROAD_HALF) == 1);
+  REQUIRE(available_streams.count(VISION_STREAM_ROAD_QUARTER) == 1);
+
+  VisionIpcClient client = VisionIpcClient("camerad", VISION_STREAM_ROAD_QUARTER, false);
+  REQUIRE(client.connect());
+  REQUIRE(client.buffers[0].width == 24);
+  REQUIRE(client.buffers[0].height == 14);
+  zmq_sleep();
+
+  VisionBuf * buf = server.get_buffer(VISION_STREAM_ROAD);
+  for (size_t y = 0; y < height; y++) {
+    for (size_t x = 0; x < width; x++) {
+      buf->y[y * buf->stride + x] = (x % 4 < 2) ? 100 : 200;
+    }
+  }
+  for (size_t y = 0; y < height / 2; y++) {
+    for (size_t x = 0; x < width; x += 2) {
+      buf->uv[y * buf->stride + x] = 64;
+      buf->uv[y * buf->stride + x + 1] = 192;
+    }
+  }
+  VisionIpcBufExtra extra = {0};
+  extra.frame_id = 42;
+  buf->set_frame_id(extra.frame_id);
+  server.send(buf, &extra);
+
+  // downscaled on the server's worker thread
+  VisionIpcBufExtra extra_recv = {0};
+  VisionBuf * recv_buf = client.recv(&extra_recv, 1000);
+  REQUIRE(recv_buf != nullptr);
+  REQUIRE(extra_recv.frame_id == 42);
+  REQUIRE(recv_buf->get_frame_id() == 42);
+  REQUIRE(recv_buf->y[0] == 150);
+  REQUIRE(recv_buf->y[(recv_buf->height - 1) * recv_buf->stride + recv_buf->width - 1] == 150);
+  REQUIRE(recv_buf->uv[0] == 64);
+  REQUIRE(recv_buf->uv[1] == 192);
+}
+
+TEST_CASE("Pyramid level stops when its client leaves"){
+  VisionIpcServer server("camerad");
+  server.create_buffers(VISION_STREAM_ROAD, 4, 100, 60);
+  server.create_pyramid(VISION_STREAM_ROAD, 1, 4);
+  server.start_listener();
+
+  auto send_frame = [&](uint32_t frame_id) {
+    VisionBuf * buf = server.get_buffer(VISION_STREAM_ROAD);
+    VisionIpcBufExtra extra = {0};
+    extra.frame_id = frame_id;
+    buf->set_frame_id(frame_id);
+    server.send(buf, &extra);
+  };
+  auto produced = [](VisionIpcClient &client, uint64_t frame_id) {
+    for (int i = 0; i < client.num_buffers; i++) {
+      if (client.buffers[i].get_frame_id() == frame_id) return true;
+    }
+    return false;
+  };
+
+  {
+    VisionIpcClient client = VisionIpcClient("camerad", VISION_STREAM_ROAD_HALF, false);
+    REQUIRE(client.connect());
+    zmq_sleep();
+    send_frame(1);
+    REQUIRE(client.recv(nullptr, 1000) != nullptr);
+  }
+  // the listener notices the closed connection on its next poll
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  send_frame(2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  VisionIpcClient client = VisionIpcClient("camerad", VISION_STREAM_ROAD_HALF, false);
+  REQUIRE(client.connect());
+  REQUIRE(produced(client, 1));
+  REQUIRE_FALSE(produced(client, 2));
+
+  zmq_sleep();
+  send_frame(3);
+  VisionIpcBufExtra extra_recv = {0};
+  REQUIRE(client.recv(&extra_recv, 1000) != nullptr);
+  REQUIRE(extra_recv.frame_id == 3);
+}
+
+// not run by default: ./test_runner "[benchmark]"
+TEST_CASE("Backend throughput", "[.][benchmark]"){
+  const size_t width = 1928, height = 1208, num_frames = 1000;
+  for (auto [name, backend] : {std::pair{"device", VISIONBUF_BACKEND_DEVICE},
+                               std::pair{"cpu", VISIONBUF_BACKEND_CPU},
+                               std::pair{"cpu hugepages", VISIONBUF_BACKEND_CPU_HUGEPAGES}}) {
+    VisionIpcServer server("camerad", backend);
+    server.create_buffers(VISION_STREAM_ROAD, 8, width, height);
+    server.start_listener();
+
+    VisionIpcClient client = VisionIpcClient("camerad", VISION_STREAM_ROAD, false);
+    REQUIRE(client.connect());
+    zmq_sleep();
+
+    std::vector<uint8_t> frame(width * height * 3 / 2, 0x80);
+    std::vector<uint8_t> out(frame.size());
+    size_t received = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < num_frames; i++) {
+      // producer writes a full frame, consumer reads it back
+      VisionBuf * buf = server.get_buffer(VISION_STREAM_ROAD);
+      memcpy(buf->addr, frame.data(), frame.size());
+      VisionIpcBufExtra extra = {0};
+      extra.frame_id = i;
+      buf->set_frame_id(i);
+      server.send(buf, &extra);
+
+      VisionBuf * recv_buf = client.recv();
+      if (recv_buf != nullptr) {
+        memcpy(out.data(), recv_buf->addr, out.size());
+        received++;
+      }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << received / secs << " frames/s, "
+              << received * frame.size() * 2 / secs / 1e9 << " GB/s" << std::endl;
+    REQUIRE(received == num_frames);
+  }
+}
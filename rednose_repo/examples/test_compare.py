@@ -119,6 +119,66 @@ class TestCompare:
       assert np.allclose(kf.filter_py.state(), kf.filter_pyx.state())
       assert np.allclose(kf.filter_py.covs(), kf.filter_pyx.covs())
 
+  def test_compare_rewind(self):
+    # The python filter keeps a checkpoint after every observation, the C++ one only keeps
+    # snapshots and replays the cached observations in between. Late observations go from
+    # short lags, which the recent snapshots cover, to lags far older than those and back.
+    np.random.seed(0)
+
+    kf = CompareFilter(GENERATED_DIR)
+
+    dt = 0.01
+    for i in range(3000):
+      t = i * dt
+      x = np.sin(t * 5)
+      phase = (i // 500) % 3
+      if i % 7 == 3:
+        t -= np.random.uniform(0.3, 0.9) if phase == 1 else np.random.uniform(0.01, 0.03)
+      if i % 501 == 500:
+        t -= 2.0  # too old for either
+
+      z = np.array([[np.random.normal(x, 0.1)]])
+      R = kf.get_R(ObservationKind.POSITION, 1)
+
+      res_py = kf.filter_py.predict_and_update_batch(t, ObservationKind.POSITION, z, R)
+      res_pyx = kf.filter_pyx.predict_and_update_batch(t, ObservationKind.POSITION, z, R)
+
+      assert (res_py is None) == (res_pyx is None)
+      assert kf.filter_py.get_filter_time() == pytest.approx(kf.filter_pyx.get_filter_time())
+      assert np.allclose(kf.filter_py.state(), kf.filter_pyx.state())
+      assert np.allclose(kf.filter_py.covs(), kf.filter_pyx.covs())
+
+  def test_compare_rewind_fast(self):
+    # At 1 kHz the 512 cached observations span about half a second, less than
+    # max_rewind_age. Lags up to the oldest cached observation must still be accepted.
+    np.random.seed(0)
+
+    kf = CompareFilter(GENERATED_DIR)
+
+    dt = 0.001
+    late = rejected = 0
+    for i in range(3000):
+      t = i * dt
+      x = np.sin(t * 5)
+      if i % 7 == 3 and i > 600:
+        t -= np.random.uniform(0.45, 0.53)
+        late += 1
+
+      z = np.array([[np.random.normal(x, 0.1)]])
+      R = kf.get_R(ObservationKind.POSITION, 1)
+
+      res_py = kf.filter_py.predict_and_update_batch(t, ObservationKind.POSITION, z, R)
+      res_pyx = kf.filter_pyx.predict_and_update_batch(t, ObservationKind.POSITION, z, R)
+
+      assert (res_py is None) == (res_pyx is None)
+      rejected += res_py is None
+      assert kf.filter_py.get_filter_time() == pytest.approx(kf.filter_pyx.get_filter_time())
+      assert np.allclose(kf.filter_py.state(), kf.filter_pyx.state())
+      assert np.allclose(kf.filter_py.covs(), kf.filter_pyx.covs())
+
+    # lags past 0.512 s are too old, the rest are rewound to
+    assert 0 < rejected < late
+
 
 if __name__ == "__main__":
   generated_dir = sys.argv[2]
@@ -39,6 +39,11 @@ EKFSym::EKFSym(std::string name, Map<MatrixXdr> Q, Map<VectorXd> x_initial, Map<
   this->Q = Q;
 
   this->max_rewind_age = max_rewind_age;
+  this->rewind_t.resize(REWIND_CACHE);
+  this->rewind_obscache.resize(REWIND_CACHE);
+  this->rewind_replay.resize(REWIND_CACHE);
+  this->rewind_anchors.init(REWIND_ANCHORS, this->dim_x, this->dim_err);
+  this->rewind_recent.init(REWIND_RECENT, this->dim_x, this->dim_err);
   this->init_state(x_initial, P_initial, NAN);
 }
 
@@ -85,13 +90,28 @@ std::optional<Estimate> EKFSym::predict_and_update_batch(double t, int kind, std
 {
   // TODO handle rewinding at this level
 
-  std::deque<Observation> rewound;
+  int replay_count = 0, replay_before = 0;
   if (!std::isnan(this->filter_time) && t < this->filter_time) {
-    if (this->rewind_t.empty() || t < this->rewind_t.front() || t < this->rewind_t.back() - this->max_rewind_age) {
+    const double lag = this->filter_time - t;
+    if (this->rewind_end == this->rewind_begin ||
+        t < this->rewind_t[(this->rewind_end - 1) % REWIND_CACHE] - this->max_rewind_age ||
+        (replay_count = this->rewind(t, replay_before)) < 0) {
       LOGD("observation too old at %f with filter at %f, ignoring!", t, this->filter_time);
       return std::nullopt;
     }
-    rewound = this->rewind(t);
+
+    // the recent snapshots cover twice the shortest lag seen within max_rewind_age, so the
+    // interval grows back once shorter lags stop coming
+    const double interval = lag / (REWIND_RECENT / 2);
+    if (interval <= this->recent_interval || t - this->recent_interval_t > this->max_rewind_age) {
+      this->recent_interval = interval;
+      this->recent_interval_t = t;
+    }
+  }
+
+  // replay up to t
+  for (int i = 0; i < replay_before; i++) {
+    this->predict_and_update_batch(this->rewind_replay[i], false);
   }
 
   Observation obs;
@@ -108,50 +128,88 @@ std::optional<Estimate> EKFSym::predict_and_update_batch(double t, int kind, std
   std::optional<Estimate> res = std::make_optional(this->predict_and_update_batch(obs, augment));
 
   // optional fast forward
-  while (!rewound.empty()) {
-    this->predict_and_update_batch(rewound.front(), false);
-    rewound.pop_front();
+  for (int i = replay_before; i < replay_count; i++) {
+    this->predict_and_update_batch(this->rewind_replay[i], false);
   }
 
   return res;
 }
 
 void EKFSym::reset_rewind() {
-  this->rewind_obscache.clear();
-  this->rewind_t.clear();
-  this->rewind_states.clear();
+  this->rewind_begin = this->rewind_end = 0;
+  this->rewind_anchors.clear();
+  this->rewind_recent.clear();
+  // no recent snapshots until an observation arrives late
+  this->recent_interval = INFINITY;
+  this->recent_interval_t = -INFINITY;
 }
 
-std::deque<Observation> EKFSym::rewind(double t) {
-  std::deque<Observation> rewound;
+int EKFSym::rewind(double t, int& replay_before) {
+  // observations from cut on came after t
+  uint64_t cut = this->rewind_end;
+  while (cut > this->rewind_begin && this->rewind_t[(cut - 1) % REWIND_CACHE] > t) {
+    cut--;
+  }
+  // older than the last REWIND_TO_KEEP observations, the rest of the cache only backs the anchors
+  if (cut == this->rewind_begin || this->rewind_end - cut >= REWIND_TO_KEEP) {
+    return -1;
+  }
+
+  // latest snapshot before that, the ones after it are invalidated by the new observation
+  const Snapshot* anchor = this->rewind_anchors.latest(cut);
+  const Snapshot* recent = this->rewind_recent.latest(cut);
+  const Snapshot* snapshot = (recent && (!anchor || recent->seq > anchor->seq)) ? recent : anchor;
+  if (!snapshot) {
+    return -1;
+  }
+  this->rewind_anchors.truncate(cut);
+  this->rewind_recent.truncate(cut);
 
-  // rewind observations until t is after previous observation
-  while (this->rewind_t.back() > t) {
-    rewound.push_front(this->rewind_obscache.back());
-    this->rewind_t.pop_back();
-    this->rewind_states.pop_back();
-    this->rewind_obscache.pop_back();
+  // move the observations since the snapshot out of the ring for replay
+  const int replay_count = this->rewind_end - snapshot->seq;
+  for (int i = 0; i < replay_count; i++) {
+    std::swap(this->rewind_replay[i], this->rewind_obscache[(snapshot->seq + i) % REWIND_CACHE]);
   }
+  replay_before = cut - snapshot->seq;
+  this->rewind_end = snapshot->seq;
 
   // set the state to the time right before that
-  this->filter_time = this->rewind_t.back();
-  this->x = this->rewind_states.back().first;
-  this->P = this->rewind_states.back().second;
+  this->filter_time = snapshot->t;
+  this->x = snapshot->x;
+  this->P = snapshot->P;
 
-  return rewound;
+  return replay_count;
 }
 
 void EKFSym::checkpoint(Observation& obs) {
-  // push to rewinder
-  this->rewind_t.push_back(this->filter_time);
-  this->rewind_states.push_back(std::make_pair(this->x, this->P));
-  this->rewind_obscache.push_back(obs);
+  // nothing can be rewound
+  if (this->max_rewind_age <= 0) {
+    return;
+  }
+
+  // only keep a certain number around, snapshots that need the dropped observation go with it
+  if (this->rewind_end - this->rewind_begin == REWIND_CACHE) {
+    this->rewind_begin++;
+    this->rewind_anchors.drop_before(this->rewind_begin);
+    this->rewind_recent.drop_before(this->rewind_begin);
+  }
 
-  // only keep a certain number around
-  if (this->rewind_t.size() > REWIND_TO_KEEP) {
-    this->rewind_t.pop_front();
-    this->rewind_states.pop_front();
-    this->rewind_obscache.pop_front();
+  // push to rewinder, obs is swapped into the ring to reuse its buffers
+  const uint64_t slot = this->rewind_end % REWIND_CACHE;
+  this->rewind_t[slot] = this->filter_time;
+  std::swap(this->rewind_obscache[slot], obs);
+  this->rewind_end++;
+
+  // anchors span max_rewind_age and at least the cached observations
+  const Snapshot* anchor = this->rewind_anchors.back();
+  if (!anchor || this->filter_time - anchor->t >= this->max_rewind_age / REWIND_ANCHORS_PER_AGE ||
+      this->rewind_end - anchor->seq >= REWIND_ANCHOR_OBS) {
+    this->rewind_anchors.push(this->filter_time, this->rewind_end, this->x, this->P);
+  } else {
+    const Snapshot* recent = this->rewind_recent.back();
+    if (!recent || this->filter_time - recent->t >= this->recent_interval) {
+      this->rewind_recent.push(this->filter_time, this->rewind_end, this->x, this->P);
+    }
   }
 }
 
@@ -221,3 +279,53 @@ VectorXd EKFSym::update(int kind, VectorXd z, MatrixXdr R, std::vector<double> e
 extra_routine_t EKFSym::get_extra_routine(const std::string& routine) {
   return this->ekf->extra_routines.at(routine);
 }
+
+void SnapshotRing::init(int capacity, int dim_x, int dim_err) {
+  this->buf.resize(capacity);
+  for (Snapshot& s : this->buf) {
+    s.x.resize(dim_x);
+    s.P.resize(dim_err, dim_err);
+  }
+  this->clear();
+}
+
+void SnapshotRing::clear() {
+  this->begin = this->end = 0;
+}
+
+const Snapshot* SnapshotRing::back() const {
+  return this->begin == this->end ? NULL : &this->buf[(this->end - 1) % this->buf.size()];
+}
+
+void SnapshotRing::push(double t, uint64_t seq, const VectorXd& x, const MatrixXdr& P) {
+  if (this->end - this->begin == this->buf.size()) {
+    this->begin++;
+  }
+  Snapshot& s = this->buf[this->end++ % this->buf.size()];
+  s.t = t;
+  s.seq = seq;
+  s.x = x;
+  s.P = P;
+}
+
+void SnapshotRing::drop_before(uint64_t seq) {
+  while (this->begin != this->end && this->buf[this->begin % this->buf.size()].seq < seq) {
+    this->begin++;
+  }
+}
+
+const Snapshot* SnapshotRing::latest(uint64_t seq) const {
+  for (uint64_t i = this->end; i > this->begin; i--) {
+    const Snapshot& s = this->buf[(i - 1) % this->buf.size()];
+    if (s.seq <= seq) {
+      return &s;
+    }
+  }
+  return NULL;
+}
+
+void SnapshotRing::truncate(uint64_t seq) {
+  while (this->begin != this->end && this->buf[(this->end - 1) % this->buf.size()].seq > seq) {
+    this->end--;
+  }
+}
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <cassert>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <deque>
@@ -16,6 +17,14 @@
 #include "ekf_load.h"
 
 #define REWIND_TO_KEEP 512
+// anchors are at most REWIND_ANCHOR_OBS observations and max_rewind_age / REWIND_ANCHORS_PER_AGE apart.
+// The cache keeps REWIND_ANCHOR_OBS observations more than can be rewound to, so there is always an
+// anchor before the oldest one, and the anchor ring holds every anchor in the cache or max_rewind_age.
+#define REWIND_ANCHOR_OBS 32
+#define REWIND_ANCHORS_PER_AGE 8
+#define REWIND_CACHE (REWIND_TO_KEEP + REWIND_ANCHOR_OBS)
+#define REWIND_ANCHORS (REWIND_CACHE / REWIND_ANCHOR_OBS + REWIND_ANCHORS_PER_AGE + 2)
+#define REWIND_RECENT 32
 
 namespace EKFS {
 
@@ -41,6 +50,33 @@ typedef struct Estimate {
   std::vector<std::vector<double>> extra_args;
 } Estimate;
 
+// filter state after the first seq cached observations were applied
+typedef struct Snapshot {
+  double t;
+  uint64_t seq;
+  Eigen::VectorXd x;
+  MatrixXdr P;
+} Snapshot;
+
+// Fixed capacity ring of snapshots, the slots are allocated once
+class SnapshotRing {
+public:
+  void init(int capacity, int dim_x, int dim_err);
+  void clear();
+  const Snapshot* back() const;
+  void push(double t, uint64_t seq, const Eigen::VectorXd& x, const MatrixXdr& P);
+  // drops the snapshots that need observations before seq for replay
+  void drop_before(uint64_t seq);
+  // latest snapshot taken after at most seq observations
+  const Snapshot* latest(uint64_t seq) const;
+  // drops the snapshots taken after more than seq observations
+  void truncate(uint64_t seq);
+
+private:
+  std::vector<Snapshot> buf;
+  uint64_t begin = 0, end = 0;
+};
+
 class EKFSym {
 public:
   EKFSym(std::string name, Eigen::Map<MatrixXdr> Q, Eigen::Map<Eigen::VectorXd> x_initial,
@@ -66,7 +102,7 @@ public:
   extra_routine_t get_extra_routine(const std::string& routine);
 
 private:
-  std::deque<Observation> rewind(double t);
+  int rewind(double t, int& replay_before);
   void checkpoint(Observation& obs);
 
   Estimate predict_and_update_batch(Observation& obs, bool augment);
@@ -99,11 +135,17 @@ private:
   // process noise
   MatrixXdr Q;
 
-  // rewind stuff
+  // rewind stuff. Late observations can go back REWIND_TO_KEEP observations, but the state is only
+  // kept at anchors spread over max_rewind_age, and densely around the lag of late observations
+  // once there were any. All rings are allocated once and indexed by observation sequence number.
   double max_rewind_age;
-  std::deque<double> rewind_t;
-  std::deque<std::pair<Eigen::VectorXd, MatrixXdr>> rewind_states;
-  std::deque<Observation> rewind_obscache;
+  double recent_interval, recent_interval_t;
+  uint64_t rewind_begin, rewind_end;
+  std::vector<double> rewind_t;  // filter time after each observation
+  std::vector<Observation> rewind_obscache;
+  std::vector<Observation> rewind_replay;
+  SnapshotRing rewind_anchors;
+  SnapshotRing rewind_recent;
 
   Eigen::VectorXd augment_times;
 
@@ -26,6 +26,21 @@ def null(H, eps=1e-12):
   return np.transpose(null_space)
 
 
+def gen_fixed_header(name, obs_eqs, dim_x, dim_err, msckf):
+  # C++ alias of EKFSymFixed with the dimensions of this filter
+  header = "#pragma once\n"
+  if msckf:
+    return header + f"// {name} uses MSCKF augmentation, it has no fixed size version\n"
+
+  max_z_dim = max(int(h_sym.shape[0]) for h_sym, _, _, _, _ in obs_eqs)
+  max_ea_dim = max([int(ea_sym.shape[0]) for _, _, ea_sym, _, _ in obs_eqs if ea_sym is not None] + [1])
+  header += "#include \"rednose/helpers/ekf_sym_fixed.h\"\n\n"
+  header += "namespace EKFS {\n"
+  header += f"using {name}_fixed = EKFSymFixed<{dim_x}, {dim_err}, {max_z_dim}, {max_ea_dim}>;\n"
+  header += "}\n"
+  return header
+
+
 def gen_code(folder, name, f_sym, dt_sym, x_sym, obs_eqs, dim_x, dim_err, eskf_params=None, msckf_params=None,  # pylint: disable=dangerous-default-value
              maha_test_kinds=[], quaternion_idxs=[], global_vars=None, extra_routines=[]):
   # optional state transition matrix, H modifier
@@ -148,7 +163,11 @@ def gen_code(folder, name, f_sym, dt_sym, x_sym, obs_eqs, dim_x, dim_err, eskf_p
 
     header += f"void {name}_update_{kind}(double *in_x, double *in_P, double *in_z, double *in_R, double *in_ea);\n"
     post_code += f"void {name}_update_{kind}(double *in_x, double *in_P, double *in_z, double *in_R, double *in_ea) {{\n"
-    post_code += f"  update<{h_sym.shape[0]}, 3, {int(maha_test)}>(in_x, in_P, h_{kind}, H_{kind}, {He_str}, in_z, in_R, in_ea, MAHA_THRESH_{kind});\n"
+    # kinds without null space projection have fixed sizes, their update doesn't allocate
+    if He_str == 'NULL':
+      post_code += f"  update_fixed<{h_sym.shape[0]}, {int(maha_test)}>(in_x, in_P, h_{kind}, H_{kind}, in_z, in_R, in_ea, MAHA_THRESH_{kind});\n"
+    else:
+      post_code += f"  update<{h_sym.shape[0]}, 3, {int(maha_test)}>(in_x, in_P, h_{kind}, H_{kind}, {He_str}, in_z, in_R, in_ea, MAHA_THRESH_{kind});\n"
     post_code += "}\n"
 
   # For ffi loading of specific functions
@@ -213,6 +232,8 @@ def gen_code(folder, name, f_sym, dt_sym, x_sym, obs_eqs, dim_x, dim_err, eskf_p
 
   with open(os.path.join(folder, f"{name}.h"), 'w', encoding='utf-8') as f:
     f.write(header)  # header is used for ffi import
+  with open(os.path.join(folder, f"{name}_fixed.h"), 'w', encoding='utf-8') as f:
+    f.write(gen_fixed_header(name, obs_eqs, dim_x, dim_err, msckf))
   with open(os.path.join(folder, f"{name}.cpp"), 'w', encoding='utf-8') as f:
     f.write(code)
 
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#include "ekf.h"
+#include "ekf_load.h"
+#include "ekf_sym.h"
+
+namespace EKFS {
+
+// EKFSym with the dimensions known at compile time. State and covariance are fixed size Eigen
+// matrices and observations are copied into preallocated arrays, so predict and update don't
+// touch the heap. Only for filters without MSCKF augmentation, the generator writes an alias
+// with the dimensions of each filter to <name>_fixed.h.
+template <int DIM, int EDIM, int MAX_ZDIM, int MAX_EADIM, int MAX_BATCH = 8, int REWIND = REWIND_TO_KEEP>
+class EKFSymFixed {
+public:
+  typedef Eigen::Matrix<double, DIM, 1> StateVector;
+  typedef Eigen::Matrix<double, EDIM, EDIM, Eigen::RowMajor> CovMatrix;
+
+  EKFSymFixed(const std::string &name, const CovMatrix &Q_initial, const StateVector &x_initial, const CovMatrix &P_initial,
+              std::vector<int> quat_idxs = {}, double rewind_age = 1.0)
+      : ekf(ekf_lookup(name)), Q(Q_initial), quaternion_idxs(quat_idxs), max_rewind_age(rewind_age),
+        rewind_buf(std::make_unique<Checkpoint[]>(REWIND)), replay(std::make_unique<Observation[]>(REWIND)) {
+    assert(ekf);
+    init_state(x_initial, P_initial, NAN);
+  }
+
+  void init_state(const StateVector &state, const CovMatrix &covs, double init_filter_time) {
+    x = state;
+    P = covs;
+    filter_time = init_filter_time;
+    reset_rewind();
+  }
+
+  const StateVector &state() const { return x; }
+  const CovMatrix &covs() const { return P; }
+  void set_filter_time(double t) { filter_time = t; }
+  double get_filter_time() const { return filter_time; }
+  void set_global(const std::string &global_var, double val) { ekf->sets.at(global_var)(val); }
+  void reset_rewind() { rewind_start = rewind_size = 0; }
+
+  void predict(double t) {
+    // initialize time
+    if (std::isnan(filter_time)) {
+      filter_time = t;
+    }
+
+    double dt = t - filter_time;
+    assert(dt >= 0.0);
+
+    ekf->predict(x.data(), P.data(), Q.data(), dt);
+    normalize_quaternions();
+    filter_time = t;
+  }
+
+  // n observations of z_dim values with their z_dim x z_dim row major covariances, and ea_dim
+  // extra args each. y receives the n * z_dim residuals if not null. Returns false if the
+  // observation is too old to rewind to.
+  bool predict_and_update_batch(double t, int kind, const double *z, const double *R, int n, int z_dim,
+                                const double *extra_args = nullptr, int ea_dim = 0, double *y = nullptr) {
+    assert(n <= MAX_BATCH && z_dim <= MAX_ZDIM && ea_dim <= MAX_EADIM);
+
+    int num_replay = 0;
+    if (!std::isnan(filter_time) && t < filter_time) {
+      if (rewind_size == 0 || t < checkpoint(0).t || t < checkpoint(rewind_size - 1).t - max_rewind_age) {
+        return false;
+      }
+      num_replay = rewind(t);
+    }
+
+    Observation obs;
+    obs.t = t;
+    obs.kind = kind;
+    obs.n = n;
+    obs.z_dim = z_dim;
+    obs.ea_dim = ea_dim;
+    std::copy_n(z, n * z_dim, obs.z.begin());
+    std::copy_n(R, n * z_dim * z_dim, obs.R.begin());
+    if (extra_args) std::copy_n(extra_args, n * ea_dim, obs.ea.begin());
+    update_batch(obs, y);
+
+    // fast forward through the observations that came after t
+    for (int i = 0; i < num_replay; i++) {
+      update_batch(replay[i], nullptr);
+    }
+    return true;
+  }
+
+private:
+  struct Observation {
+    double t;
+    int kind, n, z_dim, ea_dim;
+    std::array<double, MAX_BATCH * MAX_ZDIM> z;
+    std::array<double, MAX_BATCH * MAX_ZDIM * MAX_ZDIM> R;
+    std::array<double, MAX_BATCH * MAX_EADIM> ea;
+  };
+
+  // filter state right after obs was applied
+  struct Checkpoint {
+    double t;
+    StateVector x;
+    CovMatrix P;
+    Observation obs;
+  };
+
+  Checkpoint &checkpoint(int i) { return rewind_buf[(rewind_start + i) % REWIND]; }
+
+  void normalize_quaternions() {
+    for (int idx : quaternion_idxs) {
+      x.template segment<4>(idx).normalize();
+    }
+  }
+
+  void update_batch(const Observation &obs, double *y) {
+    predict(obs.t);
+
+    // the generated update writes the residual back into z
+    std::array<double, MAX_ZDIM> zi;
+    std::array<double, MAX_ZDIM * MAX_ZDIM> Ri;
+    std::array<double, MAX_EADIM> eai = {};
+    const auto update = ekf->updates.at(obs.kind);
+    for (int i = 0; i < obs.n; i++) {
+      std::copy_n(&obs.z[i * obs.z_dim], obs.z_dim, zi.begin());
+      std::copy_n(&obs.R[i * obs.z_dim * obs.z_dim], obs.z_dim * obs.z_dim, Ri.begin());
+      std::copy_n(&obs.ea[i * obs.ea_dim], obs.ea_dim, eai.begin());
+      update(x.data(), P.data(), zi.data(), Ri.data(), eai.data());
+      normalize_quaternions();
+      if (y) std::copy_n(zi.begin(), obs.z_dim, &y[i * obs.z_dim]);
+    }
+
+    push_checkpoint(obs);
+  }
+
+  void push_checkpoint(const Observation &obs) {
+    // only keep a certain number around
+    if (rewind_size == REWIND) {
+      rewind_start = (rewind_start + 1) % REWIND;
+      rewind_size--;
+    }
+    Checkpoint &c = checkpoint(rewind_size++);
+    c.t = filter_time;
+    c.x = x;
+    c.P = P;
+    c.obs = obs;
+  }
+
+  // restores the state before the first observation after t, returns the number of
+  // observations moved into replay
+  int rewind(double t) {
+    int first = rewind_size;
+    while (first > 1 && checkpoint(first - 1).t > t) {
+      first--;
+    }
+    const int num_replay = rewind_size - first;
+    for (int i = 0; i < num_replay; i++) {
+      replay[i] = checkpoint(first + i).obs;
+    }
+    rewind_size = first;
+
+    // set the state to the time right before that
+    const Checkpoint &c = checkpoint(rewind_size - 1);
+    filter_time = c.t;
+    x = c.x;
+    P = c.P;
+    return num_replay;
+  }
+
+  const EKF *ekf = nullptr;
+  StateVector x;
+  CovMatrix P;
+  CovMatrix Q;
+  double filter_time;
+  std::vector<int> quaternion_idxs;
+  double max_rewind_age;
+
+  // ring of the last REWIND checkpoints, allocated once
+  std::unique_ptr<Checkpoint[]> rewind_buf;
+  int rewind_start = 0, rewind_size = 0;
+  std::unique_ptr<Observation[]> replay;
+};
+
+}
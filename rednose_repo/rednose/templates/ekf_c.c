@@ -121,3 +121,64 @@ void update(double *in_x, double *in_P, Hfun h_fun, Hfun H_fun, Hfun Hea_fun, do
 }
 
 
+
+// update for kinds without null space projection. Every matrix has a compile time size,
+// so nothing is allocated on the heap.
+template <int ZDIM, bool MAHA_TEST>
+void update_fixed(double *in_x, double *in_P, Hfun h_fun, Hfun H_fun, double *in_z, double *in_R, double *in_ea, double MAHA_THRESHOLD) {
+  typedef Eigen::Matrix<double, ZDIM, 1> Z1M;
+  typedef Eigen::Matrix<double, ZDIM, ZDIM, Eigen::RowMajor> ZZM;
+  typedef Eigen::Matrix<double, ZDIM, DIM, Eigen::RowMajor> ZDM;
+  typedef Eigen::Matrix<double, ZDIM, EDIM, Eigen::RowMajor> ZEM;
+
+  double in_hx[ZDIM] = {0};
+  double in_H[ZDIM * DIM] = {0};
+  double in_H_mod[EDIM * DIM] = {0};
+  double delta_x[EDIM] = {0};
+  double x_new[DIM] = {0};
+
+  // state x, P
+  Z1M z(in_z);
+  EEM P(in_P);
+  ZZM R(in_R);
+
+  // functions from sympy
+  h_fun(in_x, in_ea, in_hx);
+  H_fun(in_x, in_ea, in_H);
+  ZDM H(in_H);
+
+  // get y (y = z - hx)
+  Z1M y = z - Z1M(in_hx);
+
+  // get modified H
+  H_mod_fun(in_x, in_H_mod);
+  DEM H_mod(in_H_mod);
+  ZEM H_err = H * H_mod;
+
+  // Do mahalobis distance test
+  if (MAHA_TEST){
+    ZZM a = (H_err * P * H_err.transpose() + R).inverse();
+    double maha_dist = (y.transpose() * a * y).value();
+    if (maha_dist > MAHA_THRESHOLD){
+      R = 1.0e16 * R;
+    }
+  }
+
+  // kalman gains and I_KH
+  ZZM S = ((H_err * P) * H_err.transpose()) + R;
+  ZEM KT = S.fullPivLu().solve(H_err * P.transpose());
+  EEM I_KH = EEM::Identity() - (KT.transpose() * H_err);
+
+  // update state by injecting dx
+  Eigen::Map<Eigen::Matrix<double, EDIM, 1>> dx(delta_x);
+  dx = KT.transpose() * y;
+  err_fun(in_x, delta_x, x_new);
+
+  // update cov
+  P = ((I_KH * P) * I_KH.transpose()) + ((KT.transpose() * R) * KT);
+
+  // copy out state
+  memcpy(in_x, x_new, DIM * sizeof(double));
+  memcpy(in_P, P.data(), EDIM * EDIM * sizeof(double));
+  memcpy(in_z, y.data(), ZDIM * sizeof(double));
+}
@@ -4,7 +4,7 @@ from SCons.Script import Dir, File
 
 
 def compile_single_filter(env, target, filter_gen_script, output_dir, extra_gen_artifacts, script_deps):
-  generated_src_files = [File(f) for f in [f'{output_dir}/{target}.cpp', f'{output_dir}/{target}.h']]
+  generated_src_files = [File(f) for f in [f'{output_dir}/{target}.cpp', f'{output_dir}/{target}.h', f'{output_dir}/{target}_fixed.h']]
   extra_generated_files = [File(f'{output_dir}/{x}') for x in extra_gen_artifacts]
   generator_file = File(filter_gen_script)
 
@@ -0,0 +1,187 @@
+// Update rate of the generated pose and car filters through the dynamic EKFSym and the
+// fixed size EKFSymFixed. Both run the same observation stream, which has some late camera
+// observations to exercise rewinding, and have to end up in the same state.
+//
+// The final states are printed in full. The fixed size filter must not allocate while it runs,
+// heap allocations are counted with a malloc wrapper.
+//
+// usage: ekf_benchmark [seconds of simulated data] [generated filter dir]
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "common/timing.h"
+#include "rednose/helpers/ekf_load.h"
+#include "rednose/helpers/ekf_sym.h"
+#include "selfdrive/locationd/models/generated/car_fixed.h"
+#include "selfdrive/locationd/models/generated/pose_fixed.h"
+
+using namespace EKFS;
+
+// glibc's own malloc, wrapped to count the allocations while counting is on
+extern "C" void *__libc_malloc(size_t size);
+static std::atomic<bool> count_allocs = false;
+static std::atomic<uint64_t> allocs = 0;
+
+extern "C" void *malloc(size_t size) {
+  if (count_allocs) allocs++;
+  return __libc_malloc(size);
+}
+
+namespace {
+
+// selfdrive/locationd/models/constants.py
+enum ObservationKind {
+  PHONE_GYRO = 4,
+  PHONE_ACCEL = 10,
+  CAMERA_ODO_TRANSLATION = 13,
+  CAMERA_ODO_ROTATION = 14,
+  ROAD_FRAME_XY_SPEED = 24,
+  ROAD_FRAME_YAW_RATE = 25,
+  STEER_ANGLE = 26,
+  ANGLE_OFFSET_FAST = 27,
+  ROAD_ROLL = 31,
+};
+
+struct Obs {
+  double t;
+  int kind;
+  int z_dim;
+  double z[3];
+  double R[9];
+};
+
+Obs make_obs(double t, int kind, int z_dim, double noise, std::initializer_list<double> z) {
+  Obs o = {t, kind, z_dim, {}, {}};
+  int i = 0;
+  for (double v : z) o.z[i++] = v;
+  for (int j = 0; j < z_dim; j++) o.R[j * z_dim + j] = noise;
+  return o;
+}
+
+// 100 Hz imu, 20 Hz camera odometry where every fourth message arrives 60 ms late
+std::vector<Obs> pose_stream(double seconds) {
+  std::vector<Obs> obs;
+  for (int i = 0; i < seconds * 100; i++) {
+    const double t = i * 0.01;
+    obs.push_back(make_obs(t, PHONE_GYRO, 3, 0.025 * 0.025, {0.01 * std::sin(t), 0.002, 0.05 * std::cos(0.3 * t)}));
+    obs.push_back(make_obs(t + 0.001, PHONE_ACCEL, 3, 0.25, {0.3 * std::sin(0.5 * t), 0.1, 9.81}));
+    if (i % 5 == 0) {
+      const double t_cam = (i % 20 == 0 && i >= 20) ? t - 0.06 : t;
+      obs.push_back(make_obs(t_cam, CAMERA_ODO_TRANSLATION, 3, 0.25, {10.0 + std::sin(0.1 * t), 0.0, 0.0}));
+      obs.push_back(make_obs(t_cam, CAMERA_ODO_ROTATION, 3, 0.0025, {0.0, 0.0, 0.05 * std::cos(0.3 * t)}));
+    }
+  }
+  return obs;
+}
+
+std::vector<Obs> car_stream(double seconds) {
+  std::vector<Obs> obs;
+  for (int i = 0; i < seconds * 100; i++) {
+    const double t = i * 0.01;
+    obs.push_back(make_obs(t, STEER_ANGLE, 1, 1e-6, {0.05 * std::sin(0.2 * t)}));
+    obs.push_back(make_obs(t, ROAD_FRAME_XY_SPEED, 2, 0.01, {20.0, 0.0}));
+    obs.push_back(make_obs(t, ROAD_FRAME_YAW_RATE, 1, 1e-4, {0.02 * std::sin(0.2 * t)}));
+    if (i % 5 == 0) {
+      obs.push_back(make_obs(t, ANGLE_OFFSET_FAST, 1, 0.03, {0.0}));
+      obs.push_back(make_obs(t, ROAD_ROLL, 1, 3e-4, {0.01}));
+    }
+  }
+  return obs;
+}
+
+template <typename KF>
+void set_car_globals(KF &kf) {
+  kf.set_global("mass", 1500.0);
+  kf.set_global("rotational_inertia", 2500.0);
+  kf.set_global("center_to_front", 1.3);
+  kf.set_global("center_to_rear", 1.4);
+  kf.set_global("stiffness_front", 80000.0);
+  kf.set_global("stiffness_rear", 90000.0);
+}
+
+double run_dynamic(EKFSym &kf, const std::vector<Obs> &obs) {
+  const uint64_t start = nanos_since_boot();
+  for (const Obs &o : obs) {
+    std::vector<Eigen::Map<Eigen::VectorXd>> z = {Eigen::Map<Eigen::VectorXd>((double *)o.z, o.z_dim)};
+    std::vector<Eigen::Map<MatrixXdr>> R = {Eigen::Map<MatrixXdr>((double *)o.R, o.z_dim, o.z_dim)};
+    kf.predict_and_update_batch(o.t, o.kind, z, R);
+  }
+  return (nanos_since_boot() - start) * 1e-9;
+}
+
+template <typename KF>
+double run_fixed(KF &kf, const std::vector<Obs> &obs, uint64_t &num_allocs) {
+  allocs = 0;
+  count_allocs = true;
+  const uint64_t start = nanos_since_boot();
+  for (const Obs &o : obs) {
+    kf.predict_and_update_batch(o.t, o.kind, o.z, o.R, 1, o.z_dim);
+  }
+  const uint64_t end = nanos_since_boot();
+  count_allocs = false;
+  num_allocs = allocs;
+  return (end - start) * 1e-9;
+}
+
+template <typename KF>
+bool benchmark(const char *name, int dim, std::vector<double> Q, std::vector<double> x0, std::vector<double> P0,
+               const std::vector<Obs> &obs, bool globals) {
+  Eigen::Map<MatrixXdr> Q_map(Q.data(), dim, dim), P_map(P0.data(), dim, dim);
+  Eigen::Map<Eigen::VectorXd> x_map(x0.data(), dim);
+
+  EKFSym dynamic(name, Q_map, x_map, P_map, dim, dim);
+  KF fixed(name, typename KF::CovMatrix(Q_map), typename KF::StateVector(x_map), typename KF::CovMatrix(P_map));
+  if (globals) {
+    set_car_globals(dynamic);
+    set_car_globals(fixed);
+  }
+
+  const double dynamic_secs = run_dynamic(dynamic, obs);
+  uint64_t fixed_allocs = 0;
+  const double fixed_secs = run_fixed(fixed, obs, fixed_allocs);
+
+  const double x_diff = (dynamic.state() - fixed.state()).cwiseAbs().maxCoeff();
+  const double P_diff = (dynamic.covs() - fixed.covs()).cwiseAbs().maxCoeff();
+  printf("%s: %zu observations, dynamic %.0f updates/s, fixed %.0f updates/s (%.2fx), max diff x %g P %g, fixed allocations %lu\n",
+         name, obs.size(), obs.size() / dynamic_secs, obs.size() / fixed_secs, dynamic_secs / fixed_secs, x_diff, P_diff, fixed_allocs);
+  printf("%s x:", name);
+  for (int i = 0; i < dim; i++) printf(" %.17g", dynamic.state()(i));
+  printf("\n");
+  return x_diff < 1e-9 && P_diff < 1e-9 && fixed_allocs == 0;
+}
+
+std::vector<double> diag(std::vector<double> d) {
+  std::vector<double> m(d.size() * d.size());
+  for (size_t i = 0; i < d.size(); i++) m[i * d.size() + i] = d[i];
+  return m;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const double seconds = argc > 1 ? atof(argv[1]) : 60.0;
+  const char *generated_dir = argc > 2 ? argv[2] : "selfdrive/locationd/models/generated";
+
+  // loaded the same way as ekf_sym_pyx
+  ekf_load_and_register(generated_dir, "pose");
+  ekf_load_and_register(generated_dir, "car");
+
+  // selfdrive/locationd/models/pose_kf.py
+  std::vector<double> pose_Q = diag({1e-6, 1e-6, 1e-6, 1e-4, 1e-4, 1e-4, 1e-2, 1e-2, 1e-2,
+                                     2.5e-9, 2.5e-9, 2.5e-9, 9.0, 9.0, 9.0, 2.5e-5, 2.5e-5, 2.5e-5});
+  std::vector<double> pose_P = diag({1e-4, 1e-4, 1e-4, 100.0, 100.0, 100.0, 1.0, 1.0, 1.0,
+                                     1.0, 1.0, 1.0, 1e4, 1e4, 1e4, 1e-4, 1e-4, 1e-4});
+  bool ok = benchmark<pose_fixed>("pose", 18, pose_Q, std::vector<double>(18, 0.0), pose_P, pose_stream(seconds), false);
+
+  // selfdrive/locationd/models/car_kf.py
+  const double deg = M_PI / 180.0;
+  std::vector<double> car_Q = diag({std::pow(0.05 / 100, 2), 1e-4, std::pow(0.02 * deg, 2), std::pow(0.25 * deg, 2),
+                                    1e-2, 1e-4, std::pow(0.1 * deg, 2), std::pow(0.1 * deg, 2), std::pow(1.0 * deg, 2)});
+  ok &= benchmark<car_fixed>("car", 9, car_Q, {1.0, 15.0, 0.0, 0.0, 10.0, 0.0, 0.0, 0.0, 0.0}, car_Q, car_stream(seconds), true);
+
+  return ok ? 0 : 1;
+}
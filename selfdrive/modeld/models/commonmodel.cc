@@ -1,5 +1,6 @@
 #include "selfdrive/modeld/models/commonmodel.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstring>
@@ -7,38 +8,52 @@
 #include "common/clutil.h"
 
 ModelFrame::ModelFrame(cl_device_id device_id, cl_context context) {
-  input_frames = std::make_unique<uint8_t[]>(buf_size);
+  input_frames[0] = std::make_unique<uint8_t[]>(buf_size);
+  input_frames[1] = std::make_unique<uint8_t[]>(buf_size);
 
   q = CL_CHECK_ERR(clCreateCommandQueue(context, device_id, 0, &err));
+  readback_q = CL_CHECK_ERR(clCreateCommandQueue(context, device_id, 0, &err));
   y_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, MODEL_WIDTH * MODEL_HEIGHT, NULL, &err));
   u_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, (MODEL_WIDTH / 2) * (MODEL_HEIGHT / 2), NULL, &err));
   v_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, (MODEL_WIDTH / 2) * (MODEL_HEIGHT / 2), NULL, &err));
-  img_buffer_20hz_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, 5*frame_size_bytes, NULL, &err));
-  region.origin = 4 * frame_size_bytes;
-  region.size = frame_size_bytes;
-  last_img_cl = CL_CHECK_ERR(clCreateSubBuffer(img_buffer_20hz_cl, CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION, &region, &err));
+  for (int i = 0; i < HISTORY_FRAMES; i++) {
+    history_cl[i] = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, frame_size_bytes, NULL, &err));
+  }
 
   transform_init(&transform, context, device_id);
   loadyuv_init(&loadyuv, context, device_id, MODEL_WIDTH, MODEL_HEIGHT);
 }
 
 uint8_t* ModelFrame::prepare(cl_mem yuv_cl, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3 &projection, cl_mem *output) {
+  // the slot of the oldest frame becomes the newest, the rest of the history stays in place
+  history_idx = (history_idx + 1) % HISTORY_FRAMES;
+  cl_mem newest_cl = history_cl[history_idx];
+  cl_mem oldest_cl = history_cl[(history_idx + 1) % HISTORY_FRAMES];
+
+  uint8_t *input = nullptr;
+  cl_event read_events[2];
+  if (output == NULL) {
+    input_idx ^= 1;
+    input = input_frames[input_idx].get();
+    // the oldest frame was warped frames ago, it doesn't need to wait for this warp
+    CL_CHECK(clEnqueueReadBuffer(readback_q, oldest_cl, CL_FALSE, 0, frame_size_bytes, &input[0], 0, nullptr, &read_events[0]));
+    CL_CHECK(clFlush(readback_q));
+  }
+
   transform_queue(&this->transform, q,
                 yuv_cl, frame_width, frame_height, frame_stride, frame_uv_offset,
                 y_cl, u_cl, v_cl, MODEL_WIDTH, MODEL_HEIGHT, projection);
+  loadyuv_queue(&loadyuv, q, y_cl, u_cl, v_cl, newest_cl);
 
-  for (int i = 0; i < 4; i++) {
-    CL_CHECK(clEnqueueCopyBuffer(q, img_buffer_20hz_cl, img_buffer_20hz_cl, (i+1)*frame_size_bytes, i*frame_size_bytes, frame_size_bytes, 0, nullptr, nullptr));
-  }
-  loadyuv_queue(&loadyuv, q, y_cl, u_cl, v_cl, last_img_cl);
   if (output == NULL) {
-    CL_CHECK(clEnqueueReadBuffer(q, img_buffer_20hz_cl, CL_TRUE, 0, frame_size_bytes, &input_frames[0], 0, nullptr, nullptr));
-    CL_CHECK(clEnqueueReadBuffer(q, last_img_cl, CL_TRUE, 0, frame_size_bytes, &input_frames[MODEL_FRAME_SIZE], 0, nullptr, nullptr));
-    clFinish(q);
-    return &input_frames[0];
+    CL_CHECK(clEnqueueReadBuffer(q, newest_cl, CL_FALSE, 0, frame_size_bytes, &input[MODEL_FRAME_SIZE], 0, nullptr, &read_events[1]));
+    CL_CHECK(clWaitForEvents(2, read_events));
+    CL_CHECK(clReleaseEvent(read_events[0]));
+    CL_CHECK(clReleaseEvent(read_events[1]));
+    return input;
   } else {
-    copy_queue(&loadyuv, q, img_buffer_20hz_cl, *output, 0, 0, frame_size_bytes);
-    copy_queue(&loadyuv, q, last_img_cl, *output, 0, frame_size_bytes, frame_size_bytes);
+    copy_queue(&loadyuv, q, oldest_cl, *output, 0, 0, frame_size_bytes);
+    copy_queue(&loadyuv, q, newest_cl, *output, 0, frame_size_bytes, frame_size_bytes);
 
     // NOTE: Since thneed is using a different command queue, this clFinish is needed to ensure the image is ready.
     clFinish(q);
@@ -49,10 +64,84 @@ uint8_t* ModelFrame::prepare(cl_mem yuv_cl, int frame_width, int frame_height, i
 ModelFrame::~ModelFrame() {
   transform_destroy(&transform);
   loadyuv_destroy(&loadyuv);
-  CL_CHECK(clReleaseMemObject(img_buffer_20hz_cl));
-  CL_CHECK(clReleaseMemObject(last_img_cl));
+  for (int i = 0; i < HISTORY_FRAMES; i++) {
+    CL_CHECK(clReleaseMemObject(history_cl[i]));
+  }
   CL_CHECK(clReleaseMemObject(v_cl));
   CL_CHECK(clReleaseMemObject(u_cl));
   CL_CHECK(clReleaseMemObject(y_cl));
+  CL_CHECK(clReleaseCommandQueue(readback_q));
   CL_CHECK(clReleaseCommandQueue(q));
-}
\ No newline at end of file
+}
+
+// ModelFrameCPU
+
+ModelFrameCPU::ModelFrameCPU(int num_threads) {
+  history = std::make_unique<uint8_t[]>(HISTORY_FRAMES * frame_size_bytes);
+  input_frames = std::make_unique<uint8_t[]>(buf_size);
+
+  const int uv_rows = MODEL_HEIGHT / 2;
+  if (num_threads <= 0) num_threads = std::max(1, (int)std::thread::hardware_concurrency());
+  num_threads = std::min(num_threads, uv_rows);
+
+  bands = std::vector<Band>(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    bands[i].uv_row_start = uv_rows * i / num_threads;
+    bands[i].uv_row_end = uv_rows * (i + 1) / num_threads;
+  }
+  for (int i = 1; i < num_threads; i++) {
+    workers.emplace_back(&ModelFrameCPU::workerThread, this, i);
+  }
+}
+
+ModelFrameCPU::~ModelFrameCPU() {
+  {
+    std::lock_guard lk(lock);
+    exit = true;
+  }
+  work_cv.notify_all();
+  for (auto &t : workers) t.join();
+}
+
+uint8_t* ModelFrameCPU::prepare(const uint8_t *yuv, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3 &projection) {
+  // the slot of the oldest frame becomes the newest, nothing is shifted
+  history_idx = (history_idx + 1) % HISTORY_FRAMES;
+  uint8_t *newest = &history[history_idx * frame_size_bytes];
+  {
+    std::lock_guard lk(lock);
+    job = {yuv, frame_width, frame_height, frame_stride, frame_uv_offset, projection, newest};
+    pending = workers.size();
+    job_seq++;
+  }
+  work_cv.notify_all();
+  transform_cpu(yuv, frame_width, frame_height, frame_stride, frame_uv_offset, newest, MODEL_WIDTH, MODEL_HEIGHT,
+                projection, bands[0].uv_row_start, bands[0].uv_row_end, &bands[0].scratch);
+  {
+    std::unique_lock lk(lock);
+    done_cv.wait(lk, [this] { return pending == 0; });
+  }
+
+  // model input is the frame from HISTORY_FRAMES - 1 frames ago followed by the newest
+  const int oldest_idx = (history_idx + 1) % HISTORY_FRAMES;
+  memcpy(&input_frames[0], &history[oldest_idx * frame_size_bytes], frame_size_bytes);
+  memcpy(&input_frames[MODEL_FRAME_SIZE], newest, frame_size_bytes);
+  return &input_frames[0];
+}
+
+void ModelFrameCPU::workerThread(int band) {
+  uint64_t seen = 0;
+  std::unique_lock lk(lock);
+  while (true) {
+    work_cv.wait(lk, [&] { return exit || job_seq != seen; });
+    if (exit) break;
+    seen = job_seq;
+    const Job j = job;
+
+    lk.unlock();
+    Band &b = bands[band];
+    transform_cpu(j.yuv, j.width, j.height, j.stride, j.uv_offset, j.out, MODEL_WIDTH, MODEL_HEIGHT,
+                  j.transform, b.uv_row_start, b.uv_row_end, &b.scratch);
+    lk.lock();
+    if (--pending == 0) done_cv.notify_one();
+  }
+}
@@ -3,7 +3,11 @@
 #include <cfloat>
 #include <cstdlib>
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #define CL_USE_DEPRECATED_OPENCL_1_2_APIS
 #ifdef __APPLE__
@@ -15,6 +19,7 @@
 #include "common/mat.h"
 #include "selfdrive/modeld/transforms/loadyuv.h"
 #include "selfdrive/modeld/transforms/transform.h"
+#include "selfdrive/modeld/transforms/transform_cpu.h"
 
 class ModelFrame {
 public:
@@ -27,12 +32,62 @@ public:
   const int MODEL_FRAME_SIZE = MODEL_WIDTH * MODEL_HEIGHT * 3 / 2;
   const int buf_size = MODEL_FRAME_SIZE * 2;
   const size_t frame_size_bytes = MODEL_FRAME_SIZE * sizeof(uint8_t);
+  static const int HISTORY_FRAMES = 5;
 
 private:
   Transform transform;
   LoadYUVState loadyuv;
   cl_command_queue q;
-  cl_mem y_cl, u_cl, v_cl, img_buffer_20hz_cl, last_img_cl;
-  cl_buffer_region region;
+  cl_command_queue readback_q;  // reads the oldest frame back while q warps the new one
+  cl_mem y_cl, u_cl, v_cl;
+  // ring of warped frames, the model takes the oldest and the newest
+  cl_mem history_cl[HISTORY_FRAMES];
+  int history_idx = HISTORY_FRAMES - 1;  // slot of the newest frame
+  // the buffer returned by the last prepare() stays valid while the next one is filled
+  std::unique_ptr<uint8_t[]> input_frames[2];
+  int input_idx = 0;
+};
+
+// ModelFrame without OpenCL: the warp and repacking run on the CPU, split into bands of rows
+// across threads. The history is a ring of warped frames, prepare() only gathers the oldest and
+// the newest into the model input.
+class ModelFrameCPU {
+public:
+  ModelFrameCPU(int num_threads = 0);
+  ~ModelFrameCPU();
+  uint8_t* prepare(const uint8_t *yuv, int width, int height, int frame_stride, int frame_uv_offset, const mat3& transform);
+
+  const int MODEL_WIDTH = 512;
+  const int MODEL_HEIGHT = 256;
+  const int MODEL_FRAME_SIZE = MODEL_WIDTH * MODEL_HEIGHT * 3 / 2;
+  const int buf_size = MODEL_FRAME_SIZE * 2;
+  const size_t frame_size_bytes = MODEL_FRAME_SIZE * sizeof(uint8_t);
+  static const int HISTORY_FRAMES = 5;
+
+private:
+  struct Job {
+    const uint8_t *yuv;
+    int width, height, stride, uv_offset;
+    mat3 transform;
+    uint8_t *out;
+  };
+  struct Band {
+    int uv_row_start, uv_row_end;
+    TransformCPUScratch scratch;
+  };
+  void workerThread(int band);
+
+  std::unique_ptr<uint8_t[]> history;  // HISTORY_FRAMES warped frames
+  int history_idx = HISTORY_FRAMES - 1;  // slot of the newest frame
   std::unique_ptr<uint8_t[]> input_frames;
-};
\ No newline at end of file
+
+  std::vector<Band> bands;
+  // band 0 runs on the calling thread, the others on workers
+  std::vector<std::thread> workers;
+  std::mutex lock;
+  std::condition_variable work_cv, done_cv;
+  uint64_t job_seq = 0;
+  int pending = 0;
+  bool exit = false;
+  Job job;
+};
@@ -16,3 +16,8 @@ cdef extern from "selfdrive/modeld/models/commonmodel.h":
     int buf_size
     ModelFrame(cl_device_id, cl_context)
     unsigned char * prepare(cl_mem, int, int, int, int, mat3, cl_mem*)
+
+  cppclass ModelFrameCPU:
+    int buf_size
+    ModelFrameCPU(int)
+    unsigned char * prepare(const unsigned char *, int, int, int, int, mat3)
@@ -8,7 +8,7 @@ from libc.string cimport memcpy
 from msgq.visionipc.visionipc cimport cl_mem
 from msgq.visionipc.visionipc_pyx cimport VisionBuf, CLContext as BaseCLContext
 from .commonmodel cimport CL_DEVICE_TYPE_DEFAULT, cl_get_device_id, cl_create_context
-from .commonmodel cimport mat3, ModelFrame as cppModelFrame
+from .commonmodel cimport mat3, ModelFrame as cppModelFrame, ModelFrameCPU as cppModelFrameCPU
 
 
 cdef class CLContext(BaseCLContext):
@@ -43,3 +43,19 @@ cdef class ModelFrame:
     if not data:
       return None
     return np.asarray(<cnp.uint8_t[:self.frame.buf_size]> data)
+
+cdef class ModelFrameCPU:
+  cdef cppModelFrameCPU * frame
+
+  def __cinit__(self, int num_threads=0):
+    self.frame = new cppModelFrameCPU(num_threads)
+
+  def __dealloc__(self):
+    del self.frame
+
+  def prepare(self, VisionBuf buf, float[:] projection):
+    cdef mat3 cprojection
+    memcpy(cprojection.v, &projection[0], 9*sizeof(float))
+    cdef unsigned char * data
+    data = self.frame.prepare(<unsigned char *>buf.buf.addr, buf.width, buf.height, buf.stride, buf.uv_offset, cprojection)
+    return np.asarray(<cnp.uint8_t[:self.frame.buf_size]> data)
@@ -0,0 +1,191 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "common/clutil.h"
+#include "selfdrive/modeld/models/commonmodel.h"
+
+namespace {
+
+const int WIDTH = 1928, HEIGHT = 1208;
+const int STRIDE = 2048, UV_OFFSET = STRIDE * 1216;
+
+std::vector<uint8_t> make_frame(int seed) {
+  std::vector<uint8_t> yuv(UV_OFFSET + STRIDE * HEIGHT / 2);
+  for (int y = 0; y < HEIGHT; y++) {
+    for (int x = 0; x < WIDTH; x++) {
+      yuv[y * STRIDE + x] = (uint8_t)(128 + 60 * std::sin((x + seed * 7) * 0.031f) * std::cos(y * 0.017f) + ((x * 31 + y * 17 + seed) & 15));
+    }
+  }
+  for (int y = 0; y < HEIGHT / 2; y++) {
+    for (int x = 0; x < WIDTH; x++) {
+      yuv[UV_OFFSET + y * STRIDE + x] = (uint8_t)(x * 3 + y * 5 + seed);
+    }
+  }
+  return yuv;
+}
+
+// model frame to camera frame, a zoomed view with some perspective like the calibrated transforms in modeld
+mat3 test_projection(float shift = 0.0f) {
+  return {{
+    1.9f, 0.05f, 470.0f + shift,
+    0.02f, 1.85f, 370.0f,
+    0.00002f, 0.00001f, 1.0f,
+  }};
+}
+
+// transform.cl line by line
+void warp_reference(const uint8_t *src, int src_row_stride, int src_px_stride, int src_offset, int src_rows, int src_cols,
+                    uint8_t *dst, int dst_rows, int dst_cols, const float *M) {
+  for (int dy = 0; dy < dst_rows; dy++) {
+    for (int dx = 0; dx < dst_cols; dx++) {
+      float X0 = M[0] * dx + M[1] * dy + M[2];
+      float Y0 = M[3] * dx + M[4] * dy + M[5];
+      float W = M[6] * dx + M[7] * dy + M[8];
+      W = W != 0.0f ? 32 / W : 0.0f;
+      int X = std::rint(X0 * W), Y = std::rint(Y0 * W);
+      int sx = X >> 5, sy = Y >> 5;
+      int sx_clamp = std::clamp(sx, 0, src_cols - 1);
+      int sx_p1_clamp = std::clamp(sx + 1, 0, src_cols - 1);
+      int sy_clamp = std::clamp(sy, 0, src_rows - 1);
+      int sy_p1_clamp = std::clamp(sy + 1, 0, src_rows - 1);
+      int v0 = src[sy_clamp * src_row_stride + src_offset + sx_clamp * src_px_stride];
+      int v1 = src[sy_clamp * src_row_stride + src_offset + sx_p1_clamp * src_px_stride];
+      int v2 = src[sy_p1_clamp * src_row_stride + src_offset + sx_clamp * src_px_stride];
+      int v3 = src[sy_p1_clamp * src_row_stride + src_offset + sx_p1_clamp * src_px_stride];
+      float taby = 1.f / 32 * (Y & 31);
+      float tabx = 1.f / 32 * (X & 31);
+      auto coef = [](float v) { return (int)std::min(std::nearbyint(v * 32768), 32767.0f); };
+      int val = v0 * coef((1.0f - taby) * (1.0f - tabx)) + v1 * coef((1.0f - taby) * tabx) +
+                v2 * coef(taby * (1.0f - tabx)) + v3 * coef(taby * tabx);
+      dst[dy * dst_cols + dx] = std::clamp((val + (1 << 14)) >> 15, 0, 255);
+    }
+  }
+}
+
+// transform_queue + loadyuv_queue
+std::vector<uint8_t> model_frame_reference(const uint8_t *yuv, const mat3 &projection, int w, int h) {
+  std::vector<uint8_t> y(w * h), u(w * h / 4), v(w * h / 4), out(w * h * 3 / 2);
+  const mat3 projection_uv = transform_scale_buffer(projection, 0.5);
+  warp_reference(yuv, STRIDE, 1, 0, HEIGHT, WIDTH, y.data(), h, w, projection.v);
+  warp_reference(yuv, STRIDE, 2, UV_OFFSET, HEIGHT / 2, WIDTH / 2, u.data(), h / 2, w / 2, projection_uv.v);
+  warp_reference(yuv, STRIDE, 2, UV_OFFSET + 1, HEIGHT / 2, WIDTH / 2, v.data(), h / 2, w / 2, projection_uv.v);
+
+  const int uv_size = (w / 2) * (h / 2);
+  for (int oy = 0; oy < h; oy++) {
+    for (int ox = 0; ox < w; ox += 2) {
+      uint8_t *y0 = &out[(oy & 1) ? uv_size : 0];
+      uint8_t *y1 = &out[(oy & 1) ? uv_size * 3 : uv_size * 2];
+      y0[(oy / 2) * (w / 2) + ox / 2] = y[oy * w + ox];
+      y1[(oy / 2) * (w / 2) + ox / 2] = y[oy * w + ox + 1];
+    }
+  }
+  memcpy(&out[uv_size * 4], u.data(), uv_size);
+  memcpy(&out[uv_size * 5], v.data(), uv_size);
+  return out;
+}
+
+// largest difference and number of differing bytes
+std::pair<int, int> compare(const uint8_t *a, const uint8_t *b, size_t len) {
+  int max_diff = 0, mismatches = 0;
+  for (size_t i = 0; i < len; i++) {
+    int d = std::abs(a[i] - b[i]);
+    max_diff = std::max(max_diff, d);
+    mismatches += d != 0;
+  }
+  return {max_diff, mismatches};
+}
+
+}  // namespace
+
+TEST_CASE("ModelFrameCPU matches the kernels") {
+  auto yuv = make_frame(0);
+  for (int threads : {1, 3}) {
+    ModelFrameCPU frame(threads);
+    uint8_t *out = frame.prepare(yuv.data(), WIDTH, HEIGHT, STRIDE, UV_OFFSET, test_projection());
+    auto ref = model_frame_reference(yuv.data(), test_projection(), frame.MODEL_WIDTH, frame.MODEL_HEIGHT);
+    // the same float math, only FMA contraction can move a sample to the next subpixel
+    auto [max_diff, mismatches] = compare(out + frame.MODEL_FRAME_SIZE, ref.data(), frame.frame_size_bytes);
+    INFO("threads " << threads << " max diff " << max_diff << " mismatches " << mismatches);
+    REQUIRE(max_diff <= 1);
+    REQUIRE(mismatches < frame.MODEL_FRAME_SIZE / 1000);
+  }
+}
+
+TEST_CASE("ModelFrameCPU history") {
+  ModelFrameCPU frame(2);
+  std::vector<std::vector<uint8_t>> outputs;
+  for (int i = 0; i < 8; i++) {
+    auto yuv = make_frame(i);
+    uint8_t *out = frame.prepare(yuv.data(), WIDTH, HEIGHT, STRIDE, UV_OFFSET, test_projection(i));
+    outputs.emplace_back(out, out + frame.buf_size);
+  }
+  // the first half of the input is the newest frame from HISTORY_FRAMES - 1 calls earlier
+  for (int i = ModelFrameCPU::HISTORY_FRAMES - 1; i < 8; i++) {
+    const uint8_t *oldest = outputs[i].data();
+    const uint8_t *expected = outputs[i - (ModelFrameCPU::HISTORY_FRAMES - 1)].data() + frame.MODEL_FRAME_SIZE;
+    REQUIRE(memcmp(oldest, expected, frame.frame_size_bytes) == 0);
+  }
+}
+
+TEST_CASE("ModelFrameCPU matches ModelFrame") {
+  cl_uint num_platforms = 0;
+  if (clGetPlatformIDs(0, NULL, &num_platforms) != CL_SUCCESS || num_platforms == 0) {
+    WARN("no OpenCL platform, skipping");
+    return;
+  }
+  cl_device_id device_id = cl_get_device_id(CL_DEVICE_TYPE_DEFAULT);
+  cl_context context = cl_create_context(device_id);
+  ModelFrame frame_cl(device_id, context);
+  ModelFrameCPU frame_cpu;
+
+  uint8_t *prev_out_cl = nullptr;
+  std::vector<uint8_t> prev_copy;
+  for (int i = 0; i < 6; i++) {
+    auto yuv = make_frame(i);
+    cl_mem yuv_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, yuv.size(), yuv.data(), &err));
+    uint8_t *out_cl = frame_cl.prepare(yuv_cl, WIDTH, HEIGHT, STRIDE, UV_OFFSET, test_projection(i), NULL);
+    uint8_t *out_cpu = frame_cpu.prepare(yuv.data(), WIDTH, HEIGHT, STRIDE, UV_OFFSET, test_projection(i));
+    CL_CHECK(clReleaseMemObject(yuv_cl));
+
+    // double buffered, the previous input is still intact
+    if (prev_out_cl) {
+      REQUIRE(out_cl != prev_out_cl);
+      REQUIRE(memcmp(prev_out_cl + frame_cpu.MODEL_FRAME_SIZE, &prev_copy[frame_cpu.MODEL_FRAME_SIZE], frame_cpu.frame_size_bytes) == 0);
+    }
+    prev_out_cl = out_cl;
+    prev_copy.assign(out_cl, out_cl + frame_cpu.buf_size);
+
+    // the oldest frame is uninitialized in the CL history until it was filled
+    const int offset = i < ModelFrameCPU::HISTORY_FRAMES - 1 ? frame_cpu.MODEL_FRAME_SIZE : 0;
+    auto [max_diff, mismatches] = compare(out_cl + offset, out_cpu + offset, frame_cpu.buf_size - offset);
+    INFO("frame " << i << " max diff " << max_diff << " mismatches " << mismatches);
+    REQUIRE(max_diff <= 1);
+    REQUIRE(mismatches < frame_cpu.MODEL_FRAME_SIZE / 1000);
+  }
+  CL_CHECK(clReleaseContext(context));
+}
+
+// not run by default: ./test_modelframe "[benchmark]"
+TEST_CASE("ModelFrameCPU throughput", "[.][benchmark]") {
+  const int num_frames = 200;
+  auto yuv = make_frame(0);
+  for (int threads : {1, 2, 0}) {
+    ModelFrameCPU frame(threads);
+    frame.prepare(yuv.data(), WIDTH, HEIGHT, STRIDE, UV_OFFSET, test_projection());
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_frames; i++) {
+      frame.prepare(yuv.data(), WIDTH, HEIGHT, STRIDE, UV_OFFSET, test_projection());
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%dx%d -> %dx%d, %s: %.3f ms/frame\n", WIDTH, HEIGHT, frame.MODEL_WIDTH, frame.MODEL_HEIGHT,
+           threads == 0 ? "all threads" : (threads == 1 ? "1 thread" : "2 threads"), secs * 1000 / num_frames);
+  }
+}
@@ -0,0 +1,131 @@
+#include "selfdrive/modeld/transforms/transform_cpu.h"
+
+#include <cmath>
+
+namespace {
+
+// same constants as transform.cl
+constexpr int INTER_BITS = 5;
+constexpr int INTER_TAB_SIZE = 1 << INTER_BITS;
+constexpr int INTER_REMAP_COEF_BITS = 15;
+constexpr int INTER_REMAP_COEF_SCALE = 1 << INTER_REMAP_COEF_BITS;
+
+// The kernel computes the four weights from the 5 bit subpixel position on every pixel,
+// there are only 32x32 distinct sets of them.
+struct WeightTable {
+  int32_t w[INTER_TAB_SIZE * INTER_TAB_SIZE][4];
+
+  WeightTable() {
+    auto to_coef = [](float v) {
+      // convert_short_sat_rte, 1.0 saturates to 32767
+      float r = std::nearbyint(v * INTER_REMAP_COEF_SCALE);
+      return (int32_t)(r > 32767.0f ? 32767.0f : r);
+    };
+    for (int ay = 0; ay < INTER_TAB_SIZE; ay++) {
+      for (int ax = 0; ax < INTER_TAB_SIZE; ax++) {
+        const float taby = 1.f/INTER_TAB_SIZE*ay;
+        const float tabx = 1.f/INTER_TAB_SIZE*ax;
+        int32_t *t = w[ay * INTER_TAB_SIZE + ax];
+        t[0] = to_coef((1.0f-taby)*(1.0f-tabx));
+        t[1] = to_coef((1.0f-taby)*tabx);
+        t[2] = to_coef(taby*(1.0f-tabx));
+        t[3] = to_coef(taby*tabx);
+      }
+    }
+  }
+};
+
+const WeightTable weight_table;
+
+// rint() for |x| < 2^22 in the default rounding mode, without a libm call so the loop vectorizes
+inline float round_even(float x) {
+  const float magic = 12582912.0f;  // 1.5 * 2^23
+  return (x + magic) - magic;
+}
+
+inline int clamp_int(int v, int lo, int hi) {
+  v = v < lo ? lo : v;
+  return v > hi ? hi : v;
+}
+
+}  // namespace
+
+void warp_perspective_row_cpu(const uint8_t *src, int src_row_stride, int src_px_stride, int src_rows, int src_cols,
+                              uint8_t *dst, int dst_cols, int dy, const mat3 &M, TransformCPUScratch *s) {
+  int32_t *offset = s->offset.data();
+  int32_t *offset_x = s->offset_x.data();
+  int32_t *offset_y = s->offset_y.data();
+  uint16_t *tab = s->tab.data();
+
+  // coordinates and weights, vectorized
+  const float m0 = M.v[0], m1 = M.v[1], m2 = M.v[2];
+  const float m3 = M.v[3], m4 = M.v[4], m5 = M.v[5];
+  const float m6 = M.v[6], m7 = M.v[7], m8 = M.v[8];
+  const float fdy = dy;
+  const float lim = 1 << 21;  // far outside any source, keeps round_even exact
+  for (int dx = 0; dx < dst_cols; dx++) {
+    const float X0 = m0 * dx + m1 * fdy + m2;
+    const float Y0 = m3 * dx + m4 * fdy + m5;
+    float W = m6 * dx + m7 * fdy + m8;
+    W = W != 0.0f ? INTER_TAB_SIZE / W : 0.0f;
+    float xf = X0 * W, yf = Y0 * W;
+    xf = xf < -lim ? -lim : (xf > lim ? lim : xf);
+    yf = yf < -lim ? -lim : (yf > lim ? lim : yf);
+    const int X = (int)round_even(xf), Y = (int)round_even(yf);
+
+    const int sx = X >> INTER_BITS, sy = Y >> INTER_BITS;
+    const int sx_clamp = clamp_int(sx, 0, src_cols - 1);
+    const int sx_p1_clamp = clamp_int(sx + 1, 0, src_cols - 1);
+    const int sy_clamp = clamp_int(sy, 0, src_rows - 1);
+    const int sy_p1_clamp = clamp_int(sy + 1, 0, src_rows - 1);
+    offset[dx] = sy_clamp * src_row_stride + sx_clamp * src_px_stride;
+    offset_x[dx] = (sx_p1_clamp - sx_clamp) * src_px_stride;
+    offset_y[dx] = (sy_p1_clamp - sy_clamp) * src_row_stride;
+    tab[dx] = (Y & (INTER_TAB_SIZE - 1)) * INTER_TAB_SIZE + (X & (INTER_TAB_SIZE - 1));
+  }
+
+  // gather and blend
+  for (int dx = 0; dx < dst_cols; dx++) {
+    const uint8_t *p = src + offset[dx];
+    const int32_t *w = weight_table.w[tab[dx]];
+    const int val = p[0] * w[0] + p[offset_x[dx]] * w[1] + p[offset_y[dx]] * w[2] + p[offset_x[dx] + offset_y[dx]] * w[3];
+    const int pix = (val + (1 << (INTER_REMAP_COEF_BITS-1))) >> INTER_REMAP_COEF_BITS;
+    dst[dx] = pix > 255 ? 255 : pix;
+  }
+}
+
+void transform_cpu(const uint8_t *yuv, int in_width, int in_height, int in_stride, int in_uv_offset,
+                   uint8_t *out, int out_width, int out_height, const mat3 &projection,
+                   int uv_row_start, int uv_row_end, TransformCPUScratch *s) {
+  s->offset.resize(out_width);
+  s->offset_x.resize(out_width);
+  s->offset_y.resize(out_width);
+  s->tab.resize(out_width);
+  s->row.resize(out_width);
+
+  // in and out uv is half the size of y.
+  const mat3 projection_uv = transform_scale_buffer(projection, 0.5);
+
+  const int uv_width = out_width / 2;
+  const int uv_size = uv_width * (out_height / 2);
+  uint8_t *out_u = out + uv_size * 4;
+  uint8_t *out_v = out + uv_size * 5;
+
+  for (int r = uv_row_start; r < uv_row_end; r++) {
+    for (int dy = 2 * r; dy < 2 * r + 2; dy++) {
+      // loadys: even rows go to planes 0 and 2, odd rows to 1 and 3, split by column parity
+      warp_perspective_row_cpu(yuv, in_stride, 1, in_height, in_width, s->row.data(), out_width, dy, projection, s);
+      uint8_t *even = out + (dy & 1) * uv_size + r * uv_width;
+      uint8_t *odd = even + uv_size * 2;
+      const uint8_t *row = s->row.data();
+      for (int x = 0; x < uv_width; x++) {
+        even[x] = row[2 * x];
+        odd[x] = row[2 * x + 1];
+      }
+    }
+    warp_perspective_row_cpu(yuv + in_uv_offset, in_stride, 2, in_height / 2, in_width / 2,
+                             out_u + r * uv_width, uv_width, r, projection_uv, s);
+    warp_perspective_row_cpu(yuv + in_uv_offset + 1, in_stride, 2, in_height / 2, in_width / 2,
+                             out_v + r * uv_width, uv_width, r, projection_uv, s);
+  }
+}
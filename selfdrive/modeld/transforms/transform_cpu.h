@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/mat.h"
+
+// Per thread buffers for the row warps
+typedef struct {
+  std::vector<int32_t> offset;    // source offset of the top left tap
+  std::vector<int32_t> offset_x;  // offset to the right taps, 0 at the right edge
+  std::vector<int32_t> offset_y;  // offset to the bottom taps, 0 at the bottom edge
+  std::vector<uint16_t> tab;      // subpixel position, index into the weight table
+  std::vector<uint8_t> row;
+} TransformCPUScratch;
+
+// CPU version of warpPerspective in transform.cl. Warps row dy of one plane into dst[0, dst_cols)
+// with the kernel's fixed point bilinear weights.
+void warp_perspective_row_cpu(const uint8_t *src, int src_row_stride, int src_px_stride, int src_rows, int src_cols,
+                              uint8_t *dst, int dst_cols, int dy, const mat3 &M, TransformCPUScratch *s);
+
+// transform_queue followed by loadyuv_queue on the CPU, for uv rows [uv_row_start, uv_row_end) of the
+// output. The y rows are split into the four 2x2 phase planes of loadys, followed by the u and v planes.
+void transform_cpu(const uint8_t *yuv, int in_width, int in_height, int in_stride, int in_uv_offset,
+                   uint8_t *out, int out_width, int out_height, const mat3 &projection,
+                   int uv_row_start, int uv_row_end, TransformCPUScratch *s);
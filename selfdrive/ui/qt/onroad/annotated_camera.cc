@@ -4,11 +4,57 @@
 #include <QPainter>
 #include <algorithm>
 #include <cmath>
+#include <iterator>
 #include <unistd.h> // kisapilot
 
 #include "common/swaglog.h"
+#include "common/timing.h"
 #include "selfdrive/ui/qt/util.h"
 
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+
+void GpuFrameTimer::init(QOpenGLContext *ctx) {
+  const bool has_queries = ctx->isOpenGLES() ? ctx->format().majorVersion() >= 3 && ctx->hasExtension("GL_EXT_disjoint_timer_query")
+                                             : ctx->hasExtension("GL_ARB_timer_query");
+  if (has_queries) {
+    f = ctx->extraFunctions();
+    f->glGenQueries(std::size(queries), queries);
+    last_ms = 0;
+  }
+}
+
+void GpuFrameTimer::begin() {
+  if (!f) return;
+
+  if (pending[idx]) {
+    GLuint available = 0;
+    f->glGetQueryObjectuiv(queries[idx], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+      GLuint ns = 0;
+      f->glGetQueryObjectuiv(queries[idx], GL_QUERY_RESULT, &ns);
+      last_ms = ns * 1e-6;
+    }
+    pending[idx] = false;
+  }
+  f->glBeginQuery(GL_TIME_ELAPSED_EXT, queries[idx]);
+}
+
+void GpuFrameTimer::end() {
+  if (!f) return;
+
+  f->glEndQuery(GL_TIME_ELAPSED_EXT);
+  pending[idx] = true;
+  idx = (idx + 1) % std::size(queries);
+}
+
 // Window that shows camera view and variety of info drawn on top
 AnnotatedCameraWidget::AnnotatedCameraWidget(VisionStreamType type, QWidget *parent)
     : fps_filter(UI_FREQ, 3, 1. / UI_FREQ), CameraWidget("camerad", type, parent) {
@@ -32,6 +78,10 @@ AnnotatedCameraWidget::AnnotatedCameraWidget(VisionStreamType type, QWidget *par
 
   recorder = new ScreenRecoder(this);
   recorder->hide();
+
+  show_render_stats = getenv("UI_RENDER_STATS") != nullptr;
+  // onroad, the scene is updated as frames arrive, just before they are drawn
+  QObject::connect(this, &CameraWidget::vipcThreadFrameReceived, uiState(), &UIState::frameReceived, Qt::QueuedConnection);
 }
 
 void AnnotatedCameraWidget::updateState(const UIState &s) {
@@ -49,6 +99,7 @@ void AnnotatedCameraWidget::initializeGL() {
 
   prev_draw_t = millis_since_boot();
   setBackgroundColor(bg_colors[STATUS_DISENGAGED]);
+  gpu_timer.init(context());
 }
 
 mat4 AnnotatedCameraWidget::calcFrameMatrix() {
@@ -110,6 +161,7 @@ void AnnotatedCameraWidget::paintEvent(QPaintEvent *event) {
   UIState *s = uiState();
   SubMaster &sm = *(s->sm);
   const double start_draw_t = millis_since_boot();
+  const uint64_t start_cpu_ns = nanos_thread_cpu();
 
   QPainter p(this);
 
@@ -117,7 +169,7 @@ void AnnotatedCameraWidget::paintEvent(QPaintEvent *event) {
   {
     std::lock_guard lk(frame_lock);
 
-    if (frames.empty()) {
+    if (!hasFrame()) {
       if (skip_frame_count > 0) {
         skip_frame_count--;
         qDebug() << "skipping frame, not ready";
@@ -134,7 +186,7 @@ void AnnotatedCameraWidget::paintEvent(QPaintEvent *event) {
     bool has_wide_cam = available_streams.count(VISION_STREAM_WIDE_ROAD);
     if (has_wide_cam) {
       float v_ego = sm["carState"].getCarState().getVEgo();
-      if ((v_ego < 10) || available_streams.size() == 1) {
+      if ((v_ego < 10) || !available_streams.count(VISION_STREAM_ROAD)) {
         wide_cam_requested = true;
       } else if (v_ego > 15) {
         wide_cam_requested = false;
@@ -143,6 +195,7 @@ void AnnotatedCameraWidget::paintEvent(QPaintEvent *event) {
     }
     CameraWidget::setStreamType(wide_cam_requested ? VISION_STREAM_WIDE_ROAD : VISION_STREAM_ROAD);
     p.beginNativePainting();
+    gpu_timer.begin();
     CameraWidget::setFrameId(sm["modelV2"].getModelV2().getFrameId());
     CameraWidget::paintGL();
     p.endNativePainting();
@@ -190,14 +243,47 @@ void AnnotatedCameraWidget::paintEvent(QPaintEvent *event) {
     LOGW("slow frame rate: %.2f fps", fps);
   }
   prev_draw_t = cur_draw_t;
+  const double cpu_ms = (nanos_thread_cpu() - start_cpu_ns) * 1e-6;
+
+  if (show_render_stats) {
+    drawRenderStats(p, cur_draw_t - start_draw_t, cpu_ms, fps);
+  }
+  p.beginNativePainting();
+  gpu_timer.end();
+  p.endNativePainting();
 
   // publish debug msg
   MessageBuilder msg;
   auto m = msg.initEvent().initUiDebug();
   m.setDrawTimeMillis(cur_draw_t - start_draw_t);
+  m.setCpuTimeMillis(cpu_ms);
+  m.setGpuTimeMillis(std::max(gpu_timer.millis(), 0.0f));
+  const CameraFrameStats camera_stats = frameStats();
+  m.setCameraFramesDropped(camera_stats.dropped);
+  m.setCameraFramesDuplicated(camera_stats.duplicated);
   pm->send("uiDebug", msg);
 }
 
+void AnnotatedCameraWidget::drawRenderStats(QPainter &p, double draw_ms, double cpu_ms, double fps) {
+  const CameraFrameStats camera_stats = frameStats();
+  QString stats = QString("draw %1 ms  cpu %2 ms  gpu %3  %4 fps  frames %5 dropped %6 dup %7")
+                      .arg(draw_ms, 0, 'f', 1)
+                      .arg(cpu_ms, 0, 'f', 1)
+                      .arg(gpu_timer.millis() < 0 ? QString("n/a") : QString::number(gpu_timer.millis(), 'f', 1) + " ms")
+                      .arg(fps, 0, 'f', 1)
+                      .arg(camera_stats.received)
+                      .arg(camera_stats.dropped)
+                      .arg(camera_stats.duplicated);
+  p.setFont(InterFont(30, QFont::DemiBold));
+  QRect r = p.fontMetrics().boundingRect(stats).adjusted(-20, -10, 20, 10);
+  r.moveCenter({width() / 2, height() - UI_BORDER_SIZE - r.height()});
+  p.setPen(Qt::NoPen);
+  p.setBrush(QColor(0, 0, 0, 160));
+  p.drawRoundedRect(r, 10, 10);
+  p.setPen(QColor(0xff, 0xff, 0xff));
+  p.drawText(r, Qt::AlignCenter, stats);
+}
+
 void AnnotatedCameraWidget::showEvent(QShowEvent *event) {
   CameraWidget::showEvent(event);
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QOpenGLExtraFunctions>
 #include <QVBoxLayout>
 #include <memory>
 #include "selfdrive/ui/qt/onroad/hud.h"
@@ -13,6 +14,25 @@
 
 #include "common/params.h"
 
+// GPU time of a frame from GL_TIME_ELAPSED queries. Results are read two frames later, so
+// reading them never waits on the GPU.
+class GpuFrameTimer {
+public:
+  void init(QOpenGLContext *ctx);
+  // both between beginNativePainting and endNativePainting
+  void begin();
+  void end();
+  // -1 if the context has no timer queries
+  float millis() const { return last_ms; }
+
+private:
+  QOpenGLExtraFunctions *f = nullptr;
+  GLuint queries[2] = {};
+  bool pending[2] = {};
+  int idx = 0;
+  float last_ms = -1;
+};
+
 class AnnotatedCameraWidget : public CameraWidget {
   Q_OBJECT
 
@@ -44,6 +64,10 @@ protected:
   void showEvent(QShowEvent *event) override;
   mat4 calcFrameMatrix() override;
 
+  void drawRenderStats(QPainter &p, double draw_ms, double cpu_ms, double fps);
+
   double prev_draw_t = 0;
   FirstOrderFilter fps_filter;
+  GpuFrameTimer gpu_timer;
+  bool show_render_stats = false;
 };
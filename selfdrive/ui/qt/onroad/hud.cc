@@ -1,5 +1,6 @@
 #include "selfdrive/ui/qt/onroad/hud.h"
 
+#include <array>
 #include <cmath>
 #include <unistd.h> // kisapilot
 #include <QDateTime>
@@ -65,10 +66,16 @@ void HudRenderer::draw(QPainter &p, const QRect &surface_rect) {
   p.save();
 
   // Draw header gradient
-  QLinearGradient bg(0, UI_HEADER_HEIGHT - (UI_HEADER_HEIGHT / 2.5), 0, UI_HEADER_HEIGHT);
-  bg.setColorAt(0, QColor::fromRgbF(0, 0, 0, 0.45));
-  bg.setColorAt(1, QColor::fromRgbF(0, 0, 0, 0));
-  p.fillRect(0, 0, surface_rect.width(), UI_HEADER_HEIGHT, bg);
+  if (header_layer.width() != surface_rect.width()) {
+    header_layer = QPixmap(surface_rect.width(), UI_HEADER_HEIGHT);
+    header_layer.fill(Qt::transparent);
+    QLinearGradient bg(0, UI_HEADER_HEIGHT - (UI_HEADER_HEIGHT / 2.5), 0, UI_HEADER_HEIGHT);
+    bg.setColorAt(0, QColor::fromRgbF(0, 0, 0, 0.45));
+    bg.setColorAt(1, QColor::fromRgbF(0, 0, 0, 0));
+    QPainter layer_painter(&header_layer);
+    layer_painter.fillRect(header_layer.rect(), bg);
+  }
+  p.drawPixmap(0, 0, header_layer);
 
 
   drawSetSpeed(p, surface_rect);
@@ -343,174 +350,7 @@ void HudRenderer::draw(QPainter &p, const QRect &surface_rect) {
     // left panel end
 
     // debug info(right panel)
-    int width_r = 180;
-    int sp_xr = surface_rect.right() - UI_BORDER_SIZE - width_r / 2 - 10;
-    int sp_yr = UI_BORDER_SIZE + 235;
-    int num_r = 0;
-
-    //p.setRenderHint(QPainter::TextAntialiasing);
-    // cpu temp
-    num_r = num_r + 1;
-    p.setPen(whiteColor(200));
-    debugText(p, sp_xr, sp_yr, QString("CPU TEMP"), 150, 27);
-    if (s->scene.cpuTemp > 85) {
-      p.setPen(redColor(200));
-    } else if (s->scene.cpuTemp > 75) {
-      p.setPen(orangeColor(200));
-    }
-    debugText(p, sp_xr, sp_yr+60, QString::number(s->scene.cpuTemp, 'f', 0) + "°C", 150, 57);
-    p.translate(sp_xr + 90, sp_yr + 20);
-    p.rotate(-90);
-    p.setFont(InterFont(27, QFont::DemiBold));
-    p.setPen(whiteColor(200));
-    p.drawText(-40, 0, QString::number(s->scene.cpuPerc, 'f', 0) + "%");
-    p.resetMatrix();
-
-    // sys temp
-    num_r = num_r + 1;
-    sp_yr = sp_yr + j_num;
-    p.setPen(whiteColor(200));
-    debugText(p, sp_xr, sp_yr, QString("AMB TEMP"), 150, 27);
-    if (s->scene.ambientTemp > 70) {
-      p.setPen(redColor(200));
-    } else if (s->scene.ambientTemp > 60) {
-      p.setPen(orangeColor(200));
-    } 
-    debugText(p, sp_xr, sp_yr+60, QString::number(s->scene.ambientTemp, 'f', 0) + "°C", 150, 57);
-    p.translate(sp_xr + 90, sp_yr + 20);
-    p.rotate(-90);
-    p.setFont(InterFont(27, QFont::DemiBold));
-    p.setPen(whiteColor(200));
-    p.drawText(-50, 0, QString::number(s->scene.fanSpeedRpm, 'f', 0));
-    p.resetMatrix();
-
-    // Ublox GPS accuracy
-    num_r = num_r + 1;
-    sp_yr = sp_yr + j_num;
-    p.setPen(whiteColor(200));
-    debugText(p, sp_xr, sp_yr, QString("GPS PREC"), 150, 27);
-    if (s->scene.gpsAccuracy > 5) {
-      p.setPen(redColor(200));
-    } else if (s->scene.gpsAccuracy > 2.5) {
-      p.setPen(orangeColor(200));
-    }
-    if (s->scene.gpsAccuracy > 99 || s->scene.gpsAccuracy == 0) {
-      debugText(p, sp_xr, sp_yr+60, "None", 150, 52);
-    } else if (s->scene.gpsAccuracy > 9.99) {
-      debugText(p, sp_xr, sp_yr+60, QString::number(s->scene.gpsAccuracy, 'f', 1), 150, 57);
-    } else {
-      debugText(p, sp_xr, sp_yr+60, QString::number(s->scene.gpsAccuracy, 'f', 2), 150, 57);
-    }
-    p.translate(sp_xr + 90, sp_yr + 20);
-    p.rotate(-90);
-    p.setFont(InterFont(27, QFont::DemiBold));
-    p.setPen(whiteColor(200));
-    p.drawText(-35, 0, QString::number(s->scene.satelliteCount, 'f', 0));
-    p.resetMatrix();
-    // altitude
-    num_r = num_r + 1;
-    sp_yr = sp_yr + j_num;
-    p.setPen(whiteColor(200));
-    debugText(p, sp_xr, sp_yr, QString("ST USAGE"), 150, 27);
-    debugText(p, sp_xr, sp_yr+60, QString::number(s->scene.storageUsage, 'f', 0) + "%", 150, 57);
-    p.translate(sp_xr + 90, sp_yr + 20);
-    p.rotate(-90);
-    p.setFont(InterFont(27, QFont::DemiBold));
-    p.drawText(-45, 0, QString::number(s->scene.altitude, 'f', 0) + "m");
-    p.resetMatrix();
-
-    // kisapilot tpms
-    num_r = num_r + 1;
-    int tpms_width = 180;
-    int tpms_sp_xr = surface_rect.right() - UI_BORDER_SIZE - tpms_width / 2;
-    int tpms_sp_yr = sp_yr + j_num - 10;
-    // QRect tpms_panel(surface_rect.right() - UI_BORDER_SIZE - tpms_width, tpms_sp_yr - 25, tpms_width, 135);  
-    // p.setOpacity(1.0);
-    // p.setPen(QPen(QColor(255, 255, 255, 80), 6));
-    // p.drawRoundedRect(tpms_panel, 20, 20);
-    p.setPen(whiteColor(200));
-    //p.setRenderHint(QPainter::TextAntialiasing);
-    float maxv = 0;
-    float minv = 300;
-    int font_size = 60;
-
-    if (maxv < s->scene.tpmsPressureFl) {maxv = s->scene.tpmsPressureFl;}
-    if (maxv < s->scene.tpmsPressureFr) {maxv = s->scene.tpmsPressureFr;}
-    if (maxv < s->scene.tpmsPressureRl) {maxv = s->scene.tpmsPressureRl;}
-    if (maxv < s->scene.tpmsPressureRr) {maxv = s->scene.tpmsPressureRr;}
-    if (minv > s->scene.tpmsPressureFl) {minv = s->scene.tpmsPressureFl;}
-    if (minv > s->scene.tpmsPressureFr) {minv = s->scene.tpmsPressureFr;}
-    if (minv > s->scene.tpmsPressureRl) {minv = s->scene.tpmsPressureRl;}
-    if (minv > s->scene.tpmsPressureRr) {minv = s->scene.tpmsPressureRr;}
-
-    if (((maxv - minv) > 3 && s->scene.tpmsUnit != 2) || ((maxv - minv) > 0.2 && s->scene.tpmsUnit == 2)) {
-      p.setPen(redColor(200));
-    }
-    if (s->scene.tpmsUnit != 0) {
-      debugText(p, tpms_sp_xr, tpms_sp_yr+15, (s->scene.tpmsUnit == 2) ? "TPMS(bar)" : "TPMS(psi)", 150, 30);
-      font_size = (s->scene.tpmsUnit == 2) ? 43 : 36;
-    } else {
-      debugText(p, tpms_sp_xr, tpms_sp_yr+15, "TPMS(psi)", 150, 30);
-      font_size = 42;
-    }
-    if ((s->scene.tpmsPressureFl < 32 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureFl < 2.2 && s->scene.tpmsUnit == 2)) {
-      p.setPen(yellowColor(200));
-      debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, QString::number(s->scene.tpmsPressureFl, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
-    } else if (s->scene.tpmsPressureFl > 50) {
-      p.setPen(whiteColor(200));
-      debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, "N/A", 200, font_size);
-    } else if ((s->scene.tpmsPressureFl > 45 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureFl > 2.8 && s->scene.tpmsUnit == 2)) {
-      p.setPen(redColor(200));
-      debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, QString::number(s->scene.tpmsPressureFl, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
-    } else {
-      p.setPen(greenColor(200));
-      debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, QString::number(s->scene.tpmsPressureFl, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
-    }
-    if ((s->scene.tpmsPressureFr < 32 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureFr < 2.2 && s->scene.tpmsUnit == 2)) {
-      p.setPen(yellowColor(200));
-      debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, QString::number(s->scene.tpmsPressureFr, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
-    } else if (s->scene.tpmsPressureFr > 50) {
-      p.setPen(whiteColor(200));
-      debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, "N/A", 200, font_size);
-    } else if ((s->scene.tpmsPressureFr > 45 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureFr > 2.8 && s->scene.tpmsUnit == 2)) {
-      p.setPen(redColor(200));
-      debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, QString::number(s->scene.tpmsPressureFr, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
-    } else {
-      p.setPen(greenColor(200));
-      debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, QString::number(s->scene.tpmsPressureFr, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
-    }
-    if ((s->scene.tpmsPressureRl < 32 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureRl < 2.2 && s->scene.tpmsUnit == 2)) {
-      p.setPen(yellowColor(200));
-      debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, QString::number(s->scene.tpmsPressureRl, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
-    } else if (s->scene.tpmsPressureRl > 50) {
-      p.setPen(whiteColor(200));
-      debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, "N/A", 200, font_size);
-    } else if ((s->scene.tpmsPressureRl > 45 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureRl > 2.8 && s->scene.tpmsUnit == 2)) {
-      p.setPen(redColor(200));
-      debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, QString::number(s->scene.tpmsPressureRl, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
-    } else {
-      p.setPen(greenColor(200));
-      debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, QString::number(s->scene.tpmsPressureRl, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
-    }
-    if ((s->scene.tpmsPressureRr < 32 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureRr < 2.2 && s->scene.tpmsUnit == 2)) {
-      p.setPen(yellowColor(200));
-      debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, QString::number(s->scene.tpmsPressureRr, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
-    } else if (s->scene.tpmsPressureRr > 50) {
-      p.setPen(whiteColor(200));
-      debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, "N/A", 200, font_size);
-    } else if ((s->scene.tpmsPressureRr > 45 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureRr > 2.8 && s->scene.tpmsUnit == 2)) {
-      p.setPen(redColor(200));
-      debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, QString::number(s->scene.tpmsPressureRr, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
-    } else {
-      p.setPen(greenColor(200));
-      debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, QString::number(s->scene.tpmsPressureRr, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
-    }
-
-    QRect right_panel(surface_rect.right() - UI_BORDER_SIZE - width_r, UI_BORDER_SIZE + 195, width_r, 104*num_r+25);  
-    p.setPen(QPen(QColor(255, 255, 255, 80), 6));
-    p.drawRoundedRect(right_panel, 20, 20);
-    // right panel end
-
+    drawRightPanelLayer(p, surface_rect);
   }
 
 
@@ -1030,6 +870,206 @@ void HudRenderer::draw(QPainter &p, const QRect &surface_rect) {
   p.restore();
 }
 
+void HudRenderer::drawRightPanelLayer(QPainter &p, const QRect &surface_rect) {
+  const UIScene &scene = uiState()->scene;
+  // the inputs at the precision they are shown
+  const std::array<float, 15> inputs = {
+    scene.cpuTemp, (float)scene.cpuPerc, scene.ambientTemp, (float)scene.fanSpeedRpm,
+    std::round(scene.gpsAccuracy * 100), (float)scene.satelliteCount, (float)scene.storageUsage, std::round(scene.altitude),
+    (float)scene.tpmsUnit, scene.tpmsPressureFl, scene.tpmsPressureFr, scene.tpmsPressureRl, scene.tpmsPressureRr,
+    (float)surface_rect.right(), (float)surface_rect.height(),
+  };
+
+  const QPoint origin(surface_rect.right() - RIGHT_PANEL_LAYER_WIDTH, 0);
+  if (right_panel_layer.isNull() || inputs != right_panel_inputs) {
+    right_panel_inputs = inputs;
+    right_panel_layer = QPixmap(surface_rect.right() + 1 - origin.x(), surface_rect.height());
+    right_panel_layer.fill(Qt::transparent);
+
+    QPainter layer_painter(&right_panel_layer);
+    layer_painter.translate(-origin);
+    layer_painter.setBrush(Qt::NoBrush);
+    drawRightPanel(layer_painter, surface_rect);
+  }
+  p.drawPixmap(origin, right_panel_layer);
+}
+
+// device, GPS and TPMS values, they change at a few Hz so the panel is drawn into right_panel_layer
+void HudRenderer::drawRightPanel(QPainter &p, const QRect &surface_rect) {
+  UIState *s = uiState();
+  const int j_num = 100;
+  int width_r = 180;
+  int sp_xr = surface_rect.right() - UI_BORDER_SIZE - width_r / 2 - 10;
+  int sp_yr = UI_BORDER_SIZE + 235;
+  int num_r = 0;
+
+  //p.setRenderHint(QPainter::TextAntialiasing);
+  // cpu temp
+  num_r = num_r + 1;
+  p.setPen(whiteColor(200));
+  debugText(p, sp_xr, sp_yr, QString("CPU TEMP"), 150, 27);
+  if (s->scene.cpuTemp > 85) {
+    p.setPen(redColor(200));
+  } else if (s->scene.cpuTemp > 75) {
+    p.setPen(orangeColor(200));
+  }
+  debugText(p, sp_xr, sp_yr+60, QString::number(s->scene.cpuTemp, 'f', 0) + "°C", 150, 57);
+  p.save();
+  p.translate(sp_xr + 90, sp_yr + 20);
+  p.rotate(-90);
+  p.setFont(InterFont(27, QFont::DemiBold));
+  p.setPen(whiteColor(200));
+  p.drawText(-40, 0, QString::number(s->scene.cpuPerc, 'f', 0) + "%");
+  p.restore();
+
+  // sys temp
+  num_r = num_r + 1;
+  sp_yr = sp_yr + j_num;
+  p.setPen(whiteColor(200));
+  debugText(p, sp_xr, sp_yr, QString("AMB TEMP"), 150, 27);
+  if (s->scene.ambientTemp > 70) {
+    p.setPen(redColor(200));
+  } else if (s->scene.ambientTemp > 60) {
+    p.setPen(orangeColor(200));
+  } 
+  debugText(p, sp_xr, sp_yr+60, QString::number(s->scene.ambientTemp, 'f', 0) + "°C", 150, 57);
+  p.save();
+  p.translate(sp_xr + 90, sp_yr + 20);
+  p.rotate(-90);
+  p.setFont(InterFont(27, QFont::DemiBold));
+  p.setPen(whiteColor(200));
+  p.drawText(-50, 0, QString::number(s->scene.fanSpeedRpm, 'f', 0));
+  p.restore();
+
+  // Ublox GPS accuracy
+  num_r = num_r + 1;
+  sp_yr = sp_yr + j_num;
+  p.setPen(whiteColor(200));
+  debugText(p, sp_xr, sp_yr, QString("GPS PREC"), 150, 27);
+  if (s->scene.gpsAccuracy > 5) {
+    p.setPen(redColor(200));
+  } else if (s->scene.gpsAccuracy > 2.5) {
+    p.setPen(orangeColor(200));
+  }
+  if (s->scene.gpsAccuracy > 99 || s->scene.gpsAccuracy == 0) {
+    debugText(p, sp_xr, sp_yr+60, "None", 150, 52);
+  } else if (s->scene.gpsAccuracy > 9.99) {
+    debugText(p, sp_xr, sp_yr+60, QString::number(s->scene.gpsAccuracy, 'f', 1), 150, 57);
+  } else {
+    debugText(p, sp_xr, sp_yr+60, QString::number(s->scene.gpsAccuracy, 'f', 2), 150, 57);
+  }
+  p.save();
+  p.translate(sp_xr + 90, sp_yr + 20);
+  p.rotate(-90);
+  p.setFont(InterFont(27, QFont::DemiBold));
+  p.setPen(whiteColor(200));
+  p.drawText(-35, 0, QString::number(s->scene.satelliteCount, 'f', 0));
+  p.restore();
+  // altitude
+  num_r = num_r + 1;
+  sp_yr = sp_yr + j_num;
+  p.setPen(whiteColor(200));
+  debugText(p, sp_xr, sp_yr, QString("ST USAGE"), 150, 27);
+  debugText(p, sp_xr, sp_yr+60, QString::number(s->scene.storageUsage, 'f', 0) + "%", 150, 57);
+  p.save();
+  p.translate(sp_xr + 90, sp_yr + 20);
+  p.rotate(-90);
+  p.setFont(InterFont(27, QFont::DemiBold));
+  p.drawText(-45, 0, QString::number(s->scene.altitude, 'f', 0) + "m");
+  p.restore();
+
+  // kisapilot tpms
+  num_r = num_r + 1;
+  int tpms_width = 180;
+  int tpms_sp_xr = surface_rect.right() - UI_BORDER_SIZE - tpms_width / 2;
+  int tpms_sp_yr = sp_yr + j_num - 10;
+  // QRect tpms_panel(surface_rect.right() - UI_BORDER_SIZE - tpms_width, tpms_sp_yr - 25, tpms_width, 135);  
+  // p.setOpacity(1.0);
+  // p.setPen(QPen(QColor(255, 255, 255, 80), 6));
+  // p.drawRoundedRect(tpms_panel, 20, 20);
+  p.setPen(whiteColor(200));
+  //p.setRenderHint(QPainter::TextAntialiasing);
+  float maxv = 0;
+  float minv = 300;
+  int font_size = 60;
+
+  if (maxv < s->scene.tpmsPressureFl) {maxv = s->scene.tpmsPressureFl;}
+  if (maxv < s->scene.tpmsPressureFr) {maxv = s->scene.tpmsPressureFr;}
+  if (maxv < s->scene.tpmsPressureRl) {maxv = s->scene.tpmsPressureRl;}
+  if (maxv < s->scene.tpmsPressureRr) {maxv = s->scene.tpmsPressureRr;}
+  if (minv > s->scene.tpmsPressureFl) {minv = s->scene.tpmsPressureFl;}
+  if (minv > s->scene.tpmsPressureFr) {minv = s->scene.tpmsPressureFr;}
+  if (minv > s->scene.tpmsPressureRl) {minv = s->scene.tpmsPressureRl;}
+  if (minv > s->scene.tpmsPressureRr) {minv = s->scene.tpmsPressureRr;}
+
+  if (((maxv - minv) > 3 && s->scene.tpmsUnit != 2) || ((maxv - minv) > 0.2 && s->scene.tpmsUnit == 2)) {
+    p.setPen(redColor(200));
+  }
+  if (s->scene.tpmsUnit != 0) {
+    debugText(p, tpms_sp_xr, tpms_sp_yr+15, (s->scene.tpmsUnit == 2) ? "TPMS(bar)" : "TPMS(psi)", 150, 30);
+    font_size = (s->scene.tpmsUnit == 2) ? 43 : 36;
+  } else {
+    debugText(p, tpms_sp_xr, tpms_sp_yr+15, "TPMS(psi)", 150, 30);
+    font_size = 42;
+  }
+  if ((s->scene.tpmsPressureFl < 32 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureFl < 2.2 && s->scene.tpmsUnit == 2)) {
+    p.setPen(yellowColor(200));
+    debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, QString::number(s->scene.tpmsPressureFl, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
+  } else if (s->scene.tpmsPressureFl > 50) {
+    p.setPen(whiteColor(200));
+    debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, "N/A", 200, font_size);
+  } else if ((s->scene.tpmsPressureFl > 45 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureFl > 2.8 && s->scene.tpmsUnit == 2)) {
+    p.setPen(redColor(200));
+    debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, QString::number(s->scene.tpmsPressureFl, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
+  } else {
+    p.setPen(greenColor(200));
+    debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, QString::number(s->scene.tpmsPressureFl, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
+  }
+  if ((s->scene.tpmsPressureFr < 32 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureFr < 2.2 && s->scene.tpmsUnit == 2)) {
+    p.setPen(yellowColor(200));
+    debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, QString::number(s->scene.tpmsPressureFr, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
+  } else if (s->scene.tpmsPressureFr > 50) {
+    p.setPen(whiteColor(200));
+    debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, "N/A", 200, font_size);
+  } else if ((s->scene.tpmsPressureFr > 45 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureFr > 2.8 && s->scene.tpmsUnit == 2)) {
+    p.setPen(redColor(200));
+    debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, QString::number(s->scene.tpmsPressureFr, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
+  } else {
+    p.setPen(greenColor(200));
+    debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+60, QString::number(s->scene.tpmsPressureFr, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
+  }
+  if ((s->scene.tpmsPressureRl < 32 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureRl < 2.2 && s->scene.tpmsUnit == 2)) {
+    p.setPen(yellowColor(200));
+    debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, QString::number(s->scene.tpmsPressureRl, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
+  } else if (s->scene.tpmsPressureRl > 50) {
+    p.setPen(whiteColor(200));
+    debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, "N/A", 200, font_size);
+  } else if ((s->scene.tpmsPressureRl > 45 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureRl > 2.8 && s->scene.tpmsUnit == 2)) {
+    p.setPen(redColor(200));
+    debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, QString::number(s->scene.tpmsPressureRl, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
+  } else {
+    p.setPen(greenColor(200));
+    debugText(p, tpms_sp_xr-(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, QString::number(s->scene.tpmsPressureRl, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
+  }
+  if ((s->scene.tpmsPressureRr < 32 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureRr < 2.2 && s->scene.tpmsUnit == 2)) {
+    p.setPen(yellowColor(200));
+    debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, QString::number(s->scene.tpmsPressureRr, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
+  } else if (s->scene.tpmsPressureRr > 50) {
+    p.setPen(whiteColor(200));
+    debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, "N/A", 200, font_size);
+  } else if ((s->scene.tpmsPressureRr > 45 && s->scene.tpmsUnit != 2) || (s->scene.tpmsPressureRr > 2.8 && s->scene.tpmsUnit == 2)) {
+    p.setPen(redColor(200));
+    debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, QString::number(s->scene.tpmsPressureRr, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
+  } else {
+    p.setPen(greenColor(200));
+    debugText(p, tpms_sp_xr+(s->scene.tpmsUnit != 0?46:50), tpms_sp_yr+100, QString::number(s->scene.tpmsPressureRr, 'f', (s->scene.tpmsUnit != 0?1:0)), 200, font_size);
+  }
+
+  QRect right_panel(surface_rect.right() - UI_BORDER_SIZE - width_r, UI_BORDER_SIZE + 195, width_r, 104*num_r+25);  
+  p.setPen(QPen(QColor(255, 255, 255, 80), 6));
+  p.drawRoundedRect(right_panel, 20, 20);
+}
+
 void HudRenderer::drawSetSpeed(QPainter &p, const QRect &surface_rect) {
 
   UIState *s = uiState();
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+
 #include <QPainter>
 #include "selfdrive/ui/ui.h"
 
@@ -20,6 +22,8 @@ private:
   void uiText(QPainter &p, int x, int y, const QString &text, int alpha = 255, bool custom_color = false);
   void debugText(QPainter &p, int x, int y, const QString &text, int alpha = 255, int fontsize = 30, bool bold = false);
   void drawWheelState(QPainter &p, const QRect &surface_rect);
+  void drawRightPanelLayer(QPainter &p, const QRect &surface_rect);
+  void drawRightPanel(QPainter &p, const QRect &surface_rect);
 
   float speed = 0;
   float set_speed = 0;
@@ -44,6 +48,12 @@ private:
   float vel_rel = 0;
 
   const int UI_BORDER_SIZE = 15;
+  const int RIGHT_PANEL_LAYER_WIDTH = 260;
+
+  // parts of the HUD that are only redrawn when what they show changed
+  QPixmap header_layer;
+  QPixmap right_panel_layer;
+  std::array<float, 15> right_panel_inputs = {};
 
 protected:
   inline QColor redColor(int alpha = 255) { return QColor(201, 34, 49, alpha); }
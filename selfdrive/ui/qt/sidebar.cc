@@ -71,6 +71,8 @@ void Sidebar::offroadTransition(bool offroad) {
 
 void Sidebar::updateState(const UIState &s) {
   if (!isVisible()) return;
+  // everything shown comes from deviceState and pandaStates
+  if (!(s.scene.dirty & (UI_DIRTY_DEVICE | UI_DIRTY_PANDA))) return;
 
   auto &sm = *(s.sm);
 
@@ -6,7 +6,9 @@
 #include <GLES3/gl3.h>
 #endif
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <QApplication>
 
 namespace {
@@ -80,6 +82,11 @@ CameraWidget::~CameraWidget() {
     glDeleteBuffers(1, &frame_vbo);
     glDeleteBuffers(1, &frame_ibo);
     glDeleteTextures(2, textures);
+#ifndef QCOM2
+    for (auto &buf : pixel_buffers) {
+      glDeleteBuffers(1, &buf.pbo);
+    }
+#endif
   }
   doneCurrent();
 }
@@ -107,7 +114,9 @@ void CameraWidget::initializeGL() {
   GLint frame_pos_loc = program->attributeLocation("aPosition");
   GLint frame_texcoord_loc = program->attributeLocation("aTexCoord");
 
-  auto [x1, x2, y1, y2] = requested_stream_type == VISION_STREAM_DRIVER ? std::tuple(0.f, 1.f, 1.f, 0.f) : std::tuple(1.f, 0.f, 1.f, 0.f);
+  const bool driver = requested_stream_type == VISION_STREAM_DRIVER || requested_stream_type == VISION_STREAM_DRIVER_HALF ||
+                      requested_stream_type == VISION_STREAM_DRIVER_QUARTER;
+  auto [x1, x2, y1, y2] = driver ? std::tuple(0.f, 1.f, 1.f, 0.f) : std::tuple(1.f, 0.f, 1.f, 0.f);
   const uint8_t frame_indicies[] = {0, 1, 2, 0, 2, 3};
   const float frame_coords[4][4] = {
     {-1.0, -1.0, x2, y1}, // bl
@@ -162,6 +171,8 @@ void CameraWidget::stopVipcThread() {
     vipc_thread->wait();
     vipc_thread = nullptr;
   }
+  // the buffers went away with the vipc client
+  clearFrames();
 
 #ifdef QCOM2
   EGLDisplay egl_display = eglGetCurrentDisplay();
@@ -198,31 +209,29 @@ void CameraWidget::paintGL() {
   glClear(GL_STENCIL_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
   std::lock_guard lk(frame_lock);
-  if (frames.empty()) return;
-
-  int frame_idx = frames.size() - 1;
+#ifndef QCOM2
+  // the uploads started by the previous paint are done by now, this also retries buffers that failed to map
+  for (auto &b : pixel_buffers) {
+    if (b.state == PixelBuffer::UNMAPPED && b.pbo) mapPixelBuffer(b);
+  }
+#endif
+  if (!has_frame) return;
 
   // Always draw latest frame until sync logic is more stable
-  // for (frame_idx = 0; frame_idx < frames.size() - 1; frame_idx++) {
-  //   if (frames[frame_idx].first == draw_frame_id) break;
-  // }
-
-  // Log duplicate/dropped frames
-  if (frames[frame_idx].first == prev_frame_id) {
-    qDebug() << "Drawing same frame twice" << frames[frame_idx].first;
-  } else if (frames[frame_idx].first != prev_frame_id + 1) {
-    qDebug() << "Skipped frame" << frames[frame_idx].first;
-  }
-  prev_frame_id = frames[frame_idx].first;
-  VisionBuf *frame = frames[frame_idx].second;
+#ifdef QCOM2
+  VisionBuf *frame = latest_frame;
   assert(frame != nullptr);
+  countFrame(latest_frame_id);
+#else
+  uploadFrame();
+  countFrame(texture_frame_id);
+#endif
 
   auto frame_mat = calcFrameMatrix();
 
   glViewport(0, 0, glWidth(), glHeight());
   glBindVertexArray(frame_vao);
   glUseProgram(program->programId());
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
 #ifdef QCOM2
   // no frame copy
@@ -230,18 +239,10 @@ void CameraWidget::paintGL() {
   glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, egl_images[frame->idx]);
   assert(glGetError() == GL_NO_ERROR);
 #else
-  // fallback to copy
-  glPixelStorei(GL_UNPACK_ROW_LENGTH, stream_stride);
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, textures[0]);
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, stream_width, stream_height, GL_RED, GL_UNSIGNED_BYTE, frame->y);
-  assert(glGetError() == GL_NO_ERROR);
-
-  glPixelStorei(GL_UNPACK_ROW_LENGTH, stream_stride/2);
   glActiveTexture(GL_TEXTURE0 + 1);
   glBindTexture(GL_TEXTURE_2D, textures[1]);
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, stream_width/2, stream_height/2, GL_RG, GL_UNSIGNED_BYTE, frame->uv);
-  assert(glGetError() == GL_NO_ERROR);
 #endif
 
   glUniformMatrix4fv(program->uniformLocation("uTransform"), 1, GL_TRUE, frame_mat.v);
@@ -251,9 +252,96 @@ void CameraWidget::paintGL() {
   glBindVertexArray(0);
   glBindTexture(GL_TEXTURE_2D, 0);
   glActiveTexture(GL_TEXTURE0);
+}
+
+void CameraWidget::countFrame(uint32_t frame_id) {
+  if (prev_frame_id) {
+    if (frame_id == *prev_frame_id) {
+      frame_stats.duplicated++;
+    } else if (frame_id > *prev_frame_id + 1) {
+      frame_stats.dropped += frame_id - *prev_frame_id - 1;
+    }
+  }
+  frame_stats.drawn++;
+  prev_frame_id = frame_id;
+}
+
+CameraFrameStats CameraWidget::frameStats() const {
+  CameraFrameStats stats = frame_stats;
+  stats.received = frames_received;
+  return stats;
+}
+
+#ifndef QCOM2
+void CameraWidget::mapPixelBuffer(PixelBuffer &buf) {
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buf.pbo);
+  // invalidating lets the driver hand out new storage instead of waiting for the last upload
+  buf.ptr = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, pixel_buffer_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  buf.state = buf.ptr ? PixelBuffer::FREE : PixelBuffer::UNMAPPED;
+}
+
+// runs on the vipc thread, the copy itself is done without holding frame_lock
+void CameraWidget::copyFrame(VisionBuf *buf, uint32_t frame_id) {
+  const size_t y_size = buf->stride * buf->height;
+  const size_t uv_size = buf->stride * buf->height / 2;
+
+  PixelBuffer *target = nullptr;
+  {
+    std::lock_guard lk(frame_lock);
+    for (auto state : {PixelBuffer::FREE, PixelBuffer::READY}) {
+      for (auto &b : pixel_buffers) {
+        if (!target && b.state == state) target = &b;
+      }
+    }
+    // both buffers are being uploaded, or the stream changed size
+    if (!target || y_size + uv_size > pixel_buffer_size) return;
+    target->state = PixelBuffer::FILLING;
+  }
+
+  memcpy(target->ptr, buf->y, y_size);
+  memcpy(target->ptr + y_size, buf->uv, uv_size);
+
+  std::lock_guard lk(frame_lock);
+  for (auto &b : pixel_buffers) {
+    if (b.state == PixelBuffer::READY) b.state = PixelBuffer::FREE;
+  }
+  target->state = PixelBuffer::READY;
+  target->frame_id = frame_id;
+  has_frame = true;
+}
+
+// call with frame_lock held
+void CameraWidget::uploadFrame() {
+  auto ready = std::find_if(pixel_buffers.begin(), pixel_buffers.end(), [](auto &b) { return b.state == PixelBuffer::READY; });
+  if (ready == pixel_buffers.end()) return;
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ready->pbo);
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  ready->ptr = nullptr;
+  ready->state = PixelBuffer::UNMAPPED;
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, stream_stride);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, textures[0]);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, stream_width, stream_height, GL_RED, GL_UNSIGNED_BYTE, (const void *)0);
+  assert(glGetError() == GL_NO_ERROR);
+
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, stream_stride/2);
+  glActiveTexture(GL_TEXTURE0 + 1);
+  glBindTexture(GL_TEXTURE_2D, textures[1]);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, stream_width/2, stream_height/2, GL_RG, GL_UNSIGNED_BYTE, (const void *)(size_t)(stream_stride * stream_height));
+  assert(glGetError() == GL_NO_ERROR);
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
   glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  texture_frame_id = ready->frame_id;
 }
+#endif
 
 void CameraWidget::vipcConnected(VisionIpcClient *vipc_client) {
   makeCurrent();
@@ -302,7 +390,23 @@ void CameraWidget::vipcConnected(VisionIpcClient *vipc_client) {
   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, stream_width/2, stream_height/2, 0, GL_RG, GL_UNSIGNED_BYTE, nullptr);
   assert(glGetError() == GL_NO_ERROR);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  std::lock_guard lk(frame_lock);
+  pixel_buffer_size = stream_stride * stream_height * 3 / 2;
+  for (auto &buf : pixel_buffers) {
+    if (!buf.pbo) glGenBuffers(1, &buf.pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buf.pbo);
+    if (buf.ptr) glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, pixel_buffer_size, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    buf.ptr = nullptr;
+    mapPixelBuffer(buf);
+  }
+  assert(glGetError() == GL_NO_ERROR);
 #endif
+  // frame ids of another camera don't follow the last one drawn
+  prev_frame_id.reset();
 }
 
 void CameraWidget::vipcFrameReceived() {
@@ -340,13 +444,18 @@ void CameraWidget::vipcThread() {
     }
 
     if (VisionBuf *buf = vipc_client->recv(&meta_main, 1000)) {
+      frames_received++;
+#ifdef QCOM2
       {
         std::lock_guard lk(frame_lock);
-        frames.push_back(std::make_pair(meta_main.frame_id, buf));
-        while (frames.size() > FRAME_BUFFER_SIZE) {
-          frames.pop_front();
-        }
+        latest_frame = buf;
+        latest_frame_id = meta_main.frame_id;
+        has_frame = true;
       }
+#else
+      // paint even if no buffer took the frame, a buffer that failed to map is only mapped again by paintGL
+      copyFrame(buf, meta_main.frame_id);
+#endif
       emit vipcThreadFrameReceived();
     } else {
       if (!isVisible()) {
@@ -358,6 +467,13 @@ void CameraWidget::vipcThread() {
 
 void CameraWidget::clearFrames() {
   std::lock_guard lk(frame_lock);
-  frames.clear();
+  has_frame = false;
+#ifdef QCOM2
+  latest_frame = nullptr;
+#else
+  for (auto &buf : pixel_buffers) {
+    if (buf.state == PixelBuffer::READY) buf.state = PixelBuffer::FREE;
+  }
+#endif
   available_streams.clear();
 }
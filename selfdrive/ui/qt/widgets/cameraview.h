@@ -1,12 +1,13 @@
 #pragma once
 
-#include <deque>
+#include <array>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <set>
 #include <string>
-#include <utility>
 
 #include <QOpenGLFunctions>
 #include <QOpenGLShaderProgram>
@@ -25,7 +26,13 @@
 #include "msgq/visionipc/visionipc_client.h"
 #include "selfdrive/ui/ui.h"
 
-const int FRAME_BUFFER_SIZE = 5;
+struct CameraFrameStats {
+  uint64_t received = 0;
+  uint64_t drawn = 0;
+  // frames the camera sent that were never drawn, and draws of a frame that was drawn before
+  uint64_t dropped = 0;
+  uint64_t duplicated = 0;
+};
 
 class CameraWidget : public QOpenGLWidget, protected QOpenGLFunctions {
   Q_OBJECT
@@ -38,6 +45,7 @@ public:
   void setFrameId(int frame_id) { draw_frame_id = frame_id; }
   void setStreamType(VisionStreamType type) { requested_stream_type = type; }
   VisionStreamType getStreamType() { return active_stream_type; }
+  CameraFrameStats frameStats() const;
   void stopVipcThread();
 
 signals:
@@ -54,6 +62,9 @@ protected:
   virtual mat4 calcFrameMatrix();
   void vipcThread();
   void clearFrames();
+  // a frame arrived since the stream (re)connected, call with frame_lock held
+  bool hasFrame() const { return has_frame; }
+  void countFrame(uint32_t frame_id);
 
   int glWidth();
   int glHeight();
@@ -65,6 +76,25 @@ protected:
 
 #ifdef QCOM2
   std::map<int, EGLImageKHR> egl_images;
+  VisionBuf *latest_frame = nullptr;
+  uint32_t latest_frame_id = 0;
+#else
+  // The vipc thread copies each frame into a mapped pixel buffer, paintGL unmaps it and starts the
+  // texture upload from it. While one buffer uploads the other takes the next frame.
+  struct PixelBuffer {
+    enum State { UNMAPPED, FREE, FILLING, READY };
+    GLuint pbo = 0;
+    uint8_t *ptr = nullptr;
+    State state = UNMAPPED;
+    uint32_t frame_id = 0;
+  };
+  void mapPixelBuffer(PixelBuffer &buf);
+  void copyFrame(VisionBuf *buf, uint32_t frame_id);
+  void uploadFrame();
+
+  std::array<PixelBuffer, 2> pixel_buffers;
+  size_t pixel_buffer_size = 0;
+  uint32_t texture_frame_id = 0;
 #endif
 
   std::string stream_name;
@@ -76,9 +106,11 @@ protected:
   std::set<VisionStreamType> available_streams;
   QThread *vipc_thread = nullptr;
   std::recursive_mutex frame_lock;
-  std::deque<std::pair<uint32_t, VisionBuf*>> frames;
+  bool has_frame = false;
   uint32_t draw_frame_id = 0;
-  uint32_t prev_frame_id = 0;
+  std::optional<uint32_t> prev_frame_id;
+  std::atomic<uint64_t> frames_received = 0;
+  CameraFrameStats frame_stats;
 
 protected slots:
   void vipcConnected(VisionIpcClient *vipc_client);
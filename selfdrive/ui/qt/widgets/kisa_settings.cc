@@ -0,0 +1,96 @@
+#include "selfdrive/ui/qt/widgets/kisa_settings.h"
+
+#include "common/timing.h"
+
+// a local write the directory still disagrees with after this long lost to another writer
+const int UNCONFIRMED_TIMEOUT_MS = 2000;
+
+KisaSettings *KisaSettings::instance() {
+  static KisaSettings settings;
+  return &settings;
+}
+
+KisaSettings::KisaSettings(QObject *parent) : QObject(parent) {
+  // only the changed params are read, on the params watcher thread, and handed to the GUI thread
+  listener_id = params.watchChanges([this](const std::string &key) {
+    std::map<std::string, std::string> changed;
+    const bool all = key.empty();
+    if (all) {
+      changed = reader.readAll();
+    } else if (reader.checkKey(key)) {
+      changed[key] = reader.get(key);
+    } else {
+      return;  // temp files and the like
+    }
+    QMetaObject::invokeMethod(this, [=]() { update(changed, all); }, Qt::QueuedConnection);
+  });
+  // after the watch is set up, so no change is missed in between
+  values = params.readAll();
+}
+
+KisaSettings::~KisaSettings() {
+  params.unwatchChanges(listener_id);
+}
+
+std::string KisaSettings::get(const std::string &key) const {
+  auto it = values.find(key);
+  return it != values.end() ? it->second : "";
+}
+
+void KisaSettings::put(const std::string &key, const std::string &value) {
+  unconfirmed[key] = {value, millis_since_boot()};
+  params.putNonBlocking(key, value);
+  set(key, value);
+}
+
+void KisaSettings::remove(const std::string &key) {
+  unconfirmed[key] = {"", millis_since_boot()};
+  params.removeNonBlocking(key);
+  set(key, "");
+}
+
+void KisaSettings::watch(QObject *context, const std::string &key, std::function<void(const std::string &)> f) {
+  const QString qkey = QString::fromStdString(key);
+  QObject::connect(this, &KisaSettings::valueChanged, context, [=](const QString &changed, const QString &value) {
+    if (changed == qkey) {
+      f(value.toStdString());
+    }
+  });
+}
+
+void KisaSettings::update(std::map<std::string, std::string> changed, bool all) {
+  if (all) {
+    // a missing param reads as empty, like Params::get
+    for (const auto &[key, value] : values) {
+      changed.try_emplace(key, "");
+    }
+  }
+
+  const double now = millis_since_boot();
+  for (const auto &[key, value] : changed) {
+    // don't go back to the old value while our write is still queued
+    if (auto it = unconfirmed.find(key); it != unconfirmed.end()) {
+      const double written = it->second.second;
+      if (it->second.first != value && now - written < UNCONFIRMED_TIMEOUT_MS) {
+        // the disk wins if our write doesn't show up in time, unless there was a newer one
+        QTimer::singleShot(UNCONFIRMED_TIMEOUT_MS, this, [=, key = key, value = value]() {
+          if (auto u = unconfirmed.find(key); u != unconfirmed.end() && u->second.second == written) {
+            unconfirmed.erase(u);
+            set(key, value);
+          }
+        });
+        continue;
+      }
+      unconfirmed.erase(it);
+    }
+    set(key, value);
+  }
+}
+
+void KisaSettings::set(const std::string &key, const std::string &value) {
+  std::string &current = values[key];
+  if (current != value) {
+    current = value;
+    emit valueChanged(QString::fromStdString(key), QString::fromStdString(value));
+  }
+}
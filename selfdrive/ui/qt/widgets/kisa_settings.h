@@ -0,0 +1,63 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+
+#include <QObject>
+#include <QTimer>
+
+#include "common/params.h"
+
+// The params behind the kisapilot settings, read in bulk once and then served from memory.
+// Writes update the model right away and reach the disk on the Params writer thread. Changes
+// made by other processes are read off the GUI thread, one changed param at a time.
+class KisaSettings : public QObject {
+  Q_OBJECT
+
+public:
+  static KisaSettings *instance();
+
+  std::string get(const std::string &key) const;
+  void put(const std::string &key, const std::string &value);
+  void remove(const std::string &key);
+  // calls f with the new value each time key changes, for as long as context lives
+  void watch(QObject *context, const std::string &key, std::function<void(const std::string &)> f);
+
+signals:
+  void valueChanged(const QString &key, const QString &value);
+
+private:
+  KisaSettings(QObject *parent = nullptr);
+  ~KisaSettings();
+  void update(std::map<std::string, std::string> changed, bool all);
+  void set(const std::string &key, const std::string &value);
+
+  Params params;
+  // used on the params watcher thread only
+  Params reader;
+  int listener_id = 0;
+  std::map<std::string, std::string> values;
+  // written here but not on disk yet, with the time of the write
+  std::map<std::string, std::pair<std::string, double>> unconfirmed;
+};
+
+// stands in for Params in the kisapilot widgets
+class KisaParams {
+public:
+  inline std::string get(const std::string &key) { return KisaSettings::instance()->get(key); }
+  inline bool getBool(const std::string &key) { return get(key) == "1"; }
+  inline int put(const std::string &key, const std::string &val) {
+    KisaSettings::instance()->put(key, val);
+    return 0;
+  }
+  inline int put(const char *key, const char *val, size_t value_size) {
+    return put(std::string(key), std::string(val, value_size));
+  }
+  inline int putBool(const std::string &key, bool val) { return put(key, val ? "1" : "0"); }
+  inline int remove(const std::string &key) {
+    KisaSettings::instance()->remove(key);
+    return 0;
+  }
+};
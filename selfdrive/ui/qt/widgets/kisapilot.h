@@ -11,9 +11,25 @@
 #include "system/hardware/hw.h"
 #include "selfdrive/ui/qt/widgets/controls.h"
 #include "selfdrive/ui/qt/widgets/groupWidget.h"
+#include "selfdrive/ui/qt/widgets/kisa_settings.h"
 #include "selfdrive/ui/ui.h"
 
 
+// toggle of a bool param, follows changes made outside the widget
+class KisaToggle : public ToggleControl {
+  Q_OBJECT
+
+public:
+  KisaToggle(const std::string &param, const QString &title, const QString &desc, const QString &icon)
+      : ToggleControl(title, desc, icon, KisaParams().getBool(param)) {
+    KisaSettings::instance()->watch(this, param, [=](const std::string &value) {
+      if ((value == "1") != toggle.on) {
+        toggle.togglePosition();
+      }
+    });
+  }
+};
+
 class CLateralControlGroup : public CGroupWidget 
 {
   Q_OBJECT
@@ -33,7 +49,7 @@ public:
  private:
   QPushButton  *method_label;
   int    m_nMethod;
-  Params params;
+  KisaParams params;
   
   void  FramePID(QVBoxLayout *parent=nullptr);
   void  FrameINDI(QVBoxLayout *parent=nullptr);
@@ -146,7 +162,7 @@ private slots:
   void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
 
 private:
-  Params params;
+  KisaParams params;
 
   QString githubid;
   QString githubrepo;
@@ -170,7 +186,7 @@ private slots:
   void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
 
 private:
-  Params params;
+  KisaParams params;
 
   QString githubid;
   QString githubrepo;
@@ -186,86 +202,86 @@ private:
   void getFileID(const QString &fileid);
 };
 
-class AutoResumeToggle : public ToggleControl {
+class AutoResumeToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  AutoResumeToggle() : ToggleControl(tr("Use Auto Resume at Stop"), tr("It uses the automatic departure function when stopping while using SCC."), "../assets/offroad/icon_shell.png", Params().getBool("KisaAutoResume")) {
+  AutoResumeToggle() : KisaToggle("KisaAutoResume", tr("Use Auto Resume at Stop"), tr("It uses the automatic departure function when stopping while using SCC."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &AutoResumeToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaAutoResume", status);
+      KisaParams().putBool("KisaAutoResume", status);
     });
   }
 };
 
-class VariableCruiseToggle : public ToggleControl {
+class VariableCruiseToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  VariableCruiseToggle() : ToggleControl(tr("Use Cruise Button Spamming"), tr("Use the cruise button while using SCC to assist in acceleration and deceleration."), "../assets/offroad/icon_shell.png", Params().getBool("KisaVariableCruise")) {
+  VariableCruiseToggle() : KisaToggle("KisaVariableCruise", tr("Use Cruise Button Spamming"), tr("Use the cruise button while using SCC to assist in acceleration and deceleration."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &VariableCruiseToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaVariableCruise", status);
+      KisaParams().putBool("KisaVariableCruise", status);
     });
   }
 };
 
-class CruiseGapAdjustToggle : public ToggleControl {
+class CruiseGapAdjustToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  CruiseGapAdjustToggle() : ToggleControl(tr("Change Cruise Gap at Stop"), tr("For a quick start when stopping, the cruise gap will be changed to 1 step, and after departure, it will return to the original cruise gap according to certain conditions."), "../assets/offroad/icon_shell.png", Params().getBool("CruiseGapAdjust")) {
+  CruiseGapAdjustToggle() : KisaToggle("CruiseGapAdjust", tr("Change Cruise Gap at Stop"), tr("For a quick start when stopping, the cruise gap will be changed to 1 step, and after departure, it will return to the original cruise gap according to certain conditions."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &CruiseGapAdjustToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("CruiseGapAdjust", status);
+      KisaParams().putBool("CruiseGapAdjust", status);
     });
   }
 };
 
-class AutoEnabledToggle : public ToggleControl {
+class AutoEnabledToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  AutoEnabledToggle() : ToggleControl(tr("Use Auto Engagement"), tr("If the cruise button status is standby (CRUISE indication only and speed is not specified) in the Disengagement state, activate the automatic Engagement."), "../assets/offroad/icon_shell.png", Params().getBool("AutoEnable")) {
+  AutoEnabledToggle() : KisaToggle("AutoEnable", tr("Use Auto Engagement"), tr("If the cruise button status is standby (CRUISE indication only and speed is not specified) in the Disengagement state, activate the automatic Engagement."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &AutoEnabledToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("AutoEnable", status);
+      KisaParams().putBool("AutoEnable", status);
     });
   }
 };
 
-class CruiseAutoResToggle : public ToggleControl {
+class CruiseAutoResToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  CruiseAutoResToggle() : ToggleControl(tr("Use Auto RES while Driving"), tr("If the brake is applied while using the SCC and the standby mode is changed (CANCEL is not applicable), set it back to the previous speed when the brake pedal is released/accelerated pedal is operated. It operates when the cruise speed is set and the vehicle speed is more than 30 km/h or the car in front is recognized."), "../assets/offroad/icon_shell.png", Params().getBool("CruiseAutoRes")) {
+  CruiseAutoResToggle() : KisaToggle("CruiseAutoRes", tr("Use Auto RES while Driving"), tr("If the brake is applied while using the SCC and the standby mode is changed (CANCEL is not applicable), set it back to the previous speed when the brake pedal is released/accelerated pedal is operated. It operates when the cruise speed is set and the vehicle speed is more than 30 km/h or the car in front is recognized."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &CruiseAutoResToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("CruiseAutoRes", status);
+      KisaParams().putBool("CruiseAutoRes", status);
     });
   }
 };
 
-class BatteryChargingControlToggle : public ToggleControl {
+class BatteryChargingControlToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  BatteryChargingControlToggle() : ToggleControl(tr("Enable Battery Charging Control"), tr("It uses the battery charge control function."), "../assets/offroad/icon_shell.png", Params().getBool("KisaBatteryChargingControl")) {
+  BatteryChargingControlToggle() : KisaToggle("KisaBatteryChargingControl", tr("Enable Battery Charging Control"), tr("It uses the battery charge control function."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &BatteryChargingControlToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaBatteryChargingControl", status);
+      KisaParams().putBool("KisaBatteryChargingControl", status);
     });
   }
 };
 
-class BlindSpotDetectToggle : public ToggleControl {
+class BlindSpotDetectToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  BlindSpotDetectToggle() : ToggleControl(tr("Show BSM Status"), tr("If a car is detected in the rear, it will be displayed on the screen."), "../assets/offroad/icon_shell.png", Params().getBool("KisaBlindSpotDetect")) {
+  BlindSpotDetectToggle() : KisaToggle("KisaBlindSpotDetect", tr("Show BSM Status"), tr("If a car is detected in the rear, it will be displayed on the screen."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &BlindSpotDetectToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaBlindSpotDetect", status);
+      KisaParams().putBool("KisaBlindSpotDetect", status);
       if (state) {
         uiState()->scene.nKisaBlindSpotDetect = true;
       } else {
@@ -275,62 +291,62 @@ public:
   }
 };
 
-class UFCModeEnabledToggle : public ToggleControl {
+class UFCModeEnabledToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  UFCModeEnabledToggle() : ToggleControl(tr("User-Friendly Control(UFC) Mode"), tr("OP activates with Main Cruise Switch, AutoRES while driving, Seperate Lat/Long and etc"), "../assets/offroad/icon_shell.png", Params().getBool("UFCModeEnabled")) {
+  UFCModeEnabledToggle() : KisaToggle("UFCModeEnabled", tr("User-Friendly Control(UFC) Mode"), tr("OP activates with Main Cruise Switch, AutoRES while driving, Seperate Lat/Long and etc"), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &UFCModeEnabledToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("UFCModeEnabled", status);
+      KisaParams().putBool("UFCModeEnabled", status);
     });
   }
 };
 
-class WhitePandaSupportToggle : public ToggleControl {
+class WhitePandaSupportToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  WhitePandaSupportToggle() : ToggleControl(tr("Support WhitePanda"), tr("Turn on this function if you use WhitePanda."), "../assets/offroad/icon_shell.png", Params().getBool("WhitePandaSupport")) {
+  WhitePandaSupportToggle() : KisaToggle("WhitePandaSupport", tr("Support WhitePanda"), tr("Turn on this function if you use WhitePanda."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &WhitePandaSupportToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("WhitePandaSupport", status);
+      KisaParams().putBool("WhitePandaSupport", status);
     });
   }
 };
 
-class SteerWarningFixToggle : public ToggleControl {
+class SteerWarningFixToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  SteerWarningFixToggle() : ToggleControl(tr("Ignore of Steering Warning"), tr("Turn on the function when a steering error occurs in the vehicle and the open pilot cannot be executed (some vehicles only). Do not turn on the function if it occurs in a normal error environment while driving."), "../assets/offroad/icon_shell.png", Params().getBool("SteerWarningFix")) {
+  SteerWarningFixToggle() : KisaToggle("SteerWarningFix", tr("Ignore of Steering Warning"), tr("Turn on the function when a steering error occurs in the vehicle and the open pilot cannot be executed (some vehicles only). Do not turn on the function if it occurs in a normal error environment while driving."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &SteerWarningFixToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("SteerWarningFix", status);
+      KisaParams().putBool("SteerWarningFix", status);
     });
   }
 };
 
-class LiveSteerRatioToggle : public ToggleControl {
+class LiveSteerRatioToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  LiveSteerRatioToggle() : ToggleControl(tr("Use Live SteerRatio"), tr("Live SteerRatio is used instead of variable/fixed SteerRatio."), "../assets/offroad/icon_shell.png", Params().getBool("KisaLiveSteerRatio")) {
+  LiveSteerRatioToggle() : KisaToggle("KisaLiveSteerRatio", tr("Use Live SteerRatio"), tr("Live SteerRatio is used instead of variable/fixed SteerRatio."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &LiveSteerRatioToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaLiveSteerRatio", status);
+      KisaParams().putBool("KisaLiveSteerRatio", status);
     });
   }
 };
 
-class DrivingRecordToggle : public ToggleControl {
+class DrivingRecordToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  DrivingRecordToggle() : ToggleControl(tr("Use Auto Screen Record"), tr("Automatically record/stop the screen while driving. Recording begins after departure, and recording ends when the vehicle stops."), "../assets/offroad/icon_shell.png", Params().getBool("KisaDrivingRecord")) {
+  DrivingRecordToggle() : KisaToggle("KisaDrivingRecord", tr("Use Auto Screen Record"), tr("Automatically record/stop the screen while driving. Recording begins after departure, and recording ends when the vehicle stops."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &DrivingRecordToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaDrivingRecord", status);
+      KisaParams().putBool("KisaDrivingRecord", status);
       if (state) {
         uiState()->scene.driving_record = true;
       } else {
@@ -340,50 +356,50 @@ public:
   }
 };
 
-class TurnSteeringDisableToggle : public ToggleControl {
+class TurnSteeringDisableToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  TurnSteeringDisableToggle() : ToggleControl(tr("Stop Steer Assist on Turn Signals"), tr("When driving below the lane change speed, the automatic steering is temporarily paused while the turn signals on."), "../assets/offroad/icon_shell.png", Params().getBool("KisaTurnSteeringDisable")) {
+  TurnSteeringDisableToggle() : KisaToggle("KisaTurnSteeringDisable", tr("Stop Steer Assist on Turn Signals"), tr("When driving below the lane change speed, the automatic steering is temporarily paused while the turn signals on."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &TurnSteeringDisableToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaTurnSteeringDisable", status);
+      KisaParams().putBool("KisaTurnSteeringDisable", status);
     });
   }
 };
 
-class HotspotOnBootToggle : public ToggleControl {
+class HotspotOnBootToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  HotspotOnBootToggle() : ToggleControl(tr("HotSpot on Boot"), tr("It automatically runs a hotspot when booting."), "", Params().getBool("KisaHotspotOnBoot")) {
+  HotspotOnBootToggle() : KisaToggle("KisaHotspotOnBoot", tr("HotSpot on Boot"), tr("It automatically runs a hotspot when booting."), "") {
     QObject::connect(this, &HotspotOnBootToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaHotspotOnBoot", status);
+      KisaParams().putBool("KisaHotspotOnBoot", status);
     });
   }
 };
 
-class CruiseOverMaxSpeedToggle : public ToggleControl {
+class CruiseOverMaxSpeedToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  CruiseOverMaxSpeedToggle() : ToggleControl(tr("Reset MaxSpeed Over CurrentSpeed"), tr("If the current speed exceeds the set speed, synchronize the set speed with the current speed."), "../assets/offroad/icon_shell.png", Params().getBool("CruiseOverMaxSpeed")) {
+  CruiseOverMaxSpeedToggle() : KisaToggle("CruiseOverMaxSpeed", tr("Reset MaxSpeed Over CurrentSpeed"), tr("If the current speed exceeds the set speed, synchronize the set speed with the current speed."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &CruiseOverMaxSpeedToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("CruiseOverMaxSpeed", status);
+      KisaParams().putBool("CruiseOverMaxSpeed", status);
     });
   }
 };
 
-class DebugUiOneToggle : public ToggleControl {
+class DebugUiOneToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  DebugUiOneToggle() : ToggleControl(tr("DEBUG UI 1"), "", "../assets/offroad/icon_shell.png", Params().getBool("DebugUi1")) {
+  DebugUiOneToggle() : KisaToggle("DebugUi1", tr("DEBUG UI 1"), "", "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &DebugUiOneToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("DebugUi1", status);
+      KisaParams().putBool("DebugUi1", status);
       if (state) {
         uiState()->scene.nDebugUi1 = true;
       } else {
@@ -393,14 +409,14 @@ public:
   }
 };
 
-class DebugUiTwoToggle : public ToggleControl {
+class DebugUiTwoToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  DebugUiTwoToggle() : ToggleControl(tr("DEBUG UI 2"), "", "../assets/offroad/icon_shell.png", Params().getBool("DebugUi2")) {
+  DebugUiTwoToggle() : KisaToggle("DebugUi2", tr("DEBUG UI 2"), "", "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &DebugUiTwoToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("DebugUi2", status);
+      KisaParams().putBool("DebugUi2", status);
       if (state) {
         uiState()->scene.nDebugUi2 = true;
       } else {
@@ -410,14 +426,14 @@ public:
   }
 };
 
-class DebugUiThreeToggle : public ToggleControl {
+class DebugUiThreeToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  DebugUiThreeToggle() : ToggleControl(tr("DEBUG UI 3"), "", "../assets/offroad/icon_shell.png", Params().getBool("DebugUi3")) {
+  DebugUiThreeToggle() : KisaToggle("DebugUi3", tr("DEBUG UI 3"), "", "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &DebugUiThreeToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("DebugUi3", status);
+      KisaParams().putBool("DebugUi3", status);
       if (state) {
         uiState()->scene.nDebugUi3 = true;
       } else {
@@ -427,26 +443,26 @@ public:
   }
 };
 
-class LongLogToggle : public ToggleControl {
+class LongLogToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  LongLogToggle() : ToggleControl(tr("Show LongControl LOG"), tr("Display logs for long tuning debugs instead of variable cruise logs on the screen."), "../assets/offroad/icon_shell.png", Params().getBool("LongLogDisplay")) {
+  LongLogToggle() : KisaToggle("LongLogDisplay", tr("Show LongControl LOG"), tr("Display logs for long tuning debugs instead of variable cruise logs on the screen."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &LongLogToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("LongLogDisplay", status);
+      KisaParams().putBool("LongLogDisplay", status);
     });
   }
 };
 
-class PrebuiltToggle : public ToggleControl {
+class PrebuiltToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  PrebuiltToggle() : ToggleControl(tr("Use Smart Prebuilt"), tr("Create a Prebuilt file and speed up booting. When this function is turned on, the booting speed is accelerated using the cache, and if you press the update button in the menu after modifying the code, or if you rebooted with the 'gi' command in the command window, remove it automatically and compile it."), "../assets/offroad/icon_shell.png", Params().getBool("PutPrebuiltOn")) {
+  PrebuiltToggle() : KisaToggle("PutPrebuiltOn", tr("Use Smart Prebuilt"), tr("Create a Prebuilt file and speed up booting. When this function is turned on, the booting speed is accelerated using the cache, and if you press the update button in the menu after modifying the code, or if you rebooted with the 'gi' command in the command window, remove it automatically and compile it."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &PrebuiltToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("PutPrebuiltOn", status);
+      KisaParams().putBool("PutPrebuiltOn", status);
       if (state) {
         std::system("rm -f /data/openpilot/prebuilt");
       }
@@ -454,62 +470,62 @@ public:
   }
 };
 
-class LDWSToggle : public ToggleControl {
+class LDWSToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  LDWSToggle() : ToggleControl(tr("Set LDWS Vehicles"), "", "../assets/offroad/icon_shell.png", Params().getBool("LdwsCarFix")) {
+  LDWSToggle() : KisaToggle("LdwsCarFix", tr("Set LDWS Vehicles"), "", "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &LDWSToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("LdwsCarFix", status);
+      KisaParams().putBool("LdwsCarFix", status);
     });
   }
 };
 
-class GearDToggle : public ToggleControl {
+class GearDToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  GearDToggle() : ToggleControl(tr("Set DriverGear by Force"), tr("It is used when the gear recognition problem. Basically, CABANA data should be analyzed, but it is temporarily resolved."), "../assets/offroad/icon_shell.png", Params().getBool("JustDoGearD")) {
+  GearDToggle() : KisaToggle("JustDoGearD", tr("Set DriverGear by Force"), tr("It is used when the gear recognition problem. Basically, CABANA data should be analyzed, but it is temporarily resolved."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &GearDToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("JustDoGearD", status);
+      KisaParams().putBool("JustDoGearD", status);
     });
   }
 };
 
-class RunNaviOnBootToggle : public ToggleControl {
+class RunNaviOnBootToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  RunNaviOnBootToggle() : ToggleControl(tr("Run Navigation on Boot"), tr("Automatically execute the navigation (waze) when switching to the driving screen after booting."), "../assets/offroad/icon_shell.png", Params().getBool("KisaRunNaviOnBoot")) {
+  RunNaviOnBootToggle() : KisaToggle("KisaRunNaviOnBoot", tr("Run Navigation on Boot"), tr("Automatically execute the navigation (waze) when switching to the driving screen after booting."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &RunNaviOnBootToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaRunNaviOnBoot", status);
+      KisaParams().putBool("KisaRunNaviOnBoot", status);
     });
   }
 };
 
-class BattLessToggle : public ToggleControl {
+class BattLessToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  BattLessToggle() : ToggleControl(tr("Set BatteryLess Device"), tr("This is a toggle for batteryless Device. Related settings apply."), "../assets/offroad/icon_shell.png", Params().getBool("KisaBattLess")) {
+  BattLessToggle() : KisaToggle("KisaBattLess", tr("Set BatteryLess Device"), tr("This is a toggle for batteryless Device. Related settings apply."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &BattLessToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaBattLess", status);
+      KisaParams().putBool("KisaBattLess", status);
     });
   }
 };
 
-class LiveTunePanelToggle : public ToggleControl {
+class LiveTunePanelToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  LiveTunePanelToggle() : ToggleControl(tr("Use LiveTune and Show UI"), tr("Display the UI related to live tuning on the screen. Various tuning values can be adjusted live on the driving screen. It is reflected in the parameter when adjusting, and the value is maintained even after turning off the toggle and rebooting."), "../assets/offroad/icon_shell.png", Params().getBool("KisaLiveTunePanelEnable")) {
+  LiveTunePanelToggle() : KisaToggle("KisaLiveTunePanelEnable", tr("Use LiveTune and Show UI"), tr("Display the UI related to live tuning on the screen. Various tuning values can be adjusted live on the driving screen. It is reflected in the parameter when adjusting, and the value is maintained even after turning off the toggle and rebooting."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &LiveTunePanelToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaLiveTunePanelEnable", status);
+      KisaParams().putBool("KisaLiveTunePanelEnable", status);
       if (state) {
         uiState()->scene.live_tune_panel_enable = true;
         uiState()->scene.kisa_livetune_ui = true;
@@ -521,38 +537,38 @@ public:
   }
 };
 
-class GitPullOnBootToggle : public ToggleControl {
+class GitPullOnBootToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  GitPullOnBootToggle() : ToggleControl(tr("Git Pull On Boot"), tr("If there is an update after the boot, run Git Pull automatically and reboot."), "", Params().getBool("GitPullOnBoot")) {
+  GitPullOnBootToggle() : KisaToggle("GitPullOnBoot", tr("Git Pull On Boot"), tr("If there is an update after the boot, run Git Pull automatically and reboot."), "") {
     QObject::connect(this, &GitPullOnBootToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("GitPullOnBoot", status);
+      KisaParams().putBool("GitPullOnBoot", status);
     });
   }
 };
 
-class StoppingDistAdjToggle : public ToggleControl {
+class StoppingDistAdjToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  StoppingDistAdjToggle() : ToggleControl(tr("Adjust Stopping Distance"), tr("Stop a little further ahead than the radar stop distance. If you approach the car in front of you at a high speed, it may sometimes be difficult to stop enough, so if you are uncomfortable, turn off the function."), "../assets/offroad/icon_shell.png", Params().getBool("StoppingDistAdj")) {
+  StoppingDistAdjToggle() : KisaToggle("StoppingDistAdj", tr("Adjust Stopping Distance"), tr("Stop a little further ahead than the radar stop distance. If you approach the car in front of you at a high speed, it may sometimes be difficult to stop enough, so if you are uncomfortable, turn off the function."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &StoppingDistAdjToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("StoppingDistAdj", status);
+      KisaParams().putBool("StoppingDistAdj", status);
     });
   }
 };
 
-class ShowErrorToggle : public ToggleControl {
+class ShowErrorToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  ShowErrorToggle() : ToggleControl(tr("Show TMUX Error"), tr("Display the error on the Device screen when a process error occurs while driving or off-road."), "../assets/offroad/icon_shell.png", Params().getBool("ShowError")) {
+  ShowErrorToggle() : KisaToggle("ShowError", tr("Show TMUX Error"), tr("Display the error on the Device screen when a process error occurs while driving or off-road."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &ShowErrorToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("ShowError", status);
+      KisaParams().putBool("ShowError", status);
       if (state) {
         uiState()->scene.show_error = true;
       } else {
@@ -562,374 +578,374 @@ public:
   }
 };
 
-class StockNaviSpeedToggle : public ToggleControl {
+class StockNaviSpeedToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  StockNaviSpeedToggle() : ToggleControl(tr("Use Stock SafetyCAM Speed"), tr("When decelerating the safety section, use the safety speed from the vehicle navigation system (limited to some vehicles with the corresponding data)."), "../assets/offroad/icon_shell.png", Params().getBool("StockNaviSpeedEnabled")) {
+  StockNaviSpeedToggle() : KisaToggle("StockNaviSpeedEnabled", tr("Use Stock SafetyCAM Speed"), tr("When decelerating the safety section, use the safety speed from the vehicle navigation system (limited to some vehicles with the corresponding data)."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &StockNaviSpeedToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("StockNaviSpeedEnabled", status);
+      KisaParams().putBool("StockNaviSpeedEnabled", status);
     });
   }
 };
 
-class E2ELongToggle : public ToggleControl {
+class E2ELongToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  E2ELongToggle() : ToggleControl(tr("Enable E2E Long"), tr("Activate E2E Long. It may work unexpectedly. Be careful."), "../assets/offroad/icon_shell.png", Params().getBool("E2ELong")) {
+  E2ELongToggle() : KisaToggle("E2ELong", tr("Enable E2E Long"), tr("Activate E2E Long. It may work unexpectedly. Be careful."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &E2ELongToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("E2ELong", status);
+      KisaParams().putBool("E2ELong", status);
     });
   }
 };
 
-class StopAtStopSignToggle : public ToggleControl {
+class StopAtStopSignToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  StopAtStopSignToggle() : ToggleControl(tr("Stop at Stop Sign"), tr("Openpilot tries to stop at stop sign depends on Model."), "../assets/offroad/icon_shell.png", Params().getBool("StopAtStopSign")) {
+  StopAtStopSignToggle() : KisaToggle("StopAtStopSign", tr("Stop at Stop Sign"), tr("Openpilot tries to stop at stop sign depends on Model."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &StopAtStopSignToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("StopAtStopSign", status);
+      KisaParams().putBool("StopAtStopSign", status);
     });
   }
 };
 
-class GoogleMapEnabledToggle : public ToggleControl {
+class GoogleMapEnabledToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  GoogleMapEnabledToggle() : ToggleControl(tr("Use GoogleMap for Mapbox"), tr("Use GoogleMap when you search a destination."), "../assets/offroad/icon_shell.png", Params().getBool("GoogleMapEnabled")) {
+  GoogleMapEnabledToggle() : KisaToggle("GoogleMapEnabled", tr("Use GoogleMap for Mapbox"), tr("Use GoogleMap when you search a destination."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &GoogleMapEnabledToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("GoogleMapEnabled", status);
+      KisaParams().putBool("GoogleMapEnabled", status);
     });
   }
 };
 
-class OSMEnabledToggle : public ToggleControl {
+class OSMEnabledToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  OSMEnabledToggle() : ToggleControl(tr("Enable OSM"), tr("This enables OSM."), "../assets/offroad/icon_shell.png", Params().getBool("OSMEnable")) {
+  OSMEnabledToggle() : KisaToggle("OSMEnable", tr("Enable OSM"), tr("This enables OSM."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &OSMEnabledToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("OSMEnable", status);
+      KisaParams().putBool("OSMEnable", status);
     });
   }
 };
 
-class OSMSpeedLimitEnabledToggle : public ToggleControl {
+class OSMSpeedLimitEnabledToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  OSMSpeedLimitEnabledToggle() : ToggleControl(tr("Enable OSM SpeedLimit"), tr("This enables OSM speedlimit."), "../assets/offroad/icon_shell.png", Params().getBool("OSMSpeedLimitEnable")) {
+  OSMSpeedLimitEnabledToggle() : KisaToggle("OSMSpeedLimitEnable", tr("Enable OSM SpeedLimit"), tr("This enables OSM speedlimit."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &OSMSpeedLimitEnabledToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("OSMSpeedLimitEnable", status);
+      KisaParams().putBool("OSMSpeedLimitEnable", status);
     });
   }
 };
 
-class IgnoreCanErroronISGToggle : public ToggleControl {
+class IgnoreCanErroronISGToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  IgnoreCanErroronISGToggle() : ToggleControl(tr("Ignore Can Error on ISG"), tr("Turn this on, if can error occurs on ISG operation."), "../assets/offroad/icon_shell.png", Params().getBool("IgnoreCANErroronISG")) {
+  IgnoreCanErroronISGToggle() : KisaToggle("IgnoreCANErroronISG", tr("Ignore Can Error on ISG"), tr("Turn this on, if can error occurs on ISG operation."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &IgnoreCanErroronISGToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("IgnoreCANErroronISG", status);
+      KisaParams().putBool("IgnoreCANErroronISG", status);
     });
   }
 };
 
-class StockLKASEnabledatDisenagedStatusToggle : public ToggleControl {
+class StockLKASEnabledatDisenagedStatusToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  StockLKASEnabledatDisenagedStatusToggle() : ToggleControl(tr("StockLKAS Enabled at Disengagement"), tr("Turn this on, if you want to use Stock LKAS at OP disengaged status. Seems this related to cluster error when OP active because Stock CAN messages over PANDA or not."), "../assets/offroad/icon_shell.png", Params().getBool("StockLKASEnabled")) {
+  StockLKASEnabledatDisenagedStatusToggle() : KisaToggle("StockLKASEnabled", tr("StockLKAS Enabled at Disengagement"), tr("Turn this on, if you want to use Stock LKAS at OP disengaged status. Seems this related to cluster error when OP active because Stock CAN messages over PANDA or not."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &StockLKASEnabledatDisenagedStatusToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("StockLKASEnabled", status);
+      KisaParams().putBool("StockLKASEnabled", status);
     });
   }
 };
 
-class StandstillResumeAltToggle : public ToggleControl {
+class StandstillResumeAltToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  StandstillResumeAltToggle() : ToggleControl(tr("Standstill Resume Alternative"), tr("Turn this on, if auto resume doesn't work at standstill. some cars only(ex. GENESIS). before enable, try to adjust RES message counts above.(reboot required)"), "../assets/offroad/icon_shell.png", Params().getBool("StandstillResumeAlt")) {
+  StandstillResumeAltToggle() : KisaToggle("StandstillResumeAlt", tr("Standstill Resume Alternative"), tr("Turn this on, if auto resume doesn't work at standstill. some cars only(ex. GENESIS). before enable, try to adjust RES message counts above.(reboot required)"), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &StandstillResumeAltToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("StandstillResumeAlt", status);
+      KisaParams().putBool("StandstillResumeAlt", status);
     });
   }
 };
 
-class MapboxEnabledToggle : public ToggleControl {
+class MapboxEnabledToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  MapboxEnabledToggle() : ToggleControl(tr("Enable Mapbox"), tr("If you want to use Mapbox, turn on and then connect to device using web browser http://(device ip):8082  Mapbox setting will show up and type mapbox pk and sk token(you can created this on mapbox.com website). If you want to search destinations with googlemap, first, you should create google api key and enable Enable GoogleMap for Mapbox"), "../assets/offroad/icon_shell.png", Params().getBool("MapboxEnabled")) {
+  MapboxEnabledToggle() : KisaToggle("MapboxEnabled", tr("Enable Mapbox"), tr("If you want to use Mapbox, turn on and then connect to device using web browser http://(device ip):8082  Mapbox setting will show up and type mapbox pk and sk token(you can created this on mapbox.com website). If you want to search destinations with googlemap, first, you should create google api key and enable Enable GoogleMap for Mapbox"), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &MapboxEnabledToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("MapboxEnabled", status);
+      KisaParams().putBool("MapboxEnabled", status);
     });
   }
 };
 
-class UseRadarTrackToggle : public ToggleControl {
+class UseRadarTrackToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  UseRadarTrackToggle() : ToggleControl(tr("Use Radar Track"), tr("Some cars have known radar tracks(from comma) for long control. This uses radar track directly instead of scc can message. Before you go, you must need to run hyundai_enable_radar_points.py in /data/openpilot/selfdrive/debug dir to enable your radar track. (Reboot required)"), "../assets/offroad/icon_shell.png", Params().getBool("UseRadarTrack")) {
+  UseRadarTrackToggle() : KisaToggle("UseRadarTrack", tr("Use Radar Track"), tr("Some cars have known radar tracks(from comma) for long control. This uses radar track directly instead of scc can message. Before you go, you must need to run hyundai_enable_radar_points.py in /data/openpilot/selfdrive/debug dir to enable your radar track. (Reboot required)"), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &UseRadarTrackToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("UseRadarTrack", status);
+      KisaParams().putBool("UseRadarTrack", status);
     });
   }
 };
 
-class UseRadarValue : public ToggleControl {
+class UseRadarValue : public KisaToggle {
   Q_OBJECT
 
 public:
-  UseRadarValue() : ToggleControl(tr("Use Radar for lead car"), tr("If the radar detects a lead car, the device uses radar values (distance, relative velocity, etc.) because vision can sometimes be inaccurate."), "../assets/offroad/icon_shell.png", Params().getBool("UseRadarValue")) {
+  UseRadarValue() : KisaToggle("UseRadarValue", tr("Use Radar for lead car"), tr("If the radar detects a lead car, the device uses radar values (distance, relative velocity, etc.) because vision can sometimes be inaccurate."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &UseRadarValue::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("UseRadarValue", status);
+      KisaParams().putBool("UseRadarValue", status);
     });
   }
 };
 
-class RadarDisableToggle : public ToggleControl {
+class RadarDisableToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  RadarDisableToggle() : ToggleControl(tr("Disable Radar"), tr("This is pre-requisite for LongControl of HKG. It seems that this affects AEB. So do not use this if you have any concern."), "../assets/offroad/icon_shell.png", Params().getBool("RadarDisable")) {
+  RadarDisableToggle() : KisaToggle("RadarDisable", tr("Disable Radar"), tr("This is pre-requisite for LongControl of HKG. It seems that this affects AEB. So do not use this if you have any concern."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &RadarDisableToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("RadarDisable", status);
+      KisaParams().putBool("RadarDisable", status);
     });
   }
 };
 
-class C2WithCommaPowerToggle : public ToggleControl {
+class C2WithCommaPowerToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  C2WithCommaPowerToggle() : ToggleControl(tr("C2 with CommaPower"), tr("This is for C2 users with Comma Power."), "../assets/offroad/icon_shell.png", Params().getBool("C2WithCommaPower")) {
+  C2WithCommaPowerToggle() : KisaToggle("C2WithCommaPower", tr("C2 with CommaPower"), tr("This is for C2 users with Comma Power."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &C2WithCommaPowerToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("C2WithCommaPower", status);
+      KisaParams().putBool("C2WithCommaPower", status);
     });
   }
 };
 
-class CustomTRToggle : public ToggleControl {
+class CustomTRToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  CustomTRToggle() : ToggleControl(tr("Custom TR Enable"), tr("to use Custom TR not 1.45(comma default)."), "../assets/offroad/icon_shell.png", Params().getBool("CustomTREnabled")) {
+  CustomTRToggle() : KisaToggle("CustomTREnabled", tr("Custom TR Enable"), tr("to use Custom TR not 1.45(comma default)."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &CustomTRToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("CustomTREnabled", status);
+      KisaParams().putBool("CustomTREnabled", status);
     });
   }
 };
 
-class RoutineDriveOnToggle : public ToggleControl {
+class RoutineDriveOnToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  RoutineDriveOnToggle() : ToggleControl(tr("Routine Drive by RoadName"), tr("This will adjust useful things by roadname. If you want to use, edit the file, /data/params/d/RoadList. modify like this RoadName1,offset1(ex:+0.05),RoadName2,offset2(ex:-0.05),... and the second line RoadName3,speedlimit(ex:30),RoadName4,speedlimit(ex:60),..."), "../assets/offroad/icon_shell.png", Params().getBool("RoutineDriveOn")) {
+  RoutineDriveOnToggle() : KisaToggle("RoutineDriveOn", tr("Routine Drive by RoadName"), tr("This will adjust useful things by roadname. If you want to use, edit the file, /data/params/d/RoadList. modify like this RoadName1,offset1(ex:+0.05),RoadName2,offset2(ex:-0.05),... and the second line RoadName3,speedlimit(ex:30),RoadName4,speedlimit(ex:60),..."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &RoutineDriveOnToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("RoutineDriveOn", status);
+      KisaParams().putBool("RoutineDriveOn", status);
     });
   }
 };
 
-class CloseToRoadEdgeToggle : public ToggleControl {
+class CloseToRoadEdgeToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  CloseToRoadEdgeToggle() : ToggleControl(tr("Driving Close to RoadEdge"), tr("This will adjust the camera offset to get close to road edge if the car is on the first or last lane."), "../assets/offroad/icon_shell.png", Params().getBool("CloseToRoadEdge")) {
+  CloseToRoadEdgeToggle() : KisaToggle("CloseToRoadEdge", tr("Driving Close to RoadEdge"), tr("This will adjust the camera offset to get close to road edge if the car is on the first or last lane."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &CloseToRoadEdgeToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("CloseToRoadEdge", status);
+      KisaParams().putBool("CloseToRoadEdge", status);
     });
   }
 };
 
-class ToAvoidLKASFaultToggle : public ToggleControl {
+class ToAvoidLKASFaultToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  ToAvoidLKASFaultToggle() : ToggleControl(tr("To Avoid LKAS Fault"), tr("to avoid LKAS fault above max angle limit(car specific). This is live value. Find out your maxframe while driving."), "../assets/offroad/icon_shell.png", Params().getBool("AvoidLKASFaultEnabled")) {
+  ToAvoidLKASFaultToggle() : KisaToggle("AvoidLKASFaultEnabled", tr("To Avoid LKAS Fault"), tr("to avoid LKAS fault above max angle limit(car specific). This is live value. Find out your maxframe while driving."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &ToAvoidLKASFaultToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("AvoidLKASFaultEnabled", status);
+      KisaParams().putBool("AvoidLKASFaultEnabled", status);
     });
   }
 };
 
-class ToAvoidLKASFaultBeyondToggle : public ToggleControl {
+class ToAvoidLKASFaultBeyondToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  ToAvoidLKASFaultBeyondToggle() : ToggleControl(tr("To Avoid LKAS Fault with More Steer"), tr("This is just in case you are using other panda setting.(delta updown, maxsteer, rtdelta and etc)."), "../assets/offroad/icon_shell.png", Params().getBool("AvoidLKASFaultBeyond")) {
+  ToAvoidLKASFaultBeyondToggle() : KisaToggle("AvoidLKASFaultBeyond", tr("To Avoid LKAS Fault with More Steer"), tr("This is just in case you are using other panda setting.(delta updown, maxsteer, rtdelta and etc)."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &ToAvoidLKASFaultBeyondToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("AvoidLKASFaultBeyond", status);
+      KisaParams().putBool("AvoidLKASFaultBeyond", status);
     });
   }
 };
 
-class StockDecelonCamToggle : public ToggleControl {
+class StockDecelonCamToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  StockDecelonCamToggle() : ToggleControl(tr("Use Stock Decel on SaftySection"), tr("Use stock deceleration on safety section.(the vehicle equipped with Stock Navigation)"), "../assets/offroad/icon_shell.png", Params().getBool("UseStockDecelOnSS")) {
+  StockDecelonCamToggle() : KisaToggle("UseStockDecelOnSS", tr("Use Stock Decel on SaftySection"), tr("Use stock deceleration on safety section.(the vehicle equipped with Stock Navigation)"), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &StockDecelonCamToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("UseStockDecelOnSS", status);
+      KisaParams().putBool("UseStockDecelOnSS", status);
     });
   }
 };
 
-class RPMAnimatedToggle : public ToggleControl {
+class RPMAnimatedToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  RPMAnimatedToggle() : ToggleControl(tr("RPM Animated"), tr("Show Animated RPM"), "../assets/offroad/icon_shell.png", Params().getBool("AnimatedRPM")) {
+  RPMAnimatedToggle() : KisaToggle("AnimatedRPM", tr("RPM Animated"), tr("Show Animated RPM"), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &RPMAnimatedToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("AnimatedRPM", status);
+      KisaParams().putBool("AnimatedRPM", status);
     });
   }
 };
 
-class NoSmartMDPSToggle : public ToggleControl {
+class NoSmartMDPSToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  NoSmartMDPSToggle() : ToggleControl(tr("No Smart MDPS"), tr("Turn on, if you have no smartmdps or no mdps harness to avoid sending can under certain speed that is not able to use lane keeping."), "../assets/offroad/icon_shell.png", Params().getBool("NoSmartMDPS")) {
+  NoSmartMDPSToggle() : KisaToggle("NoSmartMDPS", tr("No Smart MDPS"), tr("Turn on, if you have no smartmdps or no mdps harness to avoid sending can under certain speed that is not able to use lane keeping."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &NoSmartMDPSToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("NoSmartMDPS", status);
+      KisaParams().putBool("NoSmartMDPS", status);
     });
   }
 };
 
-class SpeedCameraOffsetToggle : public ToggleControl {
+class SpeedCameraOffsetToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  SpeedCameraOffsetToggle() : ToggleControl(tr("Speed CameraOffset"), tr("This increase offset at low speed and decrease offset at low speed. If you feel car moves to right at low speed."), "../assets/offroad/icon_shell.png", Params().getBool("SpeedCameraOffset")) {
+  SpeedCameraOffsetToggle() : KisaToggle("SpeedCameraOffset", tr("Speed CameraOffset"), tr("This increase offset at low speed and decrease offset at low speed. If you feel car moves to right at low speed."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &SpeedCameraOffsetToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("SpeedCameraOffset", status);
+      KisaParams().putBool("SpeedCameraOffset", status);
     });
   }
 };
 
-class SpeedBumpDecelToggle : public ToggleControl {
+class SpeedBumpDecelToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  SpeedBumpDecelToggle() : ToggleControl(tr("SpeedBump Deceleration"), tr("Use the deceleration feature on the speed bump. It's an indirect control method. It can be decelerated directly in long control control, but for versatility, indirect control for now."), "../assets/offroad/icon_shell.png", Params().getBool("KISASpeedBump")) {
+  SpeedBumpDecelToggle() : KisaToggle("KISASpeedBump", tr("SpeedBump Deceleration"), tr("Use the deceleration feature on the speed bump. It's an indirect control method. It can be decelerated directly in long control control, but for versatility, indirect control for now."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &SpeedBumpDecelToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KISASpeedBump", status);
+      KisaParams().putBool("KISASpeedBump", status);
     });
   }
 };
 
-class KISAEarlyStoppingToggle : public ToggleControl {
+class KISAEarlyStoppingToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  KISAEarlyStoppingToggle() : ToggleControl(tr("Early Slowdown with Gap"), tr("This feature may help your vehicle to stop early using Cruise Gap with value 4 when your car start to stop from model."), "../assets/offroad/icon_shell.png", Params().getBool("KISAEarlyStop")) {
+  KISAEarlyStoppingToggle() : KisaToggle("KISAEarlyStop", tr("Early Slowdown with Gap"), tr("This feature may help your vehicle to stop early using Cruise Gap with value 4 when your car start to stop from model."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &KISAEarlyStoppingToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KISAEarlyStop", status);
+      KisaParams().putBool("KISAEarlyStop", status);
     });
   }
 };
 
-class TorqueUseAngle : public ToggleControl {
+class TorqueUseAngle : public KisaToggle {
   Q_OBJECT
 
 public:
-  TorqueUseAngle() : ToggleControl(tr("UseAngle"), tr("Use Steer Angle On/Off"), "../assets/offroad/icon_shell.png", Params().getBool("TorqueUseAngle")) {
+  TorqueUseAngle() : KisaToggle("TorqueUseAngle", tr("UseAngle"), tr("Use Steer Angle On/Off"), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &TorqueUseAngle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("TorqueUseAngle", status);
+      KisaParams().putBool("TorqueUseAngle", status);
     });
   }
 };
 
-class TorqueUseLiveFriction : public ToggleControl {
+class TorqueUseLiveFriction : public KisaToggle {
   Q_OBJECT
 
 public:
-  TorqueUseLiveFriction() : ToggleControl(tr("Use LiveTorque"), tr("Use Live Torque"), "../assets/offroad/icon_shell.png", Params().getBool("KisaLiveTorque")) {
+  TorqueUseLiveFriction() : KisaToggle("KisaLiveTorque", tr("Use LiveTorque"), tr("Use Live Torque"), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &TorqueUseLiveFriction::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaLiveTorque", status);
+      KisaParams().putBool("KisaLiveTorque", status);
     });
   }
 };
 
-class DepartChimeAtResume : public ToggleControl {
+class DepartChimeAtResume : public KisaToggle {
   Q_OBJECT
 
 public:
-  DepartChimeAtResume() : ToggleControl(tr("Depart Chime at Resume"), tr("Use Chime for Resume. This can notify for you to get start while not using SCC."), "../assets/offroad/icon_shell.png", Params().getBool("DepartChimeAtResume")) {
+  DepartChimeAtResume() : KisaToggle("DepartChimeAtResume", tr("Depart Chime at Resume"), tr("Use Chime for Resume. This can notify for you to get start while not using SCC."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &DepartChimeAtResume::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("DepartChimeAtResume", status);
+      KisaParams().putBool("DepartChimeAtResume", status);
     });
   }
 };
 
-class CruiseGapBySpdOn : public ToggleControl {
+class CruiseGapBySpdOn : public KisaToggle {
   Q_OBJECT
 
 public:
-  CruiseGapBySpdOn() : ToggleControl(tr("Cruise Gap Change by Speed"), tr("Cruise Gap is changeable by vehicle speed."), "../assets/offroad/icon_shell.png", Params().getBool("CruiseGapBySpdOn")) {
+  CruiseGapBySpdOn() : KisaToggle("CruiseGapBySpdOn", tr("Cruise Gap Change by Speed"), tr("Cruise Gap is changeable by vehicle speed."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &CruiseGapBySpdOn::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("CruiseGapBySpdOn", status);
+      KisaParams().putBool("CruiseGapBySpdOn", status);
     });
   }
 };
 
-class CruiseSetwithRoadLimitSpeed : public ToggleControl {
+class CruiseSetwithRoadLimitSpeed : public KisaToggle {
   Q_OBJECT
 
 public:
-  CruiseSetwithRoadLimitSpeed() : ToggleControl(tr("CruiseSet with RoadLimitSpeed"), tr("Cruise Set with RoadLimitSpeed(Ext Navi)"), "../assets/offroad/icon_shell.png", Params().getBool("CruiseSetwithRoadLimitSpeedEnabled")) {
+  CruiseSetwithRoadLimitSpeed() : KisaToggle("CruiseSetwithRoadLimitSpeedEnabled", tr("CruiseSet with RoadLimitSpeed"), tr("Cruise Set with RoadLimitSpeed(Ext Navi)"), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &CruiseSetwithRoadLimitSpeed::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("CruiseSetwithRoadLimitSpeedEnabled", status);
+      KisaParams().putBool("CruiseSetwithRoadLimitSpeedEnabled", status);
     });
   }
 };
 
-class KISADebug : public ToggleControl {
+class KISADebug : public KisaToggle {
   Q_OBJECT
 
 public:
-  KISADebug() : ToggleControl(tr("KISA Debug Mode"), tr("Run KISA Debug Mode"), "../assets/offroad/icon_shell.png", Params().getBool("KISADebug")) {
+  KISADebug() : KisaToggle("KISADebug", tr("KISA Debug Mode"), tr("Run KISA Debug Mode"), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &KISADebug::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KISADebug", status);
+      KisaParams().putBool("KISADebug", status);
       if (state) {
         uiState()->scene.KISA_Debug = true;
       } else {
@@ -939,14 +955,14 @@ public:
   }
 };
 
-class LowUIProfile : public ToggleControl {
+class LowUIProfile : public KisaToggle {
   Q_OBJECT
 
 public:
-  LowUIProfile() : ToggleControl(tr("Low UI Profile"), tr("Low UI Profile to get UI more visible at bottom side."), "../assets/offroad/icon_shell.png", Params().getBool("LowUIProfile")) {
+  LowUIProfile() : KisaToggle("LowUIProfile", tr("Low UI Profile"), tr("Low UI Profile to get UI more visible at bottom side."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &LowUIProfile::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("LowUIProfile", status);
+      KisaParams().putBool("LowUIProfile", status);
       if (state) {
         uiState()->scene.low_ui_profile = true;
       } else {
@@ -956,38 +972,38 @@ public:
   }
 };
 
-class EnableLogger : public ToggleControl {
+class EnableLogger : public KisaToggle {
   Q_OBJECT
 
 public:
-  EnableLogger() : ToggleControl(tr("Enable Driving Log Record"), tr("Record the driving log locally for data analysis. Only loggers are activated and not uploaded to the server."), "../assets/offroad/icon_shell.png", Params().getBool("KisaEnableLogger")) {
+  EnableLogger() : KisaToggle("KisaEnableLogger", tr("Enable Driving Log Record"), tr("Record the driving log locally for data analysis. Only loggers are activated and not uploaded to the server."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &EnableLogger::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaEnableLogger", status);
+      KisaParams().putBool("KisaEnableLogger", status);
     });
   }
 };
 
-class EnableUploader : public ToggleControl {
+class EnableUploader : public KisaToggle {
   Q_OBJECT
 
 public:
-  EnableUploader() : ToggleControl(tr("Enable Sending Log to Server"), tr("Activate the upload process to transmit system logs and other driving data to the server. Upload it only off-road."), "../assets/offroad/icon_shell.png", Params().getBool("KisaEnableUploader")) {
+  EnableUploader() : KisaToggle("KisaEnableUploader", tr("Enable Sending Log to Server"), tr("Activate the upload process to transmit system logs and other driving data to the server. Upload it only off-road."), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &EnableUploader::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("KisaEnableUploader", status);
+      KisaParams().putBool("KisaEnableUploader", status);
     });
   }
 };
 
-class RegenBrakeFeatureToggle : public ToggleControl {
+class RegenBrakeFeatureToggle : public KisaToggle {
   Q_OBJECT
 
 public:
-  RegenBrakeFeatureToggle() : ToggleControl(tr("Use RegenBrake Feature"), tr("Advanced regeneration brake features. ST: full stop, AT: deceleration level adjustment with distance, EE: E2E longitudinal assist"), "../assets/offroad/icon_shell.png", Params().getBool("RegenBrakeFeatureOn")) {
+  RegenBrakeFeatureToggle() : KisaToggle("RegenBrakeFeatureOn", tr("Use RegenBrake Feature"), tr("Advanced regeneration brake features. ST: full stop, AT: deceleration level adjustment with distance, EE: E2E longitudinal assist"), "../assets/offroad/icon_shell.png") {
     QObject::connect(this, &RegenBrakeFeatureToggle::toggleFlipped, [=](int state) {
       bool status = state ? true : false;
-      Params().putBool("RegenBrakeFeatureOn", status);
+      KisaParams().putBool("RegenBrakeFeatureOn", status);
     });
   }
 };
@@ -1002,7 +1018,7 @@ public:
 private:
   QPushButton btn;
   QPushButton btnc;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1017,7 +1033,7 @@ public:
 private:
   QPushButton btn1;
   QPushButton btn2;
-  Params params;
+  KisaParams params;
 
   void refresh();
 };
@@ -1033,7 +1049,7 @@ private:
   QLabel label;
   QPushButton btn1;
   QPushButton btn2;
-  Params params;
+  KisaParams params;
   QString selection;
 
   void refresh();
@@ -1049,7 +1065,7 @@ public:
 private:
   QPushButton btn1;
   QPushButton btn2;
-  Params params;
+  KisaParams params;
 
   QString selection;
   QStringList stringList;
@@ -1065,7 +1081,7 @@ public:
 private:
   QPushButton btn;
   QComboBox combobox;
-  Params params;
+  KisaParams params;
 
   void refresh();
 };
@@ -1082,7 +1098,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1097,7 +1113,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1112,7 +1128,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1127,7 +1143,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1142,7 +1158,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1158,7 +1174,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1172,7 +1188,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1189,7 +1205,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1204,7 +1220,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1219,7 +1235,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1234,7 +1250,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1249,7 +1265,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1263,7 +1279,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1281,7 +1297,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1297,7 +1313,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1312,7 +1328,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1328,7 +1344,7 @@ private:
   QPushButton btnminus;
   QPushButton btnplus;
   QLabel label;
-  Params params;
+  KisaParams params;
   float digit = 0.01;
   
   void refresh();
@@ -1344,7 +1360,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1374,7 +1390,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1389,7 +1405,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1404,7 +1420,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1419,7 +1435,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1434,7 +1450,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1450,7 +1466,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   int latcontrol;
 
@@ -1468,7 +1484,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1483,7 +1499,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1498,7 +1514,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1513,7 +1529,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1528,7 +1544,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1543,7 +1559,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1558,7 +1574,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1573,7 +1589,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1588,7 +1604,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1603,7 +1619,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1618,7 +1634,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1633,7 +1649,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1648,7 +1664,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1663,7 +1679,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1678,7 +1694,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1693,7 +1709,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1708,7 +1724,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1723,7 +1739,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1738,7 +1754,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1753,7 +1769,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1768,7 +1784,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1782,7 +1798,7 @@ public:
 private:
   QLabel local_hash;
   QLabel remote_hash;
-  Params params;
+  KisaParams params;
 };
 
 class RESChoice : public AbstractControl {
@@ -1795,7 +1811,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1810,7 +1826,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1825,7 +1841,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1840,7 +1856,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1855,7 +1871,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1870,7 +1886,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1894,7 +1910,7 @@ private:
   QLabel label2a;
   QLabel label3a;
   QLabel label4a;
-  Params params;
+  KisaParams params;
   
   void refresh1();
   void refresh2();
@@ -1912,7 +1928,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -1943,7 +1959,7 @@ private:
   QLabel label2a;
   QLabel label3a;
   QLabel label4a;
-  Params params;
+  KisaParams params;
 
   void refresh1();
   void refresh2();
@@ -1960,7 +1976,7 @@ public:
 private:
   QPushButton btn;
   QPushButton btn2;
-  Params params;
+  KisaParams params;
   
   void refresh();
   void refresh2();
@@ -1981,7 +1997,7 @@ private:
   QLabel label2;
   QLabel label1a;
   QLabel label2a;
-  Params params;
+  KisaParams params;
 
   void refresh1();
   void refresh2();
@@ -1995,7 +2011,7 @@ public:
 
 private:
   QPushButton btn;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2010,7 +2026,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2025,7 +2041,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2040,7 +2056,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2055,7 +2071,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2070,7 +2086,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2092,7 +2108,7 @@ private:
   QPushButton btn;
   QLineEdit edit1;
   QLineEdit edit2;
-  Params params;
+  KisaParams params;
 
   void refresh();
 };
@@ -2114,7 +2130,7 @@ private:
   QPushButton btn;
   QLineEdit edit1;
   QLineEdit edit2;
-  Params params;
+  KisaParams params;
 
   void refresh();
 };
@@ -2129,7 +2145,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2145,7 +2161,7 @@ private:
   QPushButton btn2;
   QPushButton btn3;
   QPushButton btn4;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2160,7 +2176,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2175,7 +2191,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2190,7 +2206,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2205,7 +2221,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2220,7 +2236,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2242,7 +2258,7 @@ private:
   QPushButton btn;
   QLineEdit edit1;
   QLineEdit edit2;
-  Params params;
+  KisaParams params;
 
   void refresh();
 };
@@ -2258,7 +2274,7 @@ private:
   QPushButton btnminus;
   QPushButton btnplus;
   QLabel label;
-  Params params;
+  KisaParams params;
   float digit = 0.01;
   
   void refresh();
@@ -2274,7 +2290,7 @@ private:
   QPushButton btn;
   QLineEdit edit1;
   QLineEdit edit2;
-  Params params;
+  KisaParams params;
 
   void refresh();
 };
@@ -2289,7 +2305,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2311,7 +2327,7 @@ private:
   QPushButton btn;
   QLineEdit edit1;
   QLineEdit edit2;
-  Params params;
+  KisaParams params;
 
   void refresh();
 };
@@ -2326,7 +2342,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2346,7 +2362,7 @@ private:
   QLabel labelr1;
   QLabel labell;
   QLabel labelr;
-  Params params;
+  KisaParams params;
   
   void refreshl();
   void refreshr();
@@ -2367,7 +2383,7 @@ private:
   QLabel labelr1;
   QLabel labell;
   QLabel labelr;
-  Params params;
+  KisaParams params;
   
   void refreshl();
   void refreshr();
@@ -2382,7 +2398,7 @@ public:
 private:
   QPushButton btn0;
   QPushButton btn1;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2397,7 +2413,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2411,7 +2427,7 @@ public:
 private:
   QPushButton btn;
   QLineEdit edit;
-  Params params;
+  KisaParams params;
 
   void refresh();
 };
@@ -2426,7 +2442,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   int    m_nMethod;
 
@@ -2451,7 +2467,7 @@ private:
   QPushButton btn1;
   QPushButton btn2;
   QPushButton btn3;
-  Params params;
+  KisaParams params;
   
   void refresh1();
   void refresh2();
@@ -2477,7 +2493,7 @@ private:
   QPushButton btn1;
   QPushButton btn2;
   QPushButton btn3;
-  Params params;
+  KisaParams params;
   
   void refresh1();
   void refresh2();
@@ -2496,7 +2512,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2511,7 +2527,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2526,7 +2542,7 @@ private:
   QPushButton btn;
   QPushButton btna;
   QLineEdit edit;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2541,7 +2557,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2569,7 +2585,7 @@ private:
   QPushButton btn2;
   QPushButton btn3;
   QPushButton btn4;
-  Params params;
+  KisaParams params;
   
   void refresh1();
   void refresh2();
@@ -2591,7 +2607,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2606,7 +2622,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2620,7 +2636,7 @@ public:
 private:
   QPushButton btn;
   QLineEdit edit;
-  Params params;
+  KisaParams params;
 
   void refresh();
 };
@@ -2648,7 +2664,7 @@ private:
   QPushButton btn2;
   QPushButton btn3;
   QPushButton btn4;
-  Params params;
+  KisaParams params;
   
   void refresh1();
   void refresh2();
@@ -2670,7 +2686,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2685,7 +2701,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2700,7 +2716,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2715,7 +2731,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2730,7 +2746,7 @@ private:
   QPushButton btn1;
   QPushButton btn2;
   QPushButton btn3;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
@@ -2745,7 +2761,7 @@ private:
   QPushButton btnplus;
   QPushButton btnminus;
   QLabel label;
-  Params params;
+  KisaParams params;
   
   void refresh();
 };
\ No newline at end of file
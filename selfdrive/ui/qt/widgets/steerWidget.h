@@ -10,6 +10,7 @@
 #include <QWidget>
 
 #include "selfdrive/ui/qt/widgets/controls.h"
+#include "selfdrive/ui/qt/widgets/kisa_settings.h"
 #include "selfdrive/ui/ui.h"
 
 
@@ -35,7 +36,7 @@ private:
   void  FrameNormal(QWidget *parent);
 
  private:
-  Params params; 
+  KisaParams params; 
   QLabel *icon_label;
   QPixmap  pix_plus;
   QPixmap  pix_minus;
@@ -0,0 +1,123 @@
+#include "catch2/catch.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include "common/params.h"
+#include "common/util.h"
+#include "selfdrive/ui/qt/offroad/settings.h"
+#include "selfdrive/ui/qt/widgets/kisa_settings.h"
+
+// KisaSettings reads the params directory once, so all tests share one, set up before the first read
+static void setupParams() {
+  static bool done = false;
+  if (!done) {
+    char tmp[] = "/tmp/kisa_settings_XXXXXX";
+    REQUIRE(mkdtemp(tmp) != nullptr);
+    setenv("PARAMS_ROOT", tmp, 1);
+    done = true;
+  }
+}
+
+static bool waitFor(std::function<bool()> done, int timeout_ms = 3000) {
+  QElapsedTimer timer;
+  timer.start();
+  while (!done() && timer.elapsed() < timeout_ms) {
+    QCoreApplication::processEvents();
+    util::sleep_for(5);
+  }
+  return done();
+}
+
+TEST_CASE("KisaSettings") {
+  setupParams();
+  Params params;
+  KisaSettings *settings = KisaSettings::instance();
+
+  std::vector<std::pair<QString, QString>> changes;
+  QObject context;
+  QObject::connect(settings, &KisaSettings::valueChanged, &context, [&](const QString &key, const QString &value) {
+    changes.push_back({key, value});
+  });
+
+  SECTION("writes are seen at once and reach the disk later") {
+    KisaParams().put("KisaAutoShutdown", "3");
+    REQUIRE(settings->get("KisaAutoShutdown") == "3");
+    REQUIRE(changes == std::vector<std::pair<QString, QString>>{{"KisaAutoShutdown", "3"}});
+    REQUIRE(waitFor([&] { return params.get("KisaAutoShutdown") == "3"; }));
+
+    // writing the same value again is no change
+    KisaParams().put("KisaAutoShutdown", "3");
+    REQUIRE(changes.size() == 1);
+  }
+
+  SECTION("changes made elsewhere are picked up") {
+    params.put("KisaAutoScreenOff", "5");
+    REQUIRE(waitFor([&] { return settings->get("KisaAutoScreenOff") == "5"; }));
+    REQUIRE(changes.back() == std::pair<QString, QString>{"KisaAutoScreenOff", "5"});
+
+    params.remove("KisaAutoScreenOff");
+    REQUIRE(waitFor([&] { return settings->get("KisaAutoScreenOff").empty(); }));
+  }
+
+  SECTION("queued writes aren't undone by other changes") {
+    KisaParams().putBool("KISADebug", true);
+    params.put("KisaAutoScreenOff", "1");
+    REQUIRE(waitFor([&] { return settings->get("KisaAutoScreenOff") == "1"; }));
+    REQUIRE(settings->get("KISADebug") == "1");
+    REQUIRE(waitFor([&] { return params.getBool("KISADebug"); }));
+  }
+
+  SECTION("a remove isn't undone by a queued write") {
+    KisaParams().put("KisaAutoShutdown", "4");
+    KisaParams().remove("KisaAutoShutdown");
+    REQUIRE(settings->get("KisaAutoShutdown").empty());
+    params.put("KisaAutoScreenOff", "2");
+    REQUIRE(waitFor([&] { return settings->get("KisaAutoScreenOff") == "2"; }));
+    util::sleep_for(100);
+    REQUIRE(params.get("KisaAutoShutdown").empty());
+    REQUIRE(settings->get("KisaAutoShutdown").empty());
+  }
+}
+
+// the settings panels are built when the settings window is, their time is the time to open it
+TEST_CASE("kisapilot panel construction time") {
+  setupParams();
+  Params params;
+  const std::vector<std::string> keys = params.allKeys();
+
+  QElapsedTimer timer;
+  timer.start();
+  params.readAll();
+  printf("params readAll: %.2f ms\n", timer.nsecsElapsed() / 1e6);
+
+  // what each widget did before, one file per read
+  for (const char *pass : {"cold", "warm"}) {
+    timer.restart();
+    for (const auto &key : keys) {
+      Params().get(key);
+    }
+    printf("params get of %zu keys (%s): %.2f ms\n", keys.size(), pass, timer.nsecsElapsed() / 1e6);
+  }
+
+  KisaSettings::instance();
+  std::vector<std::pair<const char *, std::function<QWidget *()>>> panels = {
+    {"UIPanel", [] { return new UIPanel(); }},
+    {"DrivingPanel", [] { return new DrivingPanel(); }},
+    {"DeveloperPanel", [] { return new DeveloperPanel(); }},
+    {"TuningPanel", [] { return new TuningPanel(); }},
+  };
+  for (auto &[name, create] : panels) {
+    timer.restart();
+    std::unique_ptr<QWidget> panel(create());
+    printf("%s: %.2f ms\n", name, timer.nsecsElapsed() / 1e6);
+    REQUIRE(!panel->findChildren<QWidget *>().isEmpty());
+  }
+}
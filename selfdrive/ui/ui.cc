@@ -23,6 +23,7 @@ static void update_state(UIState *s) {
   UIScene &scene = s->scene;
 
   if (sm.updated("controlsState")) {
+    scene.dirty |= UI_DIRTY_CONTROLS;
     scene.controls_state = sm["controlsState"].getControlsState();
     auto cons_data = sm["controlsState"].getControlsState();
     scene.lateralControlMethod = scene.controls_state.getLateralControlMethod();
@@ -60,6 +61,7 @@ static void update_state(UIState *s) {
     scene.standstillElapsedTime = cons_data.getStandStillTimer();
   }
   if (sm.updated("carState")) {
+    scene.dirty |= UI_DIRTY_CAR_STATE;
     scene.car_state = sm["carState"].getCarState();
     auto cs_data = sm["carState"].getCarState();
     auto cruiseState = scene.car_state.getCruiseState();
@@ -98,6 +100,7 @@ static void update_state(UIState *s) {
   }
 
   if (sm.updated("liveParameters")) {
+    scene.dirty |= UI_DIRTY_LIVE_PARAMS;
     //scene.liveParams = sm["liveParameters"].getLiveParameters();
     auto live_data = sm["liveParameters"].getLiveParameters();
     scene.liveParams.angleOffset = live_data.getAngleOffsetDeg();
@@ -107,6 +110,7 @@ static void update_state(UIState *s) {
   }
 
   if (sm.updated("liveCalibration")) {
+    scene.dirty |= UI_DIRTY_CALIBRATION;
     auto list2rot = [](const capnp::List<float>::Reader &rpy_list) ->Eigen::Matrix3f {
       return euler2rot({rpy_list[0], rpy_list[1], rpy_list[2]}).cast<float>();
     };
@@ -123,6 +127,7 @@ static void update_state(UIState *s) {
   }
 
   if (sm.updated("deviceState")) {
+    scene.dirty |= UI_DIRTY_DEVICE;
     scene.deviceState = sm["deviceState"].getDeviceState();
     scene.cpuPerc = scene.deviceState.getCpuUsagePercent()[0];
     scene.cpuTemp = scene.deviceState.getCpuTempC()[0];
@@ -132,10 +137,12 @@ static void update_state(UIState *s) {
     scene.ipAddress = scene.deviceState.getIpAddress();
   }
   if (sm.updated("peripheralState")) {
+    scene.dirty |= UI_DIRTY_PERIPHERAL;
     scene.peripheralState = sm["peripheralState"].getPeripheralState();
     scene.fanSpeedRpm = scene.peripheralState.getFanSpeedRpm();
   }
   if (sm.updated("pandaStates")) {
+    scene.dirty |= UI_DIRTY_PANDA;
     auto pandaStates = sm["pandaStates"].getPandaStates();
     if (pandaStates.size() > 0) {
       scene.pandaType = pandaStates[0].getPandaType();
@@ -149,10 +156,12 @@ static void update_state(UIState *s) {
       }
     }
   } else if ((s->sm->frame - s->sm->rcv_frame("pandaStates")) > 5*UI_FREQ) {
+    if (scene.pandaType != cereal::PandaState::PandaType::UNKNOWN) scene.dirty |= UI_DIRTY_PANDA;
     scene.pandaType = cereal::PandaState::PandaType::UNKNOWN;
   }
   if (scene.pandaType == cereal::PandaState::PandaType::TRES) {
     if (sm.updated("gpsLocation")) {
+      scene.dirty |= UI_DIRTY_GPS;
       auto ge_data = sm["gpsLocation"].getGpsLocation();
       scene.gpsAccuracy = ge_data.getVerticalAccuracy();
       scene.altitude = ge_data.getAltitude();
@@ -160,12 +169,14 @@ static void update_state(UIState *s) {
     }    
   } else {
     if (sm.updated("ubloxGnss")) {
+      scene.dirty |= UI_DIRTY_GPS;
       auto ub_data = sm["ubloxGnss"].getUbloxGnss();
       if (ub_data.which() == cereal::UbloxGnss::MEASUREMENT_REPORT) {
         scene.satelliteCount = ub_data.getMeasurementReport().getNumMeas();
       }
     }
     if (sm.updated("gpsLocationExternal")) {
+      scene.dirty |= UI_DIRTY_GPS;
       auto ge_data = sm["gpsLocationExternal"].getGpsLocationExternal();
       scene.gpsAccuracy = ge_data.getHorizontalAccuracy();
       scene.altitude = ge_data.getAltitude();
@@ -173,16 +184,19 @@ static void update_state(UIState *s) {
     }
   }
   if (sm.updated("carParams")) {
+    scene.dirty |= UI_DIRTY_CAR_PARAMS;
     auto cp_data = sm["carParams"].getCarParams();
     scene.longitudinal_control = cp_data.getOpenpilotLongitudinalControl();
     scene.steer_actuator_delay = cp_data.getSteerActuatorDelay();
     scene.car_fingerprint = cp_data.getCarFingerprint();
   }
   if (sm.updated("wideRoadCameraState")) {
+    scene.dirty |= UI_DIRTY_LIGHT_SENSOR;
     auto cam_state = sm["wideRoadCameraState"].getWideRoadCameraState();
     float scale = (cam_state.getSensor() == cereal::FrameData::ImageSensor::AR0231) ? 6.0f : 1.0f;
     scene.light_sensor = std::max(100.0f - scale * cam_state.getExposureValPercent(), 0.0f);
   } else if (!sm.allAliveAndValid({"wideRoadCameraState"})) {
+    if (scene.light_sensor != -1) scene.dirty |= UI_DIRTY_LIGHT_SENSOR;
     scene.light_sensor = -1;
   }
 
@@ -198,6 +212,7 @@ static void update_state(UIState *s) {
   }
 
   if (sm.updated("lateralPlan")) {
+    scene.dirty |= UI_DIRTY_PLAN;
     scene.lateral_plan = sm["lateralPlan"].getLateralPlan();
     auto lp_data = sm["lateralPlan"].getLateralPlan();
     scene.lateralPlan.laneWidth = lp_data.getLaneWidth();
@@ -208,6 +223,7 @@ static void update_state(UIState *s) {
     scene.lateralPlan.totalCameraOffset = lp_data.getTotalCameraOffset();
   }
   if (sm.updated("longitudinalPlan")) {
+    scene.dirty |= UI_DIRTY_PLAN;
     scene.longitudinal_plan = sm["longitudinalPlan"].getLongitudinalPlan();
     auto lop_data = sm["longitudinalPlan"].getLongitudinalPlan();
     for (int i = 0; i < std::size(scene.longitudinalPlan.e2ex); i++) {
@@ -225,6 +241,7 @@ static void update_state(UIState *s) {
   }
   // kisapilot
   if (sm.updated("liveENaviData")) {
+    scene.dirty |= UI_DIRTY_NAVI;
     scene.live_enavi_data = sm["liveENaviData"].getLiveENaviData();
     auto lme_data = sm["liveENaviData"].getLiveENaviData();
     scene.liveENaviData.ekisaspeedlimit = lme_data.getSpeedLimit();
@@ -265,6 +282,7 @@ static void update_state(UIState *s) {
     }
   }
   if (sm.updated("liveMapData")) {
+    scene.dirty |= UI_DIRTY_NAVI;
     scene.live_map_data = sm["liveMapData"].getLiveMapData();
     auto lmap_data = sm["liveMapData"].getLiveMapData();
     scene.liveMapData.ospeedLimit = lmap_data.getSpeedLimit();
@@ -285,6 +303,7 @@ void ui_update_params(UIState *s) {
 
 void UIState::updateStatus() {
   if (scene.started && sm->updated("selfdriveState")) {
+    scene.dirty |= UI_DIRTY_SELFDRIVE;
     auto ss = (*sm)["selfdriveState"].getSelfdriveState();
     auto state = ss.getState();
     if (state == cereal::SelfdriveState::OpenpilotState::PRE_ENABLED || state == cereal::SelfdriveState::OpenpilotState::OVERRIDING) {
@@ -304,6 +323,7 @@ void UIState::updateStatus() {
 
   // Handle onroad/offroad transition
   if (scene.started != started_prev || sm->frame == 1) {
+    scene.dirty |= UI_DIRTY_STARTED;
     if (scene.started) {
       status = STATUS_DISENGAGED;
       scene.started_frame = sm->frame;
@@ -418,11 +438,23 @@ UIState::UIState(QObject *parent) : QObject(parent) {
 
   // update timer
   timer = new QTimer(this);
-  QObject::connect(timer, &QTimer::timeout, this, &UIState::update);
+  QObject::connect(timer, &QTimer::timeout, [=]() {
+    timer->setInterval(1000 / UI_FREQ);
+    update();
+  });
   timer->start(1000 / UI_FREQ);
 }
 
+void UIState::frameReceived() {
+  if (!scene.started) return;
+
+  // the road camera runs at UI_FREQ, the timer only takes over when frames stop
+  timer->start(1500 / UI_FREQ);
+  update();
+}
+
 void UIState::update() {
+  scene.dirty = 0;
   update_sockets(this);
   update_state(this);
   updateStatus();
@@ -52,7 +52,27 @@ const QColor bg_colors [] = {
   [STATUS_DND] = QColor(0x32, 0x32, 0x32, 0x96),
 };
 
+// what changed in the last UIState::update, so the slots of uiUpdate can skip unchanged widgets
+enum UIDirty : uint32_t {
+  UI_DIRTY_CONTROLS = 1 << 0,
+  UI_DIRTY_CAR_STATE = 1 << 1,
+  UI_DIRTY_LIVE_PARAMS = 1 << 2,
+  UI_DIRTY_CALIBRATION = 1 << 3,
+  UI_DIRTY_DEVICE = 1 << 4,
+  UI_DIRTY_PERIPHERAL = 1 << 5,
+  UI_DIRTY_PANDA = 1 << 6,
+  UI_DIRTY_GPS = 1 << 7,
+  UI_DIRTY_CAR_PARAMS = 1 << 8,
+  UI_DIRTY_LIGHT_SENSOR = 1 << 9,
+  UI_DIRTY_PLAN = 1 << 10,
+  UI_DIRTY_NAVI = 1 << 11,
+  UI_DIRTY_SELFDRIVE = 1 << 12,
+  UI_DIRTY_STARTED = 1 << 13,
+};
+
 typedef struct UIScene {
+  uint32_t dirty = 0;
+
   Eigen::Matrix3f view_from_calib = VIEW_FROM_DEVICE;
   Eigen::Matrix3f view_from_wide_calib = VIEW_FROM_DEVICE;
   cereal::PandaState::PandaType pandaType;
@@ -317,6 +337,10 @@ signals:
   void offroadTransition(bool offroad);
   void hotspotSignal();
 
+public slots:
+  // onroad, road camera frames drive the updates instead of the timer
+  void frameReceived();
+
 private slots:
   void update();
 
@@ -25,8 +25,10 @@ int main(int argc, char *argv[]) {
   {
     QHBoxLayout *hlayout = new QHBoxLayout();
     layout->addLayout(hlayout);
-    hlayout->addWidget(new CameraWidget("camerad", VISION_STREAM_DRIVER));
-    hlayout->addWidget(new CameraWidget("camerad", VISION_STREAM_WIDE_ROAD));
+    // each gets half the width, so take camerad's half resolution streams when it has them
+    const bool half = VisionIpcClient::getAvailableStreams("camerad").count(VISION_STREAM_DRIVER_HALF);
+    hlayout->addWidget(new CameraWidget("camerad", half ? VISION_STREAM_DRIVER_HALF : VISION_STREAM_DRIVER));
+    hlayout->addWidget(new CameraWidget("camerad", half ? VISION_STREAM_WIDE_ROAD_HALF : VISION_STREAM_WIDE_ROAD));
   }
 
   return a.exec();
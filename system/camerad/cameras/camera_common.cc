@@ -4,58 +4,53 @@
 #include <string>
 
 #include <jpeglib.h>
+#include "third_party/libyuv/include/libyuv.h"
 
 #include "common/clutil.h"
 #include "common/swaglog.h"
 
+#include "system/camerad/cameras/process_raw_cpu.h"
 #include "system/camerad/cameras/spectra.h"
 
 
-class ImgProc {
-public:
-  ImgProc(cl_device_id device_id, cl_context context, const CameraBuf *b, const SensorInfo *sensor, int camera_num, int buf_width, int uv_offset) {
-    char args[4096];
-    snprintf(args, sizeof(args),
-             "-cl-fast-relaxed-math -cl-denorms-are-zero -Isensors "
-             "-DFRAME_WIDTH=%d -DFRAME_HEIGHT=%d -DFRAME_STRIDE=%d -DFRAME_OFFSET=%d "
-             "-DRGB_WIDTH=%d -DRGB_HEIGHT=%d -DYUV_STRIDE=%d -DUV_OFFSET=%d "
-             "-DSENSOR_ID=%hu -DHDR_OFFSET=%d -DVIGNETTING=%d ",
-             sensor->frame_width, sensor->frame_height, sensor->hdr_offset > 0 ? sensor->frame_stride * 2 : sensor->frame_stride, sensor->frame_offset,
-             b->out_img_width, b->out_img_height, buf_width, uv_offset,
-             static_cast<unsigned short>(sensor->image_sensor), sensor->hdr_offset, camera_num == 1);
-    const char *cl_file = "cameras/process_raw.cl";
-    cl_program prg_imgproc = cl_program_from_file(context, device_id, cl_file, args);
-    krnl_ = CL_CHECK_ERR(clCreateKernel(prg_imgproc, "process_raw", &err));
-    CL_CHECK(clReleaseProgram(prg_imgproc));
-
-    const cl_queue_properties props[] = {0};  //CL_QUEUE_PRIORITY_KHR, CL_QUEUE_PRIORITY_HIGH_KHR, 0};
-    queue = CL_CHECK_ERR(clCreateCommandQueueWithProperties(context, device_id, props, &err));
-  }
-
-  void runKernel(cl_mem cam_buf_cl, cl_mem buf_cl, int width, int height, int expo_time) {
-    CL_CHECK(clSetKernelArg(krnl_, 0, sizeof(cl_mem), &cam_buf_cl));
-    CL_CHECK(clSetKernelArg(krnl_, 1, sizeof(cl_mem), &buf_cl));
-    CL_CHECK(clSetKernelArg(krnl_, 2, sizeof(cl_int), &expo_time));
+ImgProc::ImgProc(cl_device_id device_id, cl_context context, const SensorInfo *sensor, int out_width, int out_height, bool vignetting, int buf_width, int uv_offset) {
+  char args[4096];
+  snprintf(args, sizeof(args),
+           "-cl-fast-relaxed-math -cl-denorms-are-zero -Isensors "
+           "-DFRAME_WIDTH=%d -DFRAME_HEIGHT=%d -DFRAME_STRIDE=%d -DFRAME_OFFSET=%d "
+           "-DRGB_WIDTH=%d -DRGB_HEIGHT=%d -DYUV_STRIDE=%d -DUV_OFFSET=%d "
+           "-DSENSOR_ID=%hu -DHDR_OFFSET=%d -DVIGNETTING=%d ",
+           sensor->frame_width, sensor->frame_height, sensor->hdr_offset > 0 ? sensor->frame_stride * 2 : sensor->frame_stride, sensor->frame_offset,
+           out_width, out_height, buf_width, uv_offset,
+           static_cast<unsigned short>(sensor->image_sensor), sensor->hdr_offset, vignetting);
+  const char *cl_file = "cameras/process_raw.cl";
+  cl_program prg_imgproc = cl_program_from_file(context, device_id, cl_file, args);
+  krnl_ = CL_CHECK_ERR(clCreateKernel(prg_imgproc, "process_raw", &err));
+  CL_CHECK(clReleaseProgram(prg_imgproc));
+
+  const cl_queue_properties props[] = {0};  //CL_QUEUE_PRIORITY_KHR, CL_QUEUE_PRIORITY_HIGH_KHR, 0};
+  queue = CL_CHECK_ERR(clCreateCommandQueueWithProperties(context, device_id, props, &err));
+}
 
-    const size_t globalWorkSize[] = {size_t(width / 2), size_t(height / 2)};
-    const int imgproc_local_worksize = 16;
-    const size_t localWorkSize[] = {imgproc_local_worksize, imgproc_local_worksize};
+void ImgProc::runKernel(cl_mem cam_buf_cl, cl_mem buf_cl, int width, int height, int expo_time) {
+  CL_CHECK(clSetKernelArg(krnl_, 0, sizeof(cl_mem), &cam_buf_cl));
+  CL_CHECK(clSetKernelArg(krnl_, 1, sizeof(cl_mem), &buf_cl));
+  CL_CHECK(clSetKernelArg(krnl_, 2, sizeof(cl_int), &expo_time));
 
-    cl_event event;
-    CL_CHECK(clEnqueueNDRangeKernel(queue, krnl_, 2, NULL, globalWorkSize, localWorkSize, 0, 0, &event));
-    clWaitForEvents(1, &event);
-    CL_CHECK(clReleaseEvent(event));
-  }
+  const size_t globalWorkSize[] = {size_t(width / 2), size_t(height / 2)};
+  const int imgproc_local_worksize = 16;
+  const size_t localWorkSize[] = {imgproc_local_worksize, imgproc_local_worksize};
 
-  ~ImgProc() {
-    CL_CHECK(clReleaseKernel(krnl_));
-    CL_CHECK(clReleaseCommandQueue(queue));
-  }
+  cl_event event;
+  CL_CHECK(clEnqueueNDRangeKernel(queue, krnl_, 2, NULL, globalWorkSize, localWorkSize, 0, 0, &event));
+  clWaitForEvents(1, &event);
+  CL_CHECK(clReleaseEvent(event));
+}
 
-private:
-  cl_kernel krnl_;
-  cl_command_queue queue;
-};
+ImgProc::~ImgProc() {
+  CL_CHECK(clReleaseKernel(krnl_));
+  CL_CHECK(clReleaseCommandQueue(queue));
+}
 
 void CameraBuf::init(cl_device_id device_id, cl_context context, SpectraCamera *cam, VisionIpcServer * v, int frame_cnt, VisionStreamType type) {
   vipc_server = v;
@@ -85,8 +80,14 @@ void CameraBuf::init(cl_device_id device_id, cl_context context, SpectraCamera *
 
   vipc_server->create_buffers_with_sizes(stream_type, YUV_BUFFER_COUNT, out_img_width, out_img_height, nv12_size, cam->stride, cam->uv_offset);
   LOGD("created %d YUV vipc buffers with size %dx%d", YUV_BUFFER_COUNT, cam->stride, cam->y_height);
+  // half and quarter resolution streams, allocated when first asked for and computed off the camera thread
+  vipc_server->create_pyramid(stream_type, 2, PYRAMID_BUFFER_COUNT);
 
-  imgproc = new ImgProc(device_id, context, this, sensor, cam->cc.camera_num, cam->stride, cam->uv_offset);
+  if (getenv("CPU_IMGPROC")) {
+    cpu_imgproc = new RawProcessor(sensor, cam->cc.camera_num == 1, cam->stride, cam->uv_offset);
+  } else {
+    imgproc = new ImgProc(device_id, context, sensor, out_img_width, out_img_height, cam->cc.camera_num == 1, cam->stride, cam->uv_offset);
+  }
 }
 
 CameraBuf::~CameraBuf() {
@@ -94,6 +95,7 @@ CameraBuf::~CameraBuf() {
     camera_bufs_raw[i].free();
   }
   if (imgproc) delete imgproc;
+  if (cpu_imgproc) delete cpu_imgproc;
 }
 
 bool CameraBuf::acquire(int expo_time) {
@@ -110,7 +112,13 @@ bool CameraBuf::acquire(int expo_time) {
     cur_yuv_buf = vipc_server->get_buffer(stream_type);
 
     double start_time = millis_since_boot();
-    imgproc->runKernel(camera_bufs_raw[cur_buf_idx].buf_cl, cur_yuv_buf->buf_cl, out_img_width, out_img_height, expo_time);
+    if (cpu_imgproc) {
+      cur_camera_buf->sync(VISIONBUF_SYNC_FROM_DEVICE);
+      cpu_imgproc->process((const uint8_t *)cur_camera_buf->addr, (uint8_t *)cur_yuv_buf->addr, expo_time);
+      cur_yuv_buf->sync(VISIONBUF_SYNC_TO_DEVICE);
+    } else {
+      imgproc->runKernel(camera_bufs_raw[cur_buf_idx].buf_cl, cur_yuv_buf->buf_cl, out_img_width, out_img_height, expo_time);
+    }
     cur_frame_data.processing_time = (millis_since_boot() - start_time) / 1000.0;
   } else {
     cur_yuv_buf = vipc_server->get_buffer(stream_type, cur_buf_idx);
@@ -144,10 +152,8 @@ kj::Array<uint8_t> get_raw_frame_image(const CameraBuf *b) {
   return kj::mv(frame_image);
 }
 
-static kj::Array<capnp::byte> yuv420_to_jpeg(const CameraBuf *b, int thumbnail_width, int thumbnail_height) {
-  int downscale = b->cur_yuv_buf->width / thumbnail_width;
-  assert(downscale * thumbnail_height == b->cur_yuv_buf->height);
-  int in_stride = b->cur_yuv_buf->stride;
+static kj::Array<capnp::byte> yuv420_to_jpeg(const VisionBuf *yuv, int thumbnail_width, int thumbnail_height) {
+  const int in_stride = yuv->stride;
 
   // make the buffer big enough. jpeg_write_raw_data requires 16-pixels aligned height to be used.
   std::unique_ptr<uint8_t[]> buf(new uint8_t[(thumbnail_width * ((thumbnail_height + 15) & ~15) * 3) / 2]);
@@ -155,19 +161,19 @@ static kj::Array<capnp::byte> yuv420_to_jpeg(const CameraBuf *b, int thumbnail_w
   uint8_t *u_plane = y_plane + thumbnail_width * thumbnail_height;
   uint8_t *v_plane = u_plane + (thumbnail_width * thumbnail_height) / 4;
   {
-    // subsampled conversion from nv12 to yuv
-    for (int hy = 0; hy < thumbnail_height/2; hy++) {
-      for (int hx = 0; hx < thumbnail_width/2; hx++) {
-        int ix = hx * downscale + (downscale-1)/2;
-        int iy = hy * downscale + (downscale-1)/2;
-        y_plane[(hy*2 + 0)*thumbnail_width + (hx*2 + 0)] = b->cur_yuv_buf->y[(iy*2 + 0) * in_stride + ix*2 + 0];
-        y_plane[(hy*2 + 0)*thumbnail_width + (hx*2 + 1)] = b->cur_yuv_buf->y[(iy*2 + 0) * in_stride + ix*2 + 1];
-        y_plane[(hy*2 + 1)*thumbnail_width + (hx*2 + 0)] = b->cur_yuv_buf->y[(iy*2 + 1) * in_stride + ix*2 + 0];
-        y_plane[(hy*2 + 1)*thumbnail_width + (hx*2 + 1)] = b->cur_yuv_buf->y[(iy*2 + 1) * in_stride + ix*2 + 1];
-        u_plane[hy*thumbnail_width/2 + hx] = b->cur_yuv_buf->uv[iy*in_stride + ix*2 + 0];
-        v_plane[hy*thumbnail_width/2 + hx] = b->cur_yuv_buf->uv[iy*in_stride + ix*2 + 1];
-      }
-    }
+    // box filtered downscale from nv12 to yuv. libyuv has no scaler for interleaved planes,
+    // so split the chroma at full resolution first.
+    const int uv_width = yuv->width / 2, uv_height = yuv->height / 2;
+    std::unique_ptr<uint8_t[]> uv(new uint8_t[uv_width * uv_height * 2]);
+    uint8_t *u_full = uv.get(), *v_full = u_full + uv_width * uv_height;
+    libyuv::SplitUVPlane(yuv->uv, in_stride, u_full, uv_width, v_full, uv_width, uv_width, uv_height);
+
+    libyuv::ScalePlane(yuv->y, in_stride, yuv->width, yuv->height,
+                       y_plane, thumbnail_width, thumbnail_width, thumbnail_height, libyuv::kFilterBox);
+    libyuv::ScalePlane(u_full, uv_width, uv_width, uv_height,
+                       u_plane, thumbnail_width / 2, thumbnail_width / 2, thumbnail_height / 2, libyuv::kFilterBox);
+    libyuv::ScalePlane(v_full, uv_width, uv_width, uv_height,
+                       v_plane, thumbnail_width / 2, thumbnail_width / 2, thumbnail_height / 2, libyuv::kFilterBox);
   }
 
   struct jpeg_compress_struct cinfo;
@@ -220,37 +226,49 @@ static kj::Array<capnp::byte> yuv420_to_jpeg(const CameraBuf *b, int thumbnail_w
   return dat;
 }
 
-void publish_thumbnail(PubMaster *pm, const CameraBuf *b) {
-  auto thumbnail = yuv420_to_jpeg(b, b->out_img_width / 4, b->out_img_height / 4);
+static void send_thumbnail(PubMaster *pm, const VisionBuf *yuv, const FrameMetadata &meta, int width, int height) {
+  auto thumbnail = yuv420_to_jpeg(yuv, width / 4, height / 4);
   if (thumbnail.size() == 0) return;
 
   MessageBuilder msg;
   auto thumbnaild = msg.initEvent().initThumbnail();
-  thumbnaild.setFrameId(b->cur_frame_data.frame_id);
-  thumbnaild.setTimestampEof(b->cur_frame_data.timestamp_eof);
+  thumbnaild.setFrameId(meta.frame_id);
+  thumbnaild.setTimestampEof(meta.timestamp_eof);
   thumbnaild.setThumbnail(thumbnail);
 
   pm->send("thumbnail", msg);
 }
 
-float set_exposure_target(const CameraBuf *b, Rect ae_xywh, int x_skip, int y_skip) {
+void publish_thumbnail(PubMaster *pm, const CameraBuf *b) {
+  send_thumbnail(pm, b->cur_yuv_buf, b->cur_frame_data, b->out_img_width, b->out_img_height);
+}
+
+float calculate_exposure_target(const uint8_t *y, int stride, Rect ae_xywh, int x_skip, int y_skip) {
   int lum_med;
-  uint32_t lum_binning[256] = {0};
-  const uint8_t *pix_ptr = b->cur_yuv_buf->y;
+  // four interleaved sub-histograms, so runs of equal pixels don't serialize on one counter
+  uint32_t lum_binning[4][256] = {};
 
+  const int row_samples = (ae_xywh.w + x_skip - 1) / x_skip;
   unsigned int lum_total = 0;
-  for (int y = ae_xywh.y; y < ae_xywh.y + ae_xywh.h; y += y_skip) {
-    for (int x = ae_xywh.x; x < ae_xywh.x + ae_xywh.w; x += x_skip) {
-      uint8_t lum = pix_ptr[(y * b->out_img_width) + x];
-      lum_binning[lum]++;
-      lum_total += 1;
+  for (int row = ae_xywh.y; row < ae_xywh.y + ae_xywh.h; row += y_skip) {
+    const uint8_t *pix = y + row * stride + ae_xywh.x;
+    int i = 0;
+    for (; i + 4 <= row_samples; i += 4, pix += 4 * x_skip) {
+      lum_binning[0][pix[0]]++;
+      lum_binning[1][pix[x_skip]]++;
+      lum_binning[2][pix[2 * x_skip]]++;
+      lum_binning[3][pix[3 * x_skip]]++;
+    }
+    for (; i < row_samples; i++, pix += x_skip) {
+      lum_binning[0][pix[0]]++;
     }
+    lum_total += row_samples;
   }
 
   // Find mean lumimance value
   unsigned int lum_cur = 0;
   for (lum_med = 255; lum_med >= 0; lum_med--) {
-    lum_cur += lum_binning[lum_med];
+    lum_cur += lum_binning[0][lum_med] + lum_binning[1][lum_med] + lum_binning[2][lum_med] + lum_binning[3][lum_med];
 
     if (lum_cur >= lum_total / 2) {
       break;
@@ -260,6 +278,65 @@ float set_exposure_target(const CameraBuf *b, Rect ae_xywh, int x_skip, int y_sk
   return lum_med / 256.0;
 }
 
+float set_exposure_target(const CameraBuf *b, Rect ae_xywh, int x_skip, int y_skip) {
+  return calculate_exposure_target(b->cur_yuv_buf->y, b->out_img_width, ae_xywh, x_skip, y_skip);
+}
+
+// FrameStatsThread
+
+FrameStatsThread::FrameStatsThread(const char *thumbnail_service) {
+  if (thumbnail_service) {
+    pm = std::make_unique<PubMaster>(std::vector<const char *>{thumbnail_service});
+  }
+  thread = std::thread(&FrameStatsThread::run, this);
+}
+
+FrameStatsThread::~FrameStatsThread() {
+  {
+    std::lock_guard lk(lock);
+    exit = true;
+  }
+  cv.notify_one();
+  thread.join();
+}
+
+float FrameStatsThread::update(const CameraBuf *b, Rect ae_xywh, int x_skip, int y_skip, bool thumbnail) {
+  {
+    std::lock_guard lk(lock);
+    // a pending thumbnail carries over to the frame replacing it
+    thumbnail = thumbnail || (job && job->thumbnail);
+    job = Job{b->cur_yuv_buf, b->cur_frame_data, b->out_img_width, b->out_img_height, ae_xywh, x_skip, y_skip, thumbnail};
+  }
+  cv.notify_one();
+  return grey_frac.exchange(-1);
+}
+
+double FrameStatsThread::takeCpuTime() {
+  return cpu_nanos.exchange(0) / 1e9;
+}
+
+void FrameStatsThread::run() {
+  util::set_thread_name("camerad_stats");
+  while (true) {
+    Job j;
+    {
+      std::unique_lock lk(lock);
+      cv.wait(lk, [&] { return exit || job; });
+      if (exit) break;
+      j = *job;
+      job.reset();
+    }
+
+    // the buffer stays valid until camerad cycles through all YUV_BUFFER_COUNT buffers
+    const uint64_t cpu_start = nanos_thread_cpu();
+    grey_frac = calculate_exposure_target(j.buf->y, j.width, j.ae_xywh, j.x_skip, j.y_skip);
+    if (j.thumbnail && pm) {
+      send_thumbnail(pm.get(), j.buf, j.meta, j.width, j.height);
+    }
+    cpu_nanos += nanos_thread_cpu() - cpu_start;
+  }
+}
+
 int open_v4l_by_name_and_index(const char name[], int index, int flags) {
   for (int v4l_index = 0; /**/; ++v4l_index) {
     std::string v4l_name = util::read_file(util::string_format("/sys/class/video4linux/v4l-subdev%d/name", v4l_index));
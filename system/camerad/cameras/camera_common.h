@@ -1,6 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
 
 #include "cereal/messaging/messaging.h"
 #include "msgq/visionipc/visionipc_server.h"
@@ -9,6 +14,9 @@
 
 
 const int YUV_BUFFER_COUNT = 20;
+// pyramid levels are for viewers, which only want the newest frame, and for encoderd's qcam on PC,
+// which holds the few frames it has queued
+const int PYRAMID_BUFFER_COUNT = 8;
 
 typedef struct FrameMetadata {
   uint32_t frame_id;
@@ -20,11 +28,25 @@ typedef struct FrameMetadata {
 
 class SpectraCamera;
 class CameraState;
-class ImgProc;
+class SensorInfo;
+class RawProcessor;
+
+// Runs process_raw.cl on a raw frame, writing NV12
+class ImgProc {
+public:
+  ImgProc(cl_device_id device_id, cl_context context, const SensorInfo *sensor, int out_width, int out_height, bool vignetting, int buf_width, int uv_offset);
+  ~ImgProc();
+  void runKernel(cl_mem cam_buf_cl, cl_mem buf_cl, int width, int height, int expo_time);
+
+private:
+  cl_kernel krnl_;
+  cl_command_queue queue;
+};
 
 class CameraBuf {
 private:
   ImgProc *imgproc = nullptr;
+  RawProcessor *cpu_imgproc = nullptr;  // CPU_IMGPROC=1 runs process_raw on the CPU
   int cur_buf_idx;
   SafeQueue<int> safe_queue;
   int frame_buf_count;
@@ -48,8 +70,41 @@ public:
   void queue(size_t buf_idx);
 };
 
+// Computes the AE statistics and thumbnails of a camera on its own thread, reading the yuv buffer
+// after it was sent over VisionIPC. The exposure target lags the camera thread by one frame.
+class FrameStatsThread {
+public:
+  FrameStatsThread(const char *thumbnail_service);  // nullptr: no thumbnails
+  ~FrameStatsThread();
+  // Queues the current frame, replacing one the worker hasn't started yet. Returns the grey
+  // fraction of a frame finished since the last call, or -1.
+  float update(const CameraBuf *b, Rect ae_xywh, int x_skip, int y_skip, bool thumbnail);
+  double takeCpuTime();  // worker CPU seconds since the last call
+
+private:
+  struct Job {
+    const VisionBuf *buf;
+    FrameMetadata meta;
+    int width, height;
+    Rect ae_xywh;
+    int x_skip, y_skip;
+    bool thumbnail;
+  };
+  void run();
+
+  std::unique_ptr<PubMaster> pm;
+  std::mutex lock;
+  std::condition_variable cv;
+  std::optional<Job> job;
+  bool exit = false;
+  std::atomic<float> grey_frac = -1;
+  std::atomic<uint64_t> cpu_nanos = 0;
+  std::thread thread;
+};
+
 void camerad_thread();
 kj::Array<uint8_t> get_raw_frame_image(const CameraBuf *b);
+float calculate_exposure_target(const uint8_t *y, int stride, Rect ae_xywh, int x_skip, int y_skip);
 float set_exposure_target(const CameraBuf *b, Rect ae_xywh, int x_skip, int y_skip);
 void publish_thumbnail(PubMaster *pm, const CameraBuf *b);
 int open_v4l_by_name_and_index(const char name[], int index = 0, int flags = O_RDWR | O_NONBLOCK);
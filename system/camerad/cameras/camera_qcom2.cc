@@ -27,6 +27,7 @@ ExitHandler do_exit;
 const bool env_debug_frames = getenv("DEBUG_FRAMES") != nullptr;
 const bool env_log_raw_frames = getenv("LOG_RAW_FRAMES") != nullptr;
 const bool env_ctrl_exp_from_params = getenv("CTRL_EXP_FROM_PARAMS") != nullptr;
+const bool env_stats_thread = getenv("CAMERAD_STATS_THREAD") != nullptr;
 
 
 class CameraState {
@@ -224,10 +225,15 @@ void CameraState::set_camera_exposure(float grey_frac) {
 void CameraState::run() {
   util::set_thread_name(camera.cc.publish_name);
 
+  const bool is_road = camera.cc.stream_type == VISION_STREAM_ROAD;
+  std::unique_ptr<FrameStatsThread> stats;
+  if (env_stats_thread) stats = std::make_unique<FrameStatsThread>(is_road ? "thumbnail" : nullptr);
+
   std::vector<const char*> pubs = {camera.cc.publish_name};
-  if (camera.cc.stream_type == VISION_STREAM_ROAD) pubs.push_back("thumbnail");
+  if (is_road && !stats) pubs.push_back("thumbnail");
   PubMaster pm(pubs);
 
+  uint64_t cpu_start = nanos_thread_cpu();
   for (uint32_t cnt = 0; !do_exit; ++cnt) {
     // Acquire the buffer; continue if acquisition fails
     if (!camera.buf.acquire(exposure_time)) continue;
@@ -245,6 +251,9 @@ void CameraState::run() {
     framed.setMeasuredGreyFraction(measured_grey_fraction);
     framed.setTargetGreyFraction(target_grey_fraction);
     framed.setProcessingTime(meta.processing_time);
+    const VisionIpcServerStats vipc_stats = camera.buf.vipc_server->get_stats(camera.cc.stream_type);
+    framed.setVipcLeasedSkips(vipc_stats.leased_skips);
+    framed.setVipcForcedOverwrites(vipc_stats.forced_overwrites);
 
     const float ev = cur_ev[meta.frame_id % 3];
     const float perc = util::map_val(ev, camera.sensor->min_ev, camera.sensor->max_ev, 0.0f, 100.0f);
@@ -258,12 +267,24 @@ void CameraState::run() {
 
     // Process camera registers and set camera exposure
     camera.sensor->processRegisters((uint8_t *)camera.buf.cur_camera_buf->addr, framed);
-    set_camera_exposure(set_exposure_target(&camera.buf, ae_xywh, 2, camera.cc.stream_type != VISION_STREAM_DRIVER ? 2 : 4));
+    const int y_skip = camera.cc.stream_type != VISION_STREAM_DRIVER ? 2 : 4;
+    const bool thumbnail = is_road && cnt % 100 == 3;
+    if (stats) {
+      float grey_frac = stats->update(&camera.buf, ae_xywh, 2, y_skip, thumbnail);
+      if (grey_frac >= 0) set_camera_exposure(grey_frac);
+    } else {
+      set_camera_exposure(set_exposure_target(&camera.buf, ae_xywh, 2, y_skip));
+    }
+
+    // everything since the last frame was sent, including the previous thumbnail
+    const uint64_t cpu_now = nanos_thread_cpu();
+    framed.setCpuTime((cpu_now - cpu_start) / 1e9 + (stats ? stats->takeCpuTime() : 0));
+    cpu_start = cpu_now;
 
     // Send the message
     pm.send(camera.cc.publish_name, msg);
-    if (camera.cc.stream_type == VISION_STREAM_ROAD && cnt % 100 == 3) {
-      publish_thumbnail(&pm, &camera.buf);  // this takes 10ms???
+    if (thumbnail && !stats) {
+      publish_thumbnail(&pm, &camera.buf);
     }
   }
 }
@@ -0,0 +1,429 @@
+#include "system/camerad/cameras/process_raw_cpu.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+using cereal::FrameData;
+
+namespace {
+
+// Gamma is looked up by the top bits of the float representation: 1024 steps per octave between
+// 2^-20 and 4. The log curves are steep near black, a linear table would need far more entries.
+constexpr int GAMMA_MANTISSA_BITS = 10;
+constexpr int GAMMA_MIN_EXP = -20;
+constexpr int GAMMA_MAX_EXP = 2;
+constexpr int GAMMA_LUT_SIZE = (GAMMA_MAX_EXP - GAMMA_MIN_EXP) << GAMMA_MANTISSA_BITS;
+constexpr int GAMMA_LUT_BASE = (127 + GAMMA_MIN_EXP) << GAMMA_MANTISSA_BITS;
+
+inline int32_t gamma_index(float x) {
+  x = x > 0.0f ? x : 0.0f;  // also maps NaN to black, like convert_uchar_sat
+  uint32_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  const int32_t idx = (int32_t)(bits >> (23 - GAMMA_MANTISSA_BITS)) - GAMMA_LUT_BASE;
+  return idx < 0 ? 0 : idx > GAMMA_LUT_SIZE - 1 ? GAMMA_LUT_SIZE - 1 : idx;
+}
+
+// selects on values rather than std::clamp's references, so the block loop vectorizes
+inline float clamp01(float x) {
+  x = x < 0.0f ? 0.0f : x;
+  return x > 1.0f ? 1.0f : x;
+}
+
+// clamp, color correct and find the gamma table index of one pixel
+inline void color_correct(const float cm[3][3], const float rgb[3], int32_t *gamma_idx) {
+  const float r = clamp01(rgb[0]);
+  const float g = clamp01(rgb[1]);
+  const float b = clamp01(rgb[2]);
+  gamma_idx[0] = gamma_index(r * cm[0][0] + g * cm[1][0] + b * cm[2][0]);
+  gamma_idx[1] = gamma_index(r * cm[0][1] + g * cm[1][1] + b * cm[2][1]);
+  gamma_idx[2] = gamma_index(r * cm[0][2] + g * cm[1][2] + b * cm[2][2]);
+}
+
+inline float get_k(float a, float b, float c, float d) {
+  return 2.0f - (std::fabs(a - b) + std::fabs(c - d));
+}
+
+// One set of threads for all cameras, each would otherwise start one per core. The caller works
+// on its own job too, so a frame is never stuck behind another camera's.
+class WorkerPool {
+public:
+  static WorkerPool &instance() {
+    static WorkerPool pool;
+    return pool;
+  }
+
+  int size() const { return workers.size() + 1; }
+
+  // calls f(0) .. f(n - 1) and returns when all are done
+  void run(int n, const std::function<void(int)> &f) {
+    Job job = {&f, n};
+    std::unique_lock lk(lock);
+    for (int i = 1; i < n; i++) tasks.push_back({&job, i});
+    work_cv.notify_all();
+    lk.unlock();
+
+    f(0);
+    lk.lock();
+    --job.remaining;
+    // take the parts no worker has started yet
+    for (auto it = tasks.begin(); it != tasks.end();) {
+      if (it->first != &job) {
+        ++it;
+        continue;
+      }
+      const int i = it->second;
+      tasks.erase(it);
+      lk.unlock();
+      f(i);
+      lk.lock();
+      --job.remaining;
+      it = tasks.begin();
+    }
+    done_cv.wait(lk, [&] { return job.remaining == 0; });
+  }
+
+private:
+  struct Job {
+    const std::function<void(int)> *f;
+    int remaining;
+  };
+
+  WorkerPool() {
+    const int n = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < n; i++) {
+      workers.emplace_back(&WorkerPool::workerThread, this);
+    }
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard lk(lock);
+      exit = true;
+    }
+    work_cv.notify_all();
+    for (auto &t : workers) t.join();
+  }
+
+  void workerThread() {
+    std::unique_lock lk(lock);
+    while (true) {
+      work_cv.wait(lk, [&] { return exit || !tasks.empty(); });
+      if (exit) break;
+      auto [job, i] = tasks.front();
+      tasks.pop_front();
+
+      lk.unlock();
+      (*job->f)(i);
+      lk.lock();
+      if (--job->remaining == 0) done_cv.notify_all();
+    }
+  }
+
+  std::vector<std::thread> workers;
+  std::mutex lock;
+  std::condition_variable work_cv, done_cv;
+  std::deque<std::pair<Job *, int>> tasks;
+  bool exit = false;
+};
+
+inline uint8_t rgb_to_y(int r, int g, int b) { return ((b * 13 + g * 65 + r * 33 + 64) >> 7) + 16; }
+inline uint8_t rgb_to_u(int r, int g, int b) { return (b * 56 - g * 37 - r * 19 + 0x8080) >> 8; }
+inline uint8_t rgb_to_v(int r, int g, int b) { return (r * 56 - g * 47 - b * 9 + 0x8080) >> 8; }
+
+float get_vignetting_s(float r) {
+  if (r < 62500) {
+    return (1.0f + 0.0000008f*r);
+  } else if (r < 490000) {
+    return (0.9625f + 0.0000014f*r);
+  } else if (r < 1102500) {
+    return (1.26434f + 0.0000000000016f*r*r);
+  } else {
+    return (0.53503625f + 0.0000000000022f*r*r);
+  }
+}
+
+// sensor specific parts, see sensors/*_cl.h
+
+float ox03c10_lut_func(int x) {
+  if (x < 512) {
+    return x * 5.94873e-8f;
+  } else if (x < 768) {
+    return 3.0458e-05f + (x-512) * 1.19913e-7f;
+  } else if (x < 1536) {
+    return 6.1154e-05f + (x-768) * 2.38493e-7f;
+  } else if (x < 1792) {
+    return 0.0002448f + (x-1536) * 9.56930e-7f;
+  } else if (x < 2048) {
+    return 0.00048977f + (x-1792) * 1.91441e-6f;
+  } else if (x < 2304) {
+    return 0.00097984f + (x-2048) * 3.82937e-6f;
+  } else if (x < 2560) {
+    return 0.0019601f + (x-2304) * 7.659055e-6f;
+  } else if (x < 2816) {
+    return 0.0039207f + (x-2560) * 1.525e-5f;
+  } else {
+    return 0.0078421f + (std::exp((x-2816)/273.0f) - 1) * 0.0092421f;
+  }
+}
+
+float apply_gamma(FrameData::ImageSensor sensor, float rgb, int expo_time) {
+  if (sensor == FrameData::ImageSensor::AR0231) {
+    const float gamma_k = 0.75f;
+    const float gamma_b = 0.125f;
+    const float mp = 0.01f;
+    const float rk = 9 - 100*mp;
+    return (rgb > mp) ?
+      ((rk * (rgb-mp) * (1-(gamma_k*mp+gamma_b)) * (1+1/(rk*(1-mp))) / (1+rk*(rgb-mp))) + gamma_k*mp + gamma_b) :
+      ((rk * (rgb-mp) * (gamma_k*mp+gamma_b) * (1+1/(rk*mp)) / (1-rk*(rgb-mp))) + gamma_k*mp + gamma_b);
+  } else if (sensor == FrameData::ImageSensor::OX03C10) {
+    return -0.507089f*std::exp(-12.54124638f*rgb) + 0.9655f*std::sqrt(rgb) - 0.472597f*rgb + 0.507089f;
+  } else {
+    float s = std::log2((float)expo_time);
+    if (s < 6) {s = std::fmin(12.0f - s, 9.0f);}
+    return std::clamp(std::log(1 + rgb*65472.0f) * (0.48f*s*s - 12.92f*s + 115.0f) - (1.08f*s*s - 29.2f*s + 260.0f), 0.0f, 255.0f) / 255.0f;
+  }
+}
+
+}  // namespace
+
+RawProcessor::RawProcessor(const SensorInfo *sensor, bool vignetting, int yuv_stride, int uv_offset, int num_bands)
+    : width(sensor->frame_width),
+      height(sensor->hdr_offset > 0 ? (sensor->frame_height - sensor->hdr_offset) / 2 : sensor->frame_height),
+      sensor_id(sensor->image_sensor),
+      bit_depth(sensor->image_sensor == FrameData::ImageSensor::OS04C10 ? 10 : 12),
+      frame_stride(sensor->hdr_offset > 0 ? sensor->frame_stride * 2 : sensor->frame_stride),
+      frame_offset(sensor->frame_offset),
+      hdr_offset(sensor->hdr_offset),
+      yuv_stride(yuv_stride),
+      uv_offset(uv_offset),
+      bggr(sensor->image_sensor == FrameData::ImageSensor::OS04C10),
+      vignetting(vignetting) {
+  // the 10 bit sensor is always read as staggered HDR, like the kernel
+  assert((bit_depth == 10) == (hdr_offset > 0));
+
+  const float matrices[3][3][3] = {
+    {{1.82717181, -0.31231438, 0.07307673}, {-0.5743977, 1.36858544, -0.53183455}, {-0.25277411, -0.05627105, 1.45875782}},
+    {{1.5664815, -0.29808738, -0.03973474}, {-0.48672447, 1.41914433, -0.40295248}, {-0.07975703, -0.12105695, 1.44268722}},
+    {{1.55361989, -0.268894615, -0.000593219}, {-0.421217301, 1.51883144, -0.69760146}, {-0.132402589, -0.249936825, 1.69819468}},
+  };
+  const int sensor_idx = sensor_id == FrameData::ImageSensor::AR0231 ? 0 : sensor_id == FrameData::ImageSensor::OX03C10 ? 1 : 2;
+  memcpy(color_matrix, matrices[sensor_idx], sizeof(color_matrix));
+
+  if (sensor_id == FrameData::ImageSensor::AR0231) {
+    pv_lut.resize(1 << 12);
+    for (int i = 0; i < (1 << 12); i++) pv_lut[i] = (i - 168.0f) / (4096 - 168);
+  } else if (sensor_id == FrameData::ImageSensor::OX03C10) {
+    pv_lut.resize(1 << 12);
+    for (int i = 0; i < (1 << 12); i++) pv_lut[i] = ox03c10_lut_func(i) * 256.0f;
+  }
+
+  // without vignetting a single row of ones is used for every row
+  vignette.assign(vignetting ? (width / 2) * (height / 2) : width / 2, 1.0f);
+  if (vignetting) {
+    const float rsz = sensor_id == FrameData::ImageSensor::OS04C10 ? 2.2545f : 1.0f;
+    for (int gy = 0; gy < height / 2; gy++) {
+      for (int gx = 0; gx < width / 2; gx++) {
+        const int dx = gx*2 - width/2;
+        const int dy = gy*2 - height/2;
+        vignette[gy * (width / 2) + gx] = get_vignetting_s((dx*dx + dy*dy) / rsz);
+      }
+    }
+  }
+
+  if (num_bands <= 0) num_bands = WorkerPool::instance().size();
+  const int rows = height / 2;
+  num_bands = std::min(num_bands, rows);
+  bands.resize(num_bands);
+  for (int i = 0; i < num_bands; i++) {
+    Band &b = bands[i];
+    b.row_start = rows * i / num_bands;
+    b.row_end = rows * (i + 1) / num_bands;
+    b.raw.resize(8 * (width + 2));
+    b.pv.resize(4 * (width + 2));
+    b.gamma_idx.resize(12 * (width / 2));
+  }
+}
+
+void RawProcessor::updateTables(int expo_time) {
+  // only the HDR merge and its log gamma depend on the exposure time
+  if (tables_expo_time >= 0 && (hdr_offset <= 0 || expo_time == tables_expo_time)) return;
+  tables_expo_time = expo_time;
+
+  if (hdr_offset > 0) {
+    const int black_lvl = 64;
+    const float pv_range = 65536 - black_lvl;  // gamma curve is calibrated to 16bit
+    hdr_long_lut.resize(1 << 10);
+    hdr_short_lut.resize(1 << 10);
+    hdr_use_long.resize(1 << 10);
+    for (int i = 0; i < (1 << 10); i++) {
+      const float pv = i - black_lvl;
+      if (expo_time > 64) {
+        hdr_use_long[i] = pv < 1023 - black_lvl;
+        hdr_long_lut[i] = pv / pv_range;
+        hdr_short_lut[i] = (std::fmax(pv * expo_time, (float)(64 * (1023 - black_lvl))) / 64) / pv_range;
+      } else {
+        hdr_use_long[i] = pv > 32;
+        hdr_long_lut[i] = (pv * 64 / std::fmax(expo_time, 8.0f)) / pv_range;
+        hdr_short_lut[i] = (pv * std::fmin(expo_time, 8.0f) / 8) / pv_range;
+      }
+    }
+  }
+
+  gamma_lut.resize(GAMMA_LUT_SIZE);
+  for (int i = 0; i < GAMMA_LUT_SIZE; i++) {
+    // middle of the bucket
+    const uint32_t bits = ((uint32_t)(i + GAMMA_LUT_BASE) << (23 - GAMMA_MANTISSA_BITS)) | (1u << (22 - GAMMA_MANTISSA_BITS));
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    const float v = apply_gamma(sensor_id, x, expo_time) * 255.0f;
+    gamma_lut[i] = v > 0.0f ? (uint8_t)std::fmin(v, 255.0f) : 0;
+  }
+}
+
+void RawProcessor::unpackRow(const uint8_t *src, uint16_t *dst) const {
+  if (bit_depth == 12) {
+    for (int i = 0; i < width / 2; i++) {
+      const uint8_t *s = src + i * 3;
+      dst[2*i + 0] = (s[0] << 4) | (s[2] & 0xF);
+      dst[2*i + 1] = (s[1] << 4) | (s[2] >> 4);
+    }
+  } else {
+    // four high bytes followed by the low bits, first pixel in the top two bits
+    for (int i = 0; i < width / 4; i++) {
+      const uint8_t *s = src + i * 5;
+      for (int j = 0; j < 4; j++) {
+        dst[4*i + j] = (s[j] << 2) | ((s[4] >> (6 - 2*j)) & 0x3);
+      }
+    }
+  }
+}
+
+void RawProcessor::processBand(Band &b, const uint8_t *in, uint8_t *out) {
+  const int pw = width + 2;
+  const int blocks = width / 2;
+  const int rows = height / 2;
+  const int read_order[4] = {bggr ? 3 : 0, bggr ? 2 : 1, bggr ? 1 : 2, bggr ? 0 : 3};
+  const int write_order[4] = {bggr ? 2 : 0, bggr ? 3 : 1, bggr ? 0 : 2, bggr ? 1 : 3};
+
+  for (int gy = b.row_start; gy < b.row_end; gy++) {
+    // the row before, the output row pair and the row after, mirrored at the top and bottom
+    const int src_rows[4] = {gy == 0 ? 1 : 2*gy - 1, 2*gy, 2*gy + 1, gy == rows - 1 ? 2*gy : 2*gy + 2};
+    for (int i = 0; i < 4; i++) {
+      uint16_t *raw = &b.raw[i * pw];
+      float *pv = &b.pv[read_order[i] * pw];
+      const uint8_t *src = in + (size_t)(src_rows[i] + frame_offset) * frame_stride;
+      unpackRow(src, raw + 1);
+      if (hdr_offset > 0) {
+        uint16_t *raw_short = &b.raw[(4 + i) * pw];
+        unpackRow(src + (size_t)(hdr_offset / 2) * frame_stride + frame_stride / 2, raw_short + 1);
+        for (int x = 1; x <= width; x++) {
+          pv[x] = hdr_use_long[raw[x]] ? hdr_long_lut[raw[x]] : hdr_short_lut[raw_short[x]];
+        }
+      } else {
+        for (int x = 1; x <= width; x++) {
+          pv[x] = pv_lut[raw[x]];
+        }
+      }
+      // mirror padding
+      pv[0] = pv[2];
+      pv[width + 1] = pv[width - 1];
+    }
+
+    // debayer and color correct the 2x2 blocks, this loop has no table lookups so it vectorizes
+    const float *r0 = &b.pv[0], *r1 = r0 + pw, *r2 = r1 + pw, *r3 = r2 + pw;
+    const float *vrow = &vignette[vignetting ? gy * blocks : 0];
+    int32_t *idx = b.gamma_idx.data();
+    float cm[3][3];
+    memcpy(cm, color_matrix, sizeof(cm));
+    for (int gx = 0; gx < blocks; gx++) {
+      const float vf = vrow[gx];
+      // v[r][k] is v_rows[r].sk in the kernel, columns 2*gx-1 to 2*gx+2
+      float v[4][4];
+      for (int k = 0; k < 4; k++) {
+        v[0][k] = clamp01(r0[2*gx + k] * vf);
+        v[1][k] = clamp01(r1[2*gx + k] * vf);
+        v[2][k] = clamp01(r2[2*gx + k] * vf);
+        v[3][k] = clamp01(r3[2*gx + k] * vf);
+      }
+
+      float rgb[4][3];
+      const float k01 = get_k(v[0][0], v[1][1], v[0][2], v[1][1]);
+      const float k02 = get_k(v[0][2], v[1][1], v[2][2], v[1][1]);
+      const float k03 = get_k(v[2][0], v[1][1], v[2][2], v[1][1]);
+      const float k04 = get_k(v[0][0], v[1][1], v[2][0], v[1][1]);
+      rgb[0][0] = (k02*v[1][2] + k04*v[1][0]) / (k02 + k04);  // R_G1
+      rgb[0][1] = v[1][1];  // G1(R)
+      rgb[0][2] = (k01*v[0][1] + k03*v[2][1]) / (k01 + k03);  // B_G1
+
+      const float k11 = get_k(v[0][1], v[2][1], v[0][3], v[2][3]);
+      const float k12 = get_k(v[0][2], v[1][1], v[1][3], v[2][2]);
+      const float k13 = get_k(v[0][1], v[0][3], v[2][1], v[2][3]);
+      const float k14 = get_k(v[0][2], v[1][3], v[2][2], v[1][1]);
+      rgb[1][0] = v[1][2];  // R
+      rgb[1][1] = (k11*(v[0][2] + v[2][2])*0.5f + k13*(v[1][3] + v[1][1])*0.5f) / (k11 + k13);  // G_R
+      rgb[1][2] = (k12*(v[0][3] + v[2][1])*0.5f + k14*(v[0][1] + v[2][3])*0.5f) / (k12 + k14);  // B_R
+
+      const float k21 = get_k(v[1][0], v[3][0], v[1][2], v[3][2]);
+      const float k22 = get_k(v[1][1], v[2][0], v[2][2], v[3][1]);
+      const float k23 = get_k(v[1][0], v[1][2], v[3][0], v[3][2]);
+      const float k24 = get_k(v[1][1], v[2][2], v[3][1], v[2][0]);
+      rgb[2][0] = (k22*(v[1][2] + v[3][0])*0.5f + k24*(v[1][0] + v[3][2])*0.5f) / (k22 + k24);  // R_B
+      rgb[2][1] = (k21*(v[1][1] + v[3][1])*0.5f + k23*(v[2][2] + v[2][0])*0.5f) / (k21 + k23);  // G_B
+      rgb[2][2] = v[2][1];  // B
+
+      const float k31 = get_k(v[1][1], v[2][2], v[1][3], v[2][2]);
+      const float k32 = get_k(v[1][3], v[2][2], v[3][3], v[2][2]);
+      const float k33 = get_k(v[3][1], v[2][2], v[3][3], v[2][2]);
+      const float k34 = get_k(v[1][1], v[2][2], v[3][1], v[2][2]);
+      rgb[3][0] = (k31*v[1][2] + k33*v[3][2]) / (k31 + k33);  // R_G2
+      rgb[3][1] = v[2][2];  // G2(B)
+      rgb[3][2] = (k32*v[2][3] + k34*v[2][1]) / (k32 + k34);  // B_G2
+
+      color_correct(cm, rgb[0], &idx[gx*12 + 0]);
+      color_correct(cm, rgb[1], &idx[gx*12 + 3]);
+      color_correct(cm, rgb[2], &idx[gx*12 + 6]);
+      color_correct(cm, rgb[3], &idx[gx*12 + 9]);
+    }
+
+    // gamma and rgb2yuv(nv12)
+    uint8_t *y0 = out + (size_t)(2*gy) * yuv_stride;
+    uint8_t *y1 = y0 + yuv_stride;
+    uint8_t *uv = out + uv_offset + (size_t)gy * yuv_stride;
+    for (int gx = 0; gx < blocks; gx++) {
+      uint8_t rgb_out[4][3];
+      for (int w = 0; w < 4; w++) {
+        for (int c = 0; c < 3; c++) {
+          rgb_out[write_order[w]][c] = gamma_lut[idx[gx*12 + w*3 + c]];
+        }
+      }
+      y0[2*gx + 0] = rgb_to_y(rgb_out[0][0], rgb_out[0][1], rgb_out[0][2]);
+      y0[2*gx + 1] = rgb_to_y(rgb_out[1][0], rgb_out[1][1], rgb_out[1][2]);
+      y1[2*gx + 0] = rgb_to_y(rgb_out[2][0], rgb_out[2][1], rgb_out[2][2]);
+      y1[2*gx + 1] = rgb_to_y(rgb_out[3][0], rgb_out[3][1], rgb_out[3][2]);
+
+      // sum of four halved, as in the kernel's AVERAGE
+      int avg[3];
+      for (int c = 0; c < 3; c++) {
+        avg[c] = (rgb_out[0][c] + rgb_out[1][c] + rgb_out[2][c] + rgb_out[3][c] + 1) >> 1;
+      }
+      uv[2*gx + 0] = rgb_to_u(avg[0], avg[1], avg[2]);
+      uv[2*gx + 1] = rgb_to_v(avg[0], avg[1], avg[2]);
+    }
+  }
+}
+
+void RawProcessor::process(const uint8_t *in, uint8_t *out, int expo_time) {
+  updateTables(expo_time);
+  if (bands.size() == 1) {
+    processBand(bands[0], in, out);
+  } else {
+    WorkerPool::instance().run(bands.size(), [&](int i) { processBand(bands[i], in, out); });
+  }
+}
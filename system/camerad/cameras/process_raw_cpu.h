@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "system/camerad/sensors/sensor.h"
+
+// CPU port of process_raw.cl: unpacking, black level, HDR merge, vignetting, debayer,
+// color correction, gamma and RGB to NV12. The output is within one code value of the
+// OpenCL kernel, so raw frames can be processed without a GPU. Row pairs are split into
+// bands that are processed in parallel, on a worker pool shared by all cameras.
+class RawProcessor {
+public:
+  // num_bands 0 is one per core, 1 processes the frame on the calling thread only
+  RawProcessor(const SensorInfo *sensor, bool vignetting, int yuv_stride, int uv_offset, int num_bands = 0);
+  void process(const uint8_t *in, uint8_t *out, int expo_time);
+
+  const int width, height;
+
+private:
+  struct Band {
+    int row_start, row_end;  // in row pairs
+    std::vector<uint16_t> raw;    // 4 unpacked rows, plus 4 short exposure rows for HDR
+    std::vector<float> pv;        // 4 normalized rows with one pixel of mirror padding on each side
+    std::vector<int32_t> gamma_idx;  // gamma table index for each channel of the 2x2 output block
+  };
+
+  void updateTables(int expo_time);
+  void unpackRow(const uint8_t *src, uint16_t *dst) const;
+  void processBand(Band &b, const uint8_t *in, uint8_t *out);
+
+  const cereal::FrameData::ImageSensor sensor_id;
+  const int bit_depth;
+  const int frame_stride;  // bytes per row read by the kernel, a long and short exposure line for HDR
+  const int frame_offset;
+  const int hdr_offset;
+  const int yuv_stride, uv_offset;
+  const bool bggr;
+  const bool vignetting;
+
+  float color_matrix[3][3];
+  std::vector<float> vignette;  // per output 2x2 block
+  std::vector<float> pv_lut;    // raw value -> normalized value, for non HDR sensors
+  std::vector<float> hdr_long_lut, hdr_short_lut;  // HDR merge, rebuilt when the exposure time changes
+  std::vector<uint8_t> hdr_use_long;
+  std::vector<uint8_t> gamma_lut;
+  int tables_expo_time = -1;
+
+  std::vector<Band> bands;
+};
@@ -5,6 +5,8 @@
 
 #include <cmath>
 #include <cstring>
+#include <utility>
+#include <vector>
 
 #include "common/util.h"
 #include "system/camerad/cameras/camera_common.h"
@@ -82,3 +84,32 @@ TEST_CASE("camera.test_set_exposure_target") {
 
   delete[] fb_y;
 }
+
+TEST_CASE("camera.test_exposure_target_skips") {
+  // compare against a single histogram with odd sizes and every skip camerad uses
+  const int stride = W + 16;
+  std::vector<uint8_t> fb(stride * H);
+  for (size_t i = 0; i < fb.size(); i++) {
+    fb[i] = (i * 2654435761u) >> 24;
+  }
+
+  for (Rect rect : {Rect{0, 0, W, H}, Rect{3, 5, W - 10, H - 7}, Rect{1, 1, 5, 3}}) {
+    for (auto [x_skip, y_skip] : {std::pair{1, 1}, {2, 2}, {2, 4}, {3, 1}}) {
+      uint32_t hist[256] = {};
+      unsigned int total = 0;
+      for (int y = rect.y; y < rect.y + rect.h; y += y_skip) {
+        for (int x = rect.x; x < rect.x + rect.w; x += x_skip) {
+          hist[fb[y * stride + x]]++;
+          total++;
+        }
+      }
+      int med = 255;
+      for (unsigned int cur = 0; med >= 0; med--) {
+        cur += hist[med];
+        if (cur >= total / 2) break;
+      }
+
+      REQUIRE(calculate_exposure_target(fb.data(), stride, rect, x_skip, y_skip) == med / 256.0f);
+    }
+  }
+}
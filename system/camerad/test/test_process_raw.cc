@@ -0,0 +1,525 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include <sys/stat.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/clutil.h"
+#include "system/camerad/cameras/camera_common.h"
+#include "system/camerad/cameras/process_raw_cpu.h"
+
+// Line by line transliteration of process_raw.cl, one work item per 2x2 output block.
+// It is slow but reads the raw frame exactly like the kernel does.
+namespace reference {
+
+struct Params {
+  cereal::FrameData::ImageSensor sensor;
+  int frame_stride, frame_offset, hdr_offset;
+  int rgb_width, rgb_height;
+  int yuv_stride, uv_offset;
+  bool vignetting;
+};
+
+struct uchar8 { uint8_t s[8]; };
+
+uchar8 vload8(const uint8_t *p) {
+  uchar8 v;
+  memcpy(v.s, p, 8);
+  return v;
+}
+
+void parse_12bit(const uchar8 &pvs, int out[4]) {
+  out[0] = ((int)pvs.s[0] << 4) + (pvs.s[1] >> 4);
+  out[1] = ((int)pvs.s[2] << 4) + (pvs.s[4] & 0xF);
+  out[2] = ((int)pvs.s[3] << 4) + (pvs.s[4] >> 4);
+  out[3] = ((int)pvs.s[5] << 4) + (pvs.s[7] & 0xF);
+}
+
+void parse_10bit(const uchar8 &pvs, uint8_t ext, bool aligned, int out[4]) {
+  if (aligned) {
+    out[0] = ((int)pvs.s[0] << 2) + (pvs.s[1] & 0b00000011);
+    out[1] = ((int)pvs.s[2] << 2) + ((pvs.s[6] & 0b11000000) / 64);
+    out[2] = ((int)pvs.s[3] << 2) + ((pvs.s[6] & 0b00110000) / 16);
+    out[3] = ((int)pvs.s[4] << 2) + ((pvs.s[6] & 0b00001100) / 4);
+  } else {
+    out[0] = ((int)pvs.s[0] << 2) + ((pvs.s[3] & 0b00110000) / 16);
+    out[1] = ((int)pvs.s[1] << 2) + ((pvs.s[3] & 0b00001100) / 4);
+    out[2] = ((int)pvs.s[2] << 2) + ((pvs.s[3] & 0b00000011));
+    out[3] = ((int)pvs.s[4] << 2) + ((ext & 0b11000000) / 64);
+  }
+}
+
+float get_vignetting_s(float r) {
+  if (r < 62500) {
+    return (1.0f + 0.0000008f*r);
+  } else if (r < 490000) {
+    return (0.9625f + 0.0000014f*r);
+  } else if (r < 1102500) {
+    return (1.26434f + 0.0000000000016f*r*r);
+  } else {
+    return (0.53503625f + 0.0000000000022f*r*r);
+  }
+}
+
+float ox_lut_func(int x) {
+  if (x < 512) {
+    return x * 5.94873e-8;
+  } else if (512 <= x && x < 768) {
+    return 3.0458e-05 + (x-512) * 1.19913e-7;
+  } else if (768 <= x && x < 1536) {
+    return 6.1154e-05 + (x-768) * 2.38493e-7;
+  } else if (1536 <= x && x < 1792) {
+    return 0.0002448 + (x-1536) * 9.56930e-7;
+  } else if (1792 <= x && x < 2048) {
+    return 0.00048977 + (x-1792) * 1.91441e-6;
+  } else if (2048 <= x && x < 2304) {
+    return 0.00097984 + (x-2048) * 3.82937e-6;
+  } else if (2304 <= x && x < 2560) {
+    return 0.0019601 + (x-2304) * 7.659055e-6;
+  } else if (2560 <= x && x < 2816) {
+    return 0.0039207 + (x-2560) * 1.525e-5;
+  } else {
+    return 0.0078421 + (expf((x-2816)/273.0) - 1) * 0.0092421;
+  }
+}
+
+float combine_dual_pvs(float lv, float sv, int expo_time) {
+  float svc = fmaxf(sv * expo_time, (float)(64 * (1023 - 64)));
+  float svd = sv * fminf(expo_time, 8.0) / 8;
+
+  if (expo_time > 64) {
+    if (lv < 1023 - 64) {
+      return lv / (65536 - 64);
+    } else {
+      return (svc / 64) / (65536 - 64);
+    }
+  } else {
+    if (lv > 32) {
+      return (lv * 64 / fmaxf(expo_time, 8.0)) / (65536 - 64);
+    } else {
+      return svd / (65536 - 64);
+    }
+  }
+}
+
+float clampf(float x, float lo, float hi) { return fminf(fmaxf(x, lo), hi); }
+
+void normalize(const Params &p, const int parsed[4], const int short_parsed[4], float vignette_factor, int expo_time, float out[4]) {
+  for (int i = 0; i < 4; i++) {
+    float pv;
+    if (p.sensor == cereal::FrameData::ImageSensor::AR0231) {
+      pv = ((float)parsed[i] - 168) / (4096 - 168) * vignette_factor;
+    } else if (p.sensor == cereal::FrameData::ImageSensor::OX03C10) {
+      pv = ox_lut_func(parsed[i]) * vignette_factor * 256.0f;
+    } else {
+      pv = combine_dual_pvs(parsed[i] - 64, short_parsed[i] - 64, expo_time) * vignette_factor;
+    }
+    out[i] = clampf(pv, 0.0, 1.0);
+  }
+}
+
+void color_correct(const Params &p, const float rgb[3], float out[3]) {
+  static const float ccm[3][3][3] = {
+    {{1.82717181, -0.31231438, 0.07307673}, {-0.5743977, 1.36858544, -0.53183455}, {-0.25277411, -0.05627105, 1.45875782}},
+    {{1.5664815, -0.29808738, -0.03973474}, {-0.48672447, 1.41914433, -0.40295248}, {-0.07975703, -0.12105695, 1.44268722}},
+    {{1.55361989, -0.268894615, -0.000593219}, {-0.421217301, 1.51883144, -0.69760146}, {-0.132402589, -0.249936825, 1.69819468}},
+  };
+  const auto &m = ccm[(int)p.sensor - 1];
+  for (int c = 0; c < 3; c++) {
+    out[c] = rgb[0] * m[0][c] + rgb[1] * m[1][c] + rgb[2] * m[2][c];
+  }
+}
+
+float apply_gamma(const Params &p, float rgb, int expo_time) {
+  if (p.sensor == cereal::FrameData::ImageSensor::AR0231) {
+    const float gamma_k = 0.75;
+    const float gamma_b = 0.125;
+    const float mp = 0.01;
+    const float rk = 9 - 100*mp;
+    return (rgb > mp) ?
+      ((rk * (rgb-mp) * (1-(gamma_k*mp+gamma_b)) * (1+1/(rk*(1-mp))) / (1+rk*(rgb-mp))) + gamma_k*mp + gamma_b) :
+      ((rk * (rgb-mp) * (gamma_k*mp+gamma_b) * (1+1/(rk*mp)) / (1-rk*(rgb-mp))) + gamma_k*mp + gamma_b);
+  } else if (p.sensor == cereal::FrameData::ImageSensor::OX03C10) {
+    return -0.507089*expf(-12.54124638*rgb) + 0.9655*powf(rgb, 0.5) - 0.472597*rgb + 0.507089;
+  } else {
+    float s = log2f((float)expo_time);
+    if (s < 6) {s = fminf(12.0 - s, 9.0);}
+    return clampf(logf(1 + rgb*(65536 - 64)) * (0.48*s*s - 12.92*s + 115.0) - (1.08*s*s - 29.2*s + 260.0), 0.0, 255.0) / 255.0;
+  }
+}
+
+float get_k(float a, float b, float c, float d) {
+  return 2.0 - (fabsf(a - b) + fabsf(c - d));
+}
+
+uint8_t convert_uchar_sat(float x) {
+  if (!(x > 0)) return 0;
+  return x >= 255 ? 255 : (uint8_t)x;
+}
+
+void finish_pixel(const Params &p, float rgb_tmp[3], int expo_time, uint8_t out[3]) {
+  float clamped[3], corrected[3];
+  for (int c = 0; c < 3; c++) clamped[c] = clampf(rgb_tmp[c], 0.0, 1.0);
+  color_correct(p, clamped, corrected);
+  for (int c = 0; c < 3; c++) out[c] = convert_uchar_sat(apply_gamma(p, corrected[c], expo_time) * 255.0);
+}
+
+#define RGB_TO_Y(r, g, b) ((((b * 13 + g * 65 + r * 33) + 64) >> 7) + 16)
+#define RGB_TO_U(r, g, b) ((b * 56 - g * 37 - r * 19 + 0x8080) >> 8)
+#define RGB_TO_V(r, g, b) ((r * 56 - g * 47 - b * 9 + 0x8080) >> 8)
+
+void process_raw(const Params &p, const uint8_t *in, uint8_t *out, int expo_time, int gid_x, int gid_y) {
+  const int FRAME_STRIDE = p.frame_stride;
+  const int RGB_WIDTH = p.rgb_width, RGB_HEIGHT = p.rgb_height;
+  const bool hdr = p.hdr_offset > 0;
+  const bool bggr = p.sensor == cereal::FrameData::ImageSensor::OS04C10;
+  const int ROW_READ_ORDER[4] = {bggr ? 3 : 0, bggr ? 2 : 1, bggr ? 1 : 2, bggr ? 0 : 3};
+  const int RGB_WRITE_ORDER[4] = {bggr ? 2 : 0, bggr ? 3 : 1, bggr ? 0 : 2, bggr ? 1 : 3};
+
+  float vignette_factor = 1.0;
+  if (p.vignetting) {
+    int gx = (gid_x*2 - RGB_WIDTH/2);
+    int gy = (gid_y*2 - RGB_HEIGHT/2);
+    vignette_factor = get_vignetting_s((gx*gx + gy*gy) / (bggr ? 2.2545f : 1.0f));
+  }
+
+  const int row_before_offset = (gid_y == 0) ? 2 : 0;
+  const int row_after_offset = (gid_y == (RGB_HEIGHT/2 - 1)) ? 1 : 3;
+  const int row_offsets[4] = {row_before_offset, 1, 2, row_after_offset};
+
+  int start_idx;
+  bool aligned10 = false;
+  if (hdr) {
+    if (gid_x % 2 == 0) {
+      aligned10 = true;
+      start_idx = (2 * gid_y - 1) * FRAME_STRIDE + (5 * gid_x / 2 - 2) + (FRAME_STRIDE * p.frame_offset);
+    } else {
+      start_idx = (2 * gid_y - 1) * FRAME_STRIDE + (5 * (gid_x - 1) / 2 + 1) + (FRAME_STRIDE * p.frame_offset);
+    }
+  } else {
+    start_idx = (2 * gid_y - 1) * FRAME_STRIDE + (3 * gid_x - 2) + (FRAME_STRIDE * p.frame_offset);
+  }
+
+  float v_rows[4][4];
+  for (int i = 0; i < 4; i++) {
+    uchar8 dat;
+    if (i == 1 && gid_x == 0 && gid_y == 0) {
+      uchar8 tmp = vload8(in + start_idx + FRAME_STRIDE*1 + 2);
+      dat = {{0, 0, tmp.s[0], tmp.s[1], tmp.s[2], tmp.s[3], tmp.s[4], tmp.s[5]}};
+    } else {
+      dat = vload8(in + start_idx + FRAME_STRIDE*row_offsets[i]);
+    }
+    int parsed[4], short_parsed[4] = {};
+    if (hdr) {
+      const uint8_t extra_dat = aligned10 ? 0 : in[start_idx + FRAME_STRIDE*row_offsets[i] + 8];
+      parse_10bit(dat, extra_dat, aligned10, parsed);
+      const int short_idx = start_idx + FRAME_STRIDE*(row_offsets[i] + p.hdr_offset/2) + FRAME_STRIDE/2;
+      const uint8_t short_extra_dat = aligned10 ? 0 : in[short_idx + 8];
+      parse_10bit(vload8(in + short_idx), short_extra_dat, aligned10, short_parsed);
+    } else {
+      parse_12bit(dat, parsed);
+    }
+    normalize(p, parsed, short_parsed, vignette_factor, expo_time, v_rows[ROW_READ_ORDER[i]]);
+  }
+
+  // mirror padding
+  if (gid_x == 0) {
+    for (int i = 0; i < 4; i++) v_rows[i][0] = v_rows[i][2];
+  } else if (gid_x == RGB_WIDTH/2 - 1) {
+    for (int i = 0; i < 4; i++) v_rows[i][3] = v_rows[i][1];
+  }
+
+  float rgb_tmp[3];
+  uint8_t rgb_out[4][3];
+  const float k01 = get_k(v_rows[0][0], v_rows[1][1], v_rows[0][2], v_rows[1][1]);
+  const float k02 = get_k(v_rows[0][2], v_rows[1][1], v_rows[2][2], v_rows[1][1]);
+  const float k03 = get_k(v_rows[2][0], v_rows[1][1], v_rows[2][2], v_rows[1][1]);
+  const float k04 = get_k(v_rows[0][0], v_rows[1][1], v_rows[2][0], v_rows[1][1]);
+  rgb_tmp[0] = (k02*v_rows[1][2]+k04*v_rows[1][0])/(k02+k04);
+  rgb_tmp[1] = v_rows[1][1];
+  rgb_tmp[2] = (k01*v_rows[0][1]+k03*v_rows[2][1])/(k01+k03);
+  finish_pixel(p, rgb_tmp, expo_time, rgb_out[RGB_WRITE_ORDER[0]]);
+
+  const float k11 = get_k(v_rows[0][1], v_rows[2][1], v_rows[0][3], v_rows[2][3]);
+  const float k12 = get_k(v_rows[0][2], v_rows[1][1], v_rows[1][3], v_rows[2][2]);
+  const float k13 = get_k(v_rows[0][1], v_rows[0][3], v_rows[2][1], v_rows[2][3]);
+  const float k14 = get_k(v_rows[0][2], v_rows[1][3], v_rows[2][2], v_rows[1][1]);
+  rgb_tmp[0] = v_rows[1][2];
+  rgb_tmp[1] = (k11*(v_rows[0][2]+v_rows[2][2])*0.5+k13*(v_rows[1][3]+v_rows[1][1])*0.5)/(k11+k13);
+  rgb_tmp[2] = (k12*(v_rows[0][3]+v_rows[2][1])*0.5+k14*(v_rows[0][1]+v_rows[2][3])*0.5)/(k12+k14);
+  finish_pixel(p, rgb_tmp, expo_time, rgb_out[RGB_WRITE_ORDER[1]]);
+
+  const float k21 = get_k(v_rows[1][0], v_rows[3][0], v_rows[1][2], v_rows[3][2]);
+  const float k22 = get_k(v_rows[1][1], v_rows[2][0], v_rows[2][2], v_rows[3][1]);
+  const float k23 = get_k(v_rows[1][0], v_rows[1][2], v_rows[3][0], v_rows[3][2]);
+  const float k24 = get_k(v_rows[1][1], v_rows[2][2], v_rows[3][1], v_rows[2][0]);
+  rgb_tmp[0] = (k22*(v_rows[1][2]+v_rows[3][0])*0.5+k24*(v_rows[1][0]+v_rows[3][2])*0.5)/(k22+k24);
+  rgb_tmp[1] = (k21*(v_rows[1][1]+v_rows[3][1])*0.5+k23*(v_rows[2][2]+v_rows[2][0])*0.5)/(k21+k23);
+  rgb_tmp[2] = v_rows[2][1];
+  finish_pixel(p, rgb_tmp, expo_time, rgb_out[RGB_WRITE_ORDER[2]]);
+
+  const float k31 = get_k(v_rows[1][1], v_rows[2][2], v_rows[1][3], v_rows[2][2]);
+  const float k32 = get_k(v_rows[1][3], v_rows[2][2], v_rows[3][3], v_rows[2][2]);
+  const float k33 = get_k(v_rows[3][1], v_rows[2][2], v_rows[3][3], v_rows[2][2]);
+  const float k34 = get_k(v_rows[1][1], v_rows[2][2], v_rows[3][1], v_rows[2][2]);
+  rgb_tmp[0] = (k31*v_rows[1][2]+k33*v_rows[3][2])/(k31+k33);
+  rgb_tmp[1] = v_rows[2][2];
+  rgb_tmp[2] = (k32*v_rows[2][3]+k34*v_rows[2][1])/(k32+k34);
+  finish_pixel(p, rgb_tmp, expo_time, rgb_out[RGB_WRITE_ORDER[3]]);
+
+  uint8_t *yy = out + (gid_y * 2) * p.yuv_stride + gid_x * 2;
+  yy[0] = RGB_TO_Y(rgb_out[0][0], rgb_out[0][1], rgb_out[0][2]);
+  yy[1] = RGB_TO_Y(rgb_out[1][0], rgb_out[1][1], rgb_out[1][2]);
+  yy += p.yuv_stride;
+  yy[0] = RGB_TO_Y(rgb_out[2][0], rgb_out[2][1], rgb_out[2][2]);
+  yy[1] = RGB_TO_Y(rgb_out[3][0], rgb_out[3][1], rgb_out[3][2]);
+
+  const short ar = (rgb_out[0][0] + rgb_out[1][0] + rgb_out[2][0] + rgb_out[3][0] + 1) >> 1;
+  const short ag = (rgb_out[0][1] + rgb_out[1][1] + rgb_out[2][1] + rgb_out[3][1] + 1) >> 1;
+  const short ab = (rgb_out[0][2] + rgb_out[1][2] + rgb_out[2][2] + rgb_out[3][2] + 1) >> 1;
+  uint8_t *uv = out + p.uv_offset + gid_y * p.yuv_stride + gid_x * 2;
+  uv[0] = RGB_TO_U(ar, ag, ab);
+  uv[1] = RGB_TO_V(ar, ag, ab);
+}
+
+}  // namespace reference
+
+struct TestFrame {
+  std::unique_ptr<SensorInfo> sensor;
+  int width, height, yuv_stride, uv_offset;
+  std::vector<uint8_t> raw;
+};
+
+static TestFrame make_frame(SensorInfo *sensor, uint32_t seed) {
+  TestFrame f;
+  f.sensor.reset(sensor);
+  f.width = sensor->frame_width;
+  f.height = sensor->hdr_offset > 0 ? (sensor->frame_height - sensor->hdr_offset) / 2 : sensor->frame_height;
+  f.yuv_stride = f.width;
+  f.uv_offset = f.width * f.height;
+
+  // smooth gradients with noise, the kernel reads a few bytes past the last line
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> noise(-24, 24);
+  const size_t lines = sensor->frame_height + sensor->extra_height;
+  f.raw.resize(lines * sensor->frame_stride + 64);
+  for (size_t y = 0; y < lines; y++) {
+    for (size_t x = 0; x < sensor->frame_stride; x++) {
+      f.raw[y * sensor->frame_stride + x] = std::clamp<int>((x * 255 / sensor->frame_stride + y / 8) % 256 + noise(gen), 0, 255);
+    }
+  }
+  return f;
+}
+
+static std::vector<uint8_t> run_reference(const TestFrame &f, bool vignetting, int expo_time) {
+  const SensorInfo *s = f.sensor.get();
+  reference::Params p = {
+    .sensor = s->image_sensor,
+    .frame_stride = (int)(s->hdr_offset > 0 ? s->frame_stride * 2 : s->frame_stride),
+    .frame_offset = (int)s->frame_offset,
+    .hdr_offset = s->hdr_offset,
+    .rgb_width = f.width,
+    .rgb_height = f.height,
+    .yuv_stride = f.yuv_stride,
+    .uv_offset = f.uv_offset,
+    .vignetting = vignetting,
+  };
+  // the first block reads two bytes before the frame, like on the GPU these come from the previous line
+  std::vector<uint8_t> in(p.frame_stride * 2);
+  in.insert(in.end(), f.raw.begin(), f.raw.end());
+  std::vector<uint8_t> out(f.uv_offset + f.yuv_stride * f.height / 2);
+  for (int gy = 0; gy < f.height / 2; gy++) {
+    for (int gx = 0; gx < f.width / 2; gx++) {
+      reference::process_raw(p, in.data() + p.frame_stride * 2, out.data(), expo_time, gx, gy);
+    }
+  }
+  return out;
+}
+
+static void check_close(const std::vector<uint8_t> &out, const std::vector<uint8_t> &expected) {
+  REQUIRE(out.size() == expected.size());
+  int max_diff = 0;
+  size_t mismatches = 0;
+  for (size_t i = 0; i < out.size(); i++) {
+    int d = std::abs(out[i] - expected[i]);
+    max_diff = std::max(max_diff, d);
+    mismatches += d > 0;
+  }
+  INFO(mismatches << " of " << out.size() << " bytes differ");
+  REQUIRE(max_diff <= 1);
+  REQUIRE(mismatches < out.size() / 100);
+}
+
+static void check_sensor(SensorInfo *sensor, int expo_time) {
+  TestFrame f = make_frame(sensor, 1234);
+  for (bool vignetting : {false, true}) {
+    std::vector<uint8_t> expected = run_reference(f, vignetting, expo_time);
+
+    RawProcessor proc(f.sensor.get(), vignetting, f.yuv_stride, f.uv_offset, 3);
+    std::vector<uint8_t> out(expected.size());
+    proc.process(f.raw.data(), out.data(), expo_time);
+
+    INFO("vignetting " << vignetting << " expo " << expo_time);
+    check_close(out, expected);
+  }
+}
+
+TEST_CASE("process_raw CPU matches kernel: ar0231") {
+  check_sensor(new AR0231(), 500);
+}
+
+TEST_CASE("process_raw CPU matches kernel: ox03c10") {
+  check_sensor(new OX03C10(), 500);
+}
+
+TEST_CASE("process_raw CPU matches kernel: os04c10") {
+  for (int expo_time : {4, 40, 300}) {
+    check_sensor(new OS04C10(), expo_time);
+  }
+}
+
+TEST_CASE("process_raw CPU cameras share the worker pool") {
+  std::vector<TestFrame> frames;
+  frames.push_back(make_frame(new AR0231(), 1));
+  frames.push_back(make_frame(new OX03C10(), 2));
+  frames.push_back(make_frame(new OS04C10(), 3));
+
+  std::vector<std::vector<uint8_t>> expected, out;
+  for (auto &f : frames) {
+    RawProcessor proc(f.sensor.get(), true, f.yuv_stride, f.uv_offset, 1);
+    expected.emplace_back(f.uv_offset + f.yuv_stride * f.height / 2);
+    proc.process(f.raw.data(), expected.back().data(), 300);
+    out.emplace_back(expected.back().size());
+  }
+
+  // one camera thread each, like camerad
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < frames.size(); i++) {
+    threads.emplace_back([&, i]() {
+      TestFrame &f = frames[i];
+      RawProcessor proc(f.sensor.get(), true, f.yuv_stride, f.uv_offset);
+      for (int n = 0; n < 5; n++) {
+        proc.process(f.raw.data(), out[i].data(), 300);
+      }
+    });
+  }
+  for (auto &t : threads) t.join();
+  for (size_t i = 0; i < frames.size(); i++) {
+    REQUIRE(out[i] == expected[i]);
+  }
+}
+
+// The transliteration above is only as good as its reading of the kernel, so the CPU output is also
+// compared with what the kernel produced on an OpenCL device. Recorded once, from system/camerad:
+//   ./test/test_process_raw "[record]"
+// Every 32nd line of each plane is kept, to keep the files small.
+const char GOLDEN_DIR[] = "test/process_raw_golden";
+
+struct GoldenCase {
+  const char *sensor;
+  std::function<SensorInfo *()> create;
+  int expo_time;
+};
+
+static const std::vector<GoldenCase> golden_cases = {
+  {"ar0231", [] { return new AR0231(); }, 500},
+  {"ox03c10", [] { return new OX03C10(); }, 500},
+  {"os04c10", [] { return new OS04C10(); }, 4},
+  {"os04c10", [] { return new OS04C10(); }, 300},
+};
+
+static std::string golden_path(const GoldenCase &c) {
+  return std::string(GOLDEN_DIR) + "/" + c.sensor + "_" + std::to_string(c.expo_time) + ".yuv";
+}
+
+static std::vector<uint8_t> golden_lines(const TestFrame &f, const std::vector<uint8_t> &yuv) {
+  std::vector<uint8_t> lines;
+  for (int y = 16; y < f.height; y += 32) {
+    auto line = yuv.begin() + y * f.yuv_stride;
+    lines.insert(lines.end(), line, line + f.width);
+  }
+  for (int y = 8; y < f.height / 2; y += 16) {
+    auto line = yuv.begin() + f.uv_offset + y * f.yuv_stride;
+    lines.insert(lines.end(), line, line + f.width);
+  }
+  return lines;
+}
+
+TEST_CASE("process_raw CPU matches recorded kernel output") {
+  for (auto &c : golden_cases) {
+    // a missing recording fails, the CPU output would otherwise never be checked against the kernel
+    std::ifstream file(golden_path(c), std::ios::binary);
+    if (!file) {
+      FAIL("no kernel output recorded at " << golden_path(c) << ", record it with ./test/test_process_raw \"[record]\"");
+    }
+    std::vector<uint8_t> expected((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    TestFrame f = make_frame(c.create(), 1234);
+    RawProcessor proc(f.sensor.get(), true, f.yuv_stride, f.uv_offset);
+    std::vector<uint8_t> out(f.uv_offset + f.yuv_stride * f.height / 2);
+    proc.process(f.raw.data(), out.data(), c.expo_time);
+
+    INFO(c.sensor << " expo " << c.expo_time);
+    check_close(golden_lines(f, out), expected);
+  }
+}
+
+TEST_CASE("process_raw record kernel output", "[.][record]") {
+  cl_device_id device_id = cl_get_device_id(CL_DEVICE_TYPE_DEFAULT);
+  cl_context context = cl_create_context(device_id);
+  const cl_queue_properties props[] = {0};
+  cl_command_queue q = CL_CHECK_ERR(clCreateCommandQueueWithProperties(context, device_id, props, &err));
+  mkdir(GOLDEN_DIR, 0755);
+
+  for (auto &c : golden_cases) {
+    TestFrame f = make_frame(c.create(), 1234);
+    std::vector<uint8_t> out(f.uv_offset + f.yuv_stride * f.height / 2);
+    cl_mem in_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, f.raw.size(), f.raw.data(), &err));
+    cl_mem out_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_WRITE_ONLY, out.size(), NULL, &err));
+
+    ImgProc imgproc(device_id, context, f.sensor.get(), f.width, f.height, true, f.yuv_stride, f.uv_offset);
+    imgproc.runKernel(in_cl, out_cl, f.width, f.height, c.expo_time);
+    CL_CHECK(clEnqueueReadBuffer(q, out_cl, CL_TRUE, 0, out.size(), out.data(), 0, NULL, NULL));
+    CL_CHECK(clReleaseMemObject(in_cl));
+    CL_CHECK(clReleaseMemObject(out_cl));
+
+    std::vector<uint8_t> lines = golden_lines(f, out);
+    std::ofstream(golden_path(c), std::ios::binary).write((const char *)lines.data(), lines.size());
+    printf("recorded %s\n", golden_path(c).c_str());
+  }
+  CL_CHECK(clReleaseCommandQueue(q));
+  CL_CHECK(clReleaseContext(context));
+}
+
+// not run by default: ./test_process_raw "[benchmark]"
+TEST_CASE("process_raw CPU throughput", "[.][benchmark]") {
+  const int num_frames = 50;
+  std::vector<std::pair<const char *, SensorInfo *>> sensors = {{"ar0231", new AR0231()}, {"ox03c10", new OX03C10()}, {"os04c10", new OS04C10()}};
+  for (auto [name, sensor] : sensors) {
+    TestFrame f = make_frame(sensor, 1);
+    std::vector<uint8_t> out(f.uv_offset + f.yuv_stride * f.height / 2);
+    for (int bands : {1, 0}) {
+      RawProcessor proc(f.sensor.get(), true, f.yuv_stride, f.uv_offset, bands);
+      proc.process(f.raw.data(), out.data(), 300);
+
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < num_frames; i++) {
+        proc.process(f.raw.data(), out.data(), 300);
+      }
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      printf("%-8s %dx%d, %s: %.2f ms/frame, %.1f fps\n", name, f.width, f.height,
+             bands == 1 ? "1 thread" : "all threads", secs * 1000 / num_frames, num_frames / secs);
+    }
+  }
+}
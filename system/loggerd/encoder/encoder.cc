@@ -1,5 +1,7 @@
 #include "system/loggerd/encoder/encoder.h"
 
+#include <algorithm>
+
 VideoEncoder::VideoEncoder(const EncoderInfo &encoder_info, int in_width, int in_height)
     : encoder_info(encoder_info), in_width(in_width), in_height(in_height) {
 
@@ -14,6 +16,16 @@ VideoEncoder::VideoEncoder(const EncoderInfo &encoder_info, int in_width, int in
   pm.reset(new PubMaster(pubs));
 }
 
+void VideoEncoder::skip_frame(uint32_t frame_id) {
+  std::lock_guard lk(skipped_lock);
+  skipped.push_back(frame_id);
+}
+
+void VideoEncoder::clear_skipped_frames() {
+  std::lock_guard lk(skipped_lock);
+  skipped.clear();
+}
+
 void VideoEncoder::publisher_publish(VideoEncoder *e, int segment_num, uint32_t idx, VisionIpcBufExtra &extra,
                                      unsigned int flags, kj::ArrayPtr<capnp::byte> header, kj::ArrayPtr<capnp::byte> dat) {
   // broadcast packet
@@ -33,6 +45,18 @@ void VideoEncoder::publisher_publish(VideoEncoder *e, int segment_num, uint32_t
   edata.setSegmentId(idx);
   edata.setFlags(flags);
   edata.setLen(dat.size());
+  {
+    // frames skipped after this one was queued belong to the next
+    std::lock_guard lk(e->skipped_lock);
+    auto later = std::stable_partition(e->skipped.begin(), e->skipped.end(), [&](uint32_t id) { return id < extra.frame_id; });
+    if (later != e->skipped.begin()) {
+      auto ids = edata.initSkippedFrameIds(later - e->skipped.begin());
+      for (uint32_t i = 0; i < ids.size(); ++i) {
+        ids.set(i, e->skipped[i]);
+      }
+      e->skipped.erase(e->skipped.begin(), later);
+    }
+  }
   edat.setData(dat);
   edat.setWidth(out_width);
   edat.setHeight(out_height);
@@ -11,6 +11,7 @@
 #include <cassert>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -26,6 +27,12 @@ public:
   virtual int encode_frame(VisionBuf* buf, VisionIpcBufExtra *extra) = 0;
   virtual void encoder_open(const char* path) = 0;
   virtual void encoder_close() = 0;
+  // frames passed to encode_frame that the encoder may still be reading, encoder_close waits for them
+  virtual int max_frames_in_flight() { return 0; }
+  // a frame that isn't encoded, it goes in the encodeIdx of the next one
+  void skip_frame(uint32_t frame_id);
+  // drops the skipped frames not published yet, they belong to the segment that was closed
+  void clear_skipped_frames();
 
   void publisher_publish(VideoEncoder *e, int segment_num, uint32_t idx, VisionIpcBufExtra &extra, unsigned int flags, kj::ArrayPtr<capnp::byte> header, kj::ArrayPtr<capnp::byte> dat);
 
@@ -41,4 +48,8 @@ private:
   int cnt = 0;
   std::unique_ptr<PubMaster> pm;
   std::vector<capnp::byte> msg_cache;
+
+  // skipped frames not published yet, the encoder may publish on its own thread
+  std::mutex skipped_lock;
+  std::vector<uint32_t> skipped;
 };
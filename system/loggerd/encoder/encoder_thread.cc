@@ -0,0 +1,218 @@
+#include "system/loggerd/encoder/encoder_thread.h"
+
+#include <cassert>
+
+#include "common/timing.h"
+
+static ExitHandler do_exit;
+
+// Handle initial encoder syncing by waiting for all encoders to reach the same frame id
+bool sync_encoders(EncoderdState *s, VisionStreamType cam_type, uint32_t frame_id) {
+  if (s->camera_synced[cam_type]) return true;
+
+  if (s->max_waiting > 1 && s->encoders_ready != s->max_waiting) {
+    // add a small margin to the start frame id in case one of the encoders already dropped the next frame
+    update_max_atomic(s->start_frame_id, frame_id + 2);
+    if (std::exchange(s->camera_ready[cam_type], true) == false) {
+      ++s->encoders_ready;
+      LOGD("camera %d encoder ready", cam_type);
+    }
+    return false;
+  } else {
+    if (s->max_waiting == 1) update_max_atomic(s->start_frame_id, frame_id);
+    bool synced = frame_id >= s->start_frame_id;
+    s->camera_synced[cam_type] = synced;
+    if (!synced) LOGD("camera %d waiting for frame %d, cur %d", cam_type, (int)s->start_frame_id, frame_id);
+    return synced;
+  }
+}
+
+
+static EncoderLagStats *register_encoder_stats(EncoderdState *s, const char *publish_name, cereal::EncoderStats::DropPolicy policy) {
+  std::lock_guard lk(s->stats_lock);
+  auto &st = s->stats.emplace_back();
+  st.publish_name = publish_name;
+  st.drop_policy = policy;
+  return &st;
+}
+
+void encoder_thread(EncoderdState *s, const LogCameraInfo &cam_info) {
+  util::set_thread_name(cam_info.thread_name);
+
+  std::vector<std::unique_ptr<Encoder>> encoders;
+  std::vector<EncoderLagStats *> stats;
+  VisionIpcClient vipc_client = VisionIpcClient("camerad", cam_info.stream_type, false);
+  // camerad doesn't reuse a buffer while it's leased, so queued frames aren't overwritten
+  vipc_client.set_lease_mode(true);
+  uint64_t torn_frames = 0;
+
+  const size_t max_queue_depth = std::max(ENCODER_MAX_QUEUE_DEPTH, 1);
+  const bool skip_secondary = cam_info.drop_policy == cereal::EncoderStats::DropPolicy::SKIP_SECONDARY;
+
+  int cur_seg = 0;
+  while (!do_exit) {
+    if (!vipc_client.connect(false)) {
+      util::sleep_for(5);
+      continue;
+    }
+
+    // init encoders
+    if (encoders.empty()) {
+      const VisionBuf &buf_info = vipc_client.buffers[0];
+      LOGW("encoder %s init %zux%zu", cam_info.thread_name, buf_info.width, buf_info.height);
+      assert(buf_info.width > 0 && buf_info.height > 0);
+
+      for (const auto &encoder_info : cam_info.encoder_infos) {
+        auto &e = encoders.emplace_back(new Encoder(encoder_info, buf_info.width, buf_info.height));
+        e->encoder_open(nullptr);
+        stats.push_back(register_encoder_stats(s, encoder_info.publish_name, cam_info.drop_policy));
+      }
+    }
+
+    // Frames received from camerad but not yet encoded. The buffers behind them are leased, but
+    // camerad overwrites them anyway when all are leased, anything it overwrote is dropped below.
+    // Leases are released by frame id, an overwritten buffer may already be leased again for a newer frame.
+    std::deque<std::pair<VisionBuf *, VisionIpcBufExtra>> queue;
+    // Encoded frames whose buffers are still leased, until every encoder has queued enough newer
+    // frames that it can't be reading them anymore. done_at is per encoder, in frames queued.
+    struct InFlight {
+      VisionBuf *buf;
+      uint32_t frame_id;
+      std::vector<uint64_t> done_at;
+    };
+    std::deque<InFlight> in_flight;
+    std::vector<uint64_t> frames_queued(encoders.size());
+    bool lagging = false;
+    while (!do_exit) {
+      // block for the next frame only when there is nothing to encode, otherwise just drain the socket
+      VisionIpcBufExtra recv_extra;
+      VisionBuf *recv_buf = vipc_client.recv(&recv_extra, queue.empty() ? 100 : 0);
+      if (vipc_client.stats.torn_frames != torn_frames) {
+        for (auto st : stats) st->frames_overwritten += vipc_client.stats.torn_frames - torn_frames;
+        torn_frames = vipc_client.stats.torn_frames;
+      }
+      if (recv_buf != nullptr) {
+        queue.emplace_back(recv_buf, recv_extra);
+        if (queue.size() > max_queue_depth) {
+          vipc_client.release(queue.front().first, queue.front().second.frame_id);
+          queue.pop_front();
+          for (auto st : stats) st->frames_dropped++;
+        }
+        continue;
+      }
+      if (queue.empty()) continue;
+
+      auto [buf, extra] = queue.front();
+      queue.pop_front();
+
+      const uint32_t depth = queue.size();
+      for (auto st : stats) {
+        st->queue_depth = depth;
+        update_max_atomic(st->max_queue_depth, depth);
+      }
+
+      // detect loop around and drop the frames
+      if (buf->get_frame_id() != extra.frame_id) {
+        if (!lagging) {
+          LOGE("encoder %s lag  buffer id: %" PRIu64 " extra id: %d", cam_info.thread_name, buf->get_frame_id(), extra.frame_id);
+          lagging = true;
+        }
+        for (auto st : stats) st->frames_overwritten++;
+        vipc_client.release(buf, extra.frame_id);
+        continue;
+      }
+      lagging = false;
+
+      if (!sync_encoders(s, cam_info.stream_type, extra.frame_id)) {
+        vipc_client.release(buf, extra.frame_id);
+        continue;
+      }
+      if (do_exit) break;
+
+      // do rotation if required
+      const int frames_per_seg = SEGMENT_LENGTH * MAIN_FPS;
+      if (cur_seg >= 0 && extra.frame_id >= ((cur_seg + 1) * frames_per_seg) + s->start_frame_id) {
+        for (auto &e : encoders) {
+          e->encoder_close();
+          e->clear_skipped_frames();
+          e->encoder_open(NULL);
+        }
+        ++cur_seg;
+        // closing waited for every frame in flight
+        for (auto &f : in_flight) vipc_client.release(f.buf, f.frame_id);
+        in_flight.clear();
+      }
+
+      // encode a frame
+      InFlight &frame = in_flight.emplace_back(InFlight{buf, extra.frame_id, std::vector<uint64_t>(encoders.size())});
+      for (int i = 0; i < encoders.size(); ++i) {
+        // keep the main encoder on time at the expense of the secondary ones
+        if (skip_secondary && i > 0 && depth > 0) {
+          encoders[i]->skip_frame(extra.frame_id);
+          stats[i]->frames_skipped++;
+          continue;
+        }
+
+        const uint64_t t0 = nanos_since_boot();
+        int out_id = encoders[i]->encode_frame(buf, &extra);
+        const uint64_t dt = nanos_since_boot() - t0;
+        frame.done_at[i] = ++frames_queued[i] + encoders[i]->max_frames_in_flight();
+
+        if (out_id == -1) {
+          LOGE("Failed to encode frame. frame_id: %d", extra.frame_id);
+        }
+        stats[i]->frames_encoded++;
+        stats[i]->latency_sum_ns += dt;
+        stats[i]->latency_cnt++;
+        update_max_atomic(stats[i]->latency_max_ns, dt);
+      }
+
+      // give camerad back what the encoders are done with
+      auto done = [&](const InFlight &f) {
+        for (int i = 0; i < encoders.size(); ++i) {
+          if (frames_queued[i] < f.done_at[i]) return false;
+        }
+        return true;
+      };
+      while (!in_flight.empty() && done(in_flight.front())) {
+        vipc_client.release(in_flight.front().buf, in_flight.front().frame_id);
+        in_flight.pop_front();
+      }
+      const uint64_t lease_max_ns = vipc_client.stats.lease_ms_max * 1e6;
+      vipc_client.stats.lease_ms_max = 0;
+      for (auto st : stats) update_max_atomic(st->lease_max_ns, lease_max_ns);
+    }
+  }
+}
+
+void encoder_stats_thread(EncoderdState *s) {
+  PubMaster pm({"encoderStats"});
+  while (!do_exit) {
+    util::sleep_for(1000);
+
+    MessageBuilder msg;
+    auto encoder_stats = msg.initEvent().initEncoderStats();
+    std::lock_guard lk(s->stats_lock);
+    auto encoders = encoder_stats.initEncoders(s->stats.size());
+    for (int i = 0; i < s->stats.size(); ++i) {
+      auto &st = s->stats[i];
+      const uint64_t cnt = st.latency_cnt.exchange(0);
+      const uint64_t sum_ns = st.latency_sum_ns.exchange(0);
+      const uint64_t max_ns = st.latency_max_ns.exchange(0);
+
+      auto e = encoders[i];
+      e.setPublishName(st.publish_name);
+      e.setDropPolicy(st.drop_policy);
+      e.setQueueDepth(st.queue_depth);
+      e.setMaxQueueDepth(st.max_queue_depth.exchange(0));
+      e.setFramesEncoded(st.frames_encoded);
+      e.setFramesDropped(st.frames_dropped);
+      e.setFramesOverwritten(st.frames_overwritten);
+      e.setFramesSkipped(st.frames_skipped);
+      e.setEncodeLatencyMsAvg(cnt > 0 ? (sum_ns / cnt) * 1e-6 : 0);
+      e.setEncodeLatencyMsMax(max_ns * 1e-6);
+      e.setLeaseMsMax(st.lease_max_ns.exchange(0) * 1e-6);
+    }
+    pm.send("encoderStats", msg);
+  }
+}
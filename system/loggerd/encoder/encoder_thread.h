@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+#include "system/loggerd/loggerd.h"
+
+#ifdef QCOM2
+#include "system/loggerd/encoder/v4l_encoder.h"
+#define Encoder V4LEncoder
+#else
+#include "system/loggerd/encoder/ffmpeg_encoder.h"
+#define Encoder FfmpegEncoder
+#endif
+
+// Per-encoder lag counters, written by the encoder threads and read by the stats publisher
+struct EncoderLagStats {
+  const char *publish_name;
+  cereal::EncoderStats::DropPolicy drop_policy;
+
+  std::atomic<uint32_t> queue_depth = 0;
+  std::atomic<uint32_t> max_queue_depth = 0;
+  std::atomic<uint64_t> frames_encoded = 0;
+  std::atomic<uint64_t> frames_dropped = 0;
+  std::atomic<uint64_t> frames_overwritten = 0;
+  std::atomic<uint64_t> frames_skipped = 0;
+
+  // reset on every publish
+  std::atomic<uint64_t> latency_sum_ns = 0;
+  std::atomic<uint64_t> latency_max_ns = 0;
+  std::atomic<uint64_t> latency_cnt = 0;
+  std::atomic<uint64_t> lease_max_ns = 0;
+};
+
+struct EncoderdState {
+  int max_waiting = 0;
+
+  std::mutex stats_lock;
+  std::deque<EncoderLagStats> stats;
+
+  // Sync logic for startup
+  std::atomic<int> encoders_ready = 0;
+  std::atomic<uint32_t> start_frame_id = 0;
+  bool camera_ready[VISION_STREAM_MAX] = {};
+  bool camera_synced[VISION_STREAM_MAX] = {};
+};
+
+bool sync_encoders(EncoderdState *s, VisionStreamType cam_type, uint32_t frame_id);
+void encoder_thread(EncoderdState *s, const LogCameraInfo &cam_info);
+void encoder_stats_thread(EncoderdState *s);
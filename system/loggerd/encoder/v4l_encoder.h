@@ -13,6 +13,8 @@ public:
   int encode_frame(VisionBuf* buf, VisionIpcBufExtra *extra);
   void encoder_open(const char* path);
   void encoder_close();
+  // the hardware reads the VisionBuf after encode_frame returns, until its input buffer is dequeued
+  int max_frames_in_flight() { return BUF_IN_COUNT; }
 private:
   int fd;
 
@@ -116,7 +116,8 @@ int handle_encoder_msg(LoggerdState *s, Message *msg, std::string &name, struct
           assert(encoder_info.filename != NULL);
           re.writer.reset(new VideoWriter(s->logger.segmentPath().c_str(),
             encoder_info.filename, idx.getType() != cereal::EncodeIndex::Type::FULL_H_E_V_C,
-            edata.getWidth(), edata.getHeight(), encoder_info.fps, idx.getType()));
+            edata.getWidth(), edata.getHeight(), encoder_info.fps, idx.getType(),
+            (size_t)encoder_info.bitrate / 8 * SEGMENT_LENGTH));
           // write the header
           auto header = edata.getHeader();
           re.writer->write((uint8_t *)header.begin(), header.size(), idx.getTimestampEof()/1000, true, false);
@@ -286,6 +287,8 @@ void loggerd_thread() {
 
   LOGW("closing logger");
   s.logger.setExitSignal(do_exit.signal);
+  // close the video writers, so their buffered packets are written before the sync
+  remote_encoders.clear();
 
   if (do_exit.power_failure) {
     LOGE("power failure");
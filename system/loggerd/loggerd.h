@@ -27,6 +27,9 @@ const int QCAM_BITRATE = 256000;
 const bool LOGGERD_TEST = getenv("LOGGERD_TEST");
 const int SEGMENT_LENGTH = LOGGERD_TEST ? atoi(getenv("LOGGERD_SEGMENT_LENGTH")) : 60;
 
+// max frames an encoder thread holds behind the one being encoded before dropping
+const int ENCODER_MAX_QUEUE_DEPTH = getenv("ENCODER_MAX_QUEUE_DEPTH") ? atoi(getenv("ENCODER_MAX_QUEUE_DEPTH")) : 3;
+
 constexpr char PRESERVE_ATTR_NAME[] = "user.preserve";
 constexpr char PRESERVE_ATTR_VALUE = '1';
 class EncoderInfo {
@@ -51,7 +54,11 @@ public:
   const char *thread_name;
   int fps = MAIN_FPS;
   VisionStreamType stream_type;
+  // encoded from this stream when camerad doesn't have stream_type, sharing the thread of the cameras on it
+  VisionStreamType fallback_stream_type = VISION_STREAM_MAX;
   std::vector<EncoderInfo> encoder_infos;
+  // what to give up first when the encoders fall behind camerad
+  cereal::EncoderStats::DropPolicy drop_policy = cereal::EncoderStats::DropPolicy::DROP_OLDEST;
 };
 
 const EncoderInfo main_road_encoder_info = {
@@ -111,8 +118,25 @@ const EncoderInfo qcam_encoder_info = {
 const LogCameraInfo road_camera_info{
   .thread_name = "road_cam_encoder",
   .stream_type = VISION_STREAM_ROAD,
-  .encoder_infos = {main_road_encoder_info, qcam_encoder_info}
+#ifdef QCOM2
+  .encoder_infos = {main_road_encoder_info, qcam_encoder_info},
+#else
+  .encoder_infos = {main_road_encoder_info},
+#endif
+  .drop_policy = cereal::EncoderStats::DropPolicy::SKIP_SECONDARY,
+};
+
+#ifndef QCOM2
+// The software encoder scales qcam itself, from camerad's half resolution road stream it converts
+// and scales a quarter of the pixels. The hardware encoder scales for free but can't take the
+// unaligned pyramid buffers, so qcam stays on the road stream there.
+const LogCameraInfo qcam_camera_info{
+  .thread_name = "qcam_encoder",
+  .stream_type = VISION_STREAM_ROAD_HALF,
+  .fallback_stream_type = VISION_STREAM_ROAD,
+  .encoder_infos = {qcam_encoder_info},
 };
+#endif
 
 const LogCameraInfo wide_road_camera_info{
   .thread_name = "wide_road_cam_encoder",
@@ -144,5 +168,9 @@ const LogCameraInfo stream_driver_camera_info{
   .encoder_infos = {stream_driver_encoder_info}
 };
 
+#ifdef QCOM2
 const LogCameraInfo cameras_logged[] = {road_camera_info, wide_road_camera_info, driver_camera_info};
+#else
+const LogCameraInfo cameras_logged[] = {road_camera_info, wide_road_camera_info, driver_camera_info, qcam_camera_info};
+#endif
 const LogCameraInfo stream_cameras_logged[] = {stream_road_camera_info, stream_wide_road_camera_info, stream_driver_camera_info};
@@ -0,0 +1,241 @@
+// Offline throughput/latency benchmark for encoderd's encoder_thread.
+//
+// Feeds synthetic (or recorded NV12) frames through a local VisionIpcServer into
+// encoder_thread and reports fps, per-frame latency percentiles and process CPU
+// for each encoder configuration. The CPU spent filling the frames is reported on
+// its own and not counted in the encoder CPU. Does not need camerad or any hardware.
+//
+// usage: encoder_benchmark [--frames N] [--fps F] [--nv12 file] [--width W --height H] [config ...]
+//   config: road, qcam, qcam_half, livestream (default: all)
+//   qcam_half encodes qcam from the half resolution road stream, the server's downscale counts as its CPU
+//   --fps 0 runs closed loop: the next frame is sent once the previous one is encoded
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/timing.h"
+#include "common/util.h"
+#include "msgq/visionipc/visionipc_server.h"
+#include "system/loggerd/encoder/encoder_thread.h"
+
+const int YUV_BUFFER_COUNT = 20;
+const int PYRAMID_BUFFER_COUNT = 8;
+
+struct BenchmarkConfig {
+  std::string name;
+  LogCameraInfo cam_info;
+};
+
+struct BenchmarkResult {
+  int frames_sent = 0;
+  int frames_encoded = 0;
+  double wall_s = 0;
+  double cpu_s = 0;
+  double fill_cpu_s = 0;
+  std::vector<double> latency_ms;
+};
+
+static double cpu_seconds() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+}
+
+static double thread_cpu_seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill_synthetic_frame(VisionBuf *buf, int frame_id) {
+  // moving gradient so consecutive frames are not identical
+  for (int y = 0; y < buf->height; ++y) {
+    uint8_t *row = buf->y + y * buf->stride;
+    for (int x = 0; x < buf->width; ++x) {
+      row[x] = (x + y + frame_id * 4) & 0xff;
+    }
+  }
+  for (int y = 0; y < buf->height / 2; ++y) {
+    memset(buf->uv + y * buf->stride, (y + frame_id) & 0xff, buf->width);
+  }
+}
+
+static void fill_recorded_frame(VisionBuf *buf, const std::string &nv12, int frame_id) {
+  const size_t frame_size = buf->width * buf->height * 3 / 2;
+  const size_t frame_cnt = nv12.size() / frame_size;
+  const char *src = nv12.data() + (frame_id % frame_cnt) * frame_size;
+  for (int y = 0; y < buf->height; ++y) {
+    memcpy(buf->y + y * buf->stride, src + y * buf->width, buf->width);
+  }
+  src += buf->width * buf->height;
+  for (int y = 0; y < buf->height / 2; ++y) {
+    memcpy(buf->uv + y * buf->stride, src + y * buf->width, buf->width);
+  }
+}
+
+BenchmarkResult run_benchmark(const BenchmarkConfig &cfg, int width, int height, int frames, double fps, const std::string &nv12) {
+  ExitHandler do_exit;
+  do_exit = false;
+
+  // frames are sent on the road stream, the half resolution level is only computed while a config reads it
+  VisionIpcServer server("camerad");
+  server.create_buffers(VISION_STREAM_ROAD, YUV_BUFFER_COUNT, width, height);
+  server.create_pyramid(VISION_STREAM_ROAD, 1, PYRAMID_BUFFER_COUNT);
+  server.start_listener();
+
+  // latency is measured on the first (main) encoder of the configuration
+  const char *publish_name = cfg.cam_info.encoder_infos[0].publish_name;
+  std::unique_ptr<Context> ctx(Context::create());
+  std::unique_ptr<SubSocket> sock(SubSocket::create(ctx.get(), publish_name));
+  assert(sock != nullptr);
+  sock->setTimeout(100);
+
+  EncoderdState s;
+  s.max_waiting = 1;
+  std::thread encoder(encoder_thread, &s, cfg.cam_info);
+
+  std::unique_ptr<std::atomic<uint64_t>[]> sent_ns(new std::atomic<uint64_t>[frames]());
+  BenchmarkResult result;
+  std::atomic<int> encoded = 0;
+  std::thread receiver([&]() {
+    AlignedBuffer aligned_buf;
+    while (!do_exit) {
+      std::unique_ptr<Message> msg(sock->receive());
+      if (!msg) continue;
+
+      const uint64_t now = nanos_since_boot();
+      capnp::FlatArrayMessageReader reader(aligned_buf.align(msg.get()));
+      auto event = reader.getRoot<cereal::Event>();
+      auto edata = (event.*(cfg.cam_info.encoder_infos[0].get_encode_data_func))();
+      const uint32_t frame_id = edata.getIdx().getFrameId();
+      if (frame_id < frames && sent_ns[frame_id] > 0) {
+        result.latency_ms.push_back((now - sent_ns[frame_id]) * 1e-6);
+      }
+      ++encoded;
+    }
+  });
+
+  // wait for encoder_thread to connect before starting the clock
+  util::sleep_for(500);
+
+  const double t_start = millis_since_boot();
+  const double cpu_start = cpu_seconds();
+  for (int i = 0; i < frames && !do_exit; ++i) {
+    VisionBuf *buf = server.get_buffer(VISION_STREAM_ROAD);
+    // the fill stands in for camerad, its CPU is counted apart from the encoder's
+    const double fill_start = thread_cpu_seconds();
+    if (nv12.empty()) {
+      fill_synthetic_frame(buf, i);
+    } else {
+      fill_recorded_frame(buf, nv12, i);
+    }
+    result.fill_cpu_s += thread_cpu_seconds() - fill_start;
+
+    VisionIpcBufExtra extra = {
+      .frame_id = (uint32_t)i,
+      .timestamp_sof = nanos_since_boot(),
+      .timestamp_eof = nanos_since_boot(),
+      .valid = true,
+    };
+    buf->set_frame_id(i);
+    sent_ns[i] = nanos_since_boot();
+    server.send(buf, &extra);
+    ++result.frames_sent;
+
+    if (fps > 0) {
+      const double next = t_start + (i + 1) * 1000.0 / fps;
+      const double now = millis_since_boot();
+      if (next > now) util::sleep_for(next - now);
+    } else {
+      // closed loop: wait for this frame to come out of the encoder
+      const double deadline = millis_since_boot() + 1000;
+      while (encoded <= i && millis_since_boot() < deadline) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  // give the encoder a moment to finish the queued frames
+  const double drain_deadline = millis_since_boot() + 1000;
+  while (encoded < result.frames_sent && millis_since_boot() < drain_deadline) {
+    util::sleep_for(1);
+  }
+  result.wall_s = (millis_since_boot() - t_start) / 1000.0;
+  result.cpu_s = cpu_seconds() - cpu_start - result.fill_cpu_s;
+
+  do_exit = true;
+  encoder.join();
+  receiver.join();
+
+  result.frames_encoded = encoded;
+  return result;
+}
+
+static double percentile(std::vector<double> &v, double p) {
+  if (v.empty()) return 0;
+  size_t idx = std::min(v.size() - 1, (size_t)(p / 100.0 * v.size()));
+  std::nth_element(v.begin(), v.begin() + idx, v.end());
+  return v[idx];
+}
+
+int main(int argc, char *argv[]) {
+  int frames = 600;
+  double fps = MAIN_FPS;
+  int width = 1928, height = 1208;
+  std::string nv12_path, nv12;
+  std::vector<std::string> selected;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--frames" && i + 1 < argc) {
+      frames = atoi(argv[++i]);
+    } else if (arg == "--fps" && i + 1 < argc) {
+      fps = atof(argv[++i]);
+    } else if (arg == "--width" && i + 1 < argc) {
+      width = atoi(argv[++i]);
+    } else if (arg == "--height" && i + 1 < argc) {
+      height = atoi(argv[++i]);
+    } else if (arg == "--nv12" && i + 1 < argc) {
+      nv12_path = argv[++i];
+    } else {
+      selected.push_back(arg);
+    }
+  }
+
+  // after all arguments, --width and --height may come after --nv12
+  if (!nv12_path.empty()) {
+    nv12 = util::read_file(nv12_path);
+    if (nv12.size() < (size_t)width * height * 3 / 2) {
+      fprintf(stderr, "%s does not contain a full %dx%d NV12 frame\n", nv12_path.c_str(), width, height);
+      return 1;
+    }
+  }
+
+  const std::vector<BenchmarkConfig> configs = {
+    {"road", {.thread_name = "road_cam_encoder", .stream_type = VISION_STREAM_ROAD, .encoder_infos = {main_road_encoder_info}}},
+    {"qcam", {.thread_name = "road_cam_encoder", .stream_type = VISION_STREAM_ROAD, .encoder_infos = {qcam_encoder_info}}},
+#ifndef QCOM2
+    {"qcam_half", qcam_camera_info},
+#endif
+    {"livestream", {.thread_name = "road_cam_encoder", .stream_type = VISION_STREAM_ROAD, .encoder_infos = {stream_road_encoder_info}}},
+  };
+
+  printf("%-12s %8s %8s %8s %10s %10s %10s %8s %8s\n", "config", "sent", "encoded", "fps", "p50 (ms)", "p90 (ms)", "p99 (ms)", "cpu %", "fill %");
+  for (const auto &cfg : configs) {
+    if (!selected.empty() && std::find(selected.begin(), selected.end(), cfg.name) == selected.end()) continue;
+
+    auto r = run_benchmark(cfg, width, height, frames, fps, nv12);
+    printf("%-12s %8d %8d %8.1f %10.2f %10.2f %10.2f %8.1f %8.1f\n", cfg.name.c_str(), r.frames_sent, r.frames_encoded,
+           r.frames_encoded / r.wall_s, percentile(r.latency_ms, 50), percentile(r.latency_ms, 90),
+           percentile(r.latency_ms, 99), 100.0 * r.cpu_s / r.wall_s, 100.0 * r.fill_cpu_s / r.wall_s);
+  }
+  return 0;
+}
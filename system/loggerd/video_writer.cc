@@ -1,11 +1,44 @@
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <mutex>
+#include <vector>
 
 #include "system/loggerd/video_writer.h"
 #include "common/swaglog.h"
+#include "common/timing.h"
 #include "common/util.h"
 
-VideoWriter::VideoWriter(const char *path, const char *filename, bool remuxing, int width, int height, int fps, cereal::EncodeIndex::Type codec)
+// large enough to batch several packets of the main encoders per write, a multiple of the fs block size
+constexpr size_t RAW_CHUNK_SIZE = 1024 * 1024;
+// a full chunk is ~0.8 s of the main encoders, this bounds what a crash loses
+constexpr double RAW_CHUNK_MAX_AGE_MS = 200;
+
+// chunk buffers are handed back on close so segment rotation doesn't reallocate them
+static std::mutex chunk_pool_lock;
+static std::vector<std::unique_ptr<uint8_t[]>> chunk_pool;
+
+static std::unique_ptr<uint8_t[]> get_chunk() {
+  std::lock_guard lk(chunk_pool_lock);
+  if (chunk_pool.empty()) {
+    return std::make_unique<uint8_t[]>(RAW_CHUNK_SIZE);
+  }
+  auto chunk = std::move(chunk_pool.back());
+  chunk_pool.pop_back();
+  return chunk;
+}
+
+static void put_chunk(std::unique_ptr<uint8_t[]> chunk) {
+  std::lock_guard lk(chunk_pool_lock);
+  chunk_pool.push_back(std::move(chunk));
+}
+
+VideoWriter::VideoWriter(const char *path, const char *filename, bool remuxing, int width, int height, int fps, cereal::EncodeIndex::Type codec,
+                         size_t expected_size)
   : remuxing(remuxing) {
   vid_path = util::string_format("%s/%s", path, filename);
   lock_path = util::string_format("%s/%s.lock", path, filename);
@@ -45,16 +78,50 @@ VideoWriter::VideoWriter(const char *path, const char *filename, bool remuxing,
     assert(err >= 0);
 
   } else {
-    this->of = util::safe_fopen(this->vid_path.c_str(), "wb");
-    assert(this->of);
+    this->fd = HANDLE_EINTR(open(this->vid_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0664));
+    assert(this->fd >= 0);
+#ifdef __linux__
+    // reserve the whole segment up front to keep the file contiguous, the unused tail is released on close
+    if (expected_size > 0 && fallocate(this->fd, FALLOC_FL_KEEP_SIZE, 0, expected_size) != 0) {
+      LOGW("fallocate %s failed errno=%d", this->vid_path.c_str(), errno);
+    }
+#endif
+    this->chunk = get_chunk();
   }
 }
 
-void VideoWriter::write(uint8_t *data, int len, long long timestamp, bool codecconfig, bool keyframe) {
-  if (of && data) {
-    size_t written = util::safe_fwrite(data, 1, len, of);
-    if (written != len) {
+void VideoWriter::flush_chunk() {
+  size_t done = 0;
+  while (done < chunk_used) {
+    ssize_t ret = HANDLE_EINTR(::write(fd, chunk.get() + done, chunk_used - done));
+    if (ret <= 0) {
       LOGE("failed to write file.errno=%d", errno);
+      break;
+    }
+    done += ret;
+  }
+  bytes_written += done;
+  chunk_used = 0;
+}
+
+void VideoWriter::write(uint8_t *data, int len, long long timestamp, bool codecconfig, bool keyframe) {
+  if (fd >= 0 && data) {
+    if (chunk_used == 0) {
+      chunk_start_ms = millis_since_boot();
+    }
+    size_t remaining = len;
+    while (remaining > 0) {
+      size_t n = std::min(remaining, RAW_CHUNK_SIZE - chunk_used);
+      memcpy(chunk.get() + chunk_used, data + (len - remaining), n);
+      chunk_used += n;
+      remaining -= n;
+      if (chunk_used == RAW_CHUNK_SIZE) {
+        flush_chunk();
+        chunk_start_ms = millis_since_boot();
+      }
+    }
+    if (chunk_used > 0 && millis_since_boot() - chunk_start_ms >= RAW_CHUNK_MAX_AGE_MS) {
+      flush_chunk();
     }
   }
 
@@ -104,9 +171,14 @@ VideoWriter::~VideoWriter() {
     if (err != 0) LOGE("avio_closep failed %d", err);
     avformat_free_context(this->ofmt_ctx);
   } else {
-    util::safe_fflush(this->of);
-    fclose(this->of);
-    this->of = nullptr;
+    flush_chunk();
+    // drop the preallocated blocks that weren't used
+    if (HANDLE_EINTR(ftruncate(this->fd, this->bytes_written)) != 0) {
+      LOGE("ftruncate %s failed errno=%d", this->vid_path.c_str(), errno);
+    }
+    close(this->fd);
+    this->fd = -1;
+    put_chunk(std::move(this->chunk));
   }
   unlink(this->lock_path.c_str());
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 
 extern "C" {
@@ -11,12 +12,22 @@ extern "C" {
 
 class VideoWriter {
 public:
-  VideoWriter(const char *path, const char *filename, bool remuxing, int width, int height, int fps, cereal::EncodeIndex::Type codec);
+  VideoWriter(const char *path, const char *filename, bool remuxing, int width, int height, int fps, cereal::EncodeIndex::Type codec,
+              size_t expected_size = 0);
   void write(uint8_t *data, int len, long long timestamp, bool codecconfig, bool keyframe);
   ~VideoWriter();
 private:
+  void flush_chunk();
+
   std::string vid_path, lock_path;
-  FILE *of = nullptr;
+
+  // raw bitstream path: packets are collected into an aligned chunk and written with one write() per chunk,
+  // or once the oldest packet in it is RAW_CHUNK_MAX_AGE_MS old
+  int fd = -1;
+  std::unique_ptr<uint8_t[]> chunk;
+  size_t chunk_used = 0;
+  double chunk_start_ms = 0;
+  size_t bytes_written = 0;
 
   AVCodecContext *codec_ctx;
   AVFormatContext *ofmt_ctx;
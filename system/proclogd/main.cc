@@ -1,6 +1,8 @@
 
 #include <sys/resource.h>
 
+#include <cstdlib>
+
 #include "common/ratekeeper.h"
 #include "common/util.h"
 #include "system/proclogd/proclog.h"
@@ -9,15 +11,33 @@ ExitHandler do_exit;
 
 int main(int argc, char **argv) {
   setpriority(PRIO_PROCESS, 0, -15);
+  // three fds are kept per thread of the managed processes
+  util::set_file_descriptor_limit(4096);
 
   RateKeeper rk("proclogd", 0.5);
-  PubMaster publisher({"procLog"});
+  PubMaster publisher({"procLog", "processTimings"});
+  SubMaster sm({"managerState"});
+  // only the processes that changed, for consumers that keep the last state of each pid
+  ProcLog proclog(getenv("PROCLOG_DELTAS") != nullptr);
 
   while (!do_exit) {
+    sm.update(0);
+    if (sm.updated("managerState")) {
+      std::vector<int> pids;
+      for (auto p : sm["managerState"].getManagerState().getProcesses()) {
+        if (p.getRunning()) pids.push_back(p.getPid());
+      }
+      proclog.trackThreads(pids);
+    }
+
     MessageBuilder msg;
-    buildProcLogMessage(msg);
+    proclog.build(msg);
     publisher.send("procLog", msg);
 
+    MessageBuilder timings_msg;
+    buildProcessTimingsMessage(timings_msg);
+    publisher.send("processTimings", timings_msg);
+
     rk.keepTime();
   }
 
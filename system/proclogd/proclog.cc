@@ -1,48 +1,97 @@
 #include "system/proclogd/proclog.h"
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
-#include <fstream>
+#include <charconv>
+#include <cstring>
+#include <istream>
 #include <iterator>
-#include <sstream>
 
+#include "common/ratekeeper.h"
 #include "common/swaglog.h"
 #include "common/util.h"
 
+namespace {
+
+// next line of buf, false at the end
+bool next_line(std::string_view &buf, std::string_view &line) {
+  if (buf.empty()) return false;
+  size_t eol = buf.find('\n');
+  line = buf.substr(0, eol);
+  buf.remove_prefix(eol == std::string_view::npos ? buf.size() : eol + 1);
+  return true;
+}
+
+// next whitespace separated token of s, empty at the end
+std::string_view next_token(std::string_view &s) {
+  size_t start = s.find_first_not_of(" \t\n");
+  if (start == std::string_view::npos) {
+    s = {};
+    return {};
+  }
+  size_t end = s.find_first_of(" \t\n", start);
+  std::string_view token = s.substr(start, end - start);
+  s.remove_prefix(end == std::string_view::npos ? s.size() : end);
+  return token;
+}
+
+template <typename T>
+bool to_number(std::string_view s, T &value) {
+  auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+  return !s.empty() && ec == std::errc() && ptr == s.data() + s.size();
+}
+
+}  // namespace
+
 namespace Parser {
 
 // parse /proc/stat
-std::vector<CPUTime> cpuTimes(std::istream &stream) {
+std::vector<CPUTime> cpuTimes(std::string_view buf) {
   std::vector<CPUTime> cpu_times;
-  std::string line;
+  std::string_view line;
   // skip the first line for cpu total
-  std::getline(stream, line);
-  while (std::getline(stream, line)) {
+  next_line(buf, line);
+  while (next_line(buf, line)) {
     if (line.compare(0, 3, "cpu") != 0) break;
 
     CPUTime t = {};
-    std::istringstream iss(line);
-    if (iss.ignore(3) >> t.id >> t.utime >> t.ntime >> t.stime >> t.itime >> t.iowtime >> t.irqtime >> t.sirqtime)
+    line.remove_prefix(3);
+    if (to_number(next_token(line), t.id) && to_number(next_token(line), t.utime) &&
+        to_number(next_token(line), t.ntime) && to_number(next_token(line), t.stime) &&
+        to_number(next_token(line), t.itime) && to_number(next_token(line), t.iowtime) &&
+        to_number(next_token(line), t.irqtime) && to_number(next_token(line), t.sirqtime)) {
       cpu_times.push_back(t);
+    }
   }
   return cpu_times;
 }
 
+std::vector<CPUTime> cpuTimes(std::istream &stream) {
+  return cpuTimes(std::string(std::istreambuf_iterator<char>(stream), {}));
+}
+
 // parse /proc/meminfo
-std::unordered_map<std::string, uint64_t> memInfo(std::istream &stream) {
+std::unordered_map<std::string, uint64_t> memInfo(std::string_view buf) {
   std::unordered_map<std::string, uint64_t> mem_info;
-  std::string line, key;
-  while (std::getline(stream, line)) {
+  std::string_view line;
+  while (next_line(buf, line)) {
     uint64_t val = 0;
-    std::istringstream iss(line);
-    if (iss >> key >> val) {
-      mem_info[key] = val * 1024;
+    std::string_view key = next_token(line);
+    if (!key.empty() && to_number(next_token(line), val)) {
+      mem_info[std::string(key)] = val * 1024;
     }
   }
   return mem_info;
 }
 
+std::unordered_map<std::string, uint64_t> memInfo(std::istream &stream) {
+  return memInfo(std::string(std::istreambuf_iterator<char>(stream), {}));
+}
+
 // field position (https://man7.org/linux/man-pages/man5/proc.5.html)
 enum StatPos {
   pid = 1,
@@ -63,50 +112,79 @@ enum StatPos {
 };
 
 // parse /proc/pid/stat
-std::optional<ProcStat> procStat(std::string stat) {
+std::optional<ProcStat> procStat(std::string_view stat) {
   // To avoid being fooled by names containing a closing paren, scan backwards.
   auto open_paren = stat.find('(');
   auto close_paren = stat.rfind(')');
-  if (open_paren == std::string::npos || close_paren == std::string::npos || open_paren > close_paren) {
+  if (open_paren == std::string_view::npos || close_paren == std::string_view::npos || open_paren > close_paren) {
     return std::nullopt;
   }
 
-  std::string name = stat.substr(open_paren + 1, close_paren - open_paren - 1);
-  // replace space in name with _
-  std::replace(&stat[open_paren], &stat[close_paren], ' ', '_');
-  std::istringstream iss(stat);
-  std::vector<std::string> v{std::istream_iterator<std::string>(iss),
-                             std::istream_iterator<std::string>()};
-  try {
-    if (v.size() != StatPos::MAX_FIELD) {
-      throw std::invalid_argument("stat");
-    }
-    ProcStat p = {
-      .name = name,
-      .pid = stoi(v[StatPos::pid - 1]),
-      .state = v[StatPos::state - 1][0],
-      .ppid = stoi(v[StatPos::ppid - 1]),
-      .utime = stoul(v[StatPos::utime - 1]),
-      .stime = stoul(v[StatPos::stime - 1]),
-      .cutime = stol(v[StatPos::cutime - 1]),
-      .cstime = stol(v[StatPos::cstime - 1]),
-      .priority = stol(v[StatPos::priority - 1]),
-      .nice = stol(v[StatPos::nice - 1]),
-      .num_threads = stol(v[StatPos::num_threads - 1]),
-      .starttime = stoull(v[StatPos::starttime - 1]),
-      .vms = stoul(v[StatPos::vsize - 1]),
-      .rss = stol(v[StatPos::rss - 1]),
-      .processor = stoi(v[StatPos::processor - 1]),
-    };
-    return p;
-  } catch (const std::invalid_argument &e) {
-    LOGE("failed to parse procStat (%s) :%s", e.what(), stat.c_str());
-  } catch (const std::out_of_range &e) {
-    LOGE("failed to parse procStat (%s) :%s", e.what(), stat.c_str());
+  // the fields after the name, from state on
+  std::string_view fields[StatPos::MAX_FIELD - StatPos::state + 1];
+  std::string_view rest = stat.substr(close_paren + 1);
+  size_t num_fields = 0;
+  for (auto token = next_token(rest); !token.empty(); token = next_token(rest)) {
+    if (num_fields == std::size(fields)) {
+      num_fields++;
+      break;
+    }
+    fields[num_fields++] = token;
+  }
+  auto field = [&fields](StatPos pos) { return fields[pos - StatPos::state]; };
+
+  ProcStat p = {};
+  std::string_view head = stat.substr(0, open_paren);
+  bool ok = num_fields == std::size(fields) &&
+            to_number(next_token(head), p.pid) &&
+            to_number(field(StatPos::ppid), p.ppid) &&
+            to_number(field(StatPos::utime), p.utime) &&
+            to_number(field(StatPos::stime), p.stime) &&
+            to_number(field(StatPos::cutime), p.cutime) &&
+            to_number(field(StatPos::cstime), p.cstime) &&
+            to_number(field(StatPos::priority), p.priority) &&
+            to_number(field(StatPos::nice), p.nice) &&
+            to_number(field(StatPos::num_threads), p.num_threads) &&
+            to_number(field(StatPos::starttime), p.starttime) &&
+            to_number(field(StatPos::vsize), p.vms) &&
+            to_number(field(StatPos::rss), p.rss) &&
+            to_number(field(StatPos::processor), p.processor);
+  if (!ok) {
+    LOGE("failed to parse procStat :%.*s", (int)stat.size(), stat.data());
+    return std::nullopt;
+  }
+  p.state = field(StatPos::state)[0];
+  p.name = stat.substr(open_paren + 1, close_paren - open_paren - 1);
+  return p;
+}
+
+// parse /proc/<pid>/task/<tid>/schedstat
+std::optional<SchedStat> schedStat(std::string_view buf) {
+  SchedStat s = {};
+  if (to_number(next_token(buf), s.run_time) && to_number(next_token(buf), s.run_delay) &&
+      to_number(next_token(buf), s.timeslices)) {
+    return s;
   }
   return std::nullopt;
 }
 
+// context switches from /proc/<pid>/task/<tid>/status
+std::optional<CtxtSwitches> ctxtSwitches(std::string_view status) {
+  CtxtSwitches c = {};
+  bool voluntary = false, nonvoluntary = false;
+  std::string_view line;
+  while (next_line(status, line)) {
+    std::string_view key = next_token(line);
+    if (key == "voluntary_ctxt_switches:") {
+      voluntary = to_number(next_token(line), c.voluntary);
+    } else if (key == "nonvoluntary_ctxt_switches:") {
+      nonvoluntary = to_number(next_token(line), c.nonvoluntary);
+    }
+  }
+  if (!voluntary || !nonvoluntary) return std::nullopt;
+  return c;
+}
+
 // return list of PIDs from /proc
 std::vector<int> pids() {
   std::vector<int> ids;
@@ -127,29 +205,20 @@ std::vector<int> pids() {
 }
 
 // null-delimited cmdline arguments to vector
-std::vector<std::string> cmdline(std::istream &stream) {
+std::vector<std::string> cmdline(std::string_view buf) {
   std::vector<std::string> ret;
-  std::string line;
-  while (std::getline(stream, line, '\0')) {
-    if (!line.empty()) {
-      ret.push_back(line);
+  while (!buf.empty()) {
+    size_t end = buf.find('\0');
+    if (end != 0) {
+      ret.emplace_back(buf.substr(0, end));
     }
+    buf.remove_prefix(end == std::string_view::npos ? buf.size() : end + 1);
   }
   return ret;
 }
 
-const ProcCache &getProcExtraInfo(int pid, const std::string &name) {
-  static std::unordered_map<pid_t, ProcCache> proc_cache;
-  ProcCache &cache = proc_cache[pid];
-  if (cache.pid != pid || cache.name != name) {
-    cache.pid = pid;
-    cache.name = name;
-    std::string proc_path = "/proc/" + std::to_string(pid);
-    cache.exe = util::readlink(proc_path + "/exe");
-    std::ifstream stream(proc_path + "/cmdline");
-    cache.cmdline = cmdline(stream);
-  }
-  return cache;
+std::vector<std::string> cmdline(std::istream &stream) {
+  return cmdline(std::string(std::istreambuf_iterator<char>(stream), {}));
 }
 
 }  // namespace Parser
@@ -157,9 +226,200 @@ const ProcCache &getProcExtraInfo(int pid, const std::string &name) {
 const double jiffy = sysconf(_SC_CLK_TCK);
 const size_t page_size = sysconf(_SC_PAGE_SIZE);
 
-void buildCPUTimes(cereal::ProcLog::Builder &builder) {
-  std::ifstream stream("/proc/stat");
-  std::vector<CPUTime> stats = Parser::cpuTimes(stream);
+ProcLog::ProcLog(bool deltas, int full_interval) : deltas(deltas), full_interval(full_interval) {
+  proc_dir = opendir("/proc");
+  assert(proc_dir);
+  stat_fd = HANDLE_EINTR(open("/proc/stat", O_RDONLY | O_CLOEXEC));
+  meminfo_fd = HANDLE_EINTR(open("/proc/meminfo", O_RDONLY | O_CLOEXEC));
+  buf.resize(4096);
+}
+
+ProcLog::~ProcLog() {
+  procs.clear();
+  if (stat_fd >= 0) close(stat_fd);
+  if (meminfo_fd >= 0) close(meminfo_fd);
+  closedir(proc_dir);
+}
+
+ProcLog::Proc::~Proc() {
+  if (stat_fd >= 0) close(stat_fd);
+  if (task_dir) closedir(task_dir);
+}
+
+ProcLog::Thread::~Thread() {
+  for (int fd : {stat_fd, schedstat_fd, status_fd}) {
+    if (fd >= 0) close(fd);
+  }
+}
+
+void ProcLog::trackThreads(const std::vector<int> &pids) {
+  thread_pids = std::unordered_set<int>(pids.begin(), pids.end());
+}
+
+// The whole file from the start, valid until the next read. A short read is the end of a
+// /proc file, so small files take a single pread.
+std::optional<std::string_view> ProcLog::read(int fd) {
+  if (fd < 0) return std::nullopt;
+
+  size_t len = 0;
+  while (true) {
+    if (len == buf.size()) {
+      buf.resize(buf.size() * 2);
+    }
+    ssize_t n = HANDLE_EINTR(pread(fd, &buf[len], buf.size() - len, len));
+    if (n < 0) return std::nullopt;
+    len += n;
+    if (len < buf.size()) break;
+  }
+  if (len == 0) return std::nullopt;
+  return std::string_view(buf.data(), len);
+}
+
+// Reads path relative to dir_fd through fd, which is opened on first use and then kept. Without
+// a free fd it is opened again on the next read.
+std::optional<std::string_view> ProcLog::readAt(int dir_fd, const char *path, int &fd) {
+  const bool opened = fd < 0;
+  if (opened) {
+    fd = HANDLE_EINTR(openat(dir_fd, path, O_RDONLY | O_CLOEXEC));
+  }
+  auto data = read(fd);
+  if (!data && !opened) {
+    // the process we had open exited, and its pid was reused
+    close(fd);
+    fd = HANDLE_EINTR(openat(dir_fd, path, O_RDONLY | O_CLOEXEC));
+    data = read(fd);
+  }
+  return data;
+}
+
+static bool same_stat(const ProcStat &a, const ProcStat &b) {
+  return a.state == b.state && a.ppid == b.ppid && a.utime == b.utime && a.stime == b.stime &&
+         a.cutime == b.cutime && a.cstime == b.cstime && a.priority == b.priority && a.nice == b.nice &&
+         a.num_threads == b.num_threads && a.vms == b.vms && a.rss == b.rss &&
+         a.processor == b.processor && a.name == b.name;
+}
+
+// reads the threads of a process, true if any of them changed
+bool ProcLog::updateThreads(int pid, Proc &p) {
+  if (!p.task_dir) {
+    char path[32];
+    snprintf(path, sizeof(path), "%d/task", pid);
+    int fd = HANDLE_EINTR(openat(dirfd(proc_dir), path, O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (fd < 0 || !(p.task_dir = fdopendir(fd))) {
+      if (fd >= 0) close(fd);
+      p.threads.clear();
+      return false;
+    }
+  }
+
+  const uint64_t seen = p.seen;
+  rewinddir(p.task_dir);
+  struct dirent *de = NULL;
+  while ((de = readdir(p.task_dir))) {
+    int tid = 0;
+    if (de->d_type == DT_DIR && to_number(de->d_name, tid)) {
+      p.threads[tid].seen = seen;
+    }
+  }
+
+  bool changed = false;
+  const int task_fd = dirfd(p.task_dir);
+  for (auto it = p.threads.begin(); it != p.threads.end();) {
+    Thread &t = it->second;
+    char path[32];
+    std::optional<ProcStat> stat;
+    std::optional<SchedStat> sched;
+    std::optional<CtxtSwitches> ctxt;
+    if (t.seen == seen) {
+      snprintf(path, sizeof(path), "%d/stat", it->first);
+      auto data = readAt(task_fd, path, t.stat_fd);
+      stat = data ? Parser::procStat(*data) : std::nullopt;
+    }
+    if (stat) {
+      snprintf(path, sizeof(path), "%d/schedstat", it->first);
+      auto data = readAt(task_fd, path, t.schedstat_fd);
+      sched = data ? Parser::schedStat(*data) : std::nullopt;
+    }
+    if (sched) {
+      snprintf(path, sizeof(path), "%d/status", it->first);
+      auto data = readAt(task_fd, path, t.status_fd);
+      ctxt = data ? Parser::ctxtSwitches(*data) : std::nullopt;
+    }
+    if (!ctxt) {
+      it = p.threads.erase(it);
+      changed = true;
+      continue;
+    }
+
+    changed |= !same_stat(t.stat, *stat) || t.sched.run_time != sched->run_time || t.sched.run_delay != sched->run_delay;
+    t.stat = std::move(*stat);
+    t.sched = *sched;
+    t.ctxt = *ctxt;
+    ++it;
+  }
+  return changed;
+}
+
+void ProcLog::update() {
+  sample++;
+
+  // new processes
+  rewinddir(proc_dir);
+  struct dirent *de = NULL;
+  while ((de = readdir(proc_dir))) {
+    int pid = 0;
+    if (de->d_type == DT_DIR && to_number(de->d_name, pid)) {
+      procs[pid].seen = sample;
+    }
+  }
+
+  // read the processes, and forget the ones that exited
+  for (auto it = procs.begin(); it != procs.end();) {
+    const int pid = it->first;
+    Proc &p = it->second;
+    std::optional<ProcStat> stat;
+    if (p.seen == sample) {
+      char path[32];
+      snprintf(path, sizeof(path), "%d/stat", pid);
+      auto data = readAt(dirfd(proc_dir), path, p.stat_fd);
+      stat = data ? Parser::procStat(*data) : std::nullopt;
+    }
+    if (!stat) {
+      if (p.cache.pid == pid) removed.push_back(pid);
+      it = procs.erase(it);
+      continue;
+    }
+
+    p.changed = p.cache.pid != pid || !same_stat(p.stat, *stat);
+    p.stat = std::move(*stat);
+
+    // exec changes the name
+    if (p.cache.pid != pid || p.cache_starttime != p.stat.starttime || p.cache.name != p.stat.name) {
+      std::string proc_path = "/proc/" + std::to_string(pid);
+      p.cache.pid = pid;
+      p.cache.name = p.stat.name;
+      p.cache.exe = util::readlink(proc_path + "/exe");
+      p.cache.cmdline = Parser::cmdline(util::read_file(proc_path + "/cmdline"));
+      p.cache_starttime = p.stat.starttime;
+    }
+
+    p.track_threads = thread_pids.count(pid) > 0;
+    if (p.track_threads) {
+      p.changed |= updateThreads(pid, p);
+    } else if (p.task_dir) {
+      closedir(p.task_dir);
+      p.task_dir = nullptr;
+      p.threads.clear();
+    }
+    ++it;
+  }
+}
+
+void ProcLog::buildCPUTimes(cereal::ProcLog::Builder &builder) {
+  std::vector<CPUTime> stats;
+  if (auto data = read(stat_fd)) {
+    stats = Parser::cpuTimes(*data);
+  }
 
   auto log_cpu_times = builder.initCpuTimes(stats.size());
   for (int i = 0; i < stats.size(); ++i) {
@@ -176,9 +436,11 @@ void buildCPUTimes(cereal::ProcLog::Builder &builder) {
   }
 }
 
-void buildMemInfo(cereal::ProcLog::Builder &builder) {
-  std::ifstream stream("/proc/meminfo");
-  auto mem_info = Parser::memInfo(stream);
+void ProcLog::buildMemInfo(cereal::ProcLog::Builder &builder) {
+  std::unordered_map<std::string, uint64_t> mem_info;
+  if (auto data = read(meminfo_fd)) {
+    mem_info = Parser::memInfo(*data);
+  }
 
   auto mem = builder.initMem();
   mem.setTotal(mem_info["MemTotal:"]);
@@ -191,21 +453,21 @@ void buildMemInfo(cereal::ProcLog::Builder &builder) {
   mem.setShared(mem_info["Shmem:"]);
 }
 
-void buildProcs(cereal::ProcLog::Builder &builder) {
-  auto pids = Parser::pids();
-  std::vector<ProcStat> proc_stats;
-  proc_stats.reserve(pids.size());
-  for (int pid : pids) {
-    std::string path = "/proc/" + std::to_string(pid) + "/stat";
-    if (auto stat = Parser::procStat(util::read_file(path))) {
-      proc_stats.push_back(*stat);
-    }
+void ProcLog::buildProcs(cereal::ProcLog::Builder &builder, bool full) {
+  update();
+
+  size_t count = 0;
+  for (auto &[pid, p] : procs) {
+    count += full || p.changed;
   }
 
-  auto procs = builder.initProcs(proc_stats.size());
-  for (size_t i = 0; i < proc_stats.size(); i++) {
-    auto l = procs[i];
-    const ProcStat &r = proc_stats[i];
+  auto log_procs = builder.initProcs(count);
+  size_t i = 0;
+  for (auto &[pid, p] : procs) {
+    if (!full && !p.changed) continue;
+
+    auto l = log_procs[i++];
+    const ProcStat &r = p.stat;
     l.setPid(r.pid);
     l.setState(r.state);
     l.setPpid(r.ppid);
@@ -222,18 +484,70 @@ void buildProcs(cereal::ProcLog::Builder &builder) {
     l.setProcessor(r.processor);
     l.setName(r.name);
 
-    const ProcCache &extra_info = Parser::getProcExtraInfo(r.pid, r.name);
-    l.setExe(extra_info.exe);
-    auto lcmdline = l.initCmdline(extra_info.cmdline.size());
+    l.setExe(p.cache.exe);
+    auto lcmdline = l.initCmdline(p.cache.cmdline.size());
     for (size_t j = 0; j < lcmdline.size(); j++) {
-      lcmdline.set(j, extra_info.cmdline[j]);
+      lcmdline.set(j, p.cache.cmdline[j]);
+    }
+
+    if (p.track_threads) {
+      auto lthreads = l.initThreads(p.threads.size());
+      size_t j = 0;
+      for (auto &[tid, t] : p.threads) {
+        auto lt = lthreads[j++];
+        lt.setTid(tid);
+        lt.setName(t.stat.name);
+        lt.setState(t.stat.state);
+        lt.setProcessor(t.stat.processor);
+        lt.setPriority(t.stat.priority);
+        lt.setNice(t.stat.nice);
+        lt.setCpuUser(t.stat.utime / jiffy);
+        lt.setCpuSystem(t.stat.stime / jiffy);
+        lt.setVoluntaryCtxtSwitches(t.ctxt.voluntary);
+        lt.setNonvoluntaryCtxtSwitches(t.ctxt.nonvoluntary);
+        lt.setRunTime(t.sched.run_time * 1e-9);
+        lt.setRunDelay(t.sched.run_delay * 1e-9);
+        lt.setTimeslices(t.sched.timeslices);
+      }
     }
   }
 }
 
-void buildProcLogMessage(MessageBuilder &msg) {
+void ProcLog::build(MessageBuilder &msg) {
+  const bool full = !deltas || sample % full_interval == 0;
+
   auto procLog = msg.initEvent().initProcLog();
-  buildProcs(procLog);
+  buildProcs(procLog, full);
   buildCPUTimes(procLog);
   buildMemInfo(procLog);
+
+  // a full message has every process, what isn't in it is gone
+  procLog.setIsDelta(!full);
+  if (!full) {
+    procLog.setRemovedPids(kj::arrayPtr(removed.data(), removed.size()));
+  }
+  removed.clear();
+}
+
+void buildProcLogMessage(MessageBuilder &msg) {
+  static ProcLog proclog;
+  proclog.build(msg);
+}
+
+void buildProcessTimingsMessage(MessageBuilder &msg) {
+  auto timings = ratekeeper_timings();
+  auto loops = msg.initEvent().initProcessTimings().initLoops(timings.size());
+  for (size_t i = 0; i < timings.size(); ++i) {
+    auto l = loops[i];
+    const RateKeeperTimings &t = timings[i];
+    l.setName(t.name);
+    l.setPid(t.pid);
+    l.setRate(t.rate);
+    l.setFrames(t.frames);
+    l.setLagged(t.lagged);
+    l.setMaxDurationUs(t.max_duration_us);
+    l.setMaxLatenessUs(t.max_lateness_us);
+    l.setDurationHist(kj::arrayPtr(t.duration_us.data(), t.duration_us.size()));
+    l.setLatenessHist(kj::arrayPtr(t.lateness_us.data(), t.lateness_us.size()));
+  }
 }
@@ -1,6 +1,11 @@
+#include <dirent.h>
+
+#include <map>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "cereal/messaging/messaging.h"
@@ -26,15 +31,96 @@ struct ProcStat {
   std::string name;
 };
 
+// /proc/<pid>/task/<tid>/schedstat, times in ns
+struct SchedStat {
+  unsigned long long run_time, run_delay, timeslices;
+};
+
+struct CtxtSwitches {
+  unsigned long voluntary, nonvoluntary;
+};
+
 namespace Parser {
 
 std::vector<int> pids();
-std::optional<ProcStat> procStat(std::string stat);
+std::optional<ProcStat> procStat(std::string_view stat);
+std::optional<SchedStat> schedStat(std::string_view buf);
+std::optional<CtxtSwitches> ctxtSwitches(std::string_view status);
+std::vector<std::string> cmdline(std::string_view buf);
 std::vector<std::string> cmdline(std::istream &stream);
+std::vector<CPUTime> cpuTimes(std::string_view buf);
 std::vector<CPUTime> cpuTimes(std::istream &stream);
+std::unordered_map<std::string, uint64_t> memInfo(std::string_view buf);
 std::unordered_map<std::string, uint64_t> memInfo(std::istream &stream);
-const ProcCache &getProcExtraInfo(int pid, const std::string &name);
 
 };  // namespace Parser
 
+// Samples /proc for procLog. The files read every sample stay open and are reread with pread,
+// the state of a process is kept until it exits.
+class ProcLog {
+public:
+  // with deltas, only processes that changed since the last message are sent, with isDelta set
+  // and the pids that exited in between. All of them every full_interval messages.
+  ProcLog(bool deltas = false, int full_interval = 30);
+  ~ProcLog();
+  void build(MessageBuilder &msg);
+  // processes whose threads are logged too
+  void trackThreads(const std::vector<int> &pids);
+  size_t size() const { return procs.size(); }
+
+private:
+  struct Thread {
+    Thread() = default;
+    Thread(const Thread &) = delete;
+    ~Thread();
+
+    int stat_fd = -1;
+    int schedstat_fd = -1;
+    int status_fd = -1;
+    uint64_t seen = 0;
+    ProcStat stat = {};
+    SchedStat sched = {};
+    CtxtSwitches ctxt = {};
+  };
+
+  struct Proc {
+    Proc() = default;
+    Proc(const Proc &) = delete;
+    ~Proc();
+
+    int stat_fd = -1;
+    uint64_t seen = 0;
+    bool changed = false;
+    ProcStat stat = {};
+    ProcCache cache = {};
+    unsigned long long cache_starttime = 0;
+
+    bool track_threads = false;
+    DIR *task_dir = nullptr;
+    std::map<int, Thread> threads;
+  };
+
+  std::optional<std::string_view> read(int fd);
+  std::optional<std::string_view> readAt(int dir_fd, const char *path, int &fd);
+  bool updateThreads(int pid, Proc &p);
+  void update();
+  void buildProcs(cereal::ProcLog::Builder &builder, bool full);
+  void buildCPUTimes(cereal::ProcLog::Builder &builder);
+  void buildMemInfo(cereal::ProcLog::Builder &builder);
+
+  bool deltas;
+  int full_interval;
+  uint64_t sample = 0;
+
+  DIR *proc_dir = nullptr;
+  int stat_fd = -1;
+  int meminfo_fd = -1;
+  std::map<int, Proc> procs;
+  std::vector<int> removed;  // sent processes that exited since the last message
+  std::unordered_set<int> thread_pids;
+  std::string buf;
+};
+
 void buildProcLogMessage(MessageBuilder &msg);
+// the loop timings of every RateKeeper, see common/ratekeeper.h
+void buildProcessTimingsMessage(MessageBuilder &msg);
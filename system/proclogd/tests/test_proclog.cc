@@ -1,5 +1,15 @@
 #define CATCH_CONFIG_MAIN
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 #include "catch2/catch.hpp"
+#include "common/ratekeeper.h"
+#include "common/timing.h"
 #include "common/util.h"
 #include "system/proclogd/proclog.h"
 
@@ -94,6 +104,41 @@ TEST_CASE("Parser::memInfo") {
   }
 }
 
+TEST_CASE("Parser::schedStat") {
+  SECTION("from string") {
+    auto sched = Parser::schedStat("2413411580 102456033 1234\n");
+    REQUIRE(sched);
+    REQUIRE(sched->run_time == 2413411580);
+    REQUIRE(sched->run_delay == 102456033);
+    REQUIRE(sched->timeslices == 1234);
+    REQUIRE(!Parser::schedStat("2413411580 102456033\n"));
+  }
+  SECTION("from /proc/self/task") {
+    const double start = millis_since_boot();
+    while (millis_since_boot() - start < 10) {}
+    auto sched = Parser::schedStat(util::read_file("/proc/self/task/" + std::to_string(syscall(SYS_gettid)) + "/schedstat"));
+    REQUIRE(sched);
+    REQUIRE(sched->run_time > 0);
+    REQUIRE(sched->timeslices > 0);
+  }
+}
+
+TEST_CASE("Parser::ctxtSwitches") {
+  SECTION("from string") {
+    auto ctxt = Parser::ctxtSwitches("Name:\tcat\nvoluntary_ctxt_switches:\t12\nnonvoluntary_ctxt_switches:\t3\n");
+    REQUIRE(ctxt);
+    REQUIRE(ctxt->voluntary == 12);
+    REQUIRE(ctxt->nonvoluntary == 3);
+    REQUIRE(!Parser::ctxtSwitches("Name:\tcat\nvoluntary_ctxt_switches:\t12\n"));
+  }
+  SECTION("from /proc/self/task") {
+    util::sleep_for(1);
+    auto ctxt = Parser::ctxtSwitches(util::read_file("/proc/self/task/" + std::to_string(syscall(SYS_gettid)) + "/status"));
+    REQUIRE(ctxt);
+    REQUIRE(ctxt->voluntary > 0);
+  }
+}
+
 void test_cmdline(std::string cmdline, const std::vector<std::string> requires) {
   std::stringstream ss;
   ss.write(&cmdline[0], cmdline.size());
@@ -140,3 +185,160 @@ TEST_CASE("buildProcLoggerMessage") {
     }
   }
 }
+
+static std::optional<cereal::ProcLog::Process::Reader> find_proc(cereal::ProcLog::Reader log, int pid) {
+  for (auto p : log.getProcs()) {
+    if (p.getPid() == pid) return p;
+  }
+  return std::nullopt;
+}
+
+TEST_CASE("ProcLog") {
+  pid_t child = fork();
+  if (child == 0) {
+    execlp("sleep", "sleep", "100", (char *)nullptr);
+    _exit(1);
+  }
+  REQUIRE(child > 0);
+  util::sleep_for(100);
+
+  ProcLog proclog(true, 1000);
+  auto build = [&proclog]() {
+    MessageBuilder msg;
+    proclog.build(msg);
+    return capnp::messageToFlatArray(msg);
+  };
+
+  // the first message has every process
+  auto first_buf = build();
+  capnp::FlatArrayMessageReader first(first_buf);
+  REQUIRE(!first.getRoot<cereal::Event>().getProcLog().getIsDelta());
+  auto proc = find_proc(first.getRoot<cereal::Event>().getProcLog(), child);
+  REQUIRE(proc);
+  REQUIRE(proc->getName() == "sleep");
+  REQUIRE(proc->getCmdline().size() == 2);
+  REQUIRE(proc->getCmdline()[1] == "100");
+
+  // after that only the ones that changed
+  const double start = millis_since_boot();
+  while (millis_since_boot() - start < 50) {}
+  auto delta_buf = build();
+  capnp::FlatArrayMessageReader delta(delta_buf);
+  auto log = delta.getRoot<cereal::Event>().getProcLog();
+  REQUIRE(log.getIsDelta());
+  REQUIRE(log.getProcs().size() < first.getRoot<cereal::Event>().getProcLog().getProcs().size());
+  REQUIRE(find_proc(log, ::getpid()));
+  REQUIRE(!find_proc(log, child));
+
+  // and exited processes are reported once, then forgotten
+  const size_t tracked = proclog.size();
+  kill(child, SIGKILL);
+  waitpid(child, nullptr, 0);
+  auto removed_buf = build();
+  capnp::FlatArrayMessageReader removed(removed_buf);
+  auto removed_pids = removed.getRoot<cereal::Event>().getProcLog().getRemovedPids();
+  REQUIRE(std::count(removed_pids.begin(), removed_pids.end(), child) == 1);
+  REQUIRE(proclog.size() < tracked);
+
+  auto next_buf = build();
+  capnp::FlatArrayMessageReader next(next_buf);
+  auto next_pids = next.getRoot<cereal::Event>().getProcLog().getRemovedPids();
+  REQUIRE(std::count(next_pids.begin(), next_pids.end(), child) == 0);
+}
+
+TEST_CASE("ProcLog threads") {
+  std::atomic<bool> stop = false;
+  std::atomic<pid_t> tid = 0;
+  std::thread worker([&]() {
+    pthread_setname_np(pthread_self(), "proclog_worker");
+    tid = syscall(SYS_gettid);
+    while (!stop) util::sleep_for(1);
+  });
+  while (tid == 0) util::sleep_for(1);
+
+  ProcLog proclog;
+  auto build = [&proclog]() {
+    MessageBuilder msg;
+    proclog.build(msg);
+    return capnp::messageToFlatArray(msg);
+  };
+
+  // threads are only logged for the tracked processes
+  auto untracked_buf = build();
+  capnp::FlatArrayMessageReader untracked(untracked_buf);
+  auto proc = find_proc(untracked.getRoot<cereal::Event>().getProcLog(), ::getpid());
+  REQUIRE(proc);
+  REQUIRE(proc->getThreads().size() == 0);
+
+  proclog.trackThreads({::getpid()});
+  auto tracked_buf = build();
+  capnp::FlatArrayMessageReader tracked(tracked_buf);
+  proc = find_proc(tracked.getRoot<cereal::Event>().getProcLog(), ::getpid());
+  REQUIRE(proc);
+  REQUIRE(proc->getThreads().size() >= 2);
+
+  bool found = false;
+  for (auto t : proc->getThreads()) {
+    REQUIRE(allowed_states.find(t.getState()) != std::string::npos);
+    if (t.getTid() == tid) {
+      found = true;
+      REQUIRE(t.getName() == "proclog_worker");
+      REQUIRE(t.getVoluntaryCtxtSwitches() > 0);
+      REQUIRE(t.getTimeslices() > 0);
+    }
+  }
+  REQUIRE(found);
+
+  stop = true;
+  worker.join();
+}
+
+TEST_CASE("buildProcessTimingsMessage") {
+  {
+    RateKeeper rk("test_proclog_loop", 1000);
+    for (int i = 0; i < 10; ++i) {
+      rk.keepTime();
+    }
+
+    MessageBuilder msg;
+    buildProcessTimingsMessage(msg);
+    kj::Array<capnp::word> buf = capnp::messageToFlatArray(msg);
+    capnp::FlatArrayMessageReader reader(buf);
+    bool found = false;
+    for (auto l : reader.getRoot<cereal::Event>().getProcessTimings().getLoops()) {
+      if (l.getPid() != ::getpid() || l.getName() != "test_proclog_loop") continue;
+      found = true;
+      REQUIRE(l.getRate() == 1000);
+      REQUIRE(l.getFrames() == 10);
+      REQUIRE(l.getDurationHist().size() == RateKeeperStats::BUCKETS);
+      uint64_t frames = 0;
+      for (auto n : l.getLatenessHist()) frames += n;
+      REQUIRE(frames == 10);
+    }
+    REQUIRE(found);
+  }
+
+  // the page goes away with the RateKeeper
+  for (auto &t : ratekeeper_timings()) {
+    REQUIRE(!(t.pid == ::getpid() && t.name == "test_proclog_loop"));
+  }
+}
+
+TEST_CASE("RateKeepers of the same name have their own pages") {
+  auto loops = [] {
+    std::vector<uint64_t> frames;
+    for (auto &t : ratekeeper_timings()) {
+      if (t.pid == ::getpid() && t.name == "test_proclog_twin") frames.push_back(t.frames);
+    }
+    std::sort(frames.begin(), frames.end());
+    return frames;
+  };
+
+  {
+    RateKeeper a("test_proclog_twin", 1000), b("test_proclog_twin", 1000);
+    a.monitorTime();
+    for (int i = 0; i < 3; ++i) b.monitorTime();
+    REQUIRE(loops() == std::vector<uint64_t>{1, 3});
+  }
+  REQUIRE(loops().empty());
+}
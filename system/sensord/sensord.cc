@@ -0,0 +1,142 @@
+#include "system/sensord/sensord.h"
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <poll.h>
+#include <linux/gpio.h>
+
+#include "cereal/services.h"
+#include "cereal/messaging/messaging.h"
+#include "common/ratekeeper.h"
+#include "common/swaglog.h"
+#include "common/timing.h"
+
+ExitHandler do_exit;
+
+void interrupt_loop(std::vector<std::tuple<Sensor *, std::string>> sensors, int timeout_ms) {
+  PubMaster pm({"gyroscope", "accelerometer"});
+
+  int fd = -1;
+  for (auto &[sensor, msg_name] : sensors) {
+    if (sensor->has_interrupt_enabled()) {
+      fd = sensor->gpio_fd;
+      break;
+    }
+  }
+
+  struct pollfd fd_list[1] = {0};
+  fd_list[0].fd = fd;
+  fd_list[0].events = POLLIN | POLLPRI;
+
+  while (!do_exit) {
+    uint64_t ts = 0;
+    int err = poll(fd_list, 1, timeout_ms);
+    if (err == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    } else if (err == 0) {
+      // read anyway, a FIFO interrupt doesn't fire again until it was emptied
+      LOGE("poll timed out");
+    } else {
+      if ((fd_list[0].revents & (POLLIN | POLLPRI)) == 0) {
+        LOGE("no poll events set");
+        continue;
+      }
+
+      // Read all events
+      struct gpioevent_data evdata[16];
+      err = HANDLE_EINTR(read(fd, evdata, sizeof(evdata)));
+      if (err < 0 || err % sizeof(*evdata) != 0) {
+        LOGE("error reading event data %d", err);
+        continue;
+      }
+
+      // The FIFO threshold interrupt stays high until the FIFO is read, only its rising
+      // edge means new samples. The falling edge is from our own read.
+      int num_events = err / sizeof(*evdata);
+      for (int i = 0; i < num_events; i++) {
+        if (evdata[i].id == GPIOEVENT_EVENT_RISING_EDGE) {
+          ts = evdata[i].timestamp;
+        }
+      }
+      if (ts == 0) {
+        continue;
+      }
+      uint64_t offset = nanos_since_epoch() - nanos_since_boot();
+      ts -= offset;
+    }
+
+    for (auto &[sensor, msg_name] : sensors) {
+      if (!sensor->has_interrupt_enabled()) {
+        continue;
+      }
+
+      Sensor *s = sensor;
+      s->get_events(msg_name, ts, [&](const std::string &name, MessageBuilder &msg) {
+        if (s->is_data_valid(ts != 0 ? ts : nanos_since_boot())) {
+          pm.send(name.c_str(), msg);
+        }
+      });
+    }
+  }
+}
+
+void polling_loop(Sensor *sensor, std::string msg_name, float rate_scale) {
+  PubMaster pm({msg_name.c_str()});
+  RateKeeper rk(msg_name, services.at(msg_name).frequency * rate_scale, 0, true);
+  while (!do_exit) {
+    MessageBuilder msg;
+    if (sensor->get_event(msg) && sensor->is_data_valid(nanos_since_boot())) {
+      pm.send(msg_name.c_str(), msg);
+    }
+    rk.keepTime();
+  }
+}
+
+int sensor_loop(std::vector<std::tuple<Sensor *, std::string>> &sensors, bool realtime, float rate_scale) {
+  // Initialize sensors
+  std::vector<std::thread> threads;
+  for (auto &[sensor, msg_name] : sensors) {
+    int err = sensor->init();
+    if (err < 0) {
+      continue;
+    }
+
+    if (!sensor->has_interrupt_enabled()) {
+      threads.emplace_back(polling_loop, sensor, msg_name, rate_scale);
+    }
+  }
+
+  if (realtime) {
+    // increase interrupt quality by pinning interrupt and process to core 1
+    setpriority(PRIO_PROCESS, 0, -18);
+    util::set_core_affinity({1});
+
+    // TODO: get the IRQ number from gpiochip
+    std::string irq_path = "/proc/irq/336/smp_affinity_list";
+    if (!util::file_exists(irq_path)) {
+      irq_path = "/proc/irq/335/smp_affinity_list";
+    }
+    std::system(util::string_format("sudo su -c 'echo 1 > %s'", irq_path.c_str()).c_str());
+  }
+
+  // thread for reading events via interrupts
+  threads.emplace_back(&interrupt_loop, std::ref(sensors), int(100 / rate_scale));
+
+  // wait for all threads to finish
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  for (auto &[sensor, msg_name] : sensors) {
+    sensor->shutdown();
+    delete sensor;
+  }
+  return 0;
+}
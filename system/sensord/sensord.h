@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "common/util.h"
+#include "system/sensord/sensors/sensor.h"
+
+extern ExitHandler do_exit;
+
+// Initializes the sensors and publishes their events until do_exit. Sensors with an interrupt
+// are read from one thread, the others are polled at their service frequency times rate_scale.
+// realtime pins the interrupt thread and IRQ to core 1, which needs root on the device.
+// Shuts down and deletes the sensors when done.
+int sensor_loop(std::vector<std::tuple<Sensor *, std::string>> &sensors, bool realtime = true, float rate_scale = 1.0);
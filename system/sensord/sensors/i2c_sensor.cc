@@ -32,12 +32,12 @@ int I2CSensor::set_register(uint register_address, uint8_t data) {
   return bus->set_register(get_device_address(), register_address, data);
 }
 
-int I2CSensor::init_gpio() {
+int I2CSensor::init_gpio(bool rising_edge_only) {
   if (shared_gpio || gpio_nr == 0) {
     return 0;
   }
 
-  gpio_fd = gpiochip_get_ro_value_fd("sensord", GPIOCHIP_INT, gpio_nr);
+  gpio_fd = bus->gpio_event_fd("sensord", GPIOCHIP_INT, gpio_nr, rising_edge_only);
   if (gpio_fd < 0) {
     return -1;
   }
@@ -29,7 +29,7 @@ public:
   ~I2CSensor();
   int read_register(uint register_address, uint8_t *buffer, uint8_t len);
   int set_register(uint register_address, uint8_t data);
-  int init_gpio();
+  int init_gpio(bool rising_edge_only = false);
   bool has_interrupt_enabled();
   virtual int init() = 0;
   virtual bool get_event(MessageBuilder &msg, uint64_t ts = 0) = 0;
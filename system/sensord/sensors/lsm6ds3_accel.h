@@ -45,5 +45,7 @@ public:
   LSM6DS3_Accel(I2CBus *bus, int gpio_nr = 0, bool shared_gpio = false);
   int init();
   bool get_event(MessageBuilder &msg, uint64_t ts = 0);
+  // event from the 6 bytes of output registers
+  void fill_event(MessageBuilder &msg, const uint8_t *buffer, uint64_t ts);
   int shutdown();
 };
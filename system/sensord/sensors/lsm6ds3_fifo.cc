@@ -0,0 +1,176 @@
+#include "system/sensord/sensors/lsm6ds3_fifo.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/swaglog.h"
+#include "common/timing.h"
+
+LSM6DS3_Fifo::LSM6DS3_Fifo(I2CBus *bus, int gpio_nr, int watermark_sets, double odr_hz) :
+  I2CSensor(bus, gpio_nr), accel(bus), gyro(bus), watermark_sets(watermark_sets),
+  nominal_period_ns(1e9 / odr_hz), period_ns(1e9 / odr_hz) {}
+
+int LSM6DS3_Fifo::init() {
+  // chip id, self tests, 104 Hz output data rate and auto increment
+  int ret = accel.init();
+  if (ret < 0) {
+    return ret;
+  }
+
+  ret = gyro.init();
+  if (ret < 0) {
+    return ret;
+  }
+
+  // the threshold interrupt is a level, it falls again when the FIFO is read
+  ret = init_gpio(true);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  // start from an empty FIFO
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL5, LSM6DS3_FIFO_MODE_BYPASS);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  // threshold in words
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL1, (watermark_sets * LSM6DS3_FIFO_SET_WORDS) & 0xFF);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL2, ((watermark_sets * LSM6DS3_FIFO_SET_WORDS) >> 8) & 0x0F);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  // every gyro and accel sample
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL3, LSM6DS3_FIFO_DEC_GYRO_NONE | LSM6DS3_FIFO_DEC_XL_NONE);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL5, LSM6DS3_FIFO_ODR_104HZ | LSM6DS3_FIFO_MODE_CONTINUOUS);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  // replace the data ready interrupts of accel and gyro by the FIFO threshold on INT1
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_INT1_CTRL, LSM6DS3_FIFO_INT1_FTH);
+
+fail:
+  return ret;
+}
+
+int LSM6DS3_Fifo::shutdown() {
+  int ret = 0;
+
+  // disable FIFO threshold interrupt on INT1
+  uint8_t value = 0;
+  ret = read_register(LSM6DS3_FIFO_I2C_REG_INT1_CTRL, &value, 1);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  value &= ~(LSM6DS3_FIFO_INT1_FTH);
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_INT1_CTRL, value);
+  if (ret < 0) {
+    LOGE("Could not disable lsm6ds3 FIFO interrupt!");
+    goto fail;
+  }
+
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL5, LSM6DS3_FIFO_MODE_BYPASS);
+  if (ret < 0) {
+    LOGE("Could not disable lsm6ds3 FIFO!");
+    goto fail;
+  }
+
+  // enable power-down mode
+  ret = gyro.shutdown();
+  if (ret < 0) {
+    goto fail;
+  }
+  ret = accel.shutdown();
+
+fail:
+  return ret;
+}
+
+uint64_t LSM6DS3_Fifo::first_sample_ts(uint64_t ts, int sets) {
+  uint64_t first_ts;
+  if (ts != 0) {
+    // The interrupt fired when the watermark was reached, the sets after that came in while
+    // waking up. The distance between those trigger samples gives the actual sample period,
+    // late wakeups and missed interrupts are ignored.
+    const int trigger = std::min(watermark_sets, sets) - 1;
+    if (last_trigger_ts != 0 && ts > last_trigger_ts) {
+      const double measured_ns = double(ts - last_trigger_ts) / (sets_since_trigger + trigger + 1);
+      if (std::abs(measured_ns - nominal_period_ns) < 0.1 * nominal_period_ns) {
+        period_ns += 0.1 * (measured_ns - period_ns);
+      }
+    }
+    last_trigger_ts = ts;
+    sets_since_trigger = sets - trigger - 1;
+    first_ts = ts - uint64_t(trigger * period_ns);
+  } else {
+    // no interrupt, continue from the last sample
+    sets_since_trigger += sets;
+    first_ts = last_sample_ts != 0 ? last_sample_ts + uint64_t(period_ns) : nanos_since_boot() - uint64_t((sets - 1) * period_ns);
+  }
+  return std::max(first_ts, last_sample_ts + 1);
+}
+
+void LSM6DS3_Fifo::get_events(const std::string &msg_name, uint64_t ts, const PublishFn &publish) {
+  // unread words, and the position of the next one in the gyro/accel pattern
+  uint8_t status[4];
+  if (read_register(LSM6DS3_FIFO_I2C_REG_FIFO_STATUS1, status, sizeof(status)) < 0) {
+    return;
+  }
+  if (status[1] & LSM6DS3_FIFO_OVER_RUN) {
+    LOGE("lsm6ds3 FIFO overrun");
+  }
+  int words = status[0] | ((status[1] & LSM6DS3_FIFO_DIFF_H_MASK) << 8);
+  const int pattern = status[2] | ((status[3] & LSM6DS3_FIFO_PATTERN_H_MASK) << 8);
+
+  // after a failed read the FIFO can be in the middle of a set, skip to the next one
+  if (pattern != 0 && words > 0) {
+    uint8_t skip[2 * LSM6DS3_FIFO_SET_WORDS];
+    const int skip_words = std::min(LSM6DS3_FIFO_SET_WORDS - pattern, words);
+    if (read_register(LSM6DS3_FIFO_I2C_REG_DATA_OUT_L, skip, 2 * skip_words) < 0) {
+      return;
+    }
+    words -= skip_words;
+  }
+
+  const int sets = words / LSM6DS3_FIFO_SET_WORDS;
+  if (sets == 0) {
+    return;
+  }
+
+  const uint64_t first_ts = first_sample_ts(ts, sets);
+  const uint64_t now = nanos_since_boot();
+
+  uint8_t buffer[2 * LSM6DS3_FIFO_SET_WORDS * LSM6DS3_FIFO_READ_SETS];
+  for (int i = 0; i < sets; i += LSM6DS3_FIFO_READ_SETS) {
+    const int n = std::min(LSM6DS3_FIFO_READ_SETS, sets - i);
+    const int len = 2 * LSM6DS3_FIFO_SET_WORDS * n;
+    if (read_register(LSM6DS3_FIFO_I2C_REG_DATA_OUT_L, buffer, len) != len) {
+      LOGE("lsm6ds3 FIFO read failed");
+      return;
+    }
+
+    for (int j = 0; j < n; j++) {
+      const uint8_t *set = &buffer[2 * LSM6DS3_FIFO_SET_WORDS * j];
+      last_sample_ts = std::min(first_ts + uint64_t((i + j) * period_ns), now);
+
+      MessageBuilder gyro_msg;
+      gyro.fill_event(gyro_msg, set, last_sample_ts);
+      publish("gyroscope", gyro_msg);
+
+      MessageBuilder accel_msg;
+      accel.fill_event(accel_msg, set + 6, last_sample_ts);
+      publish("accelerometer", accel_msg);
+    }
+  }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "system/sensord/sensors/i2c_sensor.h"
+#include "system/sensord/sensors/lsm6ds3_accel.h"
+#include "system/sensord/sensors/lsm6ds3_gyro.h"
+
+// Address of the chip on the bus
+#define LSM6DS3_FIFO_I2C_ADDR       0x6A
+
+// Registers of the chip
+#define LSM6DS3_FIFO_I2C_REG_FIFO_CTRL1   0x06
+#define LSM6DS3_FIFO_I2C_REG_FIFO_CTRL2   0x07
+#define LSM6DS3_FIFO_I2C_REG_FIFO_CTRL3   0x08
+#define LSM6DS3_FIFO_I2C_REG_FIFO_CTRL5   0x0A
+#define LSM6DS3_FIFO_I2C_REG_INT1_CTRL    0x0D
+#define LSM6DS3_FIFO_I2C_REG_FIFO_STATUS1 0x3A
+#define LSM6DS3_FIFO_I2C_REG_DATA_OUT_L   0x3E
+
+// Constants
+#define LSM6DS3_FIFO_DEC_GYRO_NONE   (0b001 << 3)
+#define LSM6DS3_FIFO_DEC_XL_NONE     0b001
+#define LSM6DS3_FIFO_ODR_104HZ       (0b0100 << 3)
+#define LSM6DS3_FIFO_MODE_BYPASS     0b000
+#define LSM6DS3_FIFO_MODE_CONTINUOUS 0b110
+#define LSM6DS3_FIFO_INT1_FTH        (1 << 3)
+#define LSM6DS3_FIFO_OVER_RUN        (1 << 6)
+#define LSM6DS3_FIFO_DIFF_H_MASK     0x0F
+#define LSM6DS3_FIFO_PATTERN_H_MASK  0x03
+#define LSM6DS3_FIFO_ODR_HZ          104.0
+
+// a set is gyro xyz followed by accel xyz
+#define LSM6DS3_FIFO_SET_WORDS       6
+// interrupt every 5 sets (~48 ms), and read up to 16 sets in one burst
+#define LSM6DS3_FIFO_WATERMARK_SETS  5
+#define LSM6DS3_FIFO_READ_SETS       16
+
+// Accelerometer and gyroscope queued in the chip's FIFO at 104 Hz. The threshold interrupt
+// fires once per watermark_sets samples, which are read in one burst and published as separate
+// events. Their timestamps are reconstructed from the interrupt time and the sample period,
+// which is tracked across interrupts.
+class LSM6DS3_Fifo : public I2CSensor {
+  uint8_t get_device_address() {return LSM6DS3_FIFO_I2C_ADDR;}
+
+  LSM6DS3_Accel accel;
+  LSM6DS3_Gyro gyro;
+  int watermark_sets;
+  double nominal_period_ns;
+
+  double period_ns;
+  uint64_t last_trigger_ts = 0;
+  int sets_since_trigger = 0;
+  uint64_t last_sample_ts = 0;
+
+  uint64_t first_sample_ts(uint64_t ts, int sets);
+public:
+  // odr_hz is only changed for simulations that run faster than the chip
+  LSM6DS3_Fifo(I2CBus *bus, int gpio_nr = 0, int watermark_sets = LSM6DS3_FIFO_WATERMARK_SETS, double odr_hz = LSM6DS3_FIFO_ODR_HZ);
+  int init();
+  // all events come from get_events
+  bool get_event(MessageBuilder &msg, uint64_t ts = 0) {return false;}
+  void get_events(const std::string &msg_name, uint64_t ts, const PublishFn &publish);
+  int shutdown();
+};
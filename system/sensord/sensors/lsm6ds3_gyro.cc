@@ -212,6 +212,11 @@ bool LSM6DS3_Gyro::get_event(MessageBuilder &msg, uint64_t ts) {
   int len = read_register(LSM6DS3_GYRO_I2C_REG_OUTX_L_G, buffer, sizeof(buffer));
   assert(len == sizeof(buffer));
 
+  fill_event(msg, buffer, ts);
+  return true;
+}
+
+void LSM6DS3_Gyro::fill_event(MessageBuilder &msg, const uint8_t *buffer, uint64_t ts) {
   float scale = 8.75 / 1000.0;
   float x = DEG2RAD(read_16_bit(buffer[0], buffer[1]) * scale);
   float y = DEG2RAD(read_16_bit(buffer[2], buffer[3]) * scale);
@@ -228,6 +233,4 @@ bool LSM6DS3_Gyro::get_event(MessageBuilder &msg, uint64_t ts) {
   auto svec = event.initGyroUncalibrated();
   svec.setV(xyz);
   svec.setStatus(true);
-
-  return true;
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <functional>
+#include <string>
+
 #include "cereal/messaging/messaging.h"
 
 class Sensor {
@@ -13,6 +16,16 @@ public:
   virtual bool has_interrupt_enabled() = 0;
   virtual int shutdown() = 0;
 
+  // Reads what is ready after an interrupt at ts, or after a poll timeout if ts is 0. Sensors
+  // with a hardware FIFO publish one event per queued sample, under their own service names.
+  typedef std::function<void(const std::string &msg_name, MessageBuilder &msg)> PublishFn;
+  virtual void get_events(const std::string &msg_name, uint64_t ts, const PublishFn &publish) {
+    MessageBuilder msg;
+    if (ts != 0 && get_event(msg, ts)) {
+      publish(msg_name, msg);
+    }
+  }
+
   virtual bool is_data_valid(uint64_t current_ts) {
     if (start_ts == 0) {
       start_ts = current_ts;
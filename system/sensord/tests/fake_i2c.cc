@@ -0,0 +1,107 @@
+#include "system/sensord/tests/fake_i2c.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+
+FakeI2CBus::~FakeI2CBus() {
+  for (auto &[pin_nr, line] : lines) {
+    close(line.fd);
+  }
+}
+
+void FakeI2CBus::add_device(uint8_t device_address) {
+  std::lock_guard lk(devices_lock);
+  devices[device_address];
+}
+
+void FakeI2CBus::set(uint8_t device_address, uint register_address, uint8_t value) {
+  std::lock_guard lk(devices_lock);
+  devices[device_address].regs[register_address & 0xFF] = value;
+}
+
+uint8_t FakeI2CBus::get(uint8_t device_address, uint register_address) {
+  std::lock_guard lk(devices_lock);
+  return devices[device_address].regs[register_address & 0xFF];
+}
+
+void FakeI2CBus::on_read(uint8_t device_address, uint register_address, ReadFn fn) {
+  std::lock_guard lk(devices_lock);
+  devices[device_address].read_fns[register_address] = fn;
+}
+
+void FakeI2CBus::on_write(uint8_t device_address, uint register_address, WriteFn fn) {
+  std::lock_guard lk(devices_lock);
+  devices[device_address].write_fns[register_address] = fn;
+}
+
+int FakeI2CBus::read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len) {
+  std::lock_guard lk(devices_lock);
+  auto dev = devices.find(device_address);
+  if (dev == devices.end()) {
+    return -ENXIO;
+  }
+
+  reads++;
+  bytes_read += len;
+  auto fn = dev->second.read_fns.find(register_address);
+  if (fn != dev->second.read_fns.end()) {
+    fn->second(buffer, len);
+  } else {
+    // auto increment, wrapping around the register map
+    for (int i = 0; i < len; i++) {
+      buffer[i] = dev->second.regs[(register_address + i) & 0xFF];
+    }
+  }
+  return len;
+}
+
+int FakeI2CBus::set_register(uint8_t device_address, uint register_address, uint8_t data) {
+  std::lock_guard lk(devices_lock);
+  auto dev = devices.find(device_address);
+  if (dev == devices.end()) {
+    return -ENXIO;
+  }
+
+  writes++;
+  dev->second.regs[register_address & 0xFF] = data;
+  auto fn = dev->second.write_fns.find(register_address);
+  if (fn != dev->second.write_fns.end()) {
+    fn->second(data);
+  }
+  return 0;
+}
+
+int FakeI2CBus::gpio_event_fd(const char *consumer_label, int gpiochip_id, int pin_nr, bool rising_edge_only) {
+  std::lock_guard lk(lines_lock);
+  assert(lines.find(pin_nr) == lines.end());
+
+  // a stream like the line event fd, several events can be read at once
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    return -1;
+  }
+  lines[pin_nr] = {fds[1], rising_edge_only};
+  return fds[0];
+}
+
+int FakeI2CBus::edges(int pin_nr) {
+  std::lock_guard lk(lines_lock);
+  auto line = lines.find(pin_nr);
+  return line != lines.end() ? line->second.edges : 0;
+}
+
+void FakeI2CBus::trigger(int pin_nr, uint64_t ts, uint32_t id) {
+  std::lock_guard lk(lines_lock);
+  auto line = lines.find(pin_nr);
+  if (line == lines.end() || (line->second.rising_edge_only && id == GPIOEVENT_EVENT_FALLING_EDGE)) {
+    return;
+  }
+  line->second.edges++;
+
+  struct gpioevent_data evdata = {.timestamp = ts, .id = id};
+  // the reader may already be gone when shutting down
+  send(line->second.fd, &evdata, sizeof(evdata), MSG_NOSIGNAL | MSG_DONTWAIT);
+}
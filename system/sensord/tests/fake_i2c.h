@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+
+#include <linux/gpio.h>
+
+#include "common/i2c.h"
+
+// I2C bus without hardware, for running sensors on a PC. Every device is a register map, and
+// registers backed by state like a FIFO are scripted with read and write handlers. Reads
+// from addresses without a device fail like a missing ACK. Interrupt lines are sockets that
+// deliver gpioevent_data like a gpiochip line event fd.
+class FakeI2CBus : public I2CBus {
+public:
+  // fill buffer with len bytes starting at the register
+  typedef std::function<void(uint8_t *buffer, uint8_t len)> ReadFn;
+  typedef std::function<void(uint8_t data)> WriteFn;
+
+  FakeI2CBus() {}
+  ~FakeI2CBus();
+
+  void add_device(uint8_t device_address);
+  void set(uint8_t device_address, uint register_address, uint8_t value);
+  uint8_t get(uint8_t device_address, uint register_address);
+  void on_read(uint8_t device_address, uint register_address, ReadFn fn);
+  void on_write(uint8_t device_address, uint register_address, WriteFn fn);
+
+  // queues an edge on the interrupt line, ts is in nanoseconds since epoch like the kernel's.
+  // Falling edges are dropped on lines requested with rising_edge_only.
+  void trigger(int pin_nr, uint64_t ts, uint32_t id = GPIOEVENT_EVENT_RISING_EDGE);
+
+  int read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len);
+  int set_register(uint8_t device_address, uint register_address, uint8_t data);
+  int gpio_event_fd(const char *consumer_label, int gpiochip_id, int pin_nr, bool rising_edge_only = false);
+  // edges delivered on the line so far
+  int edges(int pin_nr);
+
+  // transactions so far
+  std::atomic<int> reads = 0;
+  std::atomic<int> writes = 0;
+  std::atomic<size_t> bytes_read = 0;
+
+private:
+  struct Device {
+    std::array<uint8_t, 256> regs = {};
+    std::map<uint, ReadFn> read_fns;
+    std::map<uint, WriteFn> write_fns;
+  };
+
+  std::mutex devices_lock;
+  std::map<uint8_t, Device> devices;
+
+  struct Line {
+    int fd;  // write end of the socket
+    bool rising_edge_only;
+    int edges = 0;
+  };
+  std::mutex lines_lock;
+  std::map<int, Line> lines;
+};
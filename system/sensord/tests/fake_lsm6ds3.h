@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+
+#include "common/timing.h"
+#include "system/sensord/sensors/lsm6ds3_fifo.h"
+#include "system/sensord/tests/fake_i2c.h"
+
+// LSM6DS3TR-C on a FakeI2CBus. Sets pushed into the FIFO raise the threshold interrupt once
+// the watermark configured by the driver is reached, it goes low again when the FIFO is read
+// below the watermark.
+class FakeLSM6DS3 {
+public:
+  FakeLSM6DS3(FakeI2CBus *bus, int pin_nr = 0) : bus(bus), pin_nr(pin_nr) {
+    bus->add_device(LSM6DS3_FIFO_I2C_ADDR);
+    bus->set(LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_ACCEL_I2C_REG_ID, LSM6DS3TRC_ACCEL_CHIP_ID);
+    // new data always available for the self tests
+    bus->set(LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_ACCEL_I2C_REG_STAT_REG, LSM6DS3_ACCEL_DRDY_XLDA | LSM6DS3_GYRO_DRDY_GDA);
+
+    bus->on_read(LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_FIFO_STATUS1, [this](uint8_t *buffer, uint8_t len) {
+      std::lock_guard lk(lock);
+      const uint8_t status[4] = {uint8_t(fifo.size() & 0xFF), uint8_t((fifo.size() >> 8) & LSM6DS3_FIFO_DIFF_H_MASK), uint8_t(pattern), 0};
+      std::copy_n(status, std::min<int>(len, sizeof(status)), buffer);
+    });
+    bus->on_read(LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_DATA_OUT_L, [this](uint8_t *buffer, uint8_t len) {
+      read_fifo(buffer, len);
+    });
+    bus->on_write(LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_FIFO_CTRL1, [this](uint8_t data) {
+      std::lock_guard lk(lock);
+      threshold_words = (threshold_words & 0xF00) | data;
+    });
+    bus->on_write(LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_FIFO_CTRL2, [this](uint8_t data) {
+      std::lock_guard lk(lock);
+      threshold_words = (threshold_words & 0xFF) | ((data & 0x0F) << 8);
+    });
+    bus->on_write(LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_FIFO_CTRL5, [this](uint8_t data) {
+      std::lock_guard lk(lock);
+      // bypass mode empties the FIFO
+      if ((data & 0b111) == LSM6DS3_FIFO_MODE_BYPASS) {
+        fifo.clear();
+        pattern = 0;
+      }
+    });
+  }
+
+  // queues a set and raises the interrupt at ts (nanos since boot) when it reaches the watermark
+  void push_set(int16_t gx, int16_t gy, int16_t gz, int16_t ax, int16_t ay, int16_t az, uint64_t ts = 0) {
+    bool rising = false;
+    {
+      std::lock_guard lk(lock);
+      fifo.insert(fifo.end(), {gx, gy, gz, ax, ay, az});
+      if (!level && threshold_words > 0 && fifo.size() >= threshold_words) {
+        level = rising = true;
+      }
+    }
+    if (rising) {
+      bus->trigger(pin_nr, (ts != 0 ? ts : nanos_since_boot()) + (nanos_since_epoch() - nanos_since_boot()));
+    }
+  }
+
+  // unaligned words, like after an interrupted read
+  void push_words(std::initializer_list<int16_t> words) {
+    std::lock_guard lk(lock);
+    fifo.insert(fifo.end(), words);
+  }
+
+  void set_pattern(int p) {
+    std::lock_guard lk(lock);
+    pattern = p;
+  }
+
+  size_t words() {
+    std::lock_guard lk(lock);
+    return fifo.size();
+  }
+
+private:
+  void read_fifo(uint8_t *buffer, uint8_t len) {
+    bool falling = false;
+    {
+      std::lock_guard lk(lock);
+      for (int i = 0; i + 1 < len; i += 2) {
+        int16_t word = 0;
+        if (!fifo.empty()) {
+          word = fifo.front();
+          fifo.pop_front();
+          pattern = (pattern + 1) % LSM6DS3_FIFO_SET_WORDS;
+        }
+        buffer[i] = word & 0xFF;
+        buffer[i + 1] = (word >> 8) & 0xFF;
+      }
+      if (level && fifo.size() < threshold_words) {
+        level = false;
+        falling = true;
+      }
+    }
+    if (falling) {
+      bus->trigger(pin_nr, nanos_since_epoch(), GPIOEVENT_EVENT_FALLING_EDGE);
+    }
+  }
+
+  FakeI2CBus *bus;
+  int pin_nr;
+
+  std::mutex lock;
+  std::deque<int16_t> fifo;
+  int pattern = 0;
+  size_t threshold_words = 0;
+  bool level = false;
+};
@@ -0,0 +1,170 @@
+// Runs sensor_loop against a simulated LSM6DS3 on a FakeI2CBus, optionally faster than the real
+// 104 Hz. Reports the CPU time and I2C transactions per sample, and the error of the published
+// sample timestamps against the times the simulated chip took them. The CPU time includes the
+// fake bus, but not the threads generating and receiving the samples.
+//
+//   sensord_benchmark [--seconds 10] [--rate 1] [--jitter-us 200] [--clock-error 0.02]
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "common/timing.h"
+#include "common/util.h"
+#include "system/sensord/sensord.h"
+#include "system/sensord/sensors/lsm6ds3_fifo.h"
+#include "system/sensord/sensors/lsm6ds3_temp.h"
+#include "system/sensord/tests/fake_i2c.h"
+#include "system/sensord/tests/fake_lsm6ds3.h"
+
+// any pin, the fake bus doesn't care
+#define FAKE_LSM_INT 84
+
+// the sample index is sent as raw accel y, which ends up in acceleration v[0]
+#define ACCEL_SCALE (9.81 * 2.0f / (1 << 15))
+#define INDEX_MOD (1 << 15)
+
+struct Sample {
+  uint64_t timestamp;
+  int index_mod;
+};
+
+static double cpu_seconds() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+}
+
+static double percentile(std::vector<double> &v, double p) {
+  if (v.empty()) return 0;
+  size_t idx = std::min(v.size() - 1, (size_t)(p / 100.0 * v.size()));
+  std::nth_element(v.begin(), v.begin() + idx, v.end());
+  return v[idx];
+}
+
+int main(int argc, char *argv[]) {
+  double seconds = 10;
+  float rate = 1;
+  double jitter_us = 200;
+  double clock_error = 0.02;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--seconds" && i + 1 < argc) {
+      seconds = atof(argv[++i]);
+    } else if (arg == "--rate" && i + 1 < argc) {
+      rate = atof(argv[++i]);
+    } else if (arg == "--jitter-us" && i + 1 < argc) {
+      jitter_us = atof(argv[++i]);
+    } else if (arg == "--clock-error" && i + 1 < argc) {
+      clock_error = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--seconds s] [--rate x] [--jitter-us us] [--clock-error fraction]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  FakeI2CBus bus;
+  FakeLSM6DS3 chip(&bus, FAKE_LSM_INT);
+  std::vector<std::tuple<Sensor *, std::string>> sensors = {
+    {new LSM6DS3_Fifo(&bus, FAKE_LSM_INT, LSM6DS3_FIFO_WATERMARK_SETS, LSM6DS3_FIFO_ODR_HZ * rate), "accelerometer"},
+    {new LSM6DS3_Temp(&bus), "temperatureSensor"},
+  };
+
+  std::unique_ptr<Context> ctx(Context::create());
+  std::unique_ptr<SubSocket> sock(SubSocket::create(ctx.get(), "accelerometer"));
+  assert(sock != nullptr);
+  sock->setTimeout(100);
+
+  std::vector<Sample> received;
+  uint64_t receiver_cpu_ns = 0;
+  std::thread receiver([&]() {
+    AlignedBuffer aligned_buf;
+    while (!do_exit) {
+      std::unique_ptr<Message> msg(sock->receive());
+      if (!msg) continue;
+
+      capnp::FlatArrayMessageReader reader(aligned_buf.align(msg.get()));
+      auto accel = reader.getRoot<cereal::Event>().getAccelerometer();
+      const int index_mod = std::lround(accel.getAcceleration().getV()[0] / ACCEL_SCALE);
+      received.push_back({(uint64_t)accel.getTimestamp(), index_mod});
+    }
+    receiver_cpu_ns = nanos_thread_cpu();
+  });
+
+  // the chip's clock is off, its interrupt is seen after a random latency
+  const double period_ns = 1e9 / (LSM6DS3_FIFO_ODR_HZ * rate) * (1.0 + clock_error);
+  const uint64_t t0 = nanos_since_boot() + 100e6;
+  int generated = 0;
+  uint64_t generator_cpu_ns = 0;
+  std::thread generator([&]() {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> latency(0, jitter_us * 1e3);
+    for (int k = 0; !do_exit; k++) {
+      const uint64_t t = t0 + k * period_ns + latency(rng);
+      const uint64_t now = nanos_since_boot();
+      if (t > now) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(t - now));
+      }
+      chip.push_set(0, 0, 0, 0, k % INDEX_MOD, 0);
+      generated++;
+    }
+    generator_cpu_ns = nanos_thread_cpu();
+  });
+
+  std::thread timer([&]() {
+    const double end = millis_since_boot() + seconds * 1000;
+    while (!do_exit && millis_since_boot() < end) {
+      util::sleep_for(10);
+    }
+    do_exit = true;
+  });
+
+  const double t_start = millis_since_boot();
+  const double cpu_start = cpu_seconds();
+  sensor_loop(sensors, false, rate);
+  timer.join();
+  generator.join();
+  receiver.join();
+  const double wall_s = (millis_since_boot() - t_start) / 1000.0;
+  const double sensord_cpu_s = cpu_seconds() - cpu_start - (generator_cpu_ns + receiver_cpu_ns) * 1e-9;
+
+  // match samples by index, and skip the first two seconds of samples while the period converges
+  std::vector<double> error_us;
+  int non_monotonic = 0;
+  for (int i = 0; i < received.size(); i++) {
+    const Sample &s = received[i];
+    if (i > 0 && s.timestamp <= received[i - 1].timestamp) {
+      non_monotonic++;
+    }
+
+    const double k_est = (double(s.timestamp) - t0) / period_ns;
+    const double k = s.index_mod + INDEX_MOD * std::round((k_est - s.index_mod) / INDEX_MOD);
+    if (k < 2 * LSM6DS3_FIFO_ODR_HZ) continue;
+    error_us.push_back((double(s.timestamp) - (t0 + k * period_ns)) / 1e3);
+  }
+
+  std::vector<double> abs_error_us(error_us.size());
+  std::transform(error_us.begin(), error_us.end(), abs_error_us.begin(), [](double e) { return std::abs(e); });
+  double mean_error_us = 0;
+  for (double e : error_us) mean_error_us += e / error_us.size();
+
+  const int samples = std::max<int>(received.size(), 1);
+  printf("samples        %d generated, %zu published in %.1f s (%.0f Hz)\n", generated, received.size(), wall_s, received.size() / wall_s);
+  printf("cpu            %.2f us/sample, %.2f%% of a core\n", 1e6 * sensord_cpu_s / samples, 100.0 * sensord_cpu_s / wall_s);
+  printf("i2c            %.2f reads/sample, %.2f writes/sample, %.1f bytes/sample\n",
+         double(bus.reads) / samples, double(bus.writes) / samples, double(bus.bytes_read) / samples);
+  printf("ts error (us)  mean %.1f, p50 %.1f, p99 %.1f, max %.1f\n", mean_error_us,
+         percentile(abs_error_us, 50), percentile(abs_error_us, 99), percentile(abs_error_us, 100));
+  printf("non-monotonic  %d\n", non_monotonic);
+  return non_monotonic == 0 ? 0 : 1;
+}
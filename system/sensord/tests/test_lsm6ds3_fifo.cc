@@ -0,0 +1,156 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "common/timing.h"
+#include "system/sensord/sensors/lsm6ds3_fifo.h"
+#include "system/sensord/tests/fake_lsm6ds3.h"
+
+namespace {
+
+struct Event {
+  std::string name;
+  uint64_t timestamp;
+  std::vector<float> v;
+};
+
+std::vector<Event> get_events(LSM6DS3_Fifo &sensor, uint64_t ts) {
+  std::vector<Event> events;
+  sensor.get_events("accelerometer", ts, [&](const std::string &name, MessageBuilder &msg) {
+    auto event = msg.getRoot<cereal::Event>();
+    auto data = name == "gyroscope" ? event.getGyroscope() : event.getAccelerometer();
+    auto v = name == "gyroscope" ? data.getGyroUncalibrated().getV() : data.getAcceleration().getV();
+    events.push_back({name, (uint64_t)data.getTimestamp(), std::vector<float>(v.begin(), v.end())});
+  });
+  return events;
+}
+
+}  // namespace
+
+TEST_CASE("LSM6DS3_Fifo init") {
+  FakeI2CBus bus;
+  FakeLSM6DS3 chip(&bus);
+  LSM6DS3_Fifo sensor(&bus);
+  REQUIRE(sensor.init() >= 0);
+  REQUIRE(bus.get(LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_FIFO_CTRL1) == LSM6DS3_FIFO_WATERMARK_SETS * LSM6DS3_FIFO_SET_WORDS);
+  REQUIRE(bus.get(LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_FIFO_CTRL3) == (LSM6DS3_FIFO_DEC_GYRO_NONE | LSM6DS3_FIFO_DEC_XL_NONE));
+  REQUIRE(bus.get(LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_FIFO_CTRL5) == (LSM6DS3_FIFO_ODR_104HZ | LSM6DS3_FIFO_MODE_CONTINUOUS));
+  // only the threshold interrupt, no data ready interrupts
+  REQUIRE(bus.get(LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_INT1_CTRL) == LSM6DS3_FIFO_INT1_FTH);
+
+  REQUIRE(sensor.shutdown() >= 0);
+  REQUIRE(bus.get(LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_INT1_CTRL) == 0);
+  REQUIRE(bus.get(LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_FIFO_CTRL5) == LSM6DS3_FIFO_MODE_BYPASS);
+}
+
+TEST_CASE("LSM6DS3_Fifo without a chip") {
+  FakeI2CBus bus;
+  LSM6DS3_Fifo sensor(&bus);
+  REQUIRE(sensor.init() < 0);
+}
+
+TEST_CASE("LSM6DS3_Fifo wakes up on rising edges only") {
+  const int pin_nr = 84;
+  FakeI2CBus bus;
+  FakeLSM6DS3 chip(&bus, pin_nr);
+  LSM6DS3_Fifo sensor(&bus, pin_nr);
+  REQUIRE(sensor.init() >= 0);
+  for (int batch = 0; batch < 3; batch++) {
+    for (int i = 0; i < LSM6DS3_FIFO_WATERMARK_SETS; i++) {
+      chip.push_set(0, 0, 0, 0, 0, 0);
+    }
+    // reading the FIFO drops the level, that edge isn't requested
+    REQUIRE(get_events(sensor, nanos_since_boot()).size() == 2 * LSM6DS3_FIFO_WATERMARK_SETS);
+  }
+  REQUIRE(bus.edges(pin_nr) == 3);
+  REQUIRE(sensor.shutdown() >= 0);
+}
+
+TEST_CASE("LSM6DS3_Fifo reads a batch in one burst") {
+  FakeI2CBus bus;
+  FakeLSM6DS3 chip(&bus);
+  LSM6DS3_Fifo sensor(&bus);
+  for (int i = 0; i < 7; i++) {
+    chip.push_set(100 * i, 2, 3, 1000 * i, 20, 30);
+  }
+
+  const uint64_t ts = nanos_since_boot() - 1e9;
+  auto events = get_events(sensor, ts);
+  REQUIRE(events.size() == 14);
+  // status and data
+  REQUIRE(bus.reads == 2);
+  REQUIRE(chip.words() == 0);
+
+  const double period = 1e9 / LSM6DS3_FIFO_ODR_HZ;
+  for (int i = 0; i < 7; i++) {
+    const Event &gyro = events[2 * i], &accel = events[2 * i + 1];
+    REQUIRE(gyro.name == "gyroscope");
+    REQUIRE(accel.name == "accelerometer");
+    REQUIRE(gyro.timestamp == accel.timestamp);
+    // the interrupt was for the set at the watermark
+    REQUIRE(std::abs(double(gyro.timestamp) - (ts + (i - (LSM6DS3_FIFO_WATERMARK_SETS - 1)) * period)) < 2);
+    // device frame y, -x, z
+    REQUIRE(gyro.v[1] == Approx(-100 * i * 8.75 / 1000.0 * M_PI / 180.0));
+    REQUIRE(accel.v[0] == Approx(20 * 9.81 * 2.0 / (1 << 15)));
+    REQUIRE(accel.v[1] == Approx(-1000 * i * 9.81 * 2.0 / (1 << 15)));
+  }
+
+  // less than a set, nothing to publish
+  chip.push_words({1, 2, 3});
+  REQUIRE(get_events(sensor, ts + 1e8).empty());
+}
+
+TEST_CASE("LSM6DS3_Fifo resyncs to the start of a set") {
+  FakeI2CBus bus;
+  FakeLSM6DS3 chip(&bus);
+  LSM6DS3_Fifo sensor(&bus);
+  // a failed read left the FIFO after the gyro words of a set
+  chip.set_pattern(3);
+  chip.push_words({-1, -1, -1});
+  chip.push_set(10, 0, 0, 20, 0, 0);
+
+  auto events = get_events(sensor, nanos_since_boot() - 1e9);
+  REQUIRE(events.size() == 2);
+  REQUIRE(events[0].v[1] == Approx(-10 * 8.75 / 1000.0 * M_PI / 180.0));
+}
+
+TEST_CASE("LSM6DS3_Fifo timestamps with interrupt jitter") {
+  FakeI2CBus bus;
+  FakeLSM6DS3 chip(&bus);
+  LSM6DS3_Fifo sensor(&bus);
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> jitter(0.0, 1e6);
+
+  // the chip runs 3% slow, interrupts are handled up to 1 ms late and sometimes the read is so
+  // late that an extra set is in the FIFO
+  const double true_period = 1.03e9 / LSM6DS3_FIFO_ODR_HZ;
+  // synthetic times, the run ends about 10 s after boot. Samples are capped at the current
+  // time, which is later on any machine that runs tests.
+  const uint64_t start = 1e8;
+  int sample = 0;
+  uint64_t prev_ts = 0;
+  double max_err = 0;
+  for (int batch = 0; batch < 200; batch++) {
+    const int trigger = sample + LSM6DS3_FIFO_WATERMARK_SETS - 1;
+    const int sets = LSM6DS3_FIFO_WATERMARK_SETS + (batch % 10 == 9 ? 1 : 0);
+    for (int i = 0; i < sets; i++) {
+      chip.push_set(0, 0, 0, 0, 0, 0);
+    }
+
+    auto events = get_events(sensor, start + trigger * true_period + jitter(rng));
+    REQUIRE(events.size() == 2 * sets);
+    for (int i = 0; i < sets; i++, sample++) {
+      const uint64_t ts = events[2 * i].timestamp;
+      REQUIRE(ts > prev_ts);
+      prev_ts = ts;
+      if (batch >= 50) {
+        max_err = std::max(max_err, std::abs(double(ts) - (start + sample * true_period)));
+      }
+    }
+  }
+  INFO("max error " << max_err / 1e6 << " ms");
+  REQUIRE(max_err < 2e6);
+}
@@ -175,6 +175,7 @@ class TestSensord:
     # ensure diff between the message logMonotime and sample timestamp is small
 
     tdiffs = list()
+    fifo_diffs = list()
     for etype in self.events:
       for measurement in self.events[etype]:
         m = getattr(measurement, measurement.which())
@@ -184,10 +185,20 @@ class TestSensord:
           err_msg = f"Timestamp after logMonoTime: {m.timestamp} > {measurement.logMonoTime}"
           assert m.timestamp < measurement.logMonoTime, err_msg
 
+          # gyro and accel are read from the FIFO in batches, the oldest sample of a batch
+          # is published about one watermark (5 samples at 104Hz) after it was taken
+          fifo_diffs.append((measurement.logMonoTime - m.timestamp) / 1e6)
+          continue
+
         # negative values might occur, as non interrupt packages created
         # before the sensor is read
         tdiffs.append(abs(measurement.logMonoTime - m.timestamp) / 1e6)
 
+    late_fifo_diffs = set(filter(lambda d: d >= 75., fifo_diffs))
+    assert len(late_fifo_diffs) < 20, f"Too many late FIFO measurements: {late_fifo_diffs}"
+    avg_fifo_diff = sum(fifo_diffs)/len(fifo_diffs)
+    assert avg_fifo_diff < 35, f"Avg FIFO packet diff: {avg_fifo_diff:.1f}ms"
+
     # some sensors have a read procedure that will introduce an expected diff on the order of 20ms
     high_delay_diffs = set(filter(lambda d: d >= 25., tdiffs))
     assert len(high_delay_diffs) < 20, f"Too many measurements published: {high_delay_diffs}"
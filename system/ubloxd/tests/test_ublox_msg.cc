@@ -0,0 +1,395 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "system/ubloxd/ublox_msg.h"
+
+namespace {
+
+std::string ubx_frame(uint16_t msg_type, const std::string &payload) {
+  std::string msg = {(char)ublox::PREAMBLE1, (char)ublox::PREAMBLE2, (char)(msg_type >> 8), (char)(msg_type & 0xff),
+                     (char)(payload.size() & 0xff), (char)(payload.size() >> 8)};
+  return ublox::ubx_add_checksum(msg + payload);
+}
+
+template <typename T>
+std::string as_bytes(const T &t) {
+  return std::string((const char *)&t, sizeof(t));
+}
+
+std::string nav_pvt_payload(std::mt19937 &rng) {
+  std::uniform_int_distribution<int32_t> dist(-1000000, 1000000);
+  ublox::ubx_nav_pvt_t pvt = {};
+  pvt.iTOW = rng();
+  pvt.year = 2020 + rng() % 10;
+  pvt.month = 1 + rng() % 12;
+  pvt.day = 1 + rng() % 28;
+  pvt.hour = rng() % 24;
+  pvt.min = rng() % 60;
+  pvt.sec = rng() % 60;
+  pvt.nano = dist(rng);
+  pvt.flags = rng();
+  pvt.numSV = rng() % 32;
+  pvt.lon = dist(rng) * 1000;
+  pvt.lat = dist(rng) * 500;
+  pvt.height = dist(rng);
+  pvt.hAcc = rng() % 100000;
+  pvt.vAcc = rng() % 100000;
+  pvt.velN = dist(rng);
+  pvt.velE = dist(rng);
+  pvt.velD = dist(rng);
+  pvt.gSpeed = dist(rng);
+  pvt.headMot = dist(rng) * 30;
+  pvt.sAcc = rng() % 100000;
+  pvt.headAcc = rng() % 100000;
+  return as_bytes(pvt);
+}
+
+std::string rxm_rawx_payload(std::mt19937 &rng, int num_meas) {
+  std::uniform_real_distribution<double> dist(-1e7, 1e7);
+  ublox::ubx_rxm_rawx_t rawx = {};
+  rawx.rcvTow = std::abs(dist(rng));
+  rawx.week = rng() % 3000;
+  rawx.leapS = 18;
+  rawx.numMeas = num_meas;
+  rawx.recStat = rng();
+  std::string payload = as_bytes(rawx);
+  for (int i = 0; i < num_meas; i++) {
+    ublox::ubx_rxm_rawx_meas_t meas = {};
+    meas.prMes = 2e7 + dist(rng);
+    meas.cpMes = dist(rng) * 10;
+    meas.doMes = dist(rng) * 1e-4;
+    meas.gnssId = rng() % 7;
+    meas.svId = rng() % 64;
+    meas.freqId = rng() % 14;
+    meas.locktime = rng();
+    meas.cno = rng() % 60;
+    meas.prStdev = rng();
+    meas.cpStdev = rng();
+    meas.doStdev = rng();
+    meas.trkStat = rng();
+    payload += as_bytes(meas);
+  }
+  return payload;
+}
+
+std::string nav_sat_payload(std::mt19937 &rng, int num_svs) {
+  ublox::ubx_nav_sat_t sat = {};
+  sat.iTOW = rng();
+  sat.version = 1;
+  sat.numSvs = num_svs;
+  std::string payload = as_bytes(sat);
+  for (int i = 0; i < num_svs; i++) {
+    ublox::ubx_nav_sat_sv_t sv = {};
+    sv.gnssId = rng() % 7;
+    sv.svId = rng() % 64;
+    sv.cno = rng() % 60;
+    sv.elev = rng() % 90;
+    sv.azim = rng() % 360;
+    sv.flags = rng();
+    payload += as_bytes(sv);
+  }
+  return payload;
+}
+
+std::string random_frame(std::mt19937 &rng) {
+  switch (rng() % 3) {
+  case 0: return ubx_frame(0x0107, nav_pvt_payload(rng));
+  case 1: return ubx_frame(0x0215, rxm_rawx_payload(rng, rng() % 40));
+  default: return ubx_frame(0x0135, nav_sat_payload(rng, rng() % 40));
+  }
+}
+
+std::string rxm_sfrbx_frame(uint8_t gnss_id, uint8_t sv_id, uint8_t freq_id, const std::vector<uint32_t> &words) {
+  std::string payload = {(char)gnss_id, (char)sv_id, 0, (char)freq_id, (char)words.size(), 0, 2, 0};
+  for (uint32_t word : words) payload += as_bytes(word);
+  return ubx_frame(0x0213, payload);
+}
+
+// 10 words of 24 data bits followed by 6 parity bits, with the issue of data in the bytes
+// gps.ksy reads IODC/IODE from
+std::vector<uint32_t> gps_subframe(std::mt19937 &rng, int subframe_id, uint8_t iode) {
+  uint8_t data[30];
+  for (uint8_t &b : data) b = rng();
+  data[0] = 0x8b;
+  data[5] = (data[5] & ~(0x7 << 2)) | (subframe_id << 2);
+  data[subframe_id == 1 ? 21 : (subframe_id == 2 ? 6 : 27)] = iode;
+
+  std::vector<uint32_t> words;
+  for (int i = 0; i < 10; i++) {
+    words.push_back(((data[i * 3] << 16) | (data[i * 3 + 1] << 8) | data[i * 3 + 2]) << 6);
+  }
+  return words;
+}
+
+// immediate data string of a GLONASS frame, 4 words with the superframe number in the third
+std::vector<uint32_t> glonass_string(std::mt19937 &rng, int string_number, uint16_t superframe) {
+  std::vector<uint32_t> words = {rng(), rng(), rng(), rng()};
+  words[0] = (words[0] & ~(0x1fu << 27)) | (string_number << 27);
+  words[3] = (words[3] & 0xffff) | (superframe << 16);
+  return words;
+}
+
+// feeds data in chunks like ubloxd does and returns the frames in the order they were found
+std::vector<std::string> parse_all(UbloxMsgParser &parser, const std::string &data, size_t chunk_size) {
+  std::vector<std::string> frames;
+  for (size_t offset = 0; offset < data.size(); offset += chunk_size) {
+    const uint8_t *chunk = (const uint8_t *)data.data() + offset;
+    const size_t len = std::min(chunk_size, data.size() - offset);
+    size_t bytes_consumed = 0;
+    while (true) {
+      size_t bytes_consumed_this_time = 0;
+      bool frame_ready = parser.add_data(0.0, chunk + bytes_consumed, len - bytes_consumed, bytes_consumed_this_time);
+      bytes_consumed += bytes_consumed_this_time;
+      if (!frame_ready) break;
+      frames.push_back(parser.data());
+      parser.pop_frame();
+    }
+    REQUIRE(bytes_consumed == len);
+  }
+  return frames;
+}
+
+}  // namespace
+
+TEST_CASE("UbloxMsgParser finds frames between garbage") {
+  std::mt19937 rng(42);
+  for (size_t chunk_size : {1, 7, 64, 1024, 100000}) {
+    std::string data;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 200; i++) {
+      switch (rng() % 5) {
+      case 0: {
+        // random bytes with false preambles
+        std::string garbage(rng() % 300, '\0');
+        for (char &c : garbage) c = (rng() % 4 == 0) ? ublox::PREAMBLE1 : rng();
+        data += garbage;
+        break;
+      }
+      case 1: {
+        // corrupted frame
+        std::string frame = random_frame(rng);
+        frame[ublox::UBLOX_HEADER_SIZE + rng() % (frame.size() - ublox::UBLOX_HEADER_SIZE)] ^= 1 << (rng() % 8);
+        data += frame;
+        break;
+      }
+      case 2:
+        // a preamble with a length that runs into the next frame
+        data += std::string({(char)ublox::PREAMBLE1, (char)ublox::PREAMBLE2, 0x01, 0x07, 0x40, 0x00});
+        break;
+      default:
+        expected.push_back(random_frame(rng));
+        data += expected.back();
+      }
+    }
+
+    UbloxMsgParser parser;
+    auto frames = parse_all(parser, data, chunk_size);
+    INFO("chunk size " << chunk_size);
+    // frames that got swallowed by a bogus length are found again after resyncing
+    REQUIRE(frames == expected);
+  }
+}
+
+TEST_CASE("UbloxMsgParser drops truncated payloads") {
+  std::mt19937 rng(0);
+  UbloxMsgParser parser;
+  std::string payload = rxm_rawx_payload(rng, 10);
+  std::string frame = ubx_frame(0x0215, payload.substr(0, payload.size() - 1));
+  size_t bytes_consumed = 0;
+  REQUIRE(parser.add_data(0.0, (const uint8_t *)frame.data(), frame.size(), bytes_consumed));
+  REQUIRE_THROWS(parser.gen_msg());
+}
+
+TEST_CASE("UbloxMsgParser packed decoders match kaitai") {
+  std::mt19937 rng(1);
+  UbloxMsgParser parser;
+  for (int i = 0; i < 300; i++) {
+    const std::string frame = random_frame(rng);
+    size_t bytes_consumed = 0;
+    REQUIRE(parser.add_data(0.0, (const uint8_t *)frame.data(), frame.size(), bytes_consumed));
+    auto [service, words] = parser.gen_msg();
+    parser.pop_frame();
+
+    kaitai::kstream stream(frame);
+    ubx_t ubx_message(&stream);
+    capnp::FlatArrayMessageReader reader(words.asPtr());
+    auto event = reader.getRoot<cereal::Event>();
+
+    if (ubx_message.msg_type() == 0x0107) {
+      auto msg = static_cast<ubx_t::nav_pvt_t *>(ubx_message.body());
+      REQUIRE(service == "gpsLocationExternal");
+      auto gpsLoc = event.getGpsLocationExternal();
+      REQUIRE(gpsLoc.getFlags() == msg->flags());
+      REQUIRE(gpsLoc.getLatitude() == msg->lat() * 1e-07);
+      REQUIRE(gpsLoc.getLongitude() == msg->lon() * 1e-07);
+      REQUIRE(gpsLoc.getAltitude() == msg->height() * 1e-03);
+      REQUIRE(gpsLoc.getSpeed() == (float)(msg->g_speed() * 1e-03));
+      REQUIRE(gpsLoc.getBearingDeg() == (float)(msg->head_mot() * 1e-5));
+      REQUIRE(gpsLoc.getHorizontalAccuracy() == (float)(msg->h_acc() * 1e-03));
+      REQUIRE(gpsLoc.getVNED()[2] == msg->vel_d() * 1e-03f);
+      REQUIRE(gpsLoc.getSpeedAccuracy() == (float)(msg->s_acc() * 1e-03));
+      REQUIRE(gpsLoc.getBearingAccuracyDeg() == (float)(msg->head_acc() * 1e-05));
+    } else if (ubx_message.msg_type() == 0x0215) {
+      auto msg = static_cast<ubx_t::rxm_rawx_t *>(ubx_message.body());
+      auto mr = event.getUbloxGnss().getMeasurementReport();
+      REQUIRE(mr.getRcvTow() == msg->rcv_tow());
+      REQUIRE(mr.getGpsWeek() == msg->week());
+      REQUIRE(mr.getNumMeas() == msg->num_meas());
+      REQUIRE(mr.getReceiverStatus().getClkReset() == (bool)(msg->rec_stat() & 4));
+      auto measurements = *msg->meas();
+      for (int j = 0; j < msg->num_meas(); j++) {
+        auto m = mr.getMeasurements()[j];
+        REQUIRE(m.getSvId() == measurements[j]->sv_id());
+        REQUIRE(m.getGnssId() == measurements[j]->gnss_id());
+        REQUIRE(m.getPseudorange() == measurements[j]->pr_mes());
+        REQUIRE(m.getCarrierCycles() == measurements[j]->cp_mes());
+        REQUIRE(m.getDoppler() == measurements[j]->do_mes());
+        REQUIRE(m.getLocktime() == measurements[j]->lock_time());
+        REQUIRE(m.getPseudorangeStdev() == (float)(0.01 * pow(2, measurements[j]->pr_stdev() & 15)));
+        REQUIRE(m.getTrackingStatus().getHalfCycleSubtracted() == (bool)(measurements[j]->trk_stat() & 8));
+      }
+    } else {
+      auto msg = static_cast<ubx_t::nav_sat_t *>(ubx_message.body());
+      auto sr = event.getUbloxGnss().getSatReport();
+      REQUIRE(sr.getITow() == msg->itow());
+      REQUIRE(sr.getSvs().size() == msg->num_svs());
+      auto svs = *msg->svs();
+      for (int j = 0; j < msg->num_svs(); j++) {
+        REQUIRE(sr.getSvs()[j].getSvId() == svs[j]->sv_id());
+        REQUIRE(sr.getSvs()[j].getGnssId() == svs[j]->gnss_id());
+        REQUIRE(sr.getSvs()[j].getFlagsBitfield() == svs[j]->flags());
+      }
+    }
+  }
+}
+
+TEST_CASE("UbloxMsgParser assembles ephemerides") {
+  std::mt19937 rng(3);
+  UbloxMsgParser parser;
+  auto feed = [&](const std::string &frame) {
+    size_t bytes_consumed = 0;
+    REQUIRE(parser.add_data(0.0, (const uint8_t *)frame.data(), frame.size(), bytes_consumed));
+    auto words = parser.gen_msg().second;
+    parser.pop_frame();
+    return words;
+  };
+
+  SECTION("GPS") {
+    // subframes of two SVs interleaved, almanac subframes in between
+    for (int subframe_id : {2, 4, 1, 5, 3}) {
+      for (int sv_id : {5, 7}) {
+        auto words = feed(rxm_sfrbx_frame(0, sv_id, 0, gps_subframe(rng, subframe_id, 42)));
+        if (subframe_id == 3) {
+          capnp::FlatArrayMessageReader reader(words.asPtr());
+          auto eph = reader.getRoot<cereal::Event>().getUbloxGnss().getEphemeris();
+          REQUIRE(eph.getSvId() == sv_id);
+          REQUIRE(eph.getIode() == 42);
+        } else {
+          REQUIRE(words.size() == 0);
+        }
+      }
+    }
+
+    // a data set cutover is rejected, and the next set starts from scratch
+    feed(rxm_sfrbx_frame(0, 9, 0, gps_subframe(rng, 1, 1)));
+    feed(rxm_sfrbx_frame(0, 9, 0, gps_subframe(rng, 2, 2)));
+    REQUIRE(feed(rxm_sfrbx_frame(0, 9, 0, gps_subframe(rng, 3, 2))).size() == 0);
+    REQUIRE(feed(rxm_sfrbx_frame(0, 9, 0, gps_subframe(rng, 1, 2))).size() == 0);
+  }
+
+  SECTION("GLONASS") {
+    for (int string_number = 1; string_number <= 5; string_number++) {
+      auto words = feed(rxm_sfrbx_frame(6, 3, 8, glonass_string(rng, string_number, 100)));
+      if (string_number < 5) {
+        REQUIRE(words.size() == 0);
+      } else {
+        capnp::FlatArrayMessageReader reader(words.asPtr());
+        auto eph = reader.getRoot<cereal::Event>().getUbloxGnss().getGlonassEphemeris();
+        REQUIRE(eph.getSvId() == 3);
+        REQUIRE(eph.getFreqNum() == 1);
+      }
+    }
+
+    // strings from another superframe start a new set
+    for (int string_number = 1; string_number <= 5; string_number++) {
+      uint16_t superframe = string_number == 3 ? 101 : 102;
+      REQUIRE(feed(rxm_sfrbx_frame(6, 3, 8, glonass_string(rng, string_number, superframe))).size() == 0);
+    }
+  }
+}
+
+// not run by default: ./test_glonass_runner "[benchmark]"
+TEST_CASE("UbloxMsgParser ephemeris throughput", "[.][benchmark]") {
+  std::mt19937 rng(4);
+  // all subframes of a full GPS and GLONASS constellation
+  std::string data;
+  for (int subframe_id = 1; subframe_id <= 5; subframe_id++) {
+    for (int sv_id = 1; sv_id <= 32; sv_id++) {
+      data += rxm_sfrbx_frame(0, sv_id, 0, gps_subframe(rng, subframe_id, sv_id));
+    }
+  }
+  for (int string_number = 1; string_number <= 15; string_number++) {
+    for (int freq_id = 0; freq_id < 14; freq_id++) {
+      data += rxm_sfrbx_frame(6, freq_id + 1, freq_id, glonass_string(rng, string_number, 1));
+    }
+  }
+
+  const int rounds = 200;
+  int ephemerides = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    UbloxMsgParser parser;
+    size_t offset = 0, bytes_consumed = 0;
+    while (parser.add_data(0.0, (const uint8_t *)data.data() + offset, data.size() - offset, bytes_consumed)) {
+      offset += bytes_consumed;
+      ephemerides += parser.gen_msg().second.size() > 0;
+      parser.pop_frame();
+    }
+  }
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("full constellation: %.3f ms, %d ephemerides\n", secs * 1000 / rounds, ephemerides / rounds);
+}
+
+// not run by default: ./test_glonass_runner "[benchmark]"
+TEST_CASE("UbloxMsgParser throughput", "[.][benchmark]") {
+  std::mt19937 rng(2);
+  // what the receiver sends every 100 ms, split into 4 KB reads by pigeond
+  std::string data;
+  int num_frames = 0;
+  for (int i = 0; i < 1000; i++, num_frames += 3) {
+    data += ubx_frame(0x0107, nav_pvt_payload(rng));
+    data += ubx_frame(0x0215, rxm_rawx_payload(rng, 32));
+    data += ubx_frame(0x0135, nav_sat_payload(rng, 40));
+  }
+
+  UbloxMsgParser parser;
+  auto start = std::chrono::steady_clock::now();
+  size_t output_words = 0;
+  for (size_t offset = 0; offset < data.size(); offset += 4096) {
+    const size_t len = std::min<size_t>(4096, data.size() - offset);
+    size_t bytes_consumed = 0;
+    while (true) {
+      size_t bytes_consumed_this_time = 0;
+      bool frame_ready = parser.add_data(0.0, (const uint8_t *)data.data() + offset + bytes_consumed, len - bytes_consumed, bytes_consumed_this_time);
+      bytes_consumed += bytes_consumed_this_time;
+      if (!frame_ready) break;
+      output_words += parser.gen_msg().second.size();
+      parser.pop_frame();
+    }
+  }
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("framing and decoding: %.1f MB/s, %.0f frames/s (%zu words out)\n", data.size() / secs / 1e6, num_frames / secs, output_words);
+
+  // resyncing through a stream of false preambles
+  std::string garbage(4 << 20, '\0');
+  for (char &c : garbage) c = (rng() % 2) ? ublox::PREAMBLE1 : rng();
+  start = std::chrono::steady_clock::now();
+  auto frames = parse_all(parser, garbage, 4096);
+  secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("garbage: %.1f MB/s, %zu false frames\n", garbage.size() / secs / 1e6, frames.size());
+}
@@ -3,99 +3,125 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <iterator>
+#include <stdexcept>
 #include <unordered_map>
 #include <utility>
 
 #include "common/swaglog.h"
 
 const double gpsPi = 3.1415926535898;
+const uint8_t gpsTlmPreamble = 0x8b;
 #define UBLOX_MSG_SIZE(hdr) (*(uint16_t *)&hdr[4])
 
 inline static bool bit_to_bool(uint8_t val, int shifts) {
   return (bool)(val & (1 << shifts));
 }
 
-inline int UbloxMsgParser::needed_bytes() {
-  // Msg header incomplete?
-  if (bytes_in_parse_buf < ublox::UBLOX_HEADER_SIZE)
-    return ublox::UBLOX_HEADER_SIZE + ublox::UBLOX_CHECKSUM_SIZE - bytes_in_parse_buf;
-  uint16_t needed = UBLOX_MSG_SIZE(msg_parse_buf) + ublox::UBLOX_HEADER_SIZE + ublox::UBLOX_CHECKSUM_SIZE;
-  // too much data
-  if (needed < (uint16_t)bytes_in_parse_buf)
-    return -1;
-  return needed - (uint16_t)bytes_in_parse_buf;
+// the ephemeris parts are only copied into a stream for kaitai once a set is complete
+template <size_t N>
+inline static std::string raw_string(const std::array<uint8_t, N> &data) {
+  return std::string((const char *)data.data(), N);
 }
 
-inline bool UbloxMsgParser::valid_cheksum() {
+bool UbloxMsgParser::valid_checksum(const uint8_t *frame, size_t size) {
   uint8_t ck_a = 0, ck_b = 0;
-  for (int i = 2; i < bytes_in_parse_buf - ublox::UBLOX_CHECKSUM_SIZE; i++) {
-    ck_a = (ck_a + msg_parse_buf[i]) & 0xFF;
+  for (size_t i = 2; i < size - ublox::UBLOX_CHECKSUM_SIZE; i++) {
+    ck_a = (ck_a + frame[i]) & 0xFF;
     ck_b = (ck_b + ck_a) & 0xFF;
   }
-  if (ck_a != msg_parse_buf[bytes_in_parse_buf - 2]) {
-    LOGD("Checksum a mismatch: %02X, %02X", ck_a, msg_parse_buf[6]);
+  if (ck_a != frame[size - 2]) {
+    LOGD("Checksum a mismatch: %02X, %02X", ck_a, frame[size - 2]);
     return false;
   }
-  if (ck_b != msg_parse_buf[bytes_in_parse_buf - 1]) {
-    LOGD("Checksum b mismatch: %02X, %02X", ck_b, msg_parse_buf[7]);
+  if (ck_b != frame[size - 1]) {
+    LOGD("Checksum b mismatch: %02X, %02X", ck_b, frame[size - 1]);
     return false;
   }
   return true;
 }
 
-inline bool UbloxMsgParser::valid() {
-  return bytes_in_parse_buf >= ublox::UBLOX_HEADER_SIZE + ublox::UBLOX_CHECKSUM_SIZE &&
-         needed_bytes() == 0 && valid_cheksum();
-}
-
-inline bool UbloxMsgParser::valid_so_far() {
-  if (bytes_in_parse_buf > 0 && msg_parse_buf[0] != ublox::PREAMBLE1) {
-    return false;
-  }
-  if (bytes_in_parse_buf > 1 && msg_parse_buf[1] != ublox::PREAMBLE2) {
-    return false;
+// Moves buf_start to the next valid frame. Returns false if there is none yet, then the window
+// is either empty or starts with the preamble of a frame that isn't complete.
+bool UbloxMsgParser::find_frame() {
+  frame_size = 0;
+  while (buf_start < buf_end) {
+    const uint8_t *frame = msg_parse_buf + buf_start;
+    const size_t available = buf_end - buf_start;
+    if (frame[0] != ublox::PREAMBLE1) {
+      const uint8_t *next = (const uint8_t *)memchr(frame, ublox::PREAMBLE1, available);
+      buf_start = next ? next - msg_parse_buf : buf_end;
+      continue;
+    }
+    if (available < 2) break;
+    if (frame[1] != ublox::PREAMBLE2) {
+      buf_start++;
+      continue;
+    }
+    if (available < ublox::UBLOX_HEADER_SIZE) break;
+    const size_t size = ublox::UBLOX_HEADER_SIZE + UBLOX_MSG_SIZE(frame) + ublox::UBLOX_CHECKSUM_SIZE;
+    if (available < size) break;
+    if (!valid_checksum(frame, size)) {
+      // Corrupted msg, resync at the next preamble.
+      buf_start++;
+      continue;
+    }
+    frame_size = size;
+    return true;
   }
-  if (needed_bytes() == 0 && !valid()) {
-    return false;
+
+  if (buf_start == buf_end) {
+    buf_start = buf_end = 0;
   }
-  return true;
+  return false;
 }
 
 bool UbloxMsgParser::add_data(float log_time, const uint8_t *incoming_data, uint32_t incoming_data_len, size_t &bytes_consumed) {
   last_log_time = log_time;
-  int needed = needed_bytes();
-  if (needed > 0) {
-    bytes_consumed = std::min((uint32_t)needed, incoming_data_len);
-    // Add data to buffer
-    memcpy(msg_parse_buf + bytes_in_parse_buf, incoming_data, bytes_consumed);
-    bytes_in_parse_buf += bytes_consumed;
-  } else {
-    bytes_consumed = incoming_data_len;
-  }
-
-  // Validate msg format, detect invalid header and invalid checksum.
-  while (!valid_so_far() && bytes_in_parse_buf != 0) {
-    // Corrupted msg, drop a byte.
-    bytes_in_parse_buf -= 1;
-    if (bytes_in_parse_buf > 0)
-      memmove(&msg_parse_buf[0], &msg_parse_buf[1], bytes_in_parse_buf);
-  }
-
-  // There is redundant data at the end of buffer, reset the buffer.
-  if (needed_bytes() == -1) {
-    bytes_in_parse_buf = 0;
+  bytes_consumed = 0;
+  while (!find_frame()) {
+    if (bytes_consumed == incoming_data_len) {
+      return false;
+    }
+    // an incomplete frame is shorter than half the buffer, so this always frees enough space
+    if (buf_end == sizeof(msg_parse_buf)) {
+      memmove(msg_parse_buf, msg_parse_buf + buf_start, buf_end - buf_start);
+      buf_end -= buf_start;
+      buf_start = 0;
+    }
+    const size_t n = std::min(sizeof(msg_parse_buf) - buf_end, incoming_data_len - bytes_consumed);
+    memcpy(msg_parse_buf + buf_end, incoming_data + bytes_consumed, n);
+    buf_end += n;
+    bytes_consumed += n;
   }
-  return valid();
+  return true;
 }
 
 
 std::pair<std::string, kj::Array<capnp::word>> UbloxMsgParser::gen_msg() {
+  const uint8_t *frame = msg_parse_buf + buf_start;
+  const uint8_t *payload = frame + ublox::UBLOX_HEADER_SIZE;
+  const size_t payload_len = frame_size - ublox::UBLOX_HEADER_SIZE - ublox::UBLOX_CHECKSUM_SIZE;
+  const uint16_t msg_type = (frame[2] << 8) | frame[3];
+
+  // the high rate messages are decoded straight from the buffer
+  switch (msg_type) {
+  case 0x0107:
+    return {"gpsLocationExternal", gen_nav_pvt(payload, payload_len)};
+  case 0x0215: // UBX-RXM-RAW (Multi-GNSS Raw Measurement Data)
+    return {"ubloxGnss", gen_rxm_rawx(payload, payload_len)};
+  case 0x0135:
+    return {"ubloxGnss", gen_nav_sat(payload, payload_len)};
+  }
+
   std::string dat = data();
   kaitai::kstream stream(dat);
 
@@ -103,18 +129,12 @@ std::pair<std::string, kj::Array<capnp::word>> UbloxMsgParser::gen_msg() {
   auto body = ubx_message.body();
 
   switch (ubx_message.msg_type()) {
-  case 0x0107:
-    return {"gpsLocationExternal", gen_nav_pvt(static_cast<ubx_t::nav_pvt_t*>(body))};
   case 0x0213: // UBX-RXM-SFRB (Broadcast Navigation Data Subframe)
     return {"ubloxGnss", gen_rxm_sfrbx(static_cast<ubx_t::rxm_sfrbx_t*>(body))};
-  case 0x0215: // UBX-RXM-RAW (Multi-GNSS Raw Measurement Data)
-    return {"ubloxGnss", gen_rxm_rawx(static_cast<ubx_t::rxm_rawx_t*>(body))};
   case 0x0a09:
     return {"ubloxGnss", gen_mon_hw(static_cast<ubx_t::mon_hw_t*>(body))};
   case 0x0a0b:
     return {"ubloxGnss", gen_mon_hw2(static_cast<ubx_t::mon_hw2_t*>(body))};
-  case 0x0135:
-    return {"ubloxGnss", gen_nav_sat(static_cast<ubx_t::nav_sat_t*>(body))};
   default:
     LOGE("Unknown message type %x", ubx_message.msg_type());
     return {"ubloxGnss", kj::Array<capnp::word>()};
@@ -122,33 +142,39 @@ std::pair<std::string, kj::Array<capnp::word>> UbloxMsgParser::gen_msg() {
 }
 
 
-kj::Array<capnp::word> UbloxMsgParser::gen_nav_pvt(ubx_t::nav_pvt_t *msg) {
-  MessageBuilder msg_builder;
+kj::Array<capnp::word> UbloxMsgParser::gen_nav_pvt(const uint8_t *payload, size_t len) {
+  if (len < sizeof(ublox::ubx_nav_pvt_t)) {
+    throw std::runtime_error("NAV-PVT payload too short");
+  }
+  ublox::ubx_nav_pvt_t msg;
+  memcpy(&msg, payload, sizeof(msg));
+
+  MessageBuilder msg_builder(kj::arrayPtr(msg_segment, std::size(msg_segment)));
   auto gpsLoc = msg_builder.initEvent().initGpsLocationExternal();
   gpsLoc.setSource(cereal::GpsLocationData::SensorSource::UBLOX);
-  gpsLoc.setFlags(msg->flags());
-  gpsLoc.setHasFix((msg->flags() % 2) == 1);
-  gpsLoc.setLatitude(msg->lat() * 1e-07);
-  gpsLoc.setLongitude(msg->lon() * 1e-07);
-  gpsLoc.setAltitude(msg->height() * 1e-03);
-  gpsLoc.setSpeed(msg->g_speed() * 1e-03);
-  gpsLoc.setBearingDeg(msg->head_mot() * 1e-5);
-  gpsLoc.setHorizontalAccuracy(msg->h_acc() * 1e-03);
+  gpsLoc.setFlags(msg.flags);
+  gpsLoc.setHasFix((msg.flags % 2) == 1);
+  gpsLoc.setLatitude(msg.lat * 1e-07);
+  gpsLoc.setLongitude(msg.lon * 1e-07);
+  gpsLoc.setAltitude(msg.height * 1e-03);
+  gpsLoc.setSpeed(msg.gSpeed * 1e-03);
+  gpsLoc.setBearingDeg(msg.headMot * 1e-5);
+  gpsLoc.setHorizontalAccuracy(msg.hAcc * 1e-03);
   std::tm timeinfo = std::tm();
-  timeinfo.tm_year = msg->year() - 1900;
-  timeinfo.tm_mon = msg->month() - 1;
-  timeinfo.tm_mday = msg->day();
-  timeinfo.tm_hour = msg->hour();
-  timeinfo.tm_min = msg->min();
-  timeinfo.tm_sec = msg->sec();
+  timeinfo.tm_year = msg.year - 1900;
+  timeinfo.tm_mon = msg.month - 1;
+  timeinfo.tm_mday = msg.day;
+  timeinfo.tm_hour = msg.hour;
+  timeinfo.tm_min = msg.min;
+  timeinfo.tm_sec = msg.sec;
 
   std::time_t utc_tt = timegm(&timeinfo);
-  gpsLoc.setUnixTimestampMillis(utc_tt * 1e+03 + msg->nano() * 1e-06);
-  float f[] = { msg->vel_n() * 1e-03f, msg->vel_e() * 1e-03f, msg->vel_d() * 1e-03f };
+  gpsLoc.setUnixTimestampMillis(utc_tt * 1e+03 + msg.nano * 1e-06);
+  float f[] = { msg.velN * 1e-03f, msg.velE * 1e-03f, msg.velD * 1e-03f };
   gpsLoc.setVNED(f);
-  gpsLoc.setVerticalAccuracy(msg->v_acc() * 1e-03);
-  gpsLoc.setSpeedAccuracy(msg->s_acc() * 1e-03);
-  gpsLoc.setBearingAccuracyDeg(msg->head_acc() * 1e-05);
+  gpsLoc.setVerticalAccuracy(msg.vAcc * 1e-03);
+  gpsLoc.setSpeedAccuracy(msg.sAcc * 1e-03);
+  gpsLoc.setBearingAccuracyDeg(msg.headAcc * 1e-05);
   return capnp::messageToFlatArray(msg_builder);
 }
 
@@ -158,30 +184,32 @@ kj::Array<capnp::word> UbloxMsgParser::parse_gps_ephemeris(ubx_t::rxm_sfrbx_t *m
   auto body = *msg->body();
   assert(body.size() == 10);
 
-  std::string subframe_data;
-  subframe_data.reserve(30);
-  for (uint32_t word : body) {
-    word = word >> 6; // TODO: Verify parity
-    subframe_data.push_back(word >> 16);
-    subframe_data.push_back(word >> 8);
-    subframe_data.push_back(word >> 0);
+  std::array<uint8_t, 30> subframe_data;
+  for (int i = 0; i < 10; i++) {
+    uint32_t word = body[i] >> 6; // TODO: Verify parity
+    subframe_data[i * 3 + 0] = word >> 16;
+    subframe_data[i * 3 + 1] = word >> 8;
+    subframe_data[i * 3 + 2] = word >> 0;
   }
 
-  // Collect subframes in map and parse when we have all the parts
-  {
-    kaitai::kstream stream(subframe_data);
-    gps_t subframe(&stream);
-
-    int subframe_id = subframe.how()->subframe_id();
-    if (subframe_id > 3 || subframe_id < 1) {
-      // don't parse almanac subframes
-      return kj::Array<capnp::word>();
-    }
-    gps_subframes[msg->sv_id()][subframe_id] = subframe_data;
+  // Collect subframes and parse when we have all the parts. The subframe id is the
+  // 3 bits before the last 2 of the HOW word.
+  if (subframe_data[0] != gpsTlmPreamble) {
+    throw std::runtime_error("GPS subframe without TLM preamble");
   }
+  int subframe_id = (subframe_data[5] >> 2) & 0x7;
+  if (subframe_id > 3 || subframe_id < 1) {
+    // don't parse almanac subframes
+    return kj::Array<capnp::word>();
+  }
+  GpsSubframes &subframes = gps_subframes[msg->sv_id()];
+  subframes.data[subframe_id - 1] = subframe_data;
+  subframes.valid |= 1 << (subframe_id - 1);
 
   // publish if subframes 1-3 have been collected
-  if (gps_subframes[msg->sv_id()].size() == 3) {
+  if (subframes.valid == 0b111) {
+    subframes.valid = 0;
+
     MessageBuilder msg_builder;
     auto eph = msg_builder.initEvent().initUbloxGnss().initEphemeris();
     eph.setSvId(msg->sv_id());
@@ -193,7 +221,7 @@ kj::Array<capnp::word> UbloxMsgParser::parse_gps_ephemeris(ubx_t::rxm_sfrbx_t *m
 
     // Subframe 1
     {
-      kaitai::kstream stream(gps_subframes[msg->sv_id()][1]);
+      kaitai::kstream stream(raw_string(subframes.data[0]));
       gps_t subframe(&stream);
       gps_t::subframe_1_t* subframe_1 = static_cast<gps_t::subframe_1_t*>(subframe.body());
 
@@ -217,7 +245,7 @@ kj::Array<capnp::word> UbloxMsgParser::parse_gps_ephemeris(ubx_t::rxm_sfrbx_t *m
 
     // Subframe 2
     {
-      kaitai::kstream stream(gps_subframes[msg->sv_id()][2]);
+      kaitai::kstream stream(raw_string(subframes.data[1]));
       gps_t subframe(&stream);
       gps_t::subframe_2_t* subframe_2 = static_cast<gps_t::subframe_2_t*>(subframe.body());
 
@@ -240,7 +268,7 @@ kj::Array<capnp::word> UbloxMsgParser::parse_gps_ephemeris(ubx_t::rxm_sfrbx_t *m
 
     // Subframe 3
     {
-      kaitai::kstream stream(gps_subframes[msg->sv_id()][3]);
+      kaitai::kstream stream(raw_string(subframes.data[2]));
       gps_t subframe(&stream);
       gps_t::subframe_3_t* subframe_3 = static_cast<gps_t::subframe_3_t*>(subframe.body());
 
@@ -259,7 +287,6 @@ kj::Array<capnp::word> UbloxMsgParser::parse_gps_ephemeris(ubx_t::rxm_sfrbx_t *m
     eph.setToeWeek(week);
     eph.setTocWeek(week);
 
-    gps_subframes[msg->sv_id()].clear();
     if (iodc_lsb != iode_s2 || iodc_lsb != iode_s3) {
       // data set cutover, reject ephemeris
       return kj::Array<capnp::word>();
@@ -274,18 +301,19 @@ kj::Array<capnp::word> UbloxMsgParser::parse_glonass_ephemeris(ubx_t::rxm_sfrbx_
   // can be in view at the same time
   auto body = *msg->body();
   assert(body.size() == 4);
+  GlonassStrings &strings = glonass_strings[msg->freq_id()];
   {
-    std::string string_data;
-    string_data.reserve(16);
-    for (uint32_t word : body) {
-      for (int i = 3; i >= 0; i--)
-        string_data.push_back(word >> 8*i);
+    std::array<uint8_t, 16> string_data;
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 4; j++)
+        string_data[i * 4 + j] = body[i] >> 8*(3 - j);
     }
 
-    kaitai::kstream stream(string_data);
-    glonass_t gl_string(&stream);
-    int string_number = gl_string.string_number();
-    if (string_number < 1 || string_number > 5 || gl_string.idle_chip()) {
+    // idle chip and string number are the first 5 bits, the superframe number is the third word
+    bool idle_chip = string_data[0] >> 7;
+    int string_number = (string_data[0] >> 3) & 0xF;
+    int superframe_number = (string_data[12] << 8) | string_data[13];
+    if (string_number < 1 || string_number > 5 || idle_chip) {
       // don't parse non immediate data, idle_chip == 0
       return kj::Array<capnp::word>();
     }
@@ -294,28 +322,27 @@ kj::Array<capnp::word> UbloxMsgParser::parse_glonass_ephemeris(ubx_t::rxm_sfrbx_
     bool superframe_unknown = false;
     bool needs_clear = false;
     for (int i = 1; i <= 5; i++) {
-      if (glonass_strings[msg->freq_id()].find(i) == glonass_strings[msg->freq_id()].end())
+      if (!(strings.valid & (1 << (i - 1))))
         continue;
-      if (glonass_string_superframes[msg->freq_id()][i] == 0 || gl_string.superframe_number() == 0) {
+      if (strings.superframe[i - 1] == 0 || superframe_number == 0) {
         superframe_unknown = true;
-      } else if (glonass_string_superframes[msg->freq_id()][i] != gl_string.superframe_number()) {
+      } else if (strings.superframe[i - 1] != superframe_number) {
         needs_clear = true;
       }
       // Check if string times add up to being from the same frame
       // If superframe is known this is redundant
       // Strings are sent 2s apart and frames are 30s apart
       if (superframe_unknown &&
-          std::abs((glonass_string_times[msg->freq_id()][i] - 2.0 * i) - (last_log_time - 2.0 * string_number)) > 10)
+          std::abs((strings.time[i - 1] - 2.0 * i) - (last_log_time - 2.0 * string_number)) > 10)
         needs_clear = true;
     }
     if (needs_clear) {
-      glonass_strings[msg->freq_id()].clear();
-      glonass_string_superframes[msg->freq_id()].clear();
-      glonass_string_times[msg->freq_id()].clear();
+      strings.valid = 0;
     }
-    glonass_strings[msg->freq_id()][string_number] = string_data;
-    glonass_string_superframes[msg->freq_id()][string_number] = gl_string.superframe_number();
-    glonass_string_times[msg->freq_id()][string_number] = last_log_time;
+    strings.data[string_number - 1] = string_data;
+    strings.superframe[string_number - 1] = superframe_number;
+    strings.time[string_number - 1] = last_log_time;
+    strings.valid |= 1 << (string_number - 1);
   }
   if (msg->sv_id() == 255) {
     // data can be decoded before identifying the SV number, in this case 255
@@ -324,9 +351,10 @@ kj::Array<capnp::word> UbloxMsgParser::parse_glonass_ephemeris(ubx_t::rxm_sfrbx_
   }
 
   // publish if strings 1-5 have been collected
-  if (glonass_strings[msg->freq_id()].size() != 5) {
+  if (strings.valid != 0b11111) {
     return kj::Array<capnp::word>();
   }
+  strings.valid = 0;
 
   MessageBuilder msg_builder;
   auto eph = msg_builder.initEvent().initUbloxGnss().initGlonassEphemeris();
@@ -338,7 +366,7 @@ kj::Array<capnp::word> UbloxMsgParser::parse_glonass_ephemeris(ubx_t::rxm_sfrbx_
 
   // string number 1
   {
-    kaitai::kstream stream(glonass_strings[msg->freq_id()][1]);
+    kaitai::kstream stream(raw_string(strings.data[0]));
     glonass_t gl_stream(&stream);
     glonass_t::string_1_t* data = static_cast<glonass_t::string_1_t*>(gl_stream.data());
 
@@ -352,7 +380,7 @@ kj::Array<capnp::word> UbloxMsgParser::parse_glonass_ephemeris(ubx_t::rxm_sfrbx_
 
   // string number 2
   {
-    kaitai::kstream stream(glonass_strings[msg->freq_id()][2]);
+    kaitai::kstream stream(raw_string(strings.data[1]));
     glonass_t gl_stream(&stream);
     glonass_t::string_2_t* data = static_cast<glonass_t::string_2_t*>(gl_stream.data());
 
@@ -366,7 +394,7 @@ kj::Array<capnp::word> UbloxMsgParser::parse_glonass_ephemeris(ubx_t::rxm_sfrbx_
 
   // string number 3
   {
-    kaitai::kstream stream(glonass_strings[msg->freq_id()][3]);
+    kaitai::kstream stream(raw_string(strings.data[2]));
     glonass_t gl_stream(&stream);
     glonass_t::string_3_t* data = static_cast<glonass_t::string_3_t*>(gl_stream.data());
 
@@ -380,7 +408,7 @@ kj::Array<capnp::word> UbloxMsgParser::parse_glonass_ephemeris(ubx_t::rxm_sfrbx_
 
   // string number 4
   {
-    kaitai::kstream stream(glonass_strings[msg->freq_id()][4]);
+    kaitai::kstream stream(raw_string(strings.data[3]));
     glonass_t gl_stream(&stream);
     glonass_t::string_4_t* data = static_cast<glonass_t::string_4_t*>(gl_stream.data());
 
@@ -399,7 +427,7 @@ kj::Array<capnp::word> UbloxMsgParser::parse_glonass_ephemeris(ubx_t::rxm_sfrbx_
 
   // string number 5
   {
-    kaitai::kstream stream(glonass_strings[msg->freq_id()][5]);
+    kaitai::kstream stream(raw_string(strings.data[4]));
     glonass_t gl_stream(&stream);
     glonass_t::string_5_t* data = static_cast<glonass_t::string_5_t*>(gl_stream.data());
 
@@ -410,7 +438,6 @@ kj::Array<capnp::word> UbloxMsgParser::parse_glonass_ephemeris(ubx_t::rxm_sfrbx_
     eph.setTkSeconds(tk_seconds);
   }
 
-  glonass_strings[msg->freq_id()].clear();
   return capnp::messageToFlatArray(msg_builder);
 }
 
@@ -426,55 +453,73 @@ kj::Array<capnp::word> UbloxMsgParser::gen_rxm_sfrbx(ubx_t::rxm_sfrbx_t *msg) {
   }
 }
 
-kj::Array<capnp::word> UbloxMsgParser::gen_rxm_rawx(ubx_t::rxm_rawx_t *msg) {
-  MessageBuilder msg_builder;
+kj::Array<capnp::word> UbloxMsgParser::gen_rxm_rawx(const uint8_t *payload, size_t len) {
+  ublox::ubx_rxm_rawx_t msg;
+  if (len < sizeof(msg)) {
+    throw std::runtime_error("RXM-RAWX payload too short");
+  }
+  memcpy(&msg, payload, sizeof(msg));
+  if (len < sizeof(msg) + msg.numMeas * sizeof(ublox::ubx_rxm_rawx_meas_t)) {
+    throw std::runtime_error("RXM-RAWX payload too short");
+  }
+
+  MessageBuilder msg_builder(kj::arrayPtr(msg_segment, std::size(msg_segment)));
   auto mr = msg_builder.initEvent().initUbloxGnss().initMeasurementReport();
-  mr.setRcvTow(msg->rcv_tow());
-  mr.setGpsWeek(msg->week());
-  mr.setLeapSeconds(msg->leap_s());
-  mr.setGpsWeek(msg->week());
-
-  auto mb = mr.initMeasurements(msg->num_meas());
-  auto measurements = *msg->meas();
-  for (int8_t i = 0; i < msg->num_meas(); i++) {
-    mb[i].setSvId(measurements[i]->sv_id());
-    mb[i].setPseudorange(measurements[i]->pr_mes());
-    mb[i].setCarrierCycles(measurements[i]->cp_mes());
-    mb[i].setDoppler(measurements[i]->do_mes());
-    mb[i].setGnssId(measurements[i]->gnss_id());
-    mb[i].setGlonassFrequencyIndex(measurements[i]->freq_id());
-    mb[i].setLocktime(measurements[i]->lock_time());
-    mb[i].setCno(measurements[i]->cno());
-    mb[i].setPseudorangeStdev(0.01 * (pow(2, (measurements[i]->pr_stdev() & 15)))); // weird scaling, might be wrong
-    mb[i].setCarrierPhaseStdev(0.004 * (measurements[i]->cp_stdev() & 15));
-    mb[i].setDopplerStdev(0.002 * (pow(2, (measurements[i]->do_stdev() & 15)))); // weird scaling, might be wrong
+  mr.setRcvTow(msg.rcvTow);
+  mr.setGpsWeek(msg.week);
+  mr.setLeapSeconds(msg.leapS);
+
+  auto mb = mr.initMeasurements(msg.numMeas);
+  for (int i = 0; i < msg.numMeas; i++) {
+    ublox::ubx_rxm_rawx_meas_t meas;
+    memcpy(&meas, payload + sizeof(msg) + i * sizeof(meas), sizeof(meas));
+    mb[i].setSvId(meas.svId);
+    mb[i].setPseudorange(meas.prMes);
+    mb[i].setCarrierCycles(meas.cpMes);
+    mb[i].setDoppler(meas.doMes);
+    mb[i].setGnssId(meas.gnssId);
+    mb[i].setGlonassFrequencyIndex(meas.freqId);
+    mb[i].setLocktime(meas.locktime);
+    mb[i].setCno(meas.cno);
+    mb[i].setPseudorangeStdev(0.01 * (pow(2, (meas.prStdev & 15)))); // weird scaling, might be wrong
+    mb[i].setCarrierPhaseStdev(0.004 * (meas.cpStdev & 15));
+    mb[i].setDopplerStdev(0.002 * (pow(2, (meas.doStdev & 15)))); // weird scaling, might be wrong
 
     auto ts = mb[i].initTrackingStatus();
-    auto trk_stat = measurements[i]->trk_stat();
-    ts.setPseudorangeValid(bit_to_bool(trk_stat, 0));
-    ts.setCarrierPhaseValid(bit_to_bool(trk_stat, 1));
-    ts.setHalfCycleValid(bit_to_bool(trk_stat, 2));
-    ts.setHalfCycleSubtracted(bit_to_bool(trk_stat, 3));
+    ts.setPseudorangeValid(bit_to_bool(meas.trkStat, 0));
+    ts.setCarrierPhaseValid(bit_to_bool(meas.trkStat, 1));
+    ts.setHalfCycleValid(bit_to_bool(meas.trkStat, 2));
+    ts.setHalfCycleSubtracted(bit_to_bool(meas.trkStat, 3));
   }
 
-  mr.setNumMeas(msg->num_meas());
+  mr.setNumMeas(msg.numMeas);
   auto rs = mr.initReceiverStatus();
-  rs.setLeapSecValid(bit_to_bool(msg->rec_stat(), 0));
-  rs.setClkReset(bit_to_bool(msg->rec_stat(), 2));
+  rs.setLeapSecValid(bit_to_bool(msg.recStat, 0));
+  rs.setClkReset(bit_to_bool(msg.recStat, 2));
   return capnp::messageToFlatArray(msg_builder);
 }
 
-kj::Array<capnp::word> UbloxMsgParser::gen_nav_sat(ubx_t::nav_sat_t *msg) {
-  MessageBuilder msg_builder;
+kj::Array<capnp::word> UbloxMsgParser::gen_nav_sat(const uint8_t *payload, size_t len) {
+  ublox::ubx_nav_sat_t msg;
+  if (len < sizeof(msg)) {
+    throw std::runtime_error("NAV-SAT payload too short");
+  }
+  memcpy(&msg, payload, sizeof(msg));
+  if (len < sizeof(msg) + msg.numSvs * sizeof(ublox::ubx_nav_sat_sv_t)) {
+    throw std::runtime_error("NAV-SAT payload too short");
+  }
+
+  MessageBuilder msg_builder(kj::arrayPtr(msg_segment, std::size(msg_segment)));
   auto sr = msg_builder.initEvent().initUbloxGnss().initSatReport();
-  sr.setITow(msg->itow());
-
-  auto svs = sr.initSvs(msg->num_svs());
-  auto svs_data = *msg->svs();
-  for (int8_t i = 0; i < msg->num_svs(); i++) {
-    svs[i].setSvId(svs_data[i]->sv_id());
-    svs[i].setGnssId(svs_data[i]->gnss_id());
-    svs[i].setFlagsBitfield(svs_data[i]->flags());
+  sr.setITow(msg.iTOW);
+
+  auto svs = sr.initSvs(msg.numSvs);
+  for (int i = 0; i < msg.numSvs; i++) {
+    ublox::ubx_nav_sat_sv_t sv;
+    memcpy(&sv, payload + sizeof(msg) + i * sizeof(sv), sizeof(sv));
+    svs[i].setSvId(sv.svId);
+    svs[i].setGnssId(sv.gnssId);
+    svs[i].setFlagsBitfield(sv.flags);
   }
 
   return capnp::messageToFlatArray(msg_builder);
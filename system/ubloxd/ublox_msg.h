@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <cassert>
 #include <cstdint>
 #include <ctime>
@@ -48,6 +49,91 @@ namespace ublox {
     uint32_t tAccNs;
   } __attribute__((packed));
 
+  // payloads of the high rate messages, decoded in place. UBX is little endian like the host.
+  struct ubx_nav_pvt_t {
+    uint32_t iTOW;
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t min;
+    uint8_t sec;
+    uint8_t valid;
+    uint32_t tAcc;
+    int32_t nano;
+    uint8_t fixType;
+    uint8_t flags;
+    uint8_t flags2;
+    uint8_t numSV;
+    int32_t lon;
+    int32_t lat;
+    int32_t height;
+    int32_t hMSL;
+    uint32_t hAcc;
+    uint32_t vAcc;
+    int32_t velN;
+    int32_t velE;
+    int32_t velD;
+    int32_t gSpeed;
+    int32_t headMot;
+    int32_t sAcc;
+    uint32_t headAcc;
+    uint16_t pDOP;
+    uint8_t flags3;
+    uint8_t reserved1[5];
+    int32_t headVeh;
+    int16_t magDec;
+    uint16_t magAcc;
+  } __attribute__((packed));
+  static_assert(sizeof(ubx_nav_pvt_t) == 92);
+
+  struct ubx_rxm_rawx_t {
+    double rcvTow;
+    uint16_t week;
+    int8_t leapS;
+    uint8_t numMeas;
+    uint8_t recStat;
+    uint8_t reserved1[3];
+  } __attribute__((packed));
+  static_assert(sizeof(ubx_rxm_rawx_t) == 16);
+
+  struct ubx_rxm_rawx_meas_t {
+    double prMes;
+    double cpMes;
+    float doMes;
+    uint8_t gnssId;
+    uint8_t svId;
+    uint8_t reserved2;
+    uint8_t freqId;
+    uint16_t locktime;
+    uint8_t cno;
+    uint8_t prStdev;
+    uint8_t cpStdev;
+    uint8_t doStdev;
+    uint8_t trkStat;
+    uint8_t reserved3;
+  } __attribute__((packed));
+  static_assert(sizeof(ubx_rxm_rawx_meas_t) == 32);
+
+  struct ubx_nav_sat_t {
+    uint32_t iTOW;
+    uint8_t version;
+    uint8_t numSvs;
+    uint8_t reserved1[2];
+  } __attribute__((packed));
+  static_assert(sizeof(ubx_nav_sat_t) == 8);
+
+  struct ubx_nav_sat_sv_t {
+    uint8_t gnssId;
+    uint8_t svId;
+    uint8_t cno;
+    int8_t elev;
+    int16_t azim;
+    int16_t prRes;
+    uint32_t flags;
+  } __attribute__((packed));
+  static_assert(sizeof(ubx_nav_sat_sv_t) == 12);
+
   inline std::string ubx_add_checksum(const std::string &msg) {
     assert(msg.size() > 2);
 
@@ -92,32 +178,44 @@ namespace ublox {
 
 class UbloxMsgParser {
   public:
+    // Buffers incoming data and returns true once a valid frame is at the front, which stays
+    // there until pop_frame(). May consume only part of the data when a frame is ready.
     bool add_data(float log_time, const uint8_t *incoming_data, uint32_t incoming_data_len, size_t &bytes_consumed);
-    inline void reset() {bytes_in_parse_buf = 0;}
-    inline int needed_bytes();
-    inline std::string data() {return std::string((const char*)msg_parse_buf, bytes_in_parse_buf);}
+    inline void pop_frame() {buf_start += frame_size; frame_size = 0;}
+    inline std::string data() {return std::string((const char*)msg_parse_buf + buf_start, frame_size);}
 
     std::pair<std::string, kj::Array<capnp::word>> gen_msg();
-    kj::Array<capnp::word> gen_nav_pvt(ubx_t::nav_pvt_t *msg);
+    kj::Array<capnp::word> gen_nav_pvt(const uint8_t *payload, size_t len);
     kj::Array<capnp::word> gen_rxm_sfrbx(ubx_t::rxm_sfrbx_t *msg);
-    kj::Array<capnp::word> gen_rxm_rawx(ubx_t::rxm_rawx_t *msg);
+    kj::Array<capnp::word> gen_rxm_rawx(const uint8_t *payload, size_t len);
     kj::Array<capnp::word> gen_mon_hw(ubx_t::mon_hw_t *msg);
     kj::Array<capnp::word> gen_mon_hw2(ubx_t::mon_hw2_t *msg);
-    kj::Array<capnp::word> gen_nav_sat(ubx_t::nav_sat_t *msg);
+    kj::Array<capnp::word> gen_nav_sat(const uint8_t *payload, size_t len);
 
   private:
-    inline bool valid_cheksum();
-    inline bool valid();
-    inline bool valid_so_far();
+    bool find_frame();
+    bool valid_checksum(const uint8_t *frame, size_t size);
 
     kj::Array<capnp::word> parse_gps_ephemeris(ubx_t::rxm_sfrbx_t *msg);
     kj::Array<capnp::word> parse_glonass_ephemeris(ubx_t::rxm_sfrbx_t *msg);
 
-    std::unordered_map<int, std::unordered_map<int, std::string>> gps_subframes;
+    // subframes 1-3 of each GPS SV, 10 words of 24 bits without parity
+    struct GpsSubframes {
+      uint8_t valid;  // bit n - 1 is set once subframe n was received
+      std::array<std::array<uint8_t, 30>, 3> data;
+    };
+    std::array<GpsSubframes, 256> gps_subframes = {};
 
     float last_log_time = 0.0;
-    size_t bytes_in_parse_buf = 0;
-    uint8_t msg_parse_buf[ublox::UBLOX_HEADER_SIZE + ublox::UBLOX_MAX_MSG_SIZE];
+
+    // Frames are parsed in place from the window [buf_start, buf_end). Garbage is skipped with
+    // memchr, and the window is only moved back to the start when new data doesn't fit behind it.
+    size_t buf_start = 0, buf_end = 0;
+    size_t frame_size = 0;
+    uint8_t msg_parse_buf[2 * (ublox::UBLOX_HEADER_SIZE + ublox::UBLOX_MAX_MSG_SIZE + ublox::UBLOX_CHECKSUM_SIZE)];
+
+    // first segment of the message builders, large enough for RXM-RAWX with all channels
+    capnp::word msg_segment[4096] = {};
 
     // user range accuracy in meters
     const std::unordered_map<uint8_t, float> glonass_URA_lookup =
@@ -125,7 +223,13 @@ class UbloxMsgParser {
        { 6, 10}, { 7,  12}, { 8,  14}, { 9,  16}, {10, 32},
        {11, 64}, {12, 128}, {13, 256}, {14, 512}, {15, 1024}};
 
-    std::unordered_map<int, std::unordered_map<int, std::string>> glonass_strings;
-    std::unordered_map<int, std::unordered_map<int, long>> glonass_string_times;
-    std::unordered_map<int, std::unordered_map<int, int>> glonass_string_superframes;
+    // strings 1-5 of the GLONASS ephemeris by frequency id, with the superframe number and log
+    // time they were received at
+    struct GlonassStrings {
+      uint8_t valid;  // bit n - 1 is set once string n was received
+      std::array<std::array<uint8_t, 16>, 5> data;
+      std::array<int, 5> superframe;
+      std::array<long, 5> time;
+    };
+    std::array<GlonassStrings, 256> glonass_strings = {};
 };
@@ -41,23 +41,26 @@ int main() {
     size_t len = ubloxRaw.size();
     size_t bytes_consumed = 0;
 
-    while (bytes_consumed < len && !do_exit) {
+    // keep going after all data is consumed, there can be more than one frame buffered
+    while (!do_exit) {
       size_t bytes_consumed_this_time = 0U;
-      if (parser.add_data(log_time, data + bytes_consumed, (uint32_t)(len - bytes_consumed), bytes_consumed_this_time)) {
+      bool frame_ready = parser.add_data(log_time, data + bytes_consumed, (uint32_t)(len - bytes_consumed), bytes_consumed_this_time);
+      bytes_consumed += bytes_consumed_this_time;
+      if (!frame_ready) {
+        break;
+      }
 
-        try {
-          auto ublox_msg = parser.gen_msg();
-          if (ublox_msg.second.size() > 0) {
-            auto bytes = ublox_msg.second.asBytes();
-            pm.send(ublox_msg.first.c_str(), bytes.begin(), bytes.size());
-          }
-        } catch (const std::exception& e) {
-          LOGE("Error parsing ublox message %s", e.what());
+      try {
+        auto ublox_msg = parser.gen_msg();
+        if (ublox_msg.second.size() > 0) {
+          auto bytes = ublox_msg.second.asBytes();
+          pm.send(ublox_msg.first.c_str(), bytes.begin(), bytes.size());
         }
-
-        parser.reset();
+      } catch (const std::exception& e) {
+        LOGE("Error parsing ublox message %s", e.what());
       }
-      bytes_consumed += bytes_consumed_this_time;
+
+      parser.pop_frame();
     }
   }
 